@@ -23,9 +23,13 @@ namespace WAVM { namespace Emscripten {
 		Runtime::GCPointer<Runtime::ModuleInstance> global;
 
 		Runtime::GCPointer<Runtime::Memory> memory;
+		Runtime::GCPointer<Runtime::Table> table;
 
 		U32 errnoAddress{0};
 
+		// The stacks of exited pthreads, which are reused by new pthreads.
+		std::vector<U32> freeThreadStackAddresses;
+
 		WAVM::VFS::VFD* stdIn{nullptr};
 		WAVM::VFS::VFD* stdOut{nullptr};
 		WAVM::VFS::VFD* stdErr{nullptr};
@@ -150,20 +150,230 @@ namespace WAVM { namespace IR {
 		maxSingleByteOpcode = 0xdf,
 	};
 
-	WAVM_PACKED_STRUCT(template<typename Imm> struct OpcodeAndImm {
-		Opcode opcode;
-		Imm imm;
-	});
-
-	// Specialize for the empty immediate struct so they don't take an extra byte of space.
-	template<> struct OpcodeAndImm<NoImm>
-	{
-		union
+	// Operators are stored in a compact encoding: opcodes up to maxSingleByteOpcode are encoded as
+	// a single byte, and other opcodes as their prefix byte followed by their low byte. Index and
+	// offset immediates are encoded as LEB128, and other immediates are copied verbatim.
+	namespace OperatorEncoding {
+		enum
 		{
-			Opcode opcode;
-			NoImm imm;
+			maxEncodedOpBytes = 32
 		};
-	};
+
+		WAVM_FORCEINLINE U8* encodeVarUInt(U8* nextByte, U64 value)
+		{
+			while(value >= 0x80)
+			{
+				*nextByte++ = U8(value | 0x80);
+				value >>= 7;
+			};
+			*nextByte++ = U8(value);
+			return nextByte;
+		}
+
+		WAVM_FORCEINLINE U8* encodeVarInt(U8* nextByte, I64 value)
+		{
+			while(value < -64 || value >= 64)
+			{
+				*nextByte++ = U8(value | 0x80);
+				value >>= 7;
+			};
+			*nextByte++ = U8(value & 0x7f);
+			return nextByte;
+		}
+
+		WAVM_FORCEINLINE U64 decodeVarUInt(const U8*& nextByte)
+		{
+			U64 result = *nextByte++;
+			if(result < 0x80) { return result; }
+
+			result &= 0x7f;
+			for(U32 shift = 7;; shift += 7)
+			{
+				const U8 byte = *nextByte++;
+				result |= U64(byte & 0x7f) << shift;
+				if(byte < 0x80) { return result; }
+			}
+		}
+
+		WAVM_FORCEINLINE I64 decodeVarInt(const U8*& nextByte)
+		{
+			// Sign extend single byte values from bit 6.
+			if(*nextByte < 0x80) { return I64(U64(*nextByte++) << 57) >> 57; }
+
+			U64 result = 0;
+			U32 shift = 0;
+			U8 byte;
+			do
+			{
+				byte = *nextByte++;
+				result |= U64(byte & 0x7f) << shift;
+				shift += 7;
+			} while(byte & 0x80);
+
+			// Sign extend the result from the last encoded bit.
+			if(shift < 64 && (byte & 0x40)) { result |= ~U64(0) << shift; }
+			return I64(result);
+		}
+
+		WAVM_FORCEINLINE U8* encodeOpcode(U8* nextByte, Opcode opcode)
+		{
+			if(opcode <= (Opcode)maxSingleByteOpcode) { *nextByte++ = U8(opcode); }
+			else
+			{
+				*nextByte++ = U8(U16(opcode) >> 8);
+				*nextByte++ = U8(opcode);
+			}
+			return nextByte;
+		}
+
+		WAVM_FORCEINLINE Opcode decodeOpcode(const U8*& nextByte)
+		{
+			const U8 firstByte = *nextByte++;
+			if(firstByte <= maxSingleByteOpcode) { return Opcode(firstByte); }
+			return Opcode((U16(firstByte) << 8) | *nextByte++);
+		}
+
+		// Immediates without a specific encoding are copied verbatim.
+		template<typename Imm> WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const Imm& imm)
+		{
+			memcpy(nextByte, &imm, sizeof(Imm));
+			return nextByte + sizeof(Imm);
+		}
+		template<typename Imm> WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, Imm& imm)
+		{
+			memcpy(&imm, nextByte, sizeof(Imm));
+			nextByte += sizeof(Imm);
+		}
+
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const NoImm&) { return nextByte; }
+		WAVM_FORCEINLINE void decodeImm(const U8*&, NoImm&) {}
+
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const ControlStructureImm& imm)
+		{
+			*nextByte++ = U8(imm.type.format);
+			switch(imm.type.format)
+			{
+			case IndexedBlockType::noParametersOrResult: break;
+			case IndexedBlockType::oneResult: *nextByte++ = U8(imm.type.resultType); break;
+			case IndexedBlockType::functionType:
+				nextByte = encodeVarUInt(nextByte, imm.type.index);
+				break;
+			default: WAVM_UNREACHABLE();
+			};
+			return nextByte;
+		}
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, ControlStructureImm& imm)
+		{
+			imm.type.format = IndexedBlockType::Format(*nextByte++);
+			imm.type.index = 0;
+			switch(imm.type.format)
+			{
+			case IndexedBlockType::noParametersOrResult: break;
+			case IndexedBlockType::oneResult: imm.type.resultType = ValueType(*nextByte++); break;
+			case IndexedBlockType::functionType:
+				imm.type.index = Uptr(decodeVarUInt(nextByte));
+				break;
+			default: WAVM_UNREACHABLE();
+			};
+		}
+
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const LiteralImm<I32>& imm)
+		{
+			return encodeVarInt(nextByte, imm.value);
+		}
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, LiteralImm<I32>& imm)
+		{
+			imm.value = I32(decodeVarInt(nextByte));
+		}
+
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const LiteralImm<I64>& imm)
+		{
+			return encodeVarInt(nextByte, imm.value);
+		}
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, LiteralImm<I64>& imm)
+		{
+			imm.value = decodeVarInt(nextByte);
+		}
+
+		template<Uptr naturalAlignmentLog2>
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte,
+									   const LoadOrStoreImm<naturalAlignmentLog2>& imm)
+		{
+			*nextByte++ = imm.alignmentLog2;
+			return encodeVarUInt(nextByte, imm.offset);
+		}
+		template<Uptr naturalAlignmentLog2>
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte,
+										LoadOrStoreImm<naturalAlignmentLog2>& imm)
+		{
+			imm.alignmentLog2 = *nextByte++;
+			imm.offset = U32(decodeVarUInt(nextByte));
+		}
+
+		template<Uptr naturalAlignmentLog2>
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte,
+									   const AtomicLoadOrStoreImm<naturalAlignmentLog2>& imm)
+		{
+			*nextByte++ = imm.alignmentLog2;
+			return encodeVarUInt(nextByte, imm.offset);
+		}
+		template<Uptr naturalAlignmentLog2>
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte,
+										AtomicLoadOrStoreImm<naturalAlignmentLog2>& imm)
+		{
+			imm.alignmentLog2 = *nextByte++;
+			imm.offset = U32(decodeVarUInt(nextByte));
+		}
+
+		template<bool isGlobal>
+		WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const GetOrSetVariableImm<isGlobal>& imm)
+		{
+			return encodeVarUInt(nextByte, imm.variableIndex);
+		}
+		template<bool isGlobal>
+		WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, GetOrSetVariableImm<isGlobal>& imm)
+		{
+			imm.variableIndex = Uptr(decodeVarUInt(nextByte));
+		}
+
+		// Immediates that contain only indices are encoded as a LEB128 per index.
+#define WAVM_INDEX_IMM_ENCODING(Imm, field)                                                        \
+	WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const Imm& imm)                                   \
+	{                                                                                              \
+		return encodeVarUInt(nextByte, imm.field);                                                 \
+	}                                                                                              \
+	WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, Imm& imm)                                 \
+	{                                                                                              \
+		imm.field = Uptr(decodeVarUInt(nextByte));                                                 \
+	}
+#define WAVM_INDEX_PAIR_IMM_ENCODING(Imm, firstField, secondField)                                 \
+	WAVM_FORCEINLINE U8* encodeImm(U8* nextByte, const Imm& imm)                                   \
+	{                                                                                              \
+		return encodeVarUInt(encodeVarUInt(nextByte, imm.firstField), imm.secondField);            \
+	}                                                                                              \
+	WAVM_FORCEINLINE void decodeImm(const U8*& nextByte, Imm& imm)                                 \
+	{                                                                                              \
+		imm.firstField = Uptr(decodeVarUInt(nextByte));                                            \
+		imm.secondField = Uptr(decodeVarUInt(nextByte));                                           \
+	}
+
+		WAVM_INDEX_IMM_ENCODING(MemoryImm, memoryIndex)
+		WAVM_INDEX_PAIR_IMM_ENCODING(MemoryCopyImm, sourceMemoryIndex, destMemoryIndex)
+		WAVM_INDEX_IMM_ENCODING(TableImm, tableIndex)
+		WAVM_INDEX_PAIR_IMM_ENCODING(TableCopyImm, sourceTableIndex, destTableIndex)
+		WAVM_INDEX_IMM_ENCODING(BranchImm, targetDepth)
+		WAVM_INDEX_PAIR_IMM_ENCODING(BranchTableImm, defaultTargetDepth, branchTableIndex)
+		WAVM_INDEX_IMM_ENCODING(FunctionImm, functionIndex)
+		WAVM_INDEX_PAIR_IMM_ENCODING(CallIndirectImm, type.index, tableIndex)
+		WAVM_INDEX_IMM_ENCODING(ExceptionTypeImm, exceptionTypeIndex)
+		WAVM_INDEX_IMM_ENCODING(RethrowImm, catchDepth)
+		WAVM_INDEX_PAIR_IMM_ENCODING(DataSegmentAndMemImm, dataSegmentIndex, memoryIndex)
+		WAVM_INDEX_IMM_ENCODING(DataSegmentImm, dataSegmentIndex)
+		WAVM_INDEX_PAIR_IMM_ENCODING(ElemSegmentAndTableImm, elemSegmentIndex, tableIndex)
+		WAVM_INDEX_IMM_ENCODING(ElemSegmentImm, elemSegmentIndex)
+#undef WAVM_INDEX_IMM_ENCODING
+#undef WAVM_INDEX_PAIR_IMM_ENCODING
+	}
 
 	// Decodes an operator from an input stream and dispatches by opcode.
 	struct OperatorDecoderStream
@@ -177,19 +387,16 @@ namespace WAVM { namespace IR {
 
 		template<typename Visitor> typename Visitor::Result decodeOp(Visitor& visitor)
 		{
-			wavmAssert(nextByte + sizeof(Opcode) <= end);
-			Opcode opcode;
-			memcpy(&opcode, nextByte, sizeof(Opcode));
-			switch(opcode)
+			wavmAssert(nextByte < end);
+			switch(OperatorEncoding::decodeOpcode(nextByte))
 			{
 #define VISIT_OPCODE(opcode, name, nameString, Imm, ...)                                           \
 	case Opcode::name:                                                                             \
 	{                                                                                              \
-		wavmAssert(nextByte + sizeof(OpcodeAndImm<Imm>) <= end);                                   \
-		OpcodeAndImm<Imm> encodedOperator;                                                         \
-		memcpy(&encodedOperator, nextByte, sizeof(OpcodeAndImm<Imm>));                             \
-		nextByte += sizeof(OpcodeAndImm<Imm>);                                                     \
-		return visitor.name(encodedOperator.imm);                                                  \
+		Imm imm;                                                                                   \
+		OperatorEncoding::decodeImm(nextByte, imm);                                                \
+		wavmAssert(nextByte <= end);                                                               \
+		return visitor.name(imm);                                                                  \
 	}
 				WAVM_ENUM_OPERATORS(VISIT_OPCODE)
 #undef VISIT_OPCODE
@@ -220,12 +427,12 @@ namespace WAVM { namespace IR {
 #define VISIT_OPCODE(_, name, nameString, Imm, ...)                                                \
 	void name(Imm imm = {})                                                                        \
 	{                                                                                              \
-		OpcodeAndImm<Imm> encodedOperator;                                                         \
-		encodedOperator.opcode = Opcode::name;                                                     \
-		encodedOperator.imm = imm;                                                                 \
-		memcpy((OpcodeAndImm<Imm>*)byteStream.advance(sizeof(OpcodeAndImm<Imm>)),                  \
-			   &encodedOperator,                                                                   \
-			   sizeof(OpcodeAndImm<Imm>));                                                         \
+		U8 encodedOperator[OperatorEncoding::maxEncodedOpBytes];                                   \
+		U8* encodedEnd = OperatorEncoding::encodeOpcode(encodedOperator, Opcode::name);            \
+		encodedEnd = OperatorEncoding::encodeImm(encodedEnd, imm);                                 \
+		const Uptr numEncodedBytes = Uptr(encodedEnd - encodedOperator);                           \
+		wavmAssert(numEncodedBytes <= OperatorEncoding::maxEncodedOpBytes);                        \
+		memcpy(byteStream.advance(numEncodedBytes), encodedOperator, numEncodedBytes);             \
 	}
 		WAVM_ENUM_OPERATORS(VISIT_OPCODE)
 #undef VISIT_OPCODE
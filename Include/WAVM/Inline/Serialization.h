@@ -1,6 +1,7 @@
 #pragma once
 
 #include "WAVM/Inline/Assert.h"
+#include "WAVM/Platform/Intrinsic.h"
 
 #include <string.h>
 #include <algorithm>
@@ -108,6 +109,13 @@ namespace WAVM { namespace Serialization {
 			return next;
 		}
 
+		// Returns a pointer to the current stream cursor if there are at least numBytes already
+		// buffered following it, or nullptr otherwise. Unlike peek, never calls getMoreData.
+		inline const U8* tryPeekBuffered(Uptr numBytes) const
+		{
+			return Uptr(end - next) >= numBytes ? next : nullptr;
+		}
+
 	protected:
 		const U8* next;
 		const U8* end;
@@ -217,22 +225,51 @@ namespace WAVM { namespace Serialization {
 										  Value minValue,
 										  Value maxValue)
 	{
-		// First, read the variable number of input bytes into a fixed size buffer.
 		enum
 		{
 			maxBytes = (maxBits + 6) / 7
 		};
-		U8 bytes[maxBytes] = {0};
-		Uptr numBytes = 0;
-		I8 signExtendShift = (I8)sizeof(Value) * 8;
-		while(numBytes < maxBytes)
+		U64 decodedBits;
+		U8 lastByte;
+		Uptr numBytes;
+		const U8* bufferedBytes;
+		if(maxBytes <= 5 && (bufferedBytes = stream.tryPeekBuffered(sizeof(U64))))
 		{
-			U8 byte = *stream.advance(1);
-			bytes[numBytes] = byte;
-			++numBytes;
-			signExtendShift -= 7;
-			if(!(byte & 0x80)) { break; }
-		};
+			// If the stream has at least 8 bytes buffered, decode encodings of up to 5 bytes from a
+			// single 64-bit load without a loop. This assumes a little-endian host, like
+			// serializeNativeValue.
+			U64 word;
+			memcpy(&word, bufferedBytes, sizeof(U64));
+			const U64 terminatorMask = ~word & 0x8080808080ull;
+			numBytes = terminatorMask ? Uptr(countTrailingZeroes(terminatorMask) >> 3) + 1 : 5;
+			numBytes = std::min(numBytes, Uptr(maxBytes));
+			stream.advance(numBytes);
+
+			// Mask out the bytes following the encoding, and gather the 7-bit groups.
+			word &= ~U64(0) >> (64 - numBytes * 8);
+			lastByte = U8(word >> ((maxBytes - 1) * 8));
+			decodedBits = (word & 0x7full) | ((word >> 1) & (0x7full << 7))
+						  | ((word >> 2) & (0x7full << 14)) | ((word >> 3) & (0x7full << 21))
+						  | ((word >> 4) & (0x7full << 28));
+		}
+		else
+		{
+			// Read the variable number of input bytes into a fixed size buffer.
+			U8 bytes[maxBytes] = {0};
+			numBytes = 0;
+			while(numBytes < maxBytes)
+			{
+				U8 byte = *stream.advance(1);
+				bytes[numBytes] = byte;
+				++numBytes;
+				if(!(byte & 0x80)) { break; }
+			};
+
+			lastByte = bytes[maxBytes - 1];
+			decodedBits = 0;
+			for(Uptr byteIndex = 0; byteIndex < maxBytes; ++byteIndex)
+			{ decodedBits |= U64(bytes[byteIndex] & ~0x80) << U64(byteIndex * 7); }
+		}
 
 		// Ensure that the input does not encode more than maxBits of data.
 		enum
@@ -243,7 +280,6 @@ namespace WAVM { namespace Serialization {
 			lastByteUsedMask = U8(1 << numUsedBitsInLastByte) - U8(1),
 			lastByteSignedMask = U8(~U8(lastByteUsedMask) & ~U8(0x80))
 		};
-		const U8 lastByte = bytes[maxBytes - 1];
 		if(!std::is_signed<Value>::value)
 		{
 			if((lastByte & ~lastByteUsedMask) != 0)
@@ -264,12 +300,9 @@ namespace WAVM { namespace Serialization {
 			}
 		}
 
-		// Decode the buffer's bytes into the output integer.
-		value = 0;
-		for(Uptr byteIndex = 0; byteIndex < maxBytes; ++byteIndex)
-		{ value |= Value(U64(bytes[byteIndex] & ~0x80) << U64(byteIndex * 7)); }
-
 		// Sign extend the output integer to the full size of Value.
+		value = Value(decodedBits);
+		const I8 signExtendShift = I8(sizeof(Value) * 8) - I8(numBytes * 7);
 		if(std::is_signed<Value>::value && signExtendShift > 0)
 		{ value = Value(value << signExtendShift) >> signExtendShift; }
 
@@ -1,7 +1,16 @@
 #pragma once
 
+#include <string.h>
 #include "BasicTypes.h"
 #include "WAVM/Inline/Assert.h"
+#include "WAVM/Platform/Intrinsic.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <immintrin.h>
+#endif
+#endif
 
 namespace WAVM { namespace Unicode {
 	template<typename String> void encodeUTF8CodePoint(U32 codePoint, String& outString)
@@ -139,10 +148,87 @@ namespace WAVM { namespace Unicode {
 		}
 	}
 
+	// Returns a pointer to the first byte in [nextChar,endChar) that isn't a 7-bit ASCII
+	// character, or endChar if there are no such bytes. The portable version tests 8 bytes at a
+	// time, and there are SSE2 and AVX2 versions that test 16 and 32 bytes at a time.
+	inline const U8* skipASCIIPortable(const U8* nextChar, const U8* endChar)
+	{
+		while(endChar - nextChar >= 8)
+		{
+			U64 chars;
+			memcpy(&chars, nextChar, sizeof(U64));
+			const U64 nonASCIIMask = chars & 0x8080808080808080ull;
+			if(nonASCIIMask)
+			{
+				// This assumes a little-endian host, like the rest of WAVM.
+				return nextChar + (countTrailingZeroes(nonASCIIMask) >> 3);
+			}
+			nextChar += 8;
+		};
+		while(nextChar != endChar && *nextChar < 0x80) { ++nextChar; };
+		return nextChar;
+	}
+
+#if defined(__x86_64__) || defined(_M_X64)
+	inline const U8* skipASCIISSE2(const U8* nextChar, const U8* endChar)
+	{
+		while(endChar - nextChar >= 16)
+		{
+			const __m128i chars = _mm_loadu_si128((const __m128i*)nextChar);
+			const U32 nonASCIIMask = U32(_mm_movemask_epi8(chars));
+			if(nonASCIIMask) { return nextChar + countTrailingZeroes(nonASCIIMask); }
+			nextChar += 16;
+		};
+		return skipASCIIPortable(nextChar, endChar);
+	}
+
+#if defined(__GNUC__)
+	__attribute__((target("avx2"))) inline const U8* skipASCIIAVX2(const U8* nextChar,
+																	 const U8* endChar)
+	{
+		while(endChar - nextChar >= 32)
+		{
+			const __m256i chars = _mm256_loadu_si256((const __m256i*)nextChar);
+			const U32 nonASCIIMask = U32(_mm256_movemask_epi8(chars));
+			if(nonASCIIMask) { return nextChar + countTrailingZeroes(nonASCIIMask); }
+			nextChar += 32;
+		};
+		return skipASCIISSE2(nextChar, endChar);
+	}
+#endif
+#endif
+
+	// Chooses the fastest skipASCII implementation supported by the host CPU. SSE2 is part of the
+	// x86-64 baseline, but AVX2 must be detected at runtime.
+	typedef const U8* (*SkipASCIIFunction)(const U8*, const U8*);
+	inline SkipASCIIFunction getSkipASCIIFunction()
+	{
+#if(defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+		static const SkipASCIIFunction function = []() -> SkipASCIIFunction {
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? skipASCIIAVX2 : skipASCIISSE2;
+		}();
+		return function;
+#elif defined(__x86_64__) || defined(_M_X64)
+		return skipASCIISSE2;
+#else
+		return skipASCIIPortable;
+#endif
+	}
+
+	// Returns a pointer to the first byte that isn't part of a valid UTF-8 sequence, or endChar
+	// if the whole string is valid. Runs of ASCII characters are skipped with the vectorized
+	// skipASCII, and only the other characters are decoded one code point at a time.
 	inline const U8* validateUTF8String(const U8* nextChar, const U8* endChar)
 	{
+		const SkipASCIIFunction skipASCII = getSkipASCIIFunction();
 		U32 codePoint;
-		while(nextChar != endChar && decodeUTF8CodePoint(nextChar, endChar, codePoint)) {};
+		while(true)
+		{
+			nextChar = skipASCII(nextChar, endChar);
+			if(nextChar == endChar || !decodeUTF8CodePoint(nextChar, endChar, codePoint))
+			{ break; }
+		};
 		return nextChar;
 	}
 
@@ -40,12 +40,24 @@ namespace WAVM { namespace LLVMJIT {
 	};
 
 	// Compiles a module to object code.
-	LLVMJIT_API CompileResult compileModule(const IR::Module& irModule,
-											const TargetSpec& targetSpec,
-											std::vector<U8>& outObjectCode);
+	LLVMJIT_API CompileResult compileModule(
+		const IR::Module& irModule,
+		const TargetSpec& targetSpec,
+		std::vector<U8>& outObjectCode,
+		Runtime::MemoryBoundsCheckMode boundsCheckMode
+		= Runtime::MemoryBoundsCheckMode::guardRegion,
+		Runtime::CodegenMode codegenMode = Runtime::CodegenMode::optimized);
 
 	// Compile a module to object code with the host target spec. Cannot fail.
-	LLVMJIT_API std::vector<U8> compileModule(const IR::Module& irModule);
+	LLVMJIT_API std::vector<U8> compileModule(
+		const IR::Module& irModule,
+		Runtime::MemoryBoundsCheckMode boundsCheckMode
+		= Runtime::MemoryBoundsCheckMode::guardRegion,
+		Runtime::CodegenMode codegenMode = Runtime::CodegenMode::optimized);
+
+	// Sets whether the code of modules loaded after the call is packed into a region of memory that
+	// is backed by transparent huge pages, on platforms that support them. Defaults to false.
+	LLVMJIT_API void setCodeHugePagesEnabled(bool enable);
 
 	// An opaque type that can be used to reference a loaded JIT module.
 	struct Module;
@@ -73,6 +85,10 @@ namespace WAVM { namespace LLVMJIT {
 	struct MemoryBinding
 	{
 		Uptr id;
+
+		// The number of bytes of address space reserved for the memory. Only referenced by code
+		// compiled with MemoryBoundsCheckMode::explicitChecks.
+		Uptr numReservedBytes;
 	};
 
 	struct GlobalBinding
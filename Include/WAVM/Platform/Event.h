@@ -5,7 +5,10 @@
 #include "WAVM/Platform/Defines.h"
 
 namespace WAVM { namespace Platform {
-	// Platform-independent events.
+	struct GreenThread;
+
+	// Platform-independent events. A signal wakes the thread that is waiting for the event, or if
+	// no thread is waiting, the next thread that waits for it.
 	struct Event
 	{
 		PLATFORM_API Event();
@@ -19,6 +22,7 @@ namespace WAVM { namespace Platform {
 
 		// Wait for the event to be signaled until waitDuration nanoseconds have elapsed.
 		// If waitDuration == I128::nan(), wait forever.
+		// If called by a green thread, the green thread gives up its worker thread while waiting.
 		PLATFORM_API bool wait(I128 waitDuration);
 		PLATFORM_API void signal();
 
@@ -54,6 +58,11 @@ namespace WAVM { namespace Platform {
 		} pthreadCond;
 #else
 #error unsupported platform
+#endif
+
+#ifndef WIN32
+		bool isSignaled;
+		GreenThread* waitingGreenThread;
 #endif
 	};
 }}
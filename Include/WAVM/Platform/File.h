@@ -26,4 +26,64 @@ namespace WAVM { namespace Platform {
 		virtual ~HostFS() override {}
 	};
 	PLATFORM_API HostFS& getHostFS();
+
+	// Opens a host directory as a filesystem that can't access files outside the directory. Paths
+	// are resolved relative to a handle for the directory, instead of being appended to its path
+	// and resolved from the host's root. Returns nullptr if the directory can't be opened, or if
+	// the host doesn't support this, in which case VFS::makeSandboxFS can be used instead.
+	// Symbolic links are only followed if followSymbolicLinks is true, and the host can ensure that
+	// they refer to a file beneath the directory.
+	PLATFORM_API VFS::FileSystem* openHostSandboxFS(const std::string& rootPath,
+													 bool followSymbolicLinks = true);
+
+	// Maps numPages pages of a VFD's file, starting at the page-aligned byte offset, over the
+	// pages at baseAddress. The mapping is private, so writes to the pages aren't written to the
+	// file. Pages that are beyond the end of the file are replaced with zeroed pages. Returns
+	// Result::notPermitted if the VFD's file can't be mapped.
+	PLATFORM_API VFS::Result mapFilePages(VFS::VFD* vfd,
+										  U64 offset,
+										  U8* baseAddress,
+										  Uptr numPages);
+
+	// Replaces pages, which may have been mapped by mapFilePages, with zeroed read-write pages.
+	PLATFORM_API void unmapFilePages(U8* baseAddress, Uptr numPages);
+
+	enum class PollEventType
+	{
+		read,
+		write,
+	};
+
+	struct PollSubscription
+	{
+		VFS::VFD* vfd;
+		PollEventType type;
+	};
+
+	struct PollEvent
+	{
+		bool isReady;
+		bool isHungUp;
+
+		// For a ready read subscription, the number of bytes that may be read without blocking, or
+		// 0 if it isn't known.
+		U64 numBytes;
+	};
+
+	// Waits for VFDs to be ready to read or write. On Linux, a Poller owns an epoll set and a
+	// timerfd that are reused by every wait, so it should be kept rather than recreated.
+	struct Poller
+	{
+		virtual ~Poller() {}
+
+		// Waits until at least one of the subscriptions is ready, or until getMonotonicClock()
+		// reaches deadline. If deadline is I128::nan(), waits without a time limit. Writes one
+		// PollEvent for each subscription to outEvents.
+		virtual VFS::Result wait(const PollSubscription* subscriptions,
+								 Uptr numSubscriptions,
+								 I128 deadline,
+								 PollEvent* outEvents)
+			= 0;
+	};
+	PLATFORM_API Poller* createPoller();
 }}
@@ -17,6 +17,10 @@ namespace WAVM { namespace Platform {
 	// Returns the base 2 logarithm of the smallest virtual page size.
 	PLATFORM_API Uptr getPageSizeLog2();
 
+	// Returns the base 2 logarithm of the size of the huge pages that adviseHugePages may back
+	// virtual pages with, or 0 if the platform doesn't support transparent huge pages.
+	PLATFORM_API Uptr getHugePageSizeLog2();
+
 	// Allocates virtual addresses without commiting physical pages to them.
 	// Returns the base virtual address of the allocated addresses, or nullptr if the virtual
 	// address space has been exhausted.
@@ -44,9 +48,16 @@ namespace WAVM { namespace Platform {
 										   MemoryAccess access);
 
 	// Decommits the physical memory that was committed to the specified virtual pages.
-	// baseVirtualAddress must be a multiple of the preferred page size.
+	// baseVirtualAddress must be a multiple of the preferred page size. Any huge page advice for
+	// the pages is preserved.
 	PLATFORM_API void decommitVirtualPages(U8* baseVirtualAddress, Uptr numPages);
 
+	// Advises the OS to back the specified virtual pages with huge pages when they are committed.
+	// The pages don't need to be aligned to the huge page size, but only the aligned huge pages
+	// that are entirely committed with the same access may be backed by a huge page.
+	// Returns false if the platform doesn't support transparent huge pages.
+	PLATFORM_API bool adviseHugePages(U8* baseVirtualAddress, Uptr numPages);
+
 	// Frees virtual addresses. baseVirtualAddress must also be the address returned by
 	// allocateVirtualPages.
 	PLATFORM_API void freeVirtualPages(U8* baseVirtualAddress, Uptr numPages);
@@ -3,5 +3,7 @@
 #include "WAVM/Inline/BasicTypes.h"
 
 namespace WAVM { namespace Platform {
+	// Writes cryptographically secure random bytes. On POSIX hosts, the bytes are generated by a
+	// generator for each thread that is seeded from the OS, so small requests don't need a syscall.
 	PLATFORM_API void getCryptographicRNG(U8* outRandomBytes, Uptr numBytes);
 }}
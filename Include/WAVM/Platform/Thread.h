@@ -13,6 +13,45 @@ namespace WAVM { namespace Platform {
 
 	WAVM_RETURNS_TWICE PLATFORM_API Thread* forkCurrentThread();
 
+	// Creates a green thread: a thread that is run by a work-stealing scheduler on a pool of
+	// worker threads, one for each hardware thread, instead of on its own host thread. Green
+	// threads are detached and joined with detachThread and joinThread, and may be forked with
+	// forkCurrentThread.
+	//
+	// A green thread only gives up its worker thread at a switch point: Event::wait, joinThread,
+	// and yieldToAnotherThread. It may be resumed on a different worker thread after a switch
+	// point, so a green thread shares the thread_local variables of whichever worker thread it is
+	// running on. Code that calls a switch point must not depend on the value of a thread_local
+	// variable, or cache its address, across the call, and must not call a switch point in a C++
+	// catch block or while holding a Mutex. The calling thread's catchSignals context and user
+	// data (see setCurrentThreadUserData) are private to each green thread.
+	//
+	// On platforms that don't support green threads, this creates a host thread.
+	PLATFORM_API Thread* createGreenThread(Uptr numStackBytes,
+										   I64 (*threadEntry)(void*),
+										   void* argument);
+
+	// Sets or gets a pointer that is private to the calling thread. Unlike a thread_local variable,
+	// it is private to each green thread. A forked thread starts with null user data.
+	PLATFORM_API void setCurrentThreadUserData(void* userData);
+	PLATFORM_API void* getCurrentThreadUserData();
+
+	// Marks the calling thread as being in a call that may block its host thread for a long time,
+	// e.g. to wait for I/O. If the calling thread is a green thread, another worker thread runs
+	// the other green threads until the matching exitBlockingCall.
+	PLATFORM_API void enterBlockingCall();
+	PLATFORM_API void exitBlockingCall();
+
+	// Calls enterBlockingCall when constructed, and exitBlockingCall when destroyed.
+	struct BlockingCallScope
+	{
+		BlockingCallScope() { enterBlockingCall(); }
+		~BlockingCallScope() { exitBlockingCall(); }
+
+		BlockingCallScope(const BlockingCallScope&) = delete;
+		void operator=(const BlockingCallScope&) = delete;
+	};
+
 	PLATFORM_API Uptr getNumberOfHardwareThreads();
 
 	PLATFORM_API void yieldToAnotherThread();
@@ -115,4 +115,39 @@ namespace WAVM { namespace Runtime {
 	};
 
 	RUNTIME_API LinkResult linkModule(const IR::Module& module, Resolver& resolver);
+
+	// A link plan maps each of a module's imports to an export of one of a list of module
+	// instances. It allows linking a module against many instances of the same modules (e.g. the
+	// intrinsic modules instantiated for each process) without resolving its imports by name.
+	struct LinkPlan
+	{
+		struct ImportSource
+		{
+			Uptr moduleInstanceIndex;
+			Uptr exportIndex;
+
+			// The import's name and type, to check the export against when linking.
+			std::string moduleName;
+			std::string exportName;
+			IR::ExternType type;
+		};
+
+		std::vector<LinkResult::MissingImport> missingImports;
+		std::vector<ImportSource> importSources;
+		bool success;
+	};
+
+	// Creates a link plan by linking a module using the given resolver. Imports that the resolver
+	// fails to resolve, or resolves to an object that isn't exported by any of moduleInstances,
+	// are added to the plan's missingImports.
+	RUNTIME_API LinkPlan createLinkPlan(const IR::Module& module,
+										Resolver& resolver,
+										const std::vector<ModuleInstance*>& moduleInstances);
+
+	// Links a module using a link plan that was created for it. moduleInstances must be instances
+	// of the same modules that were passed to createLinkPlan, in the same order. Imports whose
+	// planned export doesn't exist or doesn't match the import's type are added to the result's
+	// missingImports.
+	RUNTIME_API LinkResult linkModule(const LinkPlan& linkPlan,
+									  const std::vector<ModuleInstance*>& moduleInstances);
 }}
\ No newline at end of file
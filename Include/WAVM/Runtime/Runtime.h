@@ -9,12 +9,19 @@
 #include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Platform/Diagnostics.h"
+#include "WAVM/Runtime/RuntimeData.h"
 
 // Declare IR::Module to avoid including the definition.
 namespace WAVM { namespace IR {
 	struct Module;
 }}
 
+// Declare VFS::VFD and VFS::Result to avoid including their definitions.
+namespace WAVM { namespace VFS {
+	struct VFD;
+	enum class Result : I32;
+}}
+
 // Declare the different kinds of objects. They are only declared as incomplete struct types here,
 // and Runtime clients will only handle opaque pointers to them.
 #define WAVM_DECLARE_OBJECT_TYPE(kindId, kindName, Type)                                           \
@@ -320,10 +327,14 @@ namespace WAVM { namespace Runtime {
 	//
 
 	// Creates a Memory. May return null if the memory allocation fails.
-	RUNTIME_API Memory* createMemory(Compartment* compartment,
-									 IR::MemoryType type,
-									 std::string&& debugName,
-									 ResourceQuotaRefParam resourceQuota = ResourceQuotaRef());
+	// A memory created with MemoryBoundsCheckMode::explicitChecks reserves much less address space,
+	// but may only be imported by modules compiled with MemoryBoundsCheckMode::explicitChecks.
+	RUNTIME_API Memory* createMemory(
+		Compartment* compartment,
+		IR::MemoryType type,
+		std::string&& debugName,
+		ResourceQuotaRefParam resourceQuota = ResourceQuotaRef(),
+		MemoryBoundsCheckMode boundsCheckMode = MemoryBoundsCheckMode::guardRegion);
 
 	// Gets the base address of the memory's data.
 	RUNTIME_API U8* getMemoryBaseAddress(Memory* memory);
@@ -334,12 +345,35 @@ namespace WAVM { namespace Runtime {
 	// Returns the type of a memory.
 	RUNTIME_API IR::MemoryType getMemoryType(const Memory* memory);
 
+	// Returns the number of bytes of address space reserved for the memory, excluding guard pages.
+	RUNTIME_API Uptr getMemoryNumReservedBytes(const Memory* memory);
+
+	// Sets whether memories and compiled code that are created after the call are backed by
+	// transparent huge pages on platforms that support them. Defaults to false.
+	RUNTIME_API void setHugePagesEnabled(bool enable);
+
 	// Grows or shrinks the size of a memory by numPages. Returns the previous size of the memory.
 	RUNTIME_API bool growMemory(Memory* memory, Uptr numPages, Uptr* outOldNumPages = nullptr);
 
-	// Unmaps a range of memory pages within the memory's address-space.
+	// Unmaps a range of memory pages within the memory's address-space. Pages that were mapped by
+	// mapFileIntoMemory are unmapped from the file, so they are zeroed if they are committed again.
 	RUNTIME_API void unmapMemoryPages(Memory* memory, Uptr pageIndex, Uptr numPages);
 
+	// Maps numPages pages of a VFD's file, starting at the page-aligned fileOffset, over a range of
+	// the memory's pages, which must be within its current size. If the host can map the file,
+	// reads of the pages are served directly from the host's page cache; otherwise the file is
+	// read into the pages. Writes to the pages aren't written to the file, and pages beyond the
+	// end of the file are zeroed.
+	RUNTIME_API VFS::Result mapFileIntoMemory(Memory* memory,
+											  Uptr pageIndex,
+											  Uptr numPages,
+											  VFS::VFD* vfd,
+											  U64 fileOffset);
+
+	// Replaces a range of memory pages, which may have been mapped by mapFileIntoMemory, with
+	// zeroed pages.
+	RUNTIME_API void unmapFileFromMemory(Memory* memory, Uptr pageIndex, Uptr numPages);
+
 	// Validates that an offset range is wholly inside a Memory's virtual address range.
 	// Note that this returns an address range that may fault on access, though it's guaranteed not
 	// to be mapped by anything other than the given Memory.
@@ -348,6 +382,12 @@ namespace WAVM { namespace Runtime {
 	// Validates that an offset range is wholly inside a Memory's committed pages.
 	RUNTIME_API U8* getValidatedMemoryOffsetRange(Memory* memory, Uptr offset, Uptr numBytes);
 
+	// Calls thunk(argument), and returns true if it faulted on an access to the memory's reserved
+	// address space. Unlike catchRuntimeExceptions, this doesn't allocate or throw an exception for
+	// the fault, so the thunk must not depend on destructors running if it faults. Other signals are
+	// passed through to the enclosing signal handler.
+	RUNTIME_API bool catchMemoryFaults(Memory* memory, void (*thunk)(void*), void* argument);
+
 	// Validates an access to a single element of memory at the given offset, and returns a
 	// reference to it.
 	template<typename Value> Value& memoryRef(Memory* memory, Uptr offset)
@@ -362,6 +402,19 @@ namespace WAVM { namespace Runtime {
 		return (Value*)getValidatedMemoryOffsetRange(memory, offset, numElements * sizeof(Value));
 	}
 
+	// Blocks the calling thread until the 32-bit value at the given offset is woken by
+	// wakeMemoryAddress, or timeout nanoseconds elapse. If the value isn't expectedValue, returns
+	// immediately. A negative timeout waits forever. Returns 0 if woken, 1 if the value wasn't
+	// expectedValue, or 2 if the wait timed out, like memory.atomic.wait32.
+	RUNTIME_API U32 waitOnMemoryAddress(Memory* memory,
+										Uptr offset,
+										U32 expectedValue,
+										I64 timeout);
+
+	// Wakes up to numToWake threads waiting on the given offset, and returns the number of threads
+	// that were woken. numToWake==UINT32_MAX wakes all waiting threads.
+	RUNTIME_API U32 wakeMemoryAddress(Memory* memory, Uptr offset, U32 numToWake);
+
 	//
 	// Globals
 	//
@@ -395,21 +448,60 @@ namespace WAVM { namespace Runtime {
 	typedef const std::shared_ptr<Module>& ModuleRefParam;
 	typedef const std::shared_ptr<const Module>& ModuleConstRefParam;
 
-	// Compiles an IR module to object code.
-	RUNTIME_API ModuleRef compileModule(const IR::Module& irModule);
+	// Compiles an IR module to object code. The memories defined by the module will be created
+	// with the same bounds check mode it was compiled with. CodegenMode::fastUnoptimized compiles
+	// faster, but generates slower code.
+	RUNTIME_API ModuleRef compileModule(
+		const IR::Module& irModule,
+		MemoryBoundsCheckMode boundsCheckMode = MemoryBoundsCheckMode::guardRegion,
+		CodegenMode codegenMode = CodegenMode::optimized);
 
 	// Extracts the compiled object code for a module. This may be used as an input to
 	// loadPrecompiledModule to bypass redundant compilations of the module.
 	RUNTIME_API std::vector<U8> getObjectCode(ModuleConstRefParam module);
 
 	// Loads a previously compiled module from a combination of an IR module and the object code
-	// returned by getObjectCode for the previously compiled module.
-	RUNTIME_API ModuleRef loadPrecompiledModule(const IR::Module& irModule,
-												const std::vector<U8>& objectCode);
-
-	// Accesses the IR for a compiled module.
+	// returned by getObjectCode for the previously compiled module. boundsCheckMode must be the
+	// mode that the object code was compiled with.
+	RUNTIME_API ModuleRef loadPrecompiledModule(
+		const IR::Module& irModule,
+		const std::vector<U8>& objectCode,
+		MemoryBoundsCheckMode boundsCheckMode = MemoryBoundsCheckMode::guardRegion);
+
+	// Adds a "wavm.precompiled_object" user section to an IR module that records the module's
+	// object code and the bounds check mode it was compiled with.
+	RUNTIME_API void addPrecompiledObjectSection(IR::Module& irModule,
+												 const std::vector<U8>& objectCode,
+												 MemoryBoundsCheckMode boundsCheckMode);
+
+	// Loads a previously compiled module from an IR module with a "wavm.precompiled_object" user
+	// section added by addPrecompiledObjectSection. Logs an error and returns null if the module
+	// doesn't have a valid section, or if its object code wasn't compiled with boundsCheckMode.
+	RUNTIME_API ModuleRef loadPrecompiledModule(
+		const IR::Module& irModule,
+		MemoryBoundsCheckMode boundsCheckMode = MemoryBoundsCheckMode::guardRegion);
+
+	// Accesses the IR for a compiled module. If the module's code was released by
+	// releaseModuleCode, the IR's function definitions will not include their bodies.
 	RUNTIME_API const IR::Module& getModuleIR(ModuleConstRefParam module);
 
+	// Returns a copy of the IR for a compiled module, including any function bodies that were
+	// released by releaseModuleCode.
+	RUNTIME_API IR::Module getModuleIRWithCode(ModuleConstRefParam module);
+
+	// Re-materializes the code of a module that was released by releaseModuleCode: it must produce
+	// the IR module that the module was created from, and the object code it was compiled to. It
+	// isn't called with any locks held, and may be called by multiple threads at once.
+	typedef std::function<void(IR::Module& outIRModule, std::vector<U8>& outObjectCode)>
+		ModuleCodeLoader;
+
+	// Releases a module's function bodies and object code to reduce its memory usage. When they are
+	// needed again to instantiate the module, or by getObjectCode and getModuleIRWithCode, they are
+	// re-materialized by calling codeLoader, and released again afterwards. It is safe to call
+	// while other threads instantiate the module, but the function bodies in the IR returned by
+	// getModuleIR are freed.
+	RUNTIME_API void releaseModuleCode(ModuleRefParam module, ModuleCodeLoader&& codeLoader);
+
 	//
 	// Instances
 	//
@@ -417,7 +509,9 @@ namespace WAVM { namespace Runtime {
 	typedef std::vector<Object*> ImportBindings;
 
 	// Instantiates a compiled module, bindings its imports to the specified objects. May throw a
-	// runtime exception for bad segment offsets.
+	// runtime exception for bad segment offsets, or an invalidArgument exception if a module
+	// compiled with MemoryBoundsCheckMode::guardRegion imports a memory created with
+	// MemoryBoundsCheckMode::explicitChecks.
 	RUNTIME_API ModuleInstance* instantiateModule(Compartment* compartment,
 												  ModuleConstRefParam module,
 												  ImportBindings&& imports,
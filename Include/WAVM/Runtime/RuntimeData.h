@@ -6,6 +6,8 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
+#include <string>
 
 #include "WAVM/IR/Types.h"
 #include "WAVM/IR/Value.h"
@@ -55,6 +57,33 @@ namespace WAVM { namespace Runtime {
 	static_assert(Uptr(IR::ExternKind::exceptionType) == Uptr(ObjectKind::exceptionType),
 				  "IR::ExternKind::exceptionType != ObjectKind::exceptionType");
 
+	// How the compiled code that accesses a memory ensures the accesses are within the memory.
+	enum class MemoryBoundsCheckMode : U8
+	{
+		// Reserve 8GB of address space for each memory, so any 32-bit address + 32-bit offset is
+		// within the memory's reservation, and omit explicit bounds checks: an out-of-bounds access
+		// faults on a page that isn't committed.
+		guardRegion,
+
+		// Reserve address space for each memory's maximum size plus a guard page, and emit an
+		// explicit bounds check for each access. Code compiled with this mode may access memories
+		// created with either mode.
+		explicitChecks,
+	};
+
+	// How much work the JIT does to optimize the code it generates.
+	enum class CodegenMode : U8
+	{
+		// Run LLVM's IR optimizations, and its optimizing instruction selector and register
+		// allocator.
+		optimized,
+
+		// Fast/unoptimized codegen: only promote locals to SSA values, and use LLVM's fast
+		// instruction selector and register allocator. This reduces the time to compile a module at
+		// the expense of the speed of its code.
+		fastUnoptimized,
+	};
+
 #define wavmCompartmentReservedBytes (2ull * 1024 * 1024 * 1024)
 
 	enum
@@ -151,17 +180,38 @@ namespace WAVM { namespace Runtime {
 		Uptr numCodeBytes = 0;
 		std::atomic<Uptr> numRootReferences{0};
 		std::map<U32, U32> offsetToOpIndexMap;
-		std::string debugName;
 		std::atomic<InvokeThunkPointer> invokeThunk{nullptr};
 		void* userData{nullptr};
 		void (*finalizeUserData)(void*);
 
+		// The function's debug name is debugNamePrefix followed by debugName. The functions defined
+		// by a module instance share the instance's prefix and their module's cached names, so
+		// instantiating a module doesn't allocate a name for each function.
+		std::shared_ptr<const std::string> debugNamePrefix;
+		std::shared_ptr<const std::string> debugName;
+
 		FunctionMutableData(std::string&& inDebugName)
-		: debugName(inDebugName), userData(nullptr), finalizeUserData(nullptr)
+		: userData(nullptr)
+		, finalizeUserData(nullptr)
+		, debugName(std::make_shared<const std::string>(std::move(inDebugName)))
+		{
+		}
+
+		FunctionMutableData(std::shared_ptr<const std::string>&& inDebugNamePrefix,
+							std::shared_ptr<const std::string>&& inDebugName)
+		: userData(nullptr)
+		, finalizeUserData(nullptr)
+		, debugNamePrefix(std::move(inDebugNamePrefix))
+		, debugName(std::move(inDebugName))
 		{
 		}
 
 		~FunctionMutableData();
+
+		std::string getDebugName() const
+		{
+			return debugNamePrefix ? *debugNamePrefix + *debugName : *debugName;
+		}
 	};
 
 	struct Function
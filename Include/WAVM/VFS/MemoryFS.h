@@ -0,0 +1,12 @@
+#pragma once
+
+#include "WAVM/Inline/BasicTypes.h"
+
+namespace WAVM { namespace VFS {
+	struct FileSystem;
+
+	// Creates a thread-safe filesystem that keeps its files in memory. The total number of bytes
+	// allocated for the contents of its files is limited to maxFileBytes. The filesystem may be
+	// deleted while VFDs for its files are still open.
+	VFS_API FileSystem* makeMemoryFS(U64 maxFileBytes = UINT64_MAX);
+}}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace WAVM { namespace VFS {
+	struct FileSystem;
+
+	// Creates a filesystem that forwards paths beneath mountPath to mountedFS, with mountPath
+	// stripped, and all other paths to rootFS. Doesn't take ownership of either filesystem.
+	VFS_API FileSystem* makeMountFS(FileSystem* rootFS,
+									const std::string& mountPath,
+									FileSystem* mountedFS);
+}}
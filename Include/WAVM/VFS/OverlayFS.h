@@ -0,0 +1,12 @@
+#pragma once
+
+namespace WAVM { namespace VFS {
+	struct FileSystem;
+
+	// Creates a filesystem that layers the writable upperFS over the read-only lowerFS. Files in
+	// lowerFS are read directly from it until they are written, when they are copied to upperFS.
+	// Files removed from lowerFS are only hidden. Doesn't take ownership of either filesystem, and
+	// VFDs for directories or lowerFS files opened from the overlay must be closed before it is
+	// deleted.
+	VFS_API FileSystem* makeOverlayFS(FileSystem* lowerFS, FileSystem* upperFS);
+}}
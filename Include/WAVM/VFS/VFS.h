@@ -212,6 +212,14 @@ namespace WAVM { namespace VFS {
 
 		virtual Result openDir(DirEntStream*& outStream) = 0;
 
+		// Returns the host file descriptor that Platform::Poller waits on to know when the VFD is
+		// ready to be read or written, or -1 if reads and writes of the VFD never block.
+		virtual I32 getPollableHostFD() { return -1; }
+
+		// Returns the host file descriptor that Platform::mapFilePages maps the VFD's file from,
+		// or -1 if the VFD's file can't be mapped.
+		virtual I32 getMappableHostFD() { return -1; }
+
 		Result read(void* outData,
 					Uptr numBytes,
 					Uptr* outNumBytesRead = nullptr,
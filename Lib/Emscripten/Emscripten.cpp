@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <atomic>
 #include <initializer_list>
 #include <memory>
 #include <new>
@@ -22,9 +23,12 @@
 #include "WAVM/Inline/FloatComponents.h"
 #include "WAVM/Inline/Hash.h"
 #include "WAVM/Inline/HashMap.h"
+#include "WAVM/Inline/Lock.h"
 #include "WAVM/Logging/Logging.h"
 #include "WAVM/Platform/Clock.h"
 #include "WAVM/Platform/Defines.h"
+#include "WAVM/Platform/Mutex.h"
+#include "WAVM/Platform/Thread.h"
 #include "WAVM/Runtime/Intrinsics.h"
 #include "WAVM/Runtime/Runtime.h"
 #include "WAVM/VFS/VFS.h"
@@ -69,7 +73,12 @@ enum
 
 enum ErrNo
 {
-	einval = 22
+	eperm = 1,
+	esrch = 3,
+	eagain = 11,
+	einval = 22,
+	edeadlk = 35,
+	etimedout = 110
 };
 
 struct MutableGlobals
@@ -164,18 +173,37 @@ static U32 dynamicAlloc(Emscripten::Instance* instance, U32 numBytes)
 	MutableGlobals& mutableGlobals
 		= memoryRef<MutableGlobals>(instance->memory, MutableGlobals::address);
 
-	const U32 allocationAddress = mutableGlobals.DYNAMICTOP_PTR;
-	const U32 endAddress = (allocationAddress + numBytes + 15) & -16;
-
-	mutableGlobals.DYNAMICTOP_PTR = endAddress;
+	// Atomically bump DYNAMICTOP_PTR, since it may be concurrently bumped by other threads, and by
+	// the sbrk compiled into the Emscripten module.
+	static_assert(sizeof(std::atomic<U32>) == sizeof(U32), "relying on non-standard behavior");
+	std::atomic<U32>& dynamicTop = *(std::atomic<U32>*)&mutableGlobals.DYNAMICTOP_PTR;
+	U32 allocationAddress = dynamicTop.load();
+	U32 endAddress;
+	do
+	{
+		const U64 unalignedEndAddress = U64(allocationAddress) + numBytes;
+		if(unalignedEndAddress > UINT32_MAX - 15) { throwException(ExceptionTypes::outOfMemory); }
+		endAddress = U32(unalignedEndAddress + 15) & -16;
+	} while(!dynamicTop.compare_exchange_weak(allocationAddress, endAddress));
 
 	if(endAddress > getMemoryNumPages(instance->memory) * IR::numBytesPerPage)
 	{
 		Uptr memoryMaxPages = getMemoryType(instance->memory).size.max;
 		if(memoryMaxPages == UINT64_MAX) { memoryMaxPages = IR::maxMemoryPages; }
 
-		if(endAddress > memoryMaxPages * IR::numBytesPerPage || !resizeHeap(instance, endAddress))
-		{ throwException(ExceptionTypes::outOfMemory); }
+		// Another thread may grow the memory between checking its size and resizeHeap, so only
+		// fail if the memory is still too small.
+		if(endAddress > memoryMaxPages * IR::numBytesPerPage
+		   || (!resizeHeap(instance, endAddress)
+			   && endAddress > getMemoryNumPages(instance->memory) * IR::numBytesPerPage))
+		{
+			// Give back the allocation, so later smaller allocations may still succeed. If another
+			// thread has allocated after it, DYNAMICTOP can't be moved back without freeing that
+			// allocation too, so the failed allocation's address space is left unused.
+			U32 expectedEndAddress = endAddress;
+			dynamicTop.compare_exchange_strong(expectedEndAddress, allocationAddress);
+			throwException(ExceptionTypes::outOfMemory);
+		}
 	}
 
 	return allocationAddress;
@@ -253,22 +281,231 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_sysconf", I32, _sysconf, I32 a)
 	}
 }
 
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_cond_wait", I32, _pthread_cond_wait, I32 a, I32 b)
+// Emscripten's musl pthread_mutex_t, pthread_cond_t, and pthread_once_t are implemented by WAVM on
+// words of the shared memory, using the same wait/wake machinery as the WebAssembly atomic
+// operators:
+// - The mutex's _m_type word holds the PTHREAD_MUTEX_* type, its _m_lock word holds the ID of the
+//   thread that owns it (with mutexWaitersBit set if other threads may be waiting for it), and its
+//   _m_count word holds the number of times a recursive mutex was locked again by its owner.
+// - The condition variable's first word is a sequence number that is incremented by each signal
+//   or broadcast.
+// - The once flag is 0 before the init routine runs, 1 while it runs, and 2 after it returns.
+enum
+{
+	mutexTypeOffset = 0,
+	mutexLockOffset = 4,
+	mutexCountOffset = 20,
+	mutexWaitersBit = 0x80000000,
+
+	mutexTypeNormal = 0,
+	mutexTypeRecursive = 1,
+	mutexTypeErrorCheck = 2,
+
+	onceNotRun = 0,
+	onceRunning = 1,
+	onceDone = 2,
+
+	numThreadStackBytes = 2 * 1024 * 1024,
+	numThreadHostStackBytes = 1 * 1024 * 1024
+};
+
+static std::atomic<U32>& atomicMemoryRef(Memory* memory, U32 address)
+{
+	static_assert(sizeof(std::atomic<U32>) == sizeof(U32), "relying on non-standard behavior");
+	if(address & 3)
+	{ throwException(ExceptionTypes::misalignedAtomicMemoryAccess, {U64(address)}); }
+	return *(std::atomic<U32>*)&memoryRef<U32>(memory, address);
+}
+
+// Each host thread that calls into the Emscripten module is given a non-zero pthread_t when it
+// first needs one. Threads created by pthread_create are given their ID before they start.
+static std::atomic<U32> nextThreadId{1};
+thread_local U32 currentThreadId = 0;
+
+static U32 getCurrentThreadId()
+{
+	if(!currentThreadId) { currentThreadId = nextThreadId++; }
+	return currentThreadId;
+}
+
+static Function* getTableFunction(Emscripten::Instance* instance,
+								  U32 elementIndex,
+								  FunctionType expectedType)
+{
+	Function* function = asFunctionNullable(getTableElement(instance->table, elementIndex));
+	if(!function || getFunctionType(function) != expectedType)
+	{ throwException(ExceptionTypes::indirectCallSignatureMismatch); }
+	return function;
+}
+
+static I32 lockMutex(Memory* memory, U32 mutexAddress)
+{
+	const U32 type = memoryRef<U32>(memory, mutexAddress + mutexTypeOffset) & 3;
+	std::atomic<U32>& lockWord = atomicMemoryRef(memory, mutexAddress + mutexLockOffset);
+	const U32 threadId = getCurrentThreadId();
+
+	// Try to acquire an unlocked mutex without waiting.
+	U32 lockValue = 0;
+	if(lockWord.compare_exchange_strong(lockValue, threadId)) { return 0; }
+
+	if((lockValue & ~U32(mutexWaitersBit)) == threadId)
+	{
+		if(type == mutexTypeRecursive)
+		{
+			U32& count = memoryRef<U32>(memory, mutexAddress + mutexCountOffset);
+			if(count == UINT32_MAX) { return ErrNo::eagain; }
+			++count;
+			return 0;
+		}
+		else if(type == mutexTypeErrorCheck)
+		{
+			return ErrNo::edeadlk;
+		}
+	}
+
+	// Set the waiters bit, and wait for the owner to unlock the mutex. Once a thread has waited
+	// for the mutex, it acquires it with the waiters bit set, since there may be other waiting
+	// threads that the unlock must wake.
+	while(true)
+	{
+		lockValue = lockWord.load();
+		if(!lockValue)
+		{
+			if(lockWord.compare_exchange_weak(lockValue, threadId | mutexWaitersBit)) { return 0; }
+		}
+		else if((lockValue & mutexWaitersBit)
+				|| lockWord.compare_exchange_weak(lockValue, lockValue | mutexWaitersBit))
+		{
+			waitOnMemoryAddress(
+				memory, mutexAddress + mutexLockOffset, lockValue | mutexWaitersBit, -1);
+		}
+	};
+}
+
+static I32 unlockMutex(Memory* memory, U32 mutexAddress)
+{
+	const U32 type = memoryRef<U32>(memory, mutexAddress + mutexTypeOffset) & 3;
+	std::atomic<U32>& lockWord = atomicMemoryRef(memory, mutexAddress + mutexLockOffset);
+
+	if(type != mutexTypeNormal)
+	{
+		if((lockWord.load() & ~U32(mutexWaitersBit)) != getCurrentThreadId())
+		{ return ErrNo::eperm; }
+
+		U32& count = memoryRef<U32>(memory, mutexAddress + mutexCountOffset);
+		if(count)
+		{
+			--count;
+			return 0;
+		}
+	}
+
+	if(lockWord.exchange(0) & mutexWaitersBit)
+	{ wakeMemoryAddress(memory, mutexAddress + mutexLockOffset, 1); }
+	return 0;
+}
+
+// Waits for the condition variable to be signaled, or for timeout nanoseconds to elapse if
+// timeout is non-negative.
+static I32 waitOnCondition(Memory* memory, U32 condAddress, U32 mutexAddress, I64 timeout)
 {
+	const U32 sequence = atomicMemoryRef(memory, condAddress).load();
+
+	const I32 unlockResult = unlockMutex(memory, mutexAddress);
+	if(unlockResult) { return unlockResult; }
+
+	const U32 waitResult = waitOnMemoryAddress(memory, condAddress, sequence, timeout);
+
+	const I32 lockResult = lockMutex(memory, mutexAddress);
+	if(lockResult) { return lockResult; }
+
+	return waitResult == 2 ? ErrNo::etimedout : 0;
+}
+
+static void signalCondition(Memory* memory, U32 condAddress, U32 numToWake)
+{
+	atomicMemoryRef(memory, condAddress)++;
+	wakeMemoryAddress(memory, condAddress, numToWake);
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_init",
+							   I32,
+							   _pthread_cond_init,
+							   U32 condAddress,
+							   U32 attrAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	atomicMemoryRef(instance->memory, condAddress).store(0);
 	return 0;
 }
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_cond_broadcast", I32, _pthread_cond_broadcast, I32 a)
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_destroy",
+							   I32,
+							   _pthread_cond_destroy,
+							   U32 condAddress)
 {
 	return 0;
 }
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_wait",
+							   I32,
+							   _pthread_cond_wait,
+							   U32 condAddress,
+							   U32 mutexAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	return waitOnCondition(instance->memory, condAddress, mutexAddress, -1);
+}
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_timedwait",
+							   I32,
+							   _pthread_cond_timedwait,
+							   U32 condAddress,
+							   U32 mutexAddress,
+							   U32 abstimeAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+
+	// Convert the absolute CLOCK_REALTIME timespec to a relative timeout.
+	const I32 seconds = memoryRef<I32>(instance->memory, abstimeAddress + 0);
+	const I32 nanoseconds = memoryRef<I32>(instance->memory, abstimeAddress + 4);
+	if(nanoseconds < 0 || nanoseconds >= 1000000000) { return ErrNo::einval; }
+	const I128 deadline = I128(seconds) * 1000000000 + nanoseconds;
+	const I128 timeout = deadline - Platform::getRealtimeClock();
+
+	return waitOnCondition(
+		instance->memory, condAddress, mutexAddress, timeout > 0 ? I64(timeout) : 0);
+}
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_signal",
+							   I32,
+							   _pthread_cond_signal,
+							   U32 condAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	signalCondition(instance->memory, condAddress, 1);
+	return 0;
+}
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_cond_broadcast",
+							   I32,
+							   _pthread_cond_broadcast,
+							   U32 condAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	signalCondition(instance->memory, condAddress, UINT32_MAX);
+	return 0;
+}
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_equal", I32, _pthread_equal, I32 a, I32 b)
 {
 	return a == b;
 }
 
-static HashMap<U32, I32> pthreadSpecific = {};
-static U32 pthreadSpecificNextKey = 0;
+// pthread_key_t values are allocated for all threads, but each thread has its own values for them.
+static std::atomic<U32> pthreadSpecificNextKey{0};
+thread_local HashMap<U32, I32> pthreadSpecific;
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   "_pthread_key_create",
@@ -280,19 +517,27 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 	if(key == 0) { return ErrNo::einval; }
 
 	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
-	memoryRef<U32>(instance->memory, key) = pthreadSpecificNextKey;
-	pthreadSpecific.set(pthreadSpecificNextKey, 0);
-	pthreadSpecificNextKey++;
+	memoryRef<U32>(instance->memory, key) = pthreadSpecificNextKey++;
 
 	return 0;
 }
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_mutex_lock", I32, _pthread_mutex_lock, I32 a)
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_mutex_lock",
+							   I32,
+							   _pthread_mutex_lock,
+							   U32 mutexAddress)
 {
-	return 0;
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	return lockMutex(instance->memory, mutexAddress);
 }
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_mutex_unlock", I32, _pthread_mutex_unlock, I32 a)
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_mutex_unlock",
+							   I32,
+							   _pthread_mutex_unlock,
+							   U32 mutexAddress)
 {
-	return 0;
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	return unlockMutex(instance->memory, mutexAddress);
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   "_pthread_setspecific",
@@ -301,7 +546,7 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   U32 key,
 							   I32 value)
 {
-	if(!pthreadSpecific.contains(key)) { return ErrNo::einval; }
+	if(key >= pthreadSpecificNextKey) { return ErrNo::einval; }
 	pthreadSpecific.set(key, value);
 	return 0;
 }
@@ -310,9 +555,46 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_getspecific", I32, _pthread_getspe
 	const I32* value = pthreadSpecific.get(key);
 	return value ? *value : 0;
 }
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_once", I32, _pthread_once, I32 a, I32 b)
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_once",
+							   I32,
+							   _pthread_once,
+							   U32 onceAddress,
+							   U32 initRoutine)
 {
-	throwException(Runtime::ExceptionTypes::calledUnimplementedIntrinsic);
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	std::atomic<U32>& state = atomicMemoryRef(instance->memory, onceAddress);
+
+	while(true)
+	{
+		U32 stateValue = onceNotRun;
+		if(state.compare_exchange_strong(stateValue, onceRunning))
+		{
+			// If the init routine throws an exception, reset the state so another call can run it,
+			// and wake the waiting threads before passing the exception on.
+			catchRuntimeExceptions(
+				[&] {
+					Function* initFunction = getTableFunction(
+						instance, initRoutine, FunctionType(TypeTuple{}, TypeTuple{}));
+					invokeFunctionChecked(
+						getContextFromRuntimeData(contextRuntimeData), initFunction, {});
+				},
+				[&](Exception* exception) {
+					state.store(onceNotRun);
+					wakeMemoryAddress(instance->memory, onceAddress, UINT32_MAX);
+					throwException(exception);
+				});
+
+			state.store(onceDone);
+			wakeMemoryAddress(instance->memory, onceAddress, UINT32_MAX);
+			return 0;
+		}
+		else if(stateValue == onceDone) { return 0; }
+
+		// Wait for the thread that is running the init routine to finish. If it fails, the state
+		// is reset to onceNotRun, and this thread tries to run the init routine.
+		waitOnMemoryAddress(instance->memory, onceAddress, onceRunning, -1);
+	};
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   "_pthread_cleanup_push",
@@ -323,10 +605,222 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 {
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_cleanup_pop", void, _pthread_cleanup_pop, I32 a) {}
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_self", I32, _pthread_self) { return 0; }
+WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_self", U32, _pthread_self)
+{
+	return getCurrentThreadId();
+}
+
+// Calls the Emscripten module's establishStackSpace function to set its internal stack pointers
+// in a context. The stack pointers are mutable globals, so each context has its own. Returns false
+// if the module doesn't export an establishStackSpace function with the expected (i32, i32)->()
+// signature.
+static bool establishStackSpace(Emscripten::Instance* instance,
+								Context* context,
+								I32 stackTop,
+								I32 stackMax)
+{
+	Function* establishStackSpaceFunction
+		= asFunctionNullable(getInstanceExport(instance->moduleInstance, "establishStackSpace"));
+	if(!establishStackSpaceFunction
+	   || getFunctionType(establishStackSpaceFunction)
+			  != FunctionType(TypeTuple{}, TypeTuple{ValueType::i32, ValueType::i32}))
+	{ return false; }
+
+	std::vector<IR::Value> parameters = {IR::Value(stackTop), IR::Value(stackMax)};
+	Runtime::invokeFunctionChecked(context, establishStackSpaceFunction, parameters);
+	return true;
+}
+
+// A thread created by pthread_create. Each thread runs in its own Context, and has its own stack
+// in the Emscripten module's memory. The Thread is deleted by the thread that joins it, or if it is
+// detached, by whichever of the thread and _pthread_detach finishes last.
+struct Thread
+{
+	Emscripten::Instance* instance;
+	U32 id;
+	U32 stackAddress;
+	GCPointer<Context> context;
+	GCPointer<Function> entryFunction;
+	U32 argument;
+	Platform::Thread* platformThread = nullptr;
+
+	// The following are guarded by threadsMutex once the thread is started.
+	I32 result = 0;
+	Exception* exception = nullptr;
+	bool exited = false;
+	bool detached = false;
+};
 
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_attr_init", I32, _pthread_attr_init, I32 address)
+// The pthreads that haven't been joined or detached, and a lock that also guards the Thread
+// objects and the stacks in each Emscripten::Instance::freeThreadStackAddresses.
+static Platform::Mutex threadsMutex;
+static HashMap<U32, Thread*> threads;
+
+// The Thread running on this host thread, or null if the host thread wasn't created by
+// pthread_create.
+thread_local Thread* currentThread = nullptr;
+
+static void logDetachedThreadException(Thread* thread)
+{
+	Log::printf(Log::error,
+				"Runtime exception in detached pthread %u: %s\n",
+				thread->id,
+				describeException(thread->exception).c_str());
+	destroyException(thread->exception);
+}
+
+static I64 threadEntry(void* threadVoid)
+{
+	Thread* thread = (Thread*)threadVoid;
+	currentThreadId = thread->id;
+	currentThread = thread;
+
+	// If the thread traps, keep the exception to rethrow in the thread that joins it.
+	I32 result = 0;
+	Exception* exception = nullptr;
+	catchRuntimeExceptions(
+		[thread, &result] {
+			UntaggedValue argument{thread->argument};
+			result
+				= invokeFunctionUnchecked(thread->context, thread->entryFunction, &argument)->i32;
+		},
+		[&exception](Exception* caughtException) { exception = caughtException; });
+
+	currentThread = nullptr;
+
+	Lock<Platform::Mutex> threadsLock(threadsMutex);
+	thread->instance->freeThreadStackAddresses.push_back(thread->stackAddress);
+	thread->result = result;
+	thread->exception = exception;
+	thread->exited = true;
+	if(thread->detached)
+	{
+		if(thread->exception) { logDetachedThreadException(thread); }
+		delete thread;
+	}
+
+	return result;
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_create",
+							   I32,
+							   _pthread_create,
+							   U32 threadAddress,
+							   U32 attrAddress,
+							   U32 entryFunctionIndex,
+							   U32 argument)
 {
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	Function* entryFunction
+		= getTableFunction(instance,
+						   entryFunctionIndex,
+						   FunctionType(TypeTuple{ValueType::i32}, TypeTuple{ValueType::i32}));
+
+	// Reuse the stack of an exited thread, or allocate a new stack.
+	U32 stackAddress = 0;
+	{
+		Lock<Platform::Mutex> threadsLock(threadsMutex);
+		if(instance->freeThreadStackAddresses.size())
+		{
+			stackAddress = instance->freeThreadStackAddresses.back();
+			instance->freeThreadStackAddresses.pop_back();
+		}
+	}
+	if(!stackAddress) { stackAddress = dynamicAlloc(instance, numThreadStackBytes); }
+
+	// Create a Context for the thread, and point its stack pointers at the thread's stack. If the
+	// module doesn't allow that, the thread would share the calling thread's stack, so fail.
+	Context* context = createContext(getCompartmentFromContextRuntimeData(contextRuntimeData));
+	if(!establishStackSpace(instance, context, stackAddress, stackAddress + numThreadStackBytes))
+	{
+		Lock<Platform::Mutex> threadsLock(threadsMutex);
+		instance->freeThreadStackAddresses.push_back(stackAddress);
+		return ErrNo::eagain;
+	}
+
+	Thread* thread
+		= new Thread{instance, nextThreadId++, stackAddress, context, entryFunction, argument};
+	memoryRef<U32>(instance->memory, threadAddress) = thread->id;
+
+	// Hold the lock while creating the platform thread, so the new thread can't join or detach
+	// itself before it is added to the threads map.
+	Lock<Platform::Mutex> threadsLock(threadsMutex);
+	thread->platformThread = Platform::createThread(numThreadHostStackBytes, threadEntry, thread);
+	threads.add(thread->id, thread);
+
+	return 0;
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_detach", I32, _pthread_detach, U32 threadId)
+{
+	Platform::Thread* platformThread;
+	{
+		Lock<Platform::Mutex> threadsLock(threadsMutex);
+		Thread** threadPointer = threads.get(threadId);
+		if(!threadPointer) { return ErrNo::esrch; }
+		Thread* thread = *threadPointer;
+		threads.remove(threadId);
+
+		// If the thread already exited, delete it. Otherwise, it deletes itself when it exits.
+		platformThread = thread->platformThread;
+		if(!thread->exited) { thread->detached = true; }
+		else
+		{
+			if(thread->exception) { logDetachedThreadException(thread); }
+			delete thread;
+		}
+	}
+	Platform::detachThread(platformThread);
+	return 0;
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(env,
+							   "_pthread_join",
+							   I32,
+							   _pthread_join,
+							   U32 threadId,
+							   U32 resultAddress)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	if(threadId == getCurrentThreadId()) { return ErrNo::edeadlk; }
+
+	Thread* thread;
+	{
+		Lock<Platform::Mutex> threadsLock(threadsMutex);
+		Thread** threadPointer = threads.get(threadId);
+		if(!threadPointer) { return ErrNo::esrch; }
+		thread = *threadPointer;
+		threads.remove(threadId);
+	}
+	Platform::joinThread(thread->platformThread);
+
+	const I32 result = thread->result;
+	Exception* exception = thread->exception;
+	delete thread;
+
+	// If the thread trapped, pass its exception on to the joining thread.
+	if(exception) { throwException(exception); }
+
+	if(resultAddress) { memoryRef<I32>(instance->memory, resultAddress) = result; }
+	return 0;
+}
+
+// WAVM's pthread_attr_t records a thread's stack for _pthread_attr_getstack in its first two words:
+// the lowest address of the stack, and its size in bytes. A zero address means no stack was set.
+static void setAttrStack(Emscripten::Instance* instance,
+						 U32 attrAddress,
+						 U32 stackAddress,
+						 U32 numStackBytes)
+{
+	memoryRef<U32>(instance->memory, attrAddress) = stackAddress;
+	memoryRef<U32>(instance->memory, attrAddress + 4) = numStackBytes;
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_pthread_attr_init", I32, _pthread_attr_init, U32 address)
+{
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	setAttrStack(instance, address, 0, 0);
 	return 0;
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
@@ -341,9 +835,33 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   "_pthread_getattr_np",
 							   I32,
 							   _pthread_getattr_np,
-							   I32 thread,
-							   I32 address)
+							   U32 threadId,
+							   U32 attrAddress)
 {
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+
+	// Find the stack of a thread created by pthread_create. Other threads, like the main thread,
+	// use the stack that the module's globals are initialized with.
+	U32 stackAddress = STACKTOP.getValue().u32;
+	U32 numStackBytes = STACK_MAX.getValue().u32 - STACKTOP.getValue().u32;
+	if(threadId == getCurrentThreadId())
+	{
+		if(currentThread)
+		{
+			stackAddress = currentThread->stackAddress;
+			numStackBytes = numThreadStackBytes;
+		}
+	}
+	else
+	{
+		Lock<Platform::Mutex> threadsLock(threadsMutex);
+		Thread** threadPointer = threads.get(threadId);
+		if(!threadPointer) { return ErrNo::esrch; }
+		stackAddress = (*threadPointer)->stackAddress;
+		numStackBytes = numThreadStackBytes;
+	}
+
+	setAttrStack(instance, attrAddress, stackAddress, numStackBytes);
 	return 0;
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
@@ -355,9 +873,12 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   U32 stackSizeAddress)
 {
 	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
-	memoryRef<U32>(instance->memory, stackBaseAddress) = STACKTOP.getValue().u32;
-	memoryRef<U32>(instance->memory, stackSizeAddress)
-		= STACK_MAX.getValue().u32 - STACKTOP.getValue().u32;
+	const U32 stackAddress = memoryRef<U32>(instance->memory, attrAddress);
+	const U32 numStackBytes = memoryRef<U32>(instance->memory, attrAddress + 4);
+	if(!stackAddress) { return ErrNo::einval; }
+
+	memoryRef<U32>(instance->memory, stackBaseAddress) = stackAddress;
+	memoryRef<U32>(instance->memory, stackSizeAddress) = numStackBytes;
 	return 0;
 }
 
@@ -1019,39 +1540,6 @@ DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_llvm_trunc_f64", F64, _llvm_trunc
 DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_localtime_r", U32, _localtime_r, U32, U32);
 DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_longjmp", void, _longjmp, U32, U32);
 DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_mktime", U32, _mktime, U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env,
-										"_pthread_cond_destroy",
-										U32,
-										_pthread_cond_destroy,
-										U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env,
-										"_pthread_cond_init",
-										U32,
-										_pthread_cond_init,
-										U32,
-										U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env,
-										"_pthread_cond_signal",
-										U32,
-										_pthread_cond_signal,
-										U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env,
-										"_pthread_cond_timedwait",
-										U32,
-										_pthread_cond_timedwait,
-										U32,
-										U32,
-										U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env,
-										"_pthread_create",
-										U32,
-										_pthread_create,
-										U32,
-										U32,
-										U32,
-										U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_pthread_detach", U32, _pthread_detach, U32);
-DEFINE_UNIMPLEMENTED_INTRINSIC_FUNCTION(env, "_pthread_join", U32, _pthread_join, U32, U32);
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   "_pthread_mutexattr_destroy",
 							   U32,
@@ -1066,6 +1554,8 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   _pthread_mutexattr_init,
 							   U32 attrAddress)
 {
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	memoryRef<U32>(instance->memory, attrAddress) = 0;
 	return 0;
 }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env,
@@ -1075,9 +1565,18 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(env,
 							   U32 attrAddress,
 							   U32 type)
 {
+	// musl's pthread_mutex_init copies the attribute word to the mutex's _m_type word.
+	if(type > mutexTypeErrorCheck) { return ErrNo::einval; }
+	Emscripten::Instance* instance = getEmscriptenInstance(contextRuntimeData);
+	U32& attr = memoryRef<U32>(instance->memory, attrAddress);
+	attr = (attr & ~3) | type;
+	return 0;
+}
+WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_sched_yield", U32, _sched_yield)
+{
+	Platform::yieldToAnotherThread();
 	return 0;
 }
-WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_sched_yield", U32, _sched_yield) { return 0; }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_sem_destroy", U32, _sem_destroy, U32) { return 0; }
 WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_strftime", U32, _strftime, U32, U32, U32, U32) { return 0; }
 // WAVM_DEFINE_INTRINSIC_FUNCTION(env, "_tzset", void, _tzset) { }
@@ -1139,6 +1638,7 @@ Emscripten::Instance* Emscripten::instantiate(Compartment* compartment, const IR
 	});
 
 	instance->memory = memory;
+	instance->table = table;
 
 	setUserData(compartment, instance, nullptr);
 
@@ -1152,18 +1652,8 @@ void Emscripten::initializeGlobals(Emscripten::Instance* instance,
 {
 	instance->moduleInstance = moduleInstance;
 
-	// Call the establishStackSpace function to set the Emscripten module's internal stack
-	// pointers.
-	Function* establishStackSpace
-		= asFunctionNullable(getInstanceExport(moduleInstance, "establishStackSpace"));
-	if(establishStackSpace
-	   && getFunctionType(establishStackSpace)
-			  == FunctionType(TypeTuple{}, TypeTuple{ValueType::i32, ValueType::i64}))
-	{
-		std::vector<IR::Value> parameters
-			= {IR::Value(STACKTOP.getValue().i32), IR::Value(STACK_MAX.getValue().i32)};
-		Runtime::invokeFunctionChecked(context, establishStackSpace, parameters);
-	}
+	// Set the Emscripten module's internal stack pointers for the main thread.
+	establishStackSpace(instance, context, STACKTOP.getValue().i32, STACK_MAX.getValue().i32);
 
 	// Call the global initializer functions: newer Emscripten uses a single globalCtors function,
 	// and older Emscripten uses a __GLOBAL__* function for each translation unit.
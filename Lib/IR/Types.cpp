@@ -2,11 +2,12 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include <new>
 #include <utility>
 
+#include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/Hash.h"
-#include "WAVM/Inline/HashSet.h"
 #include "WAVM/Inline/Lock.h"
 #include "WAVM/Platform/Diagnostics.h"
 #include "WAVM/Platform/Mutex.h"
@@ -37,6 +38,102 @@ struct FunctionTypeHashPolicy
 	static Uptr getKeyHash(FunctionType functionType) { return functionType.getHash(); }
 };
 
+// An insert-only set of unique type impls. Looking up an impl that is already in the set doesn't
+// take a lock: the buckets are atomic, and are never modified after they are set. Adding an impl
+// takes a lock, and if the table is half full, replaces it with a table with twice as many buckets.
+// Replaced tables are leaked, since a concurrent lookup may still be reading them.
+template<typename Impl> struct UniqueImplSet
+{
+	UniqueImplSet() : table(createTable(minBuckets)) {}
+
+	template<typename AreImplsEqual, typename CopyImpl>
+	const Impl* getOrAdd(const Impl& key, AreImplsEqual&& areImplsEqual, CopyImpl&& copyImpl)
+	{
+		const Impl* impl = get(table.load(std::memory_order_acquire), key, areImplsEqual);
+		if(impl) { return impl; }
+
+		Lock<Platform::Mutex> addLock(addMutex);
+
+		// Look up the key again, in case another thread added it before the lock was acquired.
+		Table* currentTable = table.load(std::memory_order_relaxed);
+		impl = get(currentTable, key, areImplsEqual);
+		if(impl) { return impl; }
+
+		impl = copyImpl(key);
+		if((numImpls + 1) * 2 > currentTable->numBuckets)
+		{
+			Table* newTable = createTable(currentTable->numBuckets * 2);
+			for(Uptr bucketIndex = 0; bucketIndex < currentTable->numBuckets; ++bucketIndex)
+			{
+				const Impl* bucketImpl
+					= currentTable->buckets[bucketIndex].load(std::memory_order_relaxed);
+				if(bucketImpl) { add(newTable, bucketImpl); }
+			}
+			add(newTable, impl);
+			table.store(newTable, std::memory_order_release);
+		}
+		else
+		{
+			add(currentTable, impl);
+		}
+		++numImpls;
+		return impl;
+	}
+
+private:
+	static constexpr Uptr minBuckets = 64;
+
+	struct Table
+	{
+		Uptr numBuckets;
+		std::atomic<const Impl*> buckets[1];
+
+		static Uptr calcNumBytes(Uptr numBuckets)
+		{
+			return offsetof(Table, buckets) + numBuckets * sizeof(std::atomic<const Impl*>);
+		}
+	};
+
+	std::atomic<Table*> table;
+	Platform::Mutex addMutex;
+	Uptr numImpls = 0;
+
+	static Table* createTable(Uptr numBuckets)
+	{
+		wavmAssert(!(numBuckets & (numBuckets - 1)));
+		Table* newTable = (Table*)malloc(Table::calcNumBytes(numBuckets));
+		newTable->numBuckets = numBuckets;
+		for(Uptr bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex)
+		{ new(&newTable->buckets[bucketIndex]) std::atomic<const Impl*>(nullptr); }
+		Platform::expectLeakedObject(newTable);
+		return newTable;
+	}
+
+	template<typename AreImplsEqual>
+	static const Impl* get(const Table* table, const Impl& key, AreImplsEqual& areImplsEqual)
+	{
+		const Uptr bucketMask = table->numBuckets - 1;
+		for(Uptr bucketIndex = key.hash & bucketMask;; bucketIndex = (bucketIndex + 1) & bucketMask)
+		{
+			const Impl* impl = table->buckets[bucketIndex].load(std::memory_order_acquire);
+			if(!impl) { return nullptr; }
+			else if(impl->hash == key.hash && areImplsEqual(*impl, key))
+			{
+				return impl;
+			}
+		}
+	}
+
+	static void add(Table* table, const Impl* impl)
+	{
+		const Uptr bucketMask = table->numBuckets - 1;
+		Uptr bucketIndex = impl->hash & bucketMask;
+		while(table->buckets[bucketIndex].load(std::memory_order_relaxed))
+		{ bucketIndex = (bucketIndex + 1) & bucketMask; };
+		table->buckets[bucketIndex].store(impl, std::memory_order_release);
+	}
+};
+
 IR::TypeTuple::Impl::Impl(Uptr inNumElems, const ValueType* inElems) : numElems(inNumElems)
 {
 	if(numElems) { memcpy(elems, inElems, sizeof(ValueType) * numElems); }
@@ -77,20 +174,17 @@ const TypeTuple::Impl* IR::TypeTuple::getUniqueImpl(Uptr numElems, const ValueTy
 		const Uptr numImplBytes = Impl::calcNumBytes(numElems);
 		Impl* localImpl = new(alloca(numImplBytes)) Impl(numElems, inElems);
 
-		static Platform::Mutex uniqueTypeTupleSetMutex;
-		static HashSet<TypeTuple, TypeTupleHashPolicy> uniqueTypeTupleSet;
-
-		Lock<Platform::Mutex> uniqueTypeTupleSetLock(uniqueTypeTupleSetMutex);
-
-		const TypeTuple* typeTuple = uniqueTypeTupleSet.get(TypeTuple(localImpl));
-		if(typeTuple) { return typeTuple->impl; }
-		else
-		{
-			Impl* globalImpl = new(malloc(numImplBytes)) Impl(*localImpl);
-			Platform::expectLeakedObject(globalImpl);
-			uniqueTypeTupleSet.addOrFail(TypeTuple(globalImpl));
-			return globalImpl;
-		}
+		static UniqueImplSet<Impl> uniqueImplSet;
+		return uniqueImplSet.getOrAdd(
+			*localImpl,
+			[](const Impl& left, const Impl& right) {
+				return TypeTupleHashPolicy::areKeysEqual(TypeTuple(&left), TypeTuple(&right));
+			},
+			[numImplBytes](const Impl& impl) {
+				Impl* globalImpl = new(malloc(numImplBytes)) Impl(impl);
+				Platform::expectLeakedObject(globalImpl);
+				return globalImpl;
+			});
 	}
 }
 
@@ -111,19 +205,17 @@ const FunctionType::Impl* IR::FunctionType::getUniqueImpl(TypeTuple results, Typ
 	{
 		Impl localImpl(results, params);
 
-		static Platform::Mutex uniqueFunctionTypeSetMutex;
-		static HashSet<FunctionType, FunctionTypeHashPolicy> uniqueFunctionTypeSet;
-
-		Lock<Platform::Mutex> uniqueFunctionTypeSetLock(uniqueFunctionTypeSetMutex);
-
-		const FunctionType* functionType = uniqueFunctionTypeSet.get(FunctionType(&localImpl));
-		if(functionType) { return functionType->impl; }
-		else
-		{
-			Impl* globalImpl = new Impl(localImpl);
-			Platform::expectLeakedObject(globalImpl);
-			uniqueFunctionTypeSet.addOrFail(FunctionType(globalImpl));
-			return globalImpl;
-		}
+		static UniqueImplSet<Impl> uniqueImplSet;
+		return uniqueImplSet.getOrAdd(
+			localImpl,
+			[](const Impl& left, const Impl& right) {
+				return FunctionTypeHashPolicy::areKeysEqual(FunctionType(&left),
+															FunctionType(&right));
+			},
+			[](const Impl& impl) {
+				Impl* globalImpl = new Impl(impl);
+				Platform::expectLeakedObject(globalImpl);
+				return globalImpl;
+			});
 	}
 }
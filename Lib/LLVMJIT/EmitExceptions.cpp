@@ -84,11 +84,7 @@ void EmitFunctionContext::endTryCatch()
 	// handlers.
 	llvm::BasicBlock* savedInsertionPoint = irBuilder.GetInsertBlock();
 	irBuilder.SetInsertPoint(catchContext.nextHandlerBlock);
-	emitRuntimeIntrinsic(
-		"throwException",
-		FunctionType(TypeTuple{}, TypeTuple{inferValueType<Iptr>()}),
-		{irBuilder.CreatePtrToInt(catchContext.exceptionPointer, llvmContext.iptrType)});
-	irBuilder.CreateUnreachable();
+	emitThrow(catchContext.exceptionPointer);
 	irBuilder.SetInsertPoint(savedInsertionPoint);
 
 	catchStack.pop_back();
@@ -121,10 +117,43 @@ llvm::BasicBlock* EmitFunctionContext::getInnermostUnwindToBlock()
 	}
 }
 
+// Throws an exception. If the throw is within a try in the same function, it branches directly to
+// the try's catch clauses. Otherwise, the exception is thrown through the C++ ABI to unwind to the
+// calling function.
+void EmitFunctionContext::emitThrow(llvm::Value* exceptionPointer)
+{
+	if(tryStack.size())
+	{
+		TryContext& tryContext = tryStack.back();
+		tryContext.exceptionPointerPHI->addIncoming(exceptionPointer, irBuilder.GetInsertBlock());
+		irBuilder.CreateBr(tryContext.catchDispatchBlock);
+	}
+	else
+	{
+		emitRuntimeIntrinsic(
+			"throwException",
+			FunctionType(TypeTuple{}, TypeTuple{inferValueType<Iptr>()}),
+			{irBuilder.CreatePtrToInt(exceptionPointer, llvmContext.iptrType)});
+		irBuilder.CreateUnreachable();
+	}
+}
+
 void EmitFunctionContext::try_(ControlStructureImm imm)
 {
 	auto originalInsertBlock = irBuilder.GetInsertBlock();
 
+	// Create the block that dispatches exceptions to the catch clauses. It is reached both by
+	// unwinding from a call, and by throws in this function, so the exception pointer is a PHI.
+	auto catchDispatchBlock = llvm::BasicBlock::Create(llvmContext, "catchDispatch", function);
+	irBuilder.SetInsertPoint(catchDispatchBlock);
+	llvm::PHINode* exceptionPointerPHI = irBuilder.CreatePHI(llvmContext.i8PtrType, 2);
+
+	// Load the exception type ID.
+	auto exceptionTypeId = loadFromUntypedPointer(
+		irBuilder.CreateInBoundsGEP(exceptionPointerPHI,
+									{emitLiteral(llvmContext, Uptr(offsetof(Exception, typeId)))}),
+		llvmContext.iptrType);
+
 	if(moduleContext.useWindowsSEH)
 	{
 		// Insert an alloca for the exception pointer at the beginning of the function.
@@ -158,16 +187,12 @@ void EmitFunctionContext::try_(ControlStructureImm imm)
 		// Load the exception pointer from the alloca that the catchpad wrote it to.
 		auto exceptionPointer
 			= loadFromUntypedPointer(exceptionPointerAlloca, llvmContext.i8PtrType);
+		exceptionPointerPHI->addIncoming(exceptionPointer, catchBlock);
+		irBuilder.CreateBr(catchDispatchBlock);
 
-		// Load the exception type ID.
-		auto exceptionTypeId = loadFromUntypedPointer(
-			irBuilder.CreateInBoundsGEP(
-				exceptionPointer, {emitLiteral(llvmContext, Uptr(offsetof(Exception, typeId)))}),
-			llvmContext.iptrType);
-
-		tryStack.push_back(TryContext{catchSwitchBlock});
-		catchStack.push_back(
-			CatchContext{catchSwitchInst, nullptr, exceptionPointer, catchBlock, exceptionTypeId});
+		tryStack.push_back(TryContext{catchSwitchBlock, catchDispatchBlock, exceptionPointerPHI});
+		catchStack.push_back(CatchContext{
+			catchSwitchInst, nullptr, exceptionPointerPHI, catchDispatchBlock, exceptionTypeId});
 	}
 	else
 	{
@@ -185,16 +210,12 @@ void EmitFunctionContext::try_(ControlStructureImm imm)
 
 		// Call __cxa_end_catch immediately to free memory used to throw the exception.
 		irBuilder.CreateCall(getCXAEndCatchFunction(moduleContext));
+		exceptionPointerPHI->addIncoming(exceptionPointer, landingPadBlock);
+		irBuilder.CreateBr(catchDispatchBlock);
 
-		// Load the exception type ID.
-		auto exceptionTypeId = loadFromUntypedPointer(
-			irBuilder.CreateInBoundsGEP(
-				exceptionPointer, {emitLiteral(llvmContext, Uptr(offsetof(Exception, typeId)))}),
-			llvmContext.iptrType);
-
-		tryStack.push_back(TryContext{landingPadBlock});
+		tryStack.push_back(TryContext{landingPadBlock, catchDispatchBlock, exceptionPointerPHI});
 		catchStack.push_back(CatchContext{
-			nullptr, landingPadInst, exceptionPointer, landingPadBlock, exceptionTypeId});
+			nullptr, landingPadInst, exceptionPointerPHI, catchDispatchBlock, exceptionTypeId});
 	}
 
 	irBuilder.SetInsertPoint(originalInsertBlock);
@@ -344,22 +365,13 @@ void EmitFunctionContext::throw_(ExceptionTypeImm imm)
 					 TypeTuple{inferValueType<Iptr>(), inferValueType<Iptr>(), ValueType::i32}),
 		{exceptionTypeId, argsPointerAsInt, emitLiteral(llvmContext, I32(1))})[0];
 
-	emitRuntimeIntrinsic("throwException",
-						 FunctionType(TypeTuple{}, TypeTuple{inferValueType<Iptr>()}),
-						 {irBuilder.CreatePtrToInt(exceptionPointer, llvmContext.iptrType)});
-
-	irBuilder.CreateUnreachable();
+	emitThrow(irBuilder.CreateIntToPtr(exceptionPointer, llvmContext.i8PtrType));
 	enterUnreachable();
 }
 void EmitFunctionContext::rethrow(RethrowImm imm)
 {
 	wavmAssert(imm.catchDepth < catchStack.size());
 	CatchContext& catchContext = catchStack[catchStack.size() - imm.catchDepth - 1];
-	emitRuntimeIntrinsic(
-		"throwException",
-		FunctionType(TypeTuple{}, TypeTuple{inferValueType<Iptr>()}),
-		{irBuilder.CreatePtrToInt(catchContext.exceptionPointer, llvmContext.iptrType)});
-
-	irBuilder.CreateUnreachable();
+	emitThrow(catchContext.exceptionPointer);
 	enterUnreachable();
 }
@@ -61,6 +61,12 @@ namespace WAVM { namespace LLVMJIT {
 		std::vector<BranchTarget> branchTargetStack;
 		std::vector<llvm::Value*> stack;
 
+		// With MemoryBoundsCheckMode::explicitChecks, the largest offset that has been bounds
+		// checked for each address value in boundsCheckedBlock. A check is redundant if a larger
+		// offset from the same address value was already checked in the block.
+		llvm::BasicBlock* boundsCheckedBlock = nullptr;
+		HashMap<llvm::Value*, U32> boundsCheckedAddressOffsets;
+
 		EmitFunctionContext(LLVMContext& inLLVMContext,
 							EmitModuleContext& inModuleContext,
 							const IR::Module& inIRModule,
@@ -242,7 +248,14 @@ namespace WAVM { namespace LLVMJIT {
 
 		struct TryContext
 		{
+			// The block that calls within the try unwind to.
 			llvm::BasicBlock* unwindToBlock;
+
+			// The block that dispatches an exception to the try's catch clauses. Exceptions that
+			// are thrown within the same function branch directly to it, adding an incoming value
+			// to exceptionPointerPHI.
+			llvm::BasicBlock* catchDispatchBlock;
+			llvm::PHINode* exceptionPointerPHI;
 		};
 
 		struct CatchContext
@@ -267,6 +280,7 @@ namespace WAVM { namespace LLVMJIT {
 		void exitCatch();
 
 		llvm::BasicBlock* getInnermostUnwindToBlock();
+		void emitThrow(llvm::Value* exceptionPointer);
 
 #define VISIT_OPCODE(encoding, name, nameString, Imm, ...) void name(IR::Imm imm);
 		WAVM_ENUM_OPERATORS(VISIT_OPCODE)
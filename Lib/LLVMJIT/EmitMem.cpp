@@ -2,6 +2,7 @@
 #include "EmitFunctionContext.h"
 #include "EmitModuleContext.h"
 #include "LLVMJITPrivate.h"
+#include "WAVM/IR/IR.h"
 #include "WAVM/IR/Operators.h"
 #include "WAVM/IR/Types.h"
 #include "WAVM/Inline/Assert.h"
@@ -25,28 +26,66 @@ using namespace WAVM::LLVMJIT;
 // Bounds checks a sandboxed memory address + offset, and returns an offset relative to the memory
 // base address that is guaranteed to be within the virtual address space allocated for the linear
 // memory object.
-static llvm::Value* getOffsetAndBoundedAddress(EmitContext& emitContext,
+static llvm::Value* getOffsetAndBoundedAddress(EmitFunctionContext& functionContext,
 											   llvm::Value* address,
 											   U32 offset)
 {
+	llvm::IRBuilder<>& irBuilder = functionContext.irBuilder;
+	LLVMContext& llvmContext = functionContext.llvmContext;
+
+	// Redundant bounds checks are identified by the SSA value of the address, not by the local it
+	// was loaded from: a value loaded from a local before a local.set must still be checked after
+	// the new value of the local is checked.
+	llvm::Value* boundsCheckKey = address;
+
 	// zext the 32-bit address to 64-bits.
 	// This is crucial for security, as LLVM will otherwise implicitly sign extend it to 64-bits in
 	// the GEP below, interpreting it as a signed offset and allowing access to memory outside the
 	// sandboxed memory range. There are no 'far addresses' in a 32 bit runtime.
-	address = emitContext.irBuilder.CreateZExt(address, emitContext.llvmContext.i64Type);
+	address = irBuilder.CreateZExt(address, llvmContext.i64Type);
 
 	// Add the offset to the byte index.
 	if(offset)
 	{
-		address = emitContext.irBuilder.CreateAdd(
-			address,
-			emitContext.irBuilder.CreateZExt(emitLiteral(emitContext.llvmContext, offset),
-											 emitContext.llvmContext.i64Type));
+		address = irBuilder.CreateAdd(
+			address, irBuilder.CreateZExt(emitLiteral(llvmContext, offset), llvmContext.i64Type));
 	}
 
 	// If HAS_64BIT_ADDRESS_SPACE, the memory has enough virtual address space allocated to ensure
 	// that any 32-bit byte index + 32-bit offset will fall within the virtual address sandbox, so
 	// no explicit bounds check is necessary.
+	if(functionContext.moduleContext.boundsCheckMode
+	   == WAVM::Runtime::MemoryBoundsCheckMode::explicitChecks)
+	{
+		// Otherwise, the memory only reserves enough address space for its maximum size, and the
+		// address must be checked against that. The check doesn't include the size of the access:
+		// the memory is followed by a guard page that catches accesses that straddle the end of the
+		// reservation. Accesses between the memory's current size and its reserved size fault on
+		// the reserved pages, just as they do with MemoryBoundsCheckMode::guardRegion.
+		if(irBuilder.GetInsertBlock() != functionContext.boundsCheckedBlock)
+		{ functionContext.boundsCheckedAddressOffsets.clear(); }
+
+		const U32* checkedOffset = functionContext.boundsCheckedAddressOffsets.get(boundsCheckKey);
+		if(!checkedOffset || *checkedOffset < offset)
+		{
+			functionContext.emitConditionalTrapIntrinsic(
+				irBuilder.CreateICmpUGE(
+					address,
+					irBuilder.CreateZExt(functionContext.moduleContext.memoryNumReservedBytes[0],
+										 llvmContext.i64Type)),
+				"outOfBoundsMemoryTrap",
+				FunctionType(TypeTuple(),
+							 TypeTuple({ValueType::i64, inferValueType<Uptr>()})),
+				{address,
+				 getMemoryIdFromOffset(llvmContext,
+									   functionContext.moduleContext.memoryOffsets[0])});
+
+			// The check leaves the IR builder in a new block, but that block is only reachable
+			// through the check, so the previously checked addresses remain valid.
+			functionContext.boundsCheckedBlock = irBuilder.GetInsertBlock();
+			functionContext.boundsCheckedAddressOffsets.set(boundsCheckKey, offset);
+		}
+	}
 
 	return address;
 }
@@ -125,25 +164,189 @@ void EmitFunctionContext::data_drop(DataSegmentImm imm)
 		{moduleContext.moduleInstanceId, emitLiteral(llvmContext, imm.dataSegmentIndex)});
 }
 
+// memory.copy and memory.fill with a constant size of at most this many bytes are emitted as
+// inline loads and stores instead of calls to the runtime intrinsics.
+static constexpr U64 maxInlineBulkMemoryBytes = 64;
+
+// Returns the widest type that is used to access a chunk of an inline memory.copy or memory.fill
+// with the given number of remaining bytes, and the number of bytes accessed by it.
+static llvm::Type* getInlineBulkMemoryChunkType(LLVMContext& llvmContext,
+												U64 numRemainingBytes,
+												U64& outNumChunkBytes)
+{
+	if(numRemainingBytes >= 16)
+	{
+		outNumChunkBytes = 16;
+		return llvmContext.i8x16Type;
+	}
+	else if(numRemainingBytes >= 8)
+	{
+		outNumChunkBytes = 8;
+		return llvmContext.i64Type;
+	}
+	else if(numRemainingBytes >= 4)
+	{
+		outNumChunkBytes = 4;
+		return llvmContext.i32Type;
+	}
+	else if(numRemainingBytes >= 2)
+	{
+		outNumChunkBytes = 2;
+		return llvmContext.i16Type;
+	}
+	else
+	{
+		outNumChunkBytes = 1;
+		return llvmContext.i8Type;
+	}
+}
+
+// Emits a condition that is true if the range [address, address + numBytes) crosses a
+// WebAssembly page boundary.
+static llvm::Value* emitCrossesPageBoundary(EmitFunctionContext& functionContext,
+											llvm::Value* address,
+											U64 numBytes)
+{
+	llvm::IRBuilder<>& irBuilder = functionContext.irBuilder;
+	LLVMContext& llvmContext = functionContext.llvmContext;
+	llvm::Value* pageOffset
+		= irBuilder.CreateAnd(address, emitLiteral(llvmContext, U32(numBytesPerPage - 1)));
+	return irBuilder.CreateICmpUGT(
+		irBuilder.CreateAdd(pageOffset, emitLiteral(llvmContext, U32(numBytes))),
+		emitLiteral(llvmContext, U32(numBytesPerPage)));
+}
+
+// Emits a memory.copy or memory.fill with a constant size inline, if it is small enough and the
+// accessed ranges don't cross a page boundary; otherwise, emits a call to the runtime intrinsic.
+//
+// The intrinsics guarantee that if the operation traps, all bytes before the byte that trapped
+// were written. Memories are only accessible up to a page boundary, so a range that doesn't cross a
+// page boundary is either entirely accessible, or traps on its first byte. The inline code loads
+// all the source bytes before storing any, so it also has memmove semantics for overlapping copies.
+template<typename EmitInline, typename EmitCall>
+static void emitInlineOrCallBulkMemoryOp(EmitFunctionContext& functionContext,
+										 llvm::Value* numBytes,
+										 std::initializer_list<llvm::Value*> addresses,
+										 EmitInline&& emitInline,
+										 EmitCall&& emitCall)
+{
+	llvm::IRBuilder<>& irBuilder = functionContext.irBuilder;
+	LLVMContext& llvmContext = functionContext.llvmContext;
+
+	auto constantNumBytes = llvm::dyn_cast<llvm::ConstantInt>(numBytes);
+	if(!constantNumBytes || constantNumBytes->getZExtValue() > maxInlineBulkMemoryBytes)
+	{
+		emitCall();
+		return;
+	}
+
+	// A memory.copy or memory.fill of zero bytes doesn't do anything, even if the address is out
+	// of bounds.
+	const U64 numConstantBytes = constantNumBytes->getZExtValue();
+	if(!numConstantBytes) { return; }
+
+	llvm::Value* crossesPageBoundary = nullptr;
+	for(llvm::Value* address : addresses)
+	{
+		llvm::Value* addressCrossesPageBoundary
+			= emitCrossesPageBoundary(functionContext, address, numConstantBytes);
+		if(!crossesPageBoundary) { crossesPageBoundary = addressCrossesPageBoundary; }
+		else
+		{
+			crossesPageBoundary
+				= irBuilder.CreateOr(crossesPageBoundary, addressCrossesPageBoundary);
+		}
+	}
+
+	llvm::Function* function = functionContext.function;
+	auto callBlock = llvm::BasicBlock::Create(llvmContext, "bulkMemoryCall", function);
+	auto inlineBlock = llvm::BasicBlock::Create(llvmContext, "bulkMemoryInline", function);
+	auto endBlock = llvm::BasicBlock::Create(llvmContext, "bulkMemoryEnd", function);
+	irBuilder.CreateCondBr(crossesPageBoundary,
+						   callBlock,
+						   inlineBlock,
+						   functionContext.moduleContext.likelyFalseBranchWeights);
+
+	irBuilder.SetInsertPoint(callBlock);
+	emitCall();
+	irBuilder.CreateBr(endBlock);
+
+	irBuilder.SetInsertPoint(inlineBlock);
+	emitInline(numConstantBytes);
+	irBuilder.CreateBr(endBlock);
+
+	irBuilder.SetInsertPoint(endBlock);
+}
+
 void EmitFunctionContext::memory_copy(MemoryCopyImm imm)
 {
 	auto numBytes = pop();
 	auto sourceAddress = pop();
 	auto destAddress = pop();
 
-	emitRuntimeIntrinsic(
-		"memory.copy",
-		FunctionType({},
-					 TypeTuple({ValueType::i32,
-								ValueType::i32,
-								ValueType::i32,
-								inferValueType<Uptr>(),
-								inferValueType<Uptr>()})),
-		{destAddress,
-		 sourceAddress,
-		 numBytes,
-		 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.sourceMemoryIndex]),
-		 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.destMemoryIndex])});
+	auto emitCall = [&] {
+		emitRuntimeIntrinsic(
+			"memory.copy",
+			FunctionType({},
+						 TypeTuple({ValueType::i32,
+									ValueType::i32,
+									ValueType::i32,
+									inferValueType<Uptr>(),
+									inferValueType<Uptr>()})),
+			{destAddress,
+			 sourceAddress,
+			 numBytes,
+			 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.sourceMemoryIndex]),
+			 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.destMemoryIndex])});
+	};
+
+	// Only copies within the default memory are emitted inline, since its base address is the only
+	// one that is cached in a local variable.
+	if(imm.sourceMemoryIndex != 0 || imm.destMemoryIndex != 0)
+	{
+		emitCall();
+		return;
+	}
+
+	emitInlineOrCallBulkMemoryOp(
+		*this,
+		numBytes,
+		{sourceAddress, destAddress},
+		[&](U64 numConstantBytes) {
+			llvm::Value* boundedSourceAddress
+				= getOffsetAndBoundedAddress(*this, sourceAddress, 0);
+			llvm::Value* boundedDestAddress = getOffsetAndBoundedAddress(*this, destAddress, 0);
+
+			// Load all the source bytes before storing any of them, in case the ranges overlap.
+			llvm::SmallVector<llvm::Value*, 8> chunks;
+			U64 numChunkBytes = 0;
+			for(U64 offset = 0; offset < numConstantBytes; offset += numChunkBytes)
+			{
+				llvm::Type* chunkType = getInlineBulkMemoryChunkType(
+					llvmContext, numConstantBytes - offset, numChunkBytes);
+				auto load = irBuilder.CreateLoad(coerceAddressToPointer(
+					irBuilder.CreateAdd(boundedSourceAddress, emitLiteral(llvmContext, offset)),
+					chunkType));
+				load->setAlignment(1);
+				load->setVolatile(true);
+				chunks.push_back(load);
+			}
+
+			Uptr chunkIndex = 0;
+			for(U64 offset = 0; offset < numConstantBytes; offset += numChunkBytes)
+			{
+				llvm::Type* chunkType = getInlineBulkMemoryChunkType(
+					llvmContext, numConstantBytes - offset, numChunkBytes);
+				auto store = irBuilder.CreateStore(
+					chunks[chunkIndex++],
+					coerceAddressToPointer(
+						irBuilder.CreateAdd(boundedDestAddress, emitLiteral(llvmContext, offset)),
+						chunkType));
+				store->setAlignment(1);
+				store->setVolatile(true);
+			}
+		},
+		emitCall);
 }
 
 void EmitFunctionContext::memory_fill(MemoryImm imm)
@@ -152,15 +355,62 @@ void EmitFunctionContext::memory_fill(MemoryImm imm)
 	auto value = pop();
 	auto destAddress = pop();
 
-	emitRuntimeIntrinsic(
-		"memory.fill",
-		FunctionType(
-			{},
-			TypeTuple({ValueType::i32, ValueType::i32, ValueType::i32, inferValueType<Uptr>()})),
-		{destAddress,
-		 value,
-		 numBytes,
-		 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.memoryIndex])});
+	auto emitCall = [&] {
+		emitRuntimeIntrinsic(
+			"memory.fill",
+			FunctionType({},
+						 TypeTuple({ValueType::i32,
+									ValueType::i32,
+									ValueType::i32,
+									inferValueType<Uptr>()})),
+			{destAddress,
+			 value,
+			 numBytes,
+			 getMemoryIdFromOffset(llvmContext, moduleContext.memoryOffsets[imm.memoryIndex])});
+	};
+
+	if(imm.memoryIndex != 0)
+	{
+		emitCall();
+		return;
+	}
+
+	emitInlineOrCallBulkMemoryOp(
+		*this,
+		numBytes,
+		{destAddress},
+		[&](U64 numConstantBytes) {
+			llvm::Value* boundedDestAddress = getOffsetAndBoundedAddress(*this, destAddress, 0);
+			llvm::Value* byteValue = irBuilder.CreateTrunc(value, llvmContext.i8Type);
+
+			U64 numChunkBytes = 0;
+			for(U64 offset = 0; offset < numConstantBytes; offset += numChunkBytes)
+			{
+				llvm::Type* chunkType = getInlineBulkMemoryChunkType(
+					llvmContext, numConstantBytes - offset, numChunkBytes);
+
+				// Replicate the byte value to every byte of the chunk.
+				llvm::Value* chunkValue;
+				if(chunkType->isVectorTy())
+				{ chunkValue = irBuilder.CreateVectorSplat(16, byteValue); }
+				else
+				{
+					const U64 byteMultiplier = (UINT64_MAX / 0xff) >> (64 - numChunkBytes * 8);
+					chunkValue = irBuilder.CreateMul(
+						irBuilder.CreateZExt(byteValue, chunkType),
+						llvm::ConstantInt::get(chunkType, byteMultiplier));
+				}
+
+				auto store = irBuilder.CreateStore(
+					chunkValue,
+					coerceAddressToPointer(
+						irBuilder.CreateAdd(boundedDestAddress, emitLiteral(llvmContext, offset)),
+						chunkType));
+				store->setAlignment(1);
+				store->setVolatile(true);
+			}
+		},
+		emitCall);
 }
 
 //
@@ -36,11 +36,13 @@ using namespace WAVM::Runtime;
 EmitModuleContext::EmitModuleContext(const IR::Module& inIRModule,
 									 LLVMContext& inLLVMContext,
 									 llvm::Module* inLLVMModule,
-									 llvm::TargetMachine* inTargetMachine)
+									 llvm::TargetMachine* inTargetMachine,
+									 MemoryBoundsCheckMode inBoundsCheckMode)
 : irModule(inIRModule)
 , llvmContext(inLLVMContext)
 , llvmModule(inLLVMModule)
 , targetMachine(inTargetMachine)
+, boundsCheckMode(inBoundsCheckMode)
 , defaultMemoryOffset(nullptr)
 , defaultTableOffset(nullptr)
 , diBuilder(*inLLVMModule)
@@ -96,10 +98,12 @@ static llvm::Constant* createImportedConstant(llvm::Module& llvmModule, llvm::Tw
 void LLVMJIT::emitModule(const IR::Module& irModule,
 						 LLVMContext& llvmContext,
 						 llvm::Module& outLLVMModule,
-						 llvm::TargetMachine* targetMachine)
+						 llvm::TargetMachine* targetMachine,
+						 MemoryBoundsCheckMode boundsCheckMode)
 {
 	Timing::Timer emitTimer;
-	EmitModuleContext moduleContext(irModule, llvmContext, &outLLVMModule, targetMachine);
+	EmitModuleContext moduleContext(
+		irModule, llvmContext, &outLLVMModule, targetMachine, boundsCheckMode);
 
 	// Create an external reference to the appropriate exception personality function.
 	auto personalityFunction = llvm::Function::Create(
@@ -139,6 +143,19 @@ void LLVMJIT::emitModule(const IR::Module& irModule,
 	if(moduleContext.memoryOffsets.size())
 	{ moduleContext.defaultMemoryOffset = moduleContext.memoryOffsets[0]; }
 
+	// If the module is compiled with explicit bounds checks, create LLVM external globals
+	// corresponding to the number of bytes reserved for each of the module's memory objects.
+	if(boundsCheckMode == MemoryBoundsCheckMode::explicitChecks)
+	{
+		for(Uptr memoryIndex = 0; memoryIndex < irModule.memories.size(); ++memoryIndex)
+		{
+			moduleContext.memoryNumReservedBytes.push_back(llvm::ConstantExpr::getPtrToInt(
+				createImportedConstant(outLLVMModule,
+									   getExternalName("memoryNumReservedBytes", memoryIndex)),
+				llvmContext.iptrType));
+		}
+	}
+
 	// Create LLVM external globals for the module's globals.
 	for(Uptr globalIndex = 0; globalIndex < irModule.globals.size(); ++globalIndex)
 	{
@@ -15,11 +15,13 @@ namespace WAVM { namespace LLVMJIT {
 		LLVMContext& llvmContext;
 		llvm::Module* llvmModule;
 		llvm::TargetMachine* targetMachine;
+		Runtime::MemoryBoundsCheckMode boundsCheckMode;
 		bool useWindowsSEH;
 		std::vector<llvm::Constant*> typeIds;
 		std::vector<llvm::Function*> functions;
 		std::vector<llvm::Constant*> tableOffsets;
 		std::vector<llvm::Constant*> memoryOffsets;
+		std::vector<llvm::Constant*> memoryNumReservedBytes;
 		std::vector<llvm::Constant*> globals;
 		std::vector<llvm::Constant*> exceptionTypeIds;
 
@@ -48,7 +50,8 @@ namespace WAVM { namespace LLVMJIT {
 		EmitModuleContext(const IR::Module& inModule,
 						  LLVMContext& inLLVMContext,
 						  llvm::Module* inLLVMModule,
-						  llvm::TargetMachine* inTargetMachine);
+						  llvm::TargetMachine* inTargetMachine,
+						  Runtime::MemoryBoundsCheckMode inBoundsCheckMode);
 
 		inline llvm::Function* getLLVMIntrinsic(llvm::ArrayRef<llvm::Type*> typeArguments,
 												llvm::Intrinsic::ID id)
@@ -0,0 +1,168 @@
+#include <atomic>
+#include <iterator>
+#include <map>
+
+#include "LLVMJITPrivate.h"
+#include "WAVM/Inline/Assert.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Lock.h"
+#include "WAVM/LLVMJIT/LLVMJIT.h"
+#include "WAVM/Platform/Memory.h"
+#include "WAVM/Platform/Mutex.h"
+
+using namespace WAVM;
+using namespace WAVM::LLVMJIT;
+
+// The arena is split into a code zone and a data zone. Both zones are in a single 1GB region, so
+// the code of an image is always within the +/-2GB range of RIP-relative references to its data.
+enum
+{
+	numZoneBytesLog2 = 29,
+	numZones = 2,
+	codeZoneIndex = 0,
+	dataZoneIndex = 1,
+};
+
+struct ImageArenaZone
+{
+	U8* baseAddress = nullptr;
+	Uptr numPages = 0;
+
+	// A map from the base address of each free range of pages in the zone to its number of pages.
+	std::map<U8*, Uptr> freeRanges;
+};
+
+struct ImageArena
+{
+	Platform::Mutex mutex;
+	bool isInitialized = false;
+	bool isAvailable = false;
+	ImageArenaZone zones[numZones];
+};
+
+static std::atomic<bool> codeHugePagesEnabled{false};
+
+static ImageArena& getImageArena()
+{
+	static ImageArena arena;
+	return arena;
+}
+
+static bool initImageArena(ImageArena& arena)
+{
+	wavmAssertMutexIsLockedByCurrentThread(arena.mutex);
+	if(arena.isInitialized) { return arena.isAvailable; }
+	arena.isInitialized = true;
+
+	const Uptr pageSizeLog2 = Platform::getPageSizeLog2();
+	const Uptr hugePageSizeLog2 = Platform::getHugePageSizeLog2();
+	if(hugePageSizeLog2 <= pageSizeLog2 || hugePageSizeLog2 >= numZoneBytesLog2) { return false; }
+
+	// Reserve the arena's address space aligned to a huge page. The arena is never freed.
+	const Uptr numZonePages = Uptr(1) << (numZoneBytesLog2 - pageSizeLog2);
+	U8* unalignedBaseAddress = nullptr;
+	U8* baseAddress = Platform::allocateAlignedVirtualPages(
+		numZonePages * numZones, hugePageSizeLog2, unalignedBaseAddress);
+	if(!baseAddress) { return false; }
+
+	for(Uptr zoneIndex = 0; zoneIndex < numZones; ++zoneIndex)
+	{
+		ImageArenaZone& zone = arena.zones[zoneIndex];
+		zone.baseAddress = baseAddress + ((zoneIndex * numZonePages) << pageSizeLog2);
+		zone.numPages = numZonePages;
+		zone.freeRanges.emplace(zone.baseAddress, numZonePages);
+	}
+
+	// Only the code zone is backed by huge pages: the code of all modules is executable, so it can
+	// share huge pages, but each module's data pages have different access.
+	arena.isAvailable
+		= Platform::adviseHugePages(arena.zones[codeZoneIndex].baseAddress, numZonePages);
+	return arena.isAvailable;
+}
+
+// Adds a range of pages to a zone's free ranges, and merges it with any adjacent free ranges.
+static void addFreeRange(ImageArenaZone& zone, U8* baseAddress, Uptr numPages)
+{
+	const Uptr pageSizeLog2 = Platform::getPageSizeLog2();
+	auto nextRangeIt = zone.freeRanges.lower_bound(baseAddress);
+	if(nextRangeIt != zone.freeRanges.end()
+	   && baseAddress + (numPages << pageSizeLog2) == nextRangeIt->first)
+	{
+		numPages += nextRangeIt->second;
+		nextRangeIt = zone.freeRanges.erase(nextRangeIt);
+	}
+	if(nextRangeIt != zone.freeRanges.begin())
+	{
+		auto previousRangeIt = std::prev(nextRangeIt);
+		if(previousRangeIt->first + (previousRangeIt->second << pageSizeLog2) == baseAddress)
+		{
+			previousRangeIt->second += numPages;
+			return;
+		}
+	}
+	zone.freeRanges.emplace(baseAddress, numPages);
+}
+
+void LLVMJIT::setCodeHugePagesEnabled(bool enable)
+{
+	codeHugePagesEnabled.store(enable, std::memory_order_relaxed);
+}
+
+U8* LLVMJIT::allocateImageArenaPages(Uptr numPages, bool isCode)
+{
+	if(!numPages || !codeHugePagesEnabled.load(std::memory_order_relaxed)) { return nullptr; }
+
+	ImageArena& arena = getImageArena();
+	Lock<Platform::Mutex> arenaLock(arena.mutex);
+	if(!initImageArena(arena)) { return nullptr; }
+
+	// Allocate the lowest free range that is large enough, to keep the code of all modules packed
+	// into as few huge pages as possible.
+	ImageArenaZone& zone = arena.zones[isCode ? codeZoneIndex : dataZoneIndex];
+	for(auto freeRangeIt = zone.freeRanges.begin(); freeRangeIt != zone.freeRanges.end();
+		++freeRangeIt)
+	{
+		if(freeRangeIt->second < numPages) { continue; }
+
+		U8* baseAddress = freeRangeIt->first;
+		const Uptr numRemainingPages = freeRangeIt->second - numPages;
+		zone.freeRanges.erase(freeRangeIt);
+		if(numRemainingPages)
+		{
+			zone.freeRanges.emplace(baseAddress + (numPages << Platform::getPageSizeLog2()),
+									numRemainingPages);
+		}
+
+		if(!Platform::commitVirtualPages(baseAddress, numPages))
+		{
+			addFreeRange(zone, baseAddress, numPages);
+			return nullptr;
+		}
+		return baseAddress;
+	};
+
+	return nullptr;
+}
+
+void LLVMJIT::freeImageArenaPages(U8* baseAddress, Uptr numPages)
+{
+	ImageArena& arena = getImageArena();
+	Lock<Platform::Mutex> arenaLock(arena.mutex);
+	wavmAssert(arena.isAvailable);
+
+	const Uptr pageSizeLog2 = Platform::getPageSizeLog2();
+	ImageArenaZone* zone = nullptr;
+	for(ImageArenaZone& candidateZone : arena.zones)
+	{
+		if(baseAddress >= candidateZone.baseAddress
+		   && baseAddress < candidateZone.baseAddress + (candidateZone.numPages << pageSizeLog2))
+		{ zone = &candidateZone; }
+	}
+	wavmAssert(zone);
+
+	// Decommit the pages. This preserves the huge page advice for the code zone, so the pages may
+	// be backed by huge pages again when they are reused.
+	Platform::decommitVirtualPages(baseAddress, numPages);
+
+	addFreeRange(*zone, baseAddress, numPages);
+}
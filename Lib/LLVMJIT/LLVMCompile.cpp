@@ -96,17 +96,24 @@ private:
 	std::vector<U8> output;
 };
 
-static void optimizeLLVMModule(llvm::Module& llvmModule, bool shouldLogMetrics)
+static void optimizeLLVMModule(llvm::Module& llvmModule,
+							   bool shouldLogMetrics,
+							   Runtime::CodegenMode codegenMode)
 {
-	// Run some optimization on the module's functions.
+	// Run some optimization on the module's functions. Fast/unoptimized codegen only promotes the
+	// function's locals from allocas to SSA values, which is cheap and avoids loading and storing
+	// every local.
 	Timing::Timer optimizationTimer;
 
 	llvm::legacy::FunctionPassManager fpm(&llvmModule);
 	fpm.add(llvm::createPromoteMemoryToRegisterPass());
-	fpm.add(llvm::createInstructionCombiningPass());
-	fpm.add(llvm::createCFGSimplificationPass());
-	fpm.add(llvm::createJumpThreadingPass());
-	fpm.add(llvm::createConstantPropagationPass());
+	if(codegenMode == Runtime::CodegenMode::optimized)
+	{
+		fpm.add(llvm::createInstructionCombiningPass());
+		fpm.add(llvm::createCFGSimplificationPass());
+		fpm.add(llvm::createJumpThreadingPass());
+		fpm.add(llvm::createConstantPropagationPass());
+	}
 	fpm.doInitialization();
 	for(auto functionIt = llvmModule.begin(); functionIt != llvmModule.end(); ++functionIt)
 	{ fpm.run(*functionIt); }
@@ -124,7 +131,8 @@ static void optimizeLLVMModule(llvm::Module& llvmModule, bool shouldLogMetrics)
 std::vector<U8> LLVMJIT::compileLLVMModule(LLVMContext& llvmContext,
 										   llvm::Module&& llvmModule,
 										   bool shouldLogMetrics,
-										   llvm::TargetMachine* targetMachine)
+										   llvm::TargetMachine* targetMachine,
+										   Runtime::CodegenMode codegenMode)
 {
 	// Get a target machine object for this host, and set the module to use its data layout.
 	llvmModule.setDataLayout(targetMachine->createDataLayout());
@@ -145,7 +153,14 @@ std::vector<U8> LLVMJIT::compileLLVMModule(LLVMContext& llvmContext,
 	}
 
 	// Optimize the module;
-	optimizeLLVMModule(llvmModule, shouldLogMetrics);
+	optimizeLLVMModule(llvmModule, shouldLogMetrics, codegenMode);
+
+	// Fast/unoptimized codegen uses LLVM's fast instruction selector and register allocator.
+	if(codegenMode == Runtime::CodegenMode::fastUnoptimized)
+	{
+		targetMachine->setOptLevel(llvm::CodeGenOpt::None);
+		targetMachine->setFastISel(true);
+	}
 
 	// Generate machine code for the module.
 	Timing::Timer machineCodeTimer;
@@ -188,7 +203,9 @@ std::unique_ptr<llvm::TargetMachine> LLVMJIT::getTargetMachine(const TargetSpec&
 		llvm::Triple(targetTriple), "", targetSpec.cpu, llvm::SmallVector<std::string, 0>{}));
 }
 
-std::vector<U8> LLVMJIT::compileModule(const IR::Module& irModule)
+std::vector<U8> LLVMJIT::compileModule(const IR::Module& irModule,
+									   Runtime::MemoryBoundsCheckMode boundsCheckMode,
+									   Runtime::CodegenMode codegenMode)
 {
 	LLVMContext llvmContext;
 
@@ -197,14 +214,17 @@ std::vector<U8> LLVMJIT::compileModule(const IR::Module& irModule)
 
 	// Emit LLVM IR for the module.
 	llvm::Module llvmModule("", llvmContext);
-	emitModule(irModule, llvmContext, llvmModule, targetMachine.get());
+	emitModule(irModule, llvmContext, llvmModule, targetMachine.get(), boundsCheckMode);
 
 	// Compile the LLVM IR to object code.
-	return compileLLVMModule(llvmContext, std::move(llvmModule), true, targetMachine.get());
+	return compileLLVMModule(
+		llvmContext, std::move(llvmModule), true, targetMachine.get(), codegenMode);
 }
 CompileResult LLVMJIT::compileModule(const IR::Module& irModule,
 									 const TargetSpec& targetSpec,
-									 std::vector<U8>& outObjectCode)
+									 std::vector<U8>& outObjectCode,
+									 Runtime::MemoryBoundsCheckMode boundsCheckMode,
+									 Runtime::CodegenMode codegenMode)
 {
 	LLVMContext llvmContext;
 
@@ -213,10 +233,10 @@ CompileResult LLVMJIT::compileModule(const IR::Module& irModule,
 
 	// Emit LLVM IR for the module.
 	llvm::Module llvmModule("", llvmContext);
-	emitModule(irModule, llvmContext, llvmModule, targetMachine.get());
+	emitModule(irModule, llvmContext, llvmModule, targetMachine.get(), boundsCheckMode);
 
 	// Compile the LLVM IR to object code.
-	outObjectCode
-		= compileLLVMModule(llvmContext, std::move(llvmModule), true, targetMachine.get());
+	outObjectCode = compileLLVMModule(
+		llvmContext, std::move(llvmModule), true, targetMachine.get(), codegenMode);
 	return CompileResult::success;
 }
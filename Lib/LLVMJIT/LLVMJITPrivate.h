@@ -321,12 +321,20 @@ namespace WAVM { namespace LLVMJIT {
 		{
 			auto attrs = function->getAttributes();
 
-			// LLVM 9+ has a more general purpose frame-pointer=(all|non-leaf|none) attribute that
-			// WAVM should use once we can depend on it.
+			// Keep the frame pointer in all functions, so the signal handler can walk the frame
+			// pointer chain of generated code. LLVM 9 replaced no-frame-pointer-elim with the more
+			// general frame-pointer=(all|non-leaf|none) attribute.
+#if LLVM_VERSION_MAJOR >= 9
+			attrs = attrs.addAttribute(function->getContext(),
+									   llvm::AttributeList::FunctionIndex,
+									   "frame-pointer",
+									   "all");
+#else
 			attrs = attrs.addAttribute(function->getContext(),
 									   llvm::AttributeList::FunctionIndex,
 									   "no-frame-pointer-elim",
 									   "true");
+#endif
 
 			// Set the probe-stack attribute: this will cause functions that allocate more than a
 			// page of stack space to call the wavm_probe_stack function defined in POSIX.S
@@ -370,11 +378,21 @@ namespace WAVM { namespace LLVMJIT {
 	void emitModule(const IR::Module& irModule,
 					LLVMContext& llvmContext,
 					llvm::Module& outLLVMModule,
-					llvm::TargetMachine* targetMachine);
+					llvm::TargetMachine* targetMachine,
+					Runtime::MemoryBoundsCheckMode boundsCheckMode);
 
 	// Used to override LLVM's default behavior of looking up unresolved symbols in DLL exports.
 	llvm::JITEvaluatedSymbol resolveJITImport(llvm::StringRef name);
 
+	// Allocates committed read-write pages for a JIT image from an arena shared by all JIT images.
+	// Code pages are allocated from a part of the arena that is backed by huge pages, so the code
+	// of many modules can share each huge page. Returns null if code huge pages aren't enabled or
+	// supported, or the arena is exhausted.
+	U8* allocateImageArenaPages(Uptr numPages, bool isCode);
+
+	// Decommits pages allocated by allocateImageArenaPages, and returns them to the arena.
+	void freeImageArenaPages(U8* baseAddress, Uptr numPages);
+
 	struct ModuleMemoryManager;
 
 	// Encapsulates a loaded module.
@@ -401,10 +419,13 @@ namespace WAVM { namespace LLVMJIT {
 
 	extern std::unique_ptr<llvm::TargetMachine> getTargetMachine(const TargetSpec& targetSpec);
 
-	extern std::vector<U8> compileLLVMModule(LLVMContext& llvmContext,
-											 llvm::Module&& llvmModule,
-											 bool shouldLogMetrics,
-											 llvm::TargetMachine* targetMachine);
+	// Compiles an LLVM module to object code.
+	extern std::vector<U8> compileLLVMModule(
+		LLVMContext& llvmContext,
+		llvm::Module&& llvmModule,
+		bool shouldLogMetrics,
+		llvm::TargetMachine* targetMachine,
+		Runtime::CodegenMode codegenMode = Runtime::CodegenMode::optimized);
 
 	extern void processSEHTables(U8* imageBase,
 								 const llvm::LoadedObjectInfo& loadedObject,
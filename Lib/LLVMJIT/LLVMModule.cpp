@@ -65,7 +65,7 @@ using namespace WAVM::LLVMJIT;
 static Platform::Mutex gdbRegistrationListenerMutex;
 static llvm::JITEventListener* gdbRegistrationListener = nullptr;
 
-// A map from address to loaded JIT symbols.
+// A map from the end of each loaded JIT module's code to the module.
 static Platform::Mutex addressToModuleMapMutex;
 static std::map<Uptr, LLVMJIT::Module*> addressToModuleMap;
 
@@ -78,6 +78,7 @@ struct LLVMJIT::ModuleMemoryManager : llvm::RTDyldMemoryManager
 	, codeSection({nullptr, 0, 0})
 	, readOnlySection({nullptr, 0, 0})
 	, readWriteSection({nullptr, 0, 0})
+	, isInImageArena(false)
 	, hasRegisteredEHFrames(false)
 	{
 	}
@@ -86,7 +87,23 @@ struct LLVMJIT::ModuleMemoryManager : llvm::RTDyldMemoryManager
 		// Deregister the exception handling frame info.
 		deregisterEHFrames();
 
-		if(!KEEP_UNLOADED_MODULE_ADDRESSES_RESERVED)
+		if(isInImageArena)
+		{
+			// Return the code and data pages to the shared image arena.
+			const Uptr numDataPages = readOnlySection.numPages + readWriteSection.numPages;
+			if(KEEP_UNLOADED_MODULE_ADDRESSES_RESERVED)
+			{
+				Platform::decommitVirtualPages(codeSection.baseAddress, codeSection.numPages);
+				if(numDataPages)
+				{ Platform::decommitVirtualPages(readOnlySection.baseAddress, numDataPages); }
+			}
+			else
+			{
+				freeImageArenaPages(codeSection.baseAddress, codeSection.numPages);
+				if(numDataPages) { freeImageArenaPages(readOnlySection.baseAddress, numDataPages); }
+			}
+		}
+		else if(!KEEP_UNLOADED_MODULE_ADDRESSES_RESERVED)
 		{ Platform::freeVirtualPages(imageBaseAddress, numAllocatedImagePages); }
 		else
 		{
@@ -142,6 +159,12 @@ struct LLVMJIT::ModuleMemoryManager : llvm::RTDyldMemoryManager
 		readWriteSection.numPages = shrAndRoundUp(numReadWriteBytes, Platform::getPageSizeLog2());
 		numAllocatedImagePages
 			= codeSection.numPages + readOnlySection.numPages + readWriteSection.numPages;
+
+		// If code huge pages are enabled, try to allocate the sections from the shared image arena.
+		// The Windows unwind tables use 32-bit offsets from the image base to both the code and
+		// data sections, so they must be in a single allocation.
+		if(!USE_WINDOWS_SEH && codeSection.numPages && allocateSectionsFromImageArena()) { return; }
+
 		if(numAllocatedImagePages)
 		{
 			// Reserve enough contiguous pages for all sections.
@@ -208,13 +231,17 @@ struct LLVMJIT::ModuleMemoryManager : llvm::RTDyldMemoryManager
 	}
 	virtual void invalidateInstructionCache()
 	{
-		// Invalidate the instruction cache for the whole image.
+		// Invalidate the instruction cache for the code section.
 		llvm::sys::Memory::InvalidateInstructionCache(
-			imageBaseAddress, numAllocatedImagePages << Platform::getPageSizeLog2());
+			codeSection.baseAddress, codeSection.numPages << Platform::getPageSizeLog2());
 	}
 
 	U8* getImageBaseAddress() const { return imageBaseAddress; }
-	Uptr getNumImageBytes() const { return numAllocatedImagePages << Platform::getPageSizeLog2(); }
+	Uptr getCodeEndAddress() const
+	{
+		return reinterpret_cast<Uptr>(codeSection.baseAddress
+									  + (codeSection.numPages << Platform::getPageSizeLog2()));
+	}
 
 private:
 	struct Section
@@ -232,10 +259,40 @@ private:
 	Section readOnlySection;
 	Section readWriteSection;
 
+	// True if the sections were allocated from the shared image arena instead of a contiguous
+	// image allocation. If so, imageBaseAddress is null.
+	bool isInImageArena;
+
 	bool hasRegisteredEHFrames;
 	const U8* ehFramesAddr;
 	Uptr ehFramesNumBytes;
 
+	bool allocateSectionsFromImageArena()
+	{
+		codeSection.baseAddress = allocateImageArenaPages(codeSection.numPages, true);
+		if(!codeSection.baseAddress) { return false; }
+
+		// Allocate the read-only and read-write sections contiguously in the arena's data pages.
+		// If there are no data pages, the empty data sections start at the end of the code.
+		const Uptr numDataPages = readOnlySection.numPages + readWriteSection.numPages;
+		readOnlySection.baseAddress = reinterpret_cast<U8*>(getCodeEndAddress());
+		if(numDataPages)
+		{
+			readOnlySection.baseAddress = allocateImageArenaPages(numDataPages, false);
+			if(!readOnlySection.baseAddress)
+			{
+				freeImageArenaPages(codeSection.baseAddress, codeSection.numPages);
+				codeSection.baseAddress = nullptr;
+				return false;
+			}
+		}
+		readWriteSection.baseAddress = readOnlySection.baseAddress
+									   + (readOnlySection.numPages << Platform::getPageSizeLog2());
+
+		isInImageArena = true;
+		return true;
+	}
+
 	U8* allocateBytes(Uptr numBytes, Uptr alignment, Section& section)
 	{
 		if(alignment == 0) { alignment = 1; }
@@ -562,8 +619,7 @@ Module::Module(const std::vector<U8>& objectBytes,
 		function->mutableData->offsetToOpIndexMap = std::move(std::move(offsetToOpIndexMap));
 	}
 
-	const Uptr moduleEndAddress = reinterpret_cast<Uptr>(memoryManager->getImageBaseAddress()
-														 + memoryManager->getNumImageBytes());
+	const Uptr moduleEndAddress = memoryManager->getCodeEndAddress();
 	{
 		Lock<Platform::Mutex> addressToModuleMapLock(addressToModuleMapMutex);
 		addressToModuleMap.emplace(moduleEndAddress, this);
@@ -590,8 +646,7 @@ Module::~Module()
 
 	// Remove the module from the global address to module map.
 	Lock<Platform::Mutex> addressToModuleMapLock(addressToModuleMapMutex);
-	addressToModuleMap.erase(addressToModuleMap.find(reinterpret_cast<Uptr>(
-		memoryManager->getImageBaseAddress() + memoryManager->getNumImageBytes())));
+	addressToModuleMap.erase(addressToModuleMap.find(memoryManager->getCodeEndAddress()));
 
 	// Free the FunctionMutableData objects.
 	for(const auto& pair : addressToFunctionMap) { delete pair.second->mutableData; }
@@ -655,6 +710,10 @@ std::shared_ptr<LLVMJIT::Module> LLVMJIT::loadModule(
 		importedSymbolMap.addOrFail(getExternalName("memoryOffset", memoryIndex),
 									offsetof(Runtime::CompartmentRuntimeData, memoryBases)
 										+ sizeof(void*) * memories[memoryIndex].id);
+
+		// Code compiled with explicit bounds checks uses this symbol's value as the bound.
+		importedSymbolMap.addOrFail(getExternalName("memoryNumReservedBytes", memoryIndex),
+									memories[memoryIndex].numReservedBytes);
 	}
 
 	// Bind the globals symbols.
@@ -2,6 +2,7 @@
 #include <pthread.h>
 #include <sys/time.h>
 
+#include "POSIXPrivate.h"
 #include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/Errors.h"
 #include "WAVM/Inline/I128.h"
@@ -28,10 +29,13 @@ Platform::Event::Event()
 	errorUnless(!pthread_condattr_setclock(&conditionVariableAttr, CLOCK_MONOTONIC));
 #endif
 
-	errorUnless(!pthread_cond_init((pthread_cond_t*)&pthreadCond, nullptr));
+	errorUnless(!pthread_cond_init((pthread_cond_t*)&pthreadCond, &conditionVariableAttr));
 	errorUnless(!pthread_mutex_init((pthread_mutex_t*)&pthreadMutex, nullptr));
 
 	errorUnless(!pthread_condattr_destroy(&conditionVariableAttr));
+
+	isSignaled = false;
+	waitingGreenThread = nullptr;
 }
 
 Platform::Event::~Event()
@@ -42,43 +46,81 @@ Platform::Event::~Event()
 
 bool Platform::Event::wait(I128 waitDuration)
 {
-	errorUnless(!pthread_mutex_lock((pthread_mutex_t*)&pthreadMutex));
+	pthread_mutex_t* mutex = (pthread_mutex_t*)&pthreadMutex;
+	pthread_cond_t* cond = (pthread_cond_t*)&pthreadCond;
+	errorUnless(!pthread_mutex_lock(mutex));
 
-	int result;
-	if(waitDuration == I128::nan())
+	bool result;
+	if(isSignaled) { result = true; }
+	else if(GreenThread* greenThread = getCurrentGreenThread())
+	{
+		// Suspend the green thread until signal wakes it, or the wait times out.
+		wavmAssert(!waitingGreenThread);
+		waitingGreenThread = greenThread;
+		suspendGreenThread(
+			mutex, isNaN(waitDuration) ? I128::nan() : getMonotonicClock() + waitDuration);
+		errorUnless(!pthread_mutex_lock(mutex));
+
+		// signal clears waitingGreenThread before it wakes the green thread, so if the green thread
+		// is still waiting, it was woken because the wait timed out.
+		result = waitingGreenThread != greenThread;
+		if(!result) { waitingGreenThread = nullptr; }
+	}
+	else if(isNaN(waitDuration))
 	{
-		result = pthread_cond_wait((pthread_cond_t*)&pthreadCond, (pthread_mutex_t*)&pthreadMutex);
+		while(!isSignaled) { errorUnless(!pthread_cond_wait(cond, mutex)); }
+		result = true;
 	}
 	else
 	{
-		// Use the non-POSIX relative time wait on Mac, and an absolute monotonic clock timeout on
-		// other POSIX systems.
+		const I128 untilTime = getMonotonicClock() + waitDuration;
+		while(!isSignaled)
+		{
+			// Use the non-POSIX relative time wait on Mac, and an absolute monotonic clock timeout
+			// on other POSIX systems.
 #ifdef __APPLE__
-		timespec waitTimeSpec;
-		waitTimeSpec.tv_sec = U64(waitDuration / 1000000000);
-		waitTimeSpec.tv_nsec = U64(waitDuration % 1000000000);
-
-		result = pthread_cond_timedwait_relative_np(
-			(pthread_cond_t*)&pthreadCond, (pthread_mutex_t*)&pthreadMutex, &waitTimeSpec);
+			const I128 currentTime = getMonotonicClock();
+			if(currentTime >= untilTime) { break; }
+			timespec waitTimeSpec;
+			waitTimeSpec.tv_sec = U64((untilTime - currentTime) / 1000000000);
+			waitTimeSpec.tv_nsec = U64((untilTime - currentTime) % 1000000000);
+
+			const int waitResult
+				= pthread_cond_timedwait_relative_np(cond, mutex, &waitTimeSpec);
 #else
-		const I128 untilTime = getMonotonicClock() + waitDuration;
-		timespec untilTimeSpec;
-		untilTimeSpec.tv_sec = U64(untilTime / 1000000000);
-		untilTimeSpec.tv_nsec = U64(untilTime % 1000000000);
+			timespec untilTimeSpec;
+			untilTimeSpec.tv_sec = U64(untilTime / 1000000000);
+			untilTimeSpec.tv_nsec = U64(untilTime % 1000000000);
 
-		result = pthread_cond_timedwait(
-			(pthread_cond_t*)&pthreadCond, (pthread_mutex_t*)&pthreadMutex, &untilTimeSpec);
+			const int waitResult = pthread_cond_timedwait(cond, mutex, &untilTimeSpec);
 #endif
+			if(waitResult == ETIMEDOUT) { break; }
+			errorUnless(!waitResult);
+		}
+		result = isSignaled;
 	}
+	isSignaled = false;
 
-	errorUnless(!pthread_mutex_unlock((pthread_mutex_t*)&pthreadMutex));
+	errorUnless(!pthread_mutex_unlock(mutex));
+	return result;
+}
 
-	if(result == ETIMEDOUT) { return false; }
+void Platform::Event::signal()
+{
+	pthread_mutex_t* mutex = (pthread_mutex_t*)&pthreadMutex;
+	errorUnless(!pthread_mutex_lock(mutex));
+
+	if(waitingGreenThread)
+	{
+		GreenThread* greenThread = waitingGreenThread;
+		waitingGreenThread = nullptr;
+		wakeGreenThread(greenThread);
+	}
 	else
 	{
-		errorUnless(!result);
-		return true;
+		isSignaled = true;
+		errorUnless(!pthread_cond_signal((pthread_cond_t*)&pthreadCond));
 	}
-}
 
-void Platform::Event::signal() { errorUnless(!pthread_cond_signal((pthread_cond_t*)&pthreadCond)); }
+	errorUnless(!pthread_mutex_unlock(mutex));
+}
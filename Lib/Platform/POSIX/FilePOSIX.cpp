@@ -2,21 +2,42 @@
 #define _FILE_OFFSET_BITS 64
 #endif
 
+#include <inttypes.h>
+#include <algorithm>
+#include <atomic>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#endif
+#endif
 
 #include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/HashMap.h"
 #include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Lock.h"
+#include "WAVM/Platform/Clock.h"
 #include "WAVM/Platform/File.h"
+#include "WAVM/Platform/Memory.h"
+#include "WAVM/Platform/Mutex.h"
 #include "WAVM/VFS/VFS.h"
 
 #define FILE_OFFSET_IS_64BIT (sizeof(off_t) == 8)
@@ -71,6 +92,7 @@ static Result asVFSResult(int error)
 	case EBUSY: return Result::busy;
 	case ENOTEMPTY: return Result::isNotEmpty;
 	case EMLINK: return Result::outOfLinksToParentDir;
+	case EXDEV: return Result::notAccessible;
 
 	case EINVAL:
 		// This probably needs to be handled differently for each API entry point.
@@ -537,6 +559,9 @@ struct POSIXFD : VFD
 		outStream = new POSIXDirEntStream(dir);
 		return Result::success;
 	}
+
+	virtual I32 getPollableHostFD() override { return fd; }
+	virtual I32 getMappableHostFD() override { return fd; }
 };
 
 struct POSIXStdFD : POSIXFD
@@ -597,13 +622,11 @@ protected:
 
 PLATFORM_API HostFS& Platform::getHostFS() { return POSIXFS::get(); }
 
-Result POSIXFS::open(const std::string& path,
-					 FileAccessMode accessMode,
-					 FileCreateMode createMode,
-					 VFD*& outFD,
-					 const VFDFlags& vfsFlags)
+static I32 getOpenFlags(FileAccessMode accessMode,
+						FileCreateMode createMode,
+						const VFDFlags& vfsFlags)
 {
-	U32 flags = 0;
+	I32 flags = 0;
 	switch(accessMode)
 	{
 	case FileAccessMode::none: flags = O_RDONLY; break;
@@ -623,11 +646,40 @@ Result POSIXFS::open(const std::string& path,
 	default: WAVM_UNREACHABLE();
 	};
 
-	mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+	return flags | translateVFDFlags(vfsFlags);
+}
 
-	flags |= translateVFDFlags(vfsFlags);
+static const mode_t createFileMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
 
-	const I32 fd = ::open(path.c_str(), flags, mode);
+static void getFileTimespecs(bool setLastAccessTime,
+							 I128 lastAccessTime,
+							 bool setLastWriteTime,
+							 I128 lastWriteTime,
+							 struct timespec outTimespecs[2])
+{
+	if(!setLastAccessTime) { outTimespecs[0].tv_nsec = UTIME_OMIT; }
+	else
+	{
+		outTimespecs[0].tv_sec = U64(lastAccessTime / 1000000000);
+		outTimespecs[0].tv_nsec = U32(lastAccessTime % 1000000000);
+	}
+
+	if(!setLastWriteTime) { outTimespecs[1].tv_nsec = UTIME_OMIT; }
+	else
+	{
+		outTimespecs[1].tv_sec = U64(lastWriteTime / 1000000000);
+		outTimespecs[1].tv_nsec = U32(lastWriteTime % 1000000000);
+	}
+}
+
+Result POSIXFS::open(const std::string& path,
+					 FileAccessMode accessMode,
+					 FileCreateMode createMode,
+					 VFD*& outFD,
+					 const VFDFlags& vfsFlags)
+{
+	const I32 flags = getOpenFlags(accessMode, createMode, vfsFlags);
+	const I32 fd = ::open(path.c_str(), flags, createFileMode);
 	if(fd == -1) { return asVFSResult(errno); }
 
 	outFD = new POSIXFD(fd);
@@ -651,20 +703,7 @@ Result POSIXFS::setFileTimes(const std::string& path,
 							 I128 lastWriteTime)
 {
 	struct timespec timespecs[2];
-
-	if(!setLastAccessTime) { timespecs[0].tv_nsec = UTIME_OMIT; }
-	else
-	{
-		timespecs[0].tv_sec = U64(lastAccessTime / 1000000000);
-		timespecs[0].tv_nsec = U32(lastAccessTime % 1000000000);
-	}
-
-	if(!setLastWriteTime) { timespecs[1].tv_nsec = UTIME_OMIT; }
-	else
-	{
-		timespecs[1].tv_sec = U64(lastWriteTime / 1000000000);
-		timespecs[1].tv_nsec = U32(lastWriteTime % 1000000000);
-	}
+	getFileTimespecs(setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime, timespecs);
 
 	return utimensat(AT_FDCWD, path.c_str(), timespecs, 0) == 0 ? Result::success
 																: asVFSResult(errno);
@@ -694,6 +733,502 @@ Result POSIXFS::createDir(const std::string& path)
 	return !mkdir(path.c_str(), 0666) ? Result::success : asVFSResult(errno);
 }
 
+#if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+#define HAS_OPENAT2 1
+#else
+#define HAS_OPENAT2 0
+#endif
+
+#ifdef O_PATH
+#define OPEN_DIR_PATH_FLAGS (O_PATH | O_DIRECTORY | O_CLOEXEC)
+#else
+#define OPEN_DIR_PATH_FLAGS (O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+#endif
+
+#if HAS_OPENAT2
+// Set if the kernel doesn't support openat2, so it isn't tried again.
+static std::atomic<bool> isOpenat2Unsupported{false};
+
+// Opens a path relative to dirFD with openat2, failing if the path resolves to a file that isn't
+// beneath dirFD. Returns -2 if the kernel doesn't support openat2.
+static I32 openBeneath(I32 dirFD, const char* path, I32 flags, mode_t mode)
+{
+	if(isOpenat2Unsupported.load(std::memory_order_relaxed)) { return -2; }
+
+	open_how how{};
+	how.flags = U64(flags);
+	how.mode = (flags & O_CREAT) ? mode : 0;
+	how.resolve = RESOLVE_BENEATH;
+	const long fd = syscall(SYS_openat2, dirFD, path, &how, sizeof(how));
+	if(fd < 0 && errno == ENOSYS)
+	{
+		isOpenat2Unsupported.store(true, std::memory_order_relaxed);
+		return -2;
+	}
+	return I32(fd);
+}
+#else
+static I32 openBeneath(I32 dirFD, const char* path, I32 flags, mode_t mode) { return -2; }
+#endif
+
+// A filesystem that resolves paths beneath a host directory. Rather than concatenating each path
+// with the root directory's path and resolving it from /, it resolves paths relative to an FD for
+// the root directory with openat2(RESOLVE_BENEATH), which also prevents symbolic links from
+// escaping the root. Without openat2, or if symbolic links shouldn't be followed, paths are
+// resolved a component at a time with openat, and symbolic links aren't followed.
+//
+// The FDs of recently used parent directories are kept in a small LRU cache, so operations on
+// files in the same directory only resolve the file's name. Directories that are removed by this
+// filesystem are evicted from the cache, but if another process renames or removes a cached
+// directory, paths beneath it will keep resolving to the directory's old location.
+struct POSIXSandboxFS : FileSystem
+{
+	POSIXSandboxFS(I32 inRootFD, bool inFollowSymbolicLinks)
+	: rootFD(inRootFD), followSymbolicLinks(inFollowSymbolicLinks)
+	{
+	}
+
+	~POSIXSandboxFS()
+	{
+		for(CachedDirFD& cachedDirFD : cachedDirFDs)
+		{
+			wavmAssert(!cachedDirFD.numUsers);
+			if(cachedDirFD.fd >= 0) { close(cachedDirFD.fd); }
+		}
+		close(rootFD);
+	}
+
+	virtual Result open(const std::string& path,
+						FileAccessMode accessMode,
+						FileCreateMode createMode,
+						VFD*& outFD,
+						const VFDFlags& vfsFlags = VFDFlags{}) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		const I32 fd
+			= openLeaf(parentDir, path, getOpenFlags(accessMode, createMode, vfsFlags));
+		if(fd < 0) { return asVFSResult(errno); }
+
+		outFD = new POSIXFD(fd);
+		return Result::success;
+	}
+
+	virtual Result getFileInfo(const std::string& path, FileInfo& outInfo) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		struct stat fileStatus;
+		if(fstatat(parentDir.fd, parentDir.leafName.c_str(), &fileStatus, AT_SYMLINK_NOFOLLOW))
+		{ return asVFSResult(errno); }
+
+		// If the file is a symbolic link, get the info for the file it refers to, as long as it
+		// is beneath the root.
+		if(S_ISLNK(fileStatus.st_mode))
+		{
+			const I32 fd = openLeaf(parentDir, path, OPEN_DIR_PATH_FLAGS & ~O_DIRECTORY);
+			if(fd >= 0)
+			{
+				const int statResult = fstat(fd, &fileStatus);
+				close(fd);
+				if(statResult) { return asVFSResult(errno); }
+			}
+		}
+
+		getFileInfoFromStatus(fileStatus, outInfo);
+		return Result::success;
+	}
+
+	virtual Result setFileTimes(const std::string& path,
+								bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		// Don't follow a symbolic link, since it could refer to a file outside the root.
+		struct timespec timespecs[2];
+		getFileTimespecs(
+			setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime, timespecs);
+		return !utimensat(
+				   parentDir.fd, parentDir.leafName.c_str(), timespecs, AT_SYMLINK_NOFOLLOW)
+				   ? Result::success
+				   : asVFSResult(errno);
+	}
+
+	virtual Result openDir(const std::string& path, DirEntStream*& outStream) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		const I32 fd = openLeaf(parentDir, path, O_RDONLY | O_DIRECTORY);
+		if(fd < 0) { return asVFSResult(errno); }
+
+		DIR* dir = fdopendir(fd);
+		if(!dir)
+		{
+			const int error = errno;
+			close(fd);
+			return asVFSResult(error);
+		}
+
+		outStream = new POSIXDirEntStream(dir);
+		return Result::success;
+	}
+
+	virtual Result unlinkFile(const std::string& path) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		return !unlinkat(parentDir.fd, parentDir.leafName.c_str(), 0) ? Result::success
+																		: asVFSResult(errno);
+	}
+
+	virtual Result removeDir(const std::string& path) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		if(unlinkat(parentDir.fd, parentDir.leafName.c_str(), AT_REMOVEDIR))
+		{ return asVFSResult(errno); }
+
+		evictCachedDirFDs(path);
+		return Result::success;
+	}
+
+	virtual Result createDir(const std::string& path) override
+	{
+		ParentDir parentDir(this);
+		Result result = parentDir.lookup(path);
+		if(result != Result::success) { return result; }
+
+		return !mkdirat(parentDir.fd, parentDir.leafName.c_str(), 0666) ? Result::success
+																		 : asVFSResult(errno);
+	}
+
+private:
+	static constexpr Uptr numCachedDirFDs = 16;
+
+	struct CachedDirFD
+	{
+		// The path of the directory relative to the root, without leading or trailing slashes.
+		std::string path;
+		I32 fd = -1;
+		U64 lastUseTime = 0;
+
+		// The number of ParentDirs using the FD. The FD isn't closed until it has no users.
+		Uptr numUsers = 0;
+		bool isEvicted = false;
+	};
+
+	// The FD of the directory containing a path's last component, and the name of the component.
+	struct ParentDir
+	{
+		I32 fd = -1;
+		std::string leafName;
+
+		ParentDir(POSIXSandboxFS* inFS) : fs(inFS) {}
+		~ParentDir()
+		{
+			if(cachedDirFD) { fs->releaseCachedDirFD(cachedDirFD); }
+			else if(fd >= 0 && fd != fs->rootFD)
+			{
+				close(fd);
+			}
+		}
+
+		Result lookup(const std::string& path)
+		{
+			// Split the path into the parent directory and the leaf name, ignoring leading and
+			// trailing slashes. The root directory is its own parent, with the leaf name ".".
+			Uptr begin = 0;
+			Uptr end = path.size();
+			while(begin < end && path[begin] == '/') { ++begin; };
+			while(end > begin && path[end - 1] == '/') { --end; };
+			if(begin == end)
+			{
+				fd = fs->rootFD;
+				leafName = ".";
+				return Result::success;
+			}
+
+			Uptr leafBegin = end;
+			while(leafBegin > begin && path[leafBegin - 1] != '/') { --leafBegin; };
+			leafName.assign(path, leafBegin, end - leafBegin);
+			if(leafName == "..") { return Result::notAccessible; }
+
+			Uptr parentEnd = leafBegin;
+			while(parentEnd > begin && path[parentEnd - 1] == '/') { --parentEnd; };
+			if(parentEnd == begin)
+			{
+				fd = fs->rootFD;
+				return Result::success;
+			}
+
+			return fs->getDirFD(path.data() + begin, parentEnd - begin, fd, cachedDirFD);
+		}
+
+	private:
+		POSIXSandboxFS* fs;
+		CachedDirFD* cachedDirFD = nullptr;
+	};
+
+	const I32 rootFD;
+	const bool followSymbolicLinks;
+
+	Platform::Mutex cachedDirFDsMutex;
+	CachedDirFD cachedDirFDs[numCachedDirFDs];
+	U64 nextUseTime = 1;
+
+	// Calls openBeneath if symbolic links should be followed, or returns -2 as if the kernel
+	// doesn't support openat2.
+	I32 openBeneathIfFollowingLinks(I32 dirFD, const char* path, I32 flags, mode_t mode)
+	{
+		return followSymbolicLinks ? openBeneath(dirFD, path, flags, mode) : -2;
+	}
+
+	// Opens the last component of a path. If openat2 is supported, symbolic links are followed if
+	// they refer to a file beneath the root.
+	I32 openLeaf(const ParentDir& parentDir, const std::string& path, I32 flags)
+	{
+		I32 fd = openBeneathIfFollowingLinks(
+			parentDir.fd, parentDir.leafName.c_str(), flags, createFileMode);
+		if(fd == -1 && errno == EXDEV)
+		{
+			// The leaf is a symbolic link to a file outside its parent directory, so resolve the
+			// whole path beneath the root instead.
+			Uptr begin = 0;
+			while(begin < path.size() && path[begin] == '/') { ++begin; };
+			fd = openBeneathIfFollowingLinks(rootFD, path.c_str() + begin, flags, createFileMode);
+		}
+		else if(fd == -2)
+		{
+			fd = openat(
+				parentDir.fd, parentDir.leafName.c_str(), flags | O_NOFOLLOW, createFileMode);
+		}
+		return fd;
+	}
+
+	// Resolves a directory path relative to the root directory, without a cache.
+	Result resolveDir(const std::string& dirPath, I32& outFD)
+	{
+		outFD = openBeneathIfFollowingLinks(rootFD, dirPath.c_str(), OPEN_DIR_PATH_FLAGS, 0);
+		if(outFD >= 0) { return Result::success; }
+		else if(outFD == -1)
+		{
+			return asVFSResult(errno);
+		}
+
+		// Without openat2, open each component of the path in turn, and don't follow symbolic
+		// links, which could refer to a directory outside the root.
+		I32 dirFD = rootFD;
+		Uptr componentBegin = 0;
+		while(componentBegin < dirPath.size())
+		{
+			Uptr componentEnd = dirPath.find('/', componentBegin);
+			if(componentEnd == std::string::npos) { componentEnd = dirPath.size(); }
+
+			const std::string component
+				= dirPath.substr(componentBegin, componentEnd - componentBegin);
+			componentBegin = componentEnd + 1;
+			if(component.empty() || component == ".") { continue; }
+
+			I32 nextDirFD = -1;
+			int error = EXDEV;
+			if(component != "..")
+			{
+				nextDirFD = openat(dirFD, component.c_str(), OPEN_DIR_PATH_FLAGS | O_NOFOLLOW);
+				error = errno;
+			}
+			if(dirFD != rootFD) { close(dirFD); }
+			if(nextDirFD < 0) { return asVFSResult(error); }
+			dirFD = nextDirFD;
+		};
+
+		outFD = dirFD;
+		return Result::success;
+	}
+
+	// Gets an FD for a directory relative to the root directory from the cache, or resolves it and
+	// adds it to the cache.
+	Result getDirFD(const char* dirPath,
+					Uptr numDirPathChars,
+					I32& outFD,
+					CachedDirFD*& outCachedDirFD)
+	{
+		{
+			Lock<Platform::Mutex> cachedDirFDsLock(cachedDirFDsMutex);
+			for(CachedDirFD& cachedDirFD : cachedDirFDs)
+			{
+				if(cachedDirFD.fd >= 0 && !cachedDirFD.isEvicted
+				   && cachedDirFD.path.size() == numDirPathChars
+				   && !memcmp(cachedDirFD.path.data(), dirPath, numDirPathChars))
+				{
+					++cachedDirFD.numUsers;
+					cachedDirFD.lastUseTime = nextUseTime++;
+					outFD = cachedDirFD.fd;
+					outCachedDirFD = &cachedDirFD;
+					return Result::success;
+				}
+			}
+		}
+
+		std::string dirPathString(dirPath, numDirPathChars);
+		I32 fd = -1;
+		Result result = resolveDir(dirPathString, fd);
+		if(result != Result::success) { return result; }
+
+		// Replace the least recently used entry that isn't in use. If every entry is in use, the
+		// FD is just closed when the caller is done with it.
+		Lock<Platform::Mutex> cachedDirFDsLock(cachedDirFDsMutex);
+		CachedDirFD* replacedDirFD = nullptr;
+		for(CachedDirFD& cachedDirFD : cachedDirFDs)
+		{
+			if(!cachedDirFD.numUsers
+			   && (!replacedDirFD || cachedDirFD.lastUseTime < replacedDirFD->lastUseTime))
+			{ replacedDirFD = &cachedDirFD; }
+		}
+
+		outFD = fd;
+		outCachedDirFD = nullptr;
+		if(replacedDirFD)
+		{
+			if(replacedDirFD->fd >= 0) { close(replacedDirFD->fd); }
+			replacedDirFD->path = std::move(dirPathString);
+			replacedDirFD->fd = fd;
+			replacedDirFD->lastUseTime = nextUseTime++;
+			replacedDirFD->numUsers = 1;
+			replacedDirFD->isEvicted = false;
+			outCachedDirFD = replacedDirFD;
+		}
+		return Result::success;
+	}
+
+	void releaseCachedDirFD(CachedDirFD* cachedDirFD)
+	{
+		Lock<Platform::Mutex> cachedDirFDsLock(cachedDirFDsMutex);
+		wavmAssert(cachedDirFD->numUsers);
+		if(!--cachedDirFD->numUsers && cachedDirFD->isEvicted) { closeCachedDirFD(*cachedDirFD); }
+	}
+
+	void closeCachedDirFD(CachedDirFD& cachedDirFD)
+	{
+		close(cachedDirFD.fd);
+		cachedDirFD.fd = -1;
+		cachedDirFD.path.clear();
+		cachedDirFD.lastUseTime = 0;
+		cachedDirFD.isEvicted = false;
+	}
+
+	// Evicts a removed directory and any directories beneath it from the cache.
+	void evictCachedDirFDs(const std::string& path)
+	{
+		Uptr begin = 0;
+		Uptr end = path.size();
+		while(begin < end && path[begin] == '/') { ++begin; };
+		while(end > begin && path[end - 1] == '/') { --end; };
+		const Uptr numPathChars = end - begin;
+
+		Lock<Platform::Mutex> cachedDirFDsLock(cachedDirFDsMutex);
+		for(CachedDirFD& cachedDirFD : cachedDirFDs)
+		{
+			if(cachedDirFD.fd >= 0 && cachedDirFD.path.size() >= numPathChars
+			   && !memcmp(cachedDirFD.path.data(), path.data() + begin, numPathChars)
+			   && (cachedDirFD.path.size() == numPathChars
+				   || cachedDirFD.path[numPathChars] == '/'))
+			{
+				if(cachedDirFD.numUsers) { cachedDirFD.isEvicted = true; }
+				else
+				{
+					closeCachedDirFD(cachedDirFD);
+				}
+			}
+		}
+	}
+};
+
+FileSystem* Platform::openHostSandboxFS(const std::string& rootPath, bool followSymbolicLinks)
+{
+	const I32 rootFD = ::open(rootPath.c_str(), OPEN_DIR_PATH_FLAGS);
+	if(rootFD < 0) { return nullptr; }
+	return new POSIXSandboxFS(rootFD, followSymbolicLinks);
+}
+
+Result Platform::mapFilePages(VFD* vfd, U64 offset, U8* baseAddress, Uptr numPages)
+{
+	const Uptr pageSizeLog2 = getPageSizeLog2();
+	const Uptr pageSize = Uptr(1) << pageSizeLog2;
+	wavmAssert(!(reinterpret_cast<Uptr>(baseAddress) & (pageSize - 1)));
+	if(offset & (pageSize - 1)) { return Result::invalidOffset; }
+
+	const I32 fd = vfd->getMappableHostFD();
+	if(fd < 0) { return Result::notPermitted; }
+
+	struct stat fileStatus;
+	if(fstat(fd, &fileStatus)) { return asVFSResult(errno); }
+	if(!S_ISREG(fileStatus.st_mode)) { return Result::notPermitted; }
+
+	// Accessing a mapped page that is entirely beyond the end of the file raises SIGBUS, so only
+	// map the pages that contain part of the file.
+	const U64 numFileBytes
+		= U64(fileStatus.st_size) > offset ? U64(fileStatus.st_size) - offset : 0;
+	const Uptr numFilePages
+		= Uptr(std::min(U64(numPages), (numFileBytes + pageSize - 1) >> pageSizeLog2));
+	if(numFilePages
+	   && mmap(baseAddress,
+			   numFilePages << pageSizeLog2,
+			   PROT_READ | PROT_WRITE,
+			   MAP_FIXED | MAP_PRIVATE,
+			   fd,
+			   off_t(offset))
+			  == MAP_FAILED)
+	{
+		switch(errno)
+		{
+		case EACCES:
+		case ENODEV: return Result::notPermitted;
+		case EINVAL:
+		case EOVERFLOW: return Result::invalidOffset;
+		default: return asVFSResult(errno);
+		};
+	}
+
+	if(numFilePages < numPages)
+	{
+		unmapFilePages(baseAddress + (numFilePages << pageSizeLog2), numPages - numFilePages);
+	}
+	return Result::success;
+}
+
+void Platform::unmapFilePages(U8* baseAddress, Uptr numPages)
+{
+	const Uptr numBytes = numPages << getPageSizeLog2();
+	if(mmap(baseAddress,
+			numBytes,
+			PROT_READ | PROT_WRITE,
+			MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0)
+	   == MAP_FAILED)
+	{
+		Errors::fatalf("Unmapping file pages at 0x%" PRIxPTR "-0x%" PRIxPTR " failed: %s",
+					   reinterpret_cast<Uptr>(baseAddress),
+					   reinterpret_cast<Uptr>(baseAddress) + numBytes,
+					   strerror(errno));
+	}
+}
+
 std::string Platform::getCurrentWorkingDirectory()
 {
 	const Uptr maxPathBytes = pathconf(".", _PC_PATH_MAX);
@@ -701,3 +1236,260 @@ std::string Platform::getCurrentWorkingDirectory()
 	errorUnless(getcwd(buffer, maxPathBytes) == buffer);
 	return std::string(buffer);
 }
+
+#ifdef __linux__
+// The poller keeps the merged events of each host FD as poll(2) flags, and passes them directly to
+// epoll.
+static_assert(POLLIN == EPOLLIN && POLLOUT == EPOLLOUT && POLLERR == EPOLLERR
+				  && POLLHUP == EPOLLHUP,
+			  "poll flags must match epoll flags");
+#define POLL_READ_EVENTS (POLLIN | EPOLLRDHUP)
+#define POLL_HANGUP_EVENTS (POLLHUP | EPOLLRDHUP)
+#else
+#define POLL_READ_EVENTS POLLIN
+#define POLL_HANGUP_EVENTS POLLHUP
+#endif
+
+struct POSIXPoller : Poller
+{
+	POSIXPoller()
+	{
+#ifdef __linux__
+		epollFD = epoll_create1(EPOLL_CLOEXEC);
+		errorUnless(epollFD >= 0);
+
+		// The timerfd is registered with the epoll set once, and armed for each timed wait.
+		timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		errorUnless(timerFD >= 0);
+		epoll_event timerEvent{};
+		timerEvent.events = EPOLLIN;
+		timerEvent.data.fd = timerFD;
+		errorUnless(!epoll_ctl(epollFD, EPOLL_CTL_ADD, timerFD, &timerEvent));
+#endif
+	}
+
+	~POSIXPoller()
+	{
+#ifdef __linux__
+		close(timerFD);
+		close(epollFD);
+#endif
+	}
+
+	virtual Result wait(const PollSubscription* subscriptions,
+						Uptr numSubscriptions,
+						I128 deadline,
+						PollEvent* outEvents) override
+	{
+		// Merge the subscriptions to each host FD. VFDs without a host FD never block, so they are
+		// immediately ready.
+		bool hasReadySubscription = false;
+		requestedEvents.clear();
+		for(Uptr subscriptionIndex = 0; subscriptionIndex < numSubscriptions; ++subscriptionIndex)
+		{
+			const PollSubscription& subscription = subscriptions[subscriptionIndex];
+			outEvents[subscriptionIndex] = PollEvent{false, false, 0};
+
+			const I32 fd = subscription.vfd->getPollableHostFD();
+			if(fd < 0)
+			{
+				outEvents[subscriptionIndex].isReady = true;
+				hasReadySubscription = true;
+			}
+			else
+			{
+				requestedEvents.getOrAdd(fd, I16(0))
+					|= subscription.type == PollEventType::read ? POLL_READ_EVENTS : POLLOUT;
+			}
+		}
+
+		// Wait for the host FDs, but don't block if a subscription is already ready.
+		readyEvents.clear();
+		Result result = waitForHostFDs(hasReadySubscription ? I128(0) : deadline);
+		if(result != Result::success) { return result; }
+
+		for(Uptr subscriptionIndex = 0; subscriptionIndex < numSubscriptions; ++subscriptionIndex)
+		{
+			const PollSubscription& subscription = subscriptions[subscriptionIndex];
+			const I32 fd = subscription.vfd->getPollableHostFD();
+			const I16* events = fd >= 0 ? readyEvents.get(fd) : nullptr;
+			if(!events) { continue; }
+
+			PollEvent& event = outEvents[subscriptionIndex];
+			if(subscription.type == PollEventType::read)
+			{
+				event.isReady = *events & (POLL_READ_EVENTS | POLLHUP | POLLERR);
+				int numBytes = 0;
+				if(event.isReady && !ioctl(fd, FIONREAD, &numBytes) && numBytes > 0)
+				{ event.numBytes = U64(numBytes); }
+			}
+			else
+			{
+				event.isReady = *events & (POLLOUT | POLLHUP | POLLERR);
+			}
+			event.isHungUp = *events & POLL_HANGUP_EVENTS;
+		}
+
+		return Result::success;
+	}
+
+private:
+	// The poll(2) events requested and received for each host FD by the current wait.
+	HashMap<I32, I16> requestedEvents;
+	HashMap<I32, I16> readyEvents;
+
+#ifdef __linux__
+	I32 epollFD = -1;
+	I32 timerFD = -1;
+	bool isTimerArmed = false;
+
+	// The host FDs in the epoll set, and the events they were registered for. The set is kept
+	// between waits, so polling the same FDs repeatedly only needs to update their registration.
+	HashMap<I32, I16> registeredEvents;
+	std::vector<epoll_event> epollEvents;
+
+	// Files that epoll doesn't support (e.g. regular files) never block, so they're always ready.
+	HashMap<I32, I16> alwaysReadyEvents;
+
+	Result updateEpollSet()
+	{
+		// Remove the FDs that aren't polled by this wait, so they don't cause spurious wakeups.
+		std::vector<I32> removedFDs;
+		for(const auto& pair : registeredEvents)
+		{
+			if(!requestedEvents.contains(pair.key)) { removedFDs.push_back(pair.key); }
+		}
+		for(I32 fd : removedFDs)
+		{
+			// The FD may have been closed since the last wait, which already removed it.
+			epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, nullptr);
+			registeredEvents.removeOrFail(fd);
+		}
+
+		// Add or update the FDs that are polled by this wait. An FD that is still registered is
+		// updated even if its events didn't change, since it may have been closed and reused for a
+		// different file since the last wait.
+		alwaysReadyEvents.clear();
+		for(const auto& pair : requestedEvents)
+		{
+			epoll_event event{};
+			event.events = U32(pair.value);
+			event.data.fd = pair.key;
+
+			const bool isRegistered = registeredEvents.contains(pair.key);
+			const int firstOp = isRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+			int ctlResult = epoll_ctl(epollFD, firstOp, pair.key, &event);
+			if(ctlResult && errno == (isRegistered ? ENOENT : EEXIST))
+			{
+				ctlResult = epoll_ctl(
+					epollFD, isRegistered ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, pair.key, &event);
+			}
+
+			if(!ctlResult) { registeredEvents.set(pair.key, pair.value); }
+			else
+			{
+				registeredEvents.remove(pair.key);
+				if(errno == EPERM) { alwaysReadyEvents.set(pair.key, pair.value); }
+				else
+				{
+					return asVFSResult(errno);
+				}
+			}
+		}
+
+		return Result::success;
+	}
+
+	Result waitForHostFDs(I128 deadline)
+	{
+		Result result = updateEpollSet();
+		if(result != Result::success) { return result; }
+
+		for(const auto& pair : alwaysReadyEvents) { readyEvents.set(pair.key, pair.value); }
+		if(alwaysReadyEvents.size()) { deadline = I128(0); }
+
+		// Block in epoll_wait until the deadline, using the timerfd rather than epoll_wait's
+		// timeout to get nanosecond precision.
+		int timeoutMilliseconds = -1;
+		if(deadline == I128(0)) { timeoutMilliseconds = 0; }
+		else if(!isNaN(deadline))
+		{
+			// An absolute timerfd time of 0 disarms the timer, so round it up to 1ns.
+			const I128 timerDeadline = deadline > I128(0) ? deadline : I128(1);
+			itimerspec timerSpec{};
+			timerSpec.it_value.tv_sec = time_t(U64(timerDeadline / 1000000000));
+			timerSpec.it_value.tv_nsec = long(U64(timerDeadline % 1000000000));
+			errorUnless(!timerfd_settime(timerFD, TFD_TIMER_ABSTIME, &timerSpec, nullptr));
+			isTimerArmed = true;
+		}
+		else if(isTimerArmed)
+		{
+			itimerspec timerSpec{};
+			errorUnless(!timerfd_settime(timerFD, 0, &timerSpec, nullptr));
+			isTimerArmed = false;
+		}
+
+		epollEvents.resize(registeredEvents.size() + 1);
+		const int numEpollEvents
+			= epoll_wait(epollFD, epollEvents.data(), int(epollEvents.size()), timeoutMilliseconds);
+		if(numEpollEvents < 0) { return asVFSResult(errno); }
+
+		for(int eventIndex = 0; eventIndex < numEpollEvents; ++eventIndex)
+		{
+			const epoll_event& event = epollEvents[eventIndex];
+			if(event.data.fd == timerFD)
+			{
+				// Drain the timer's expiration count so it doesn't stay readable.
+				U64 numExpirations;
+				while(read(timerFD, &numExpirations, sizeof(numExpirations)) < 0
+					  && errno == EINTR)
+				{};
+			}
+			else
+			{
+				readyEvents.set(event.data.fd, I16(event.events));
+			}
+		}
+
+		return Result::success;
+	}
+#else
+	std::vector<pollfd> pollFDs;
+
+	Result waitForHostFDs(I128 deadline)
+	{
+		pollFDs.clear();
+		for(const auto& pair : requestedEvents)
+		{ pollFDs.push_back(pollfd{pair.key, pair.value, 0}); }
+
+		// poll(2) only has a millisecond timeout, so round the time until the deadline up.
+		int timeoutMilliseconds = -1;
+		if(!isNaN(deadline))
+		{
+			const I128 timeout = deadline - getMonotonicClock();
+			const I128 roundedTimeoutMilliseconds = (timeout + 999999) / 1000000;
+			if(timeout <= I128(0)) { timeoutMilliseconds = 0; }
+			else if(roundedTimeoutMilliseconds > I128(INT32_MAX))
+			{
+				timeoutMilliseconds = INT32_MAX;
+			}
+			else
+			{
+				timeoutMilliseconds = int(I32(roundedTimeoutMilliseconds));
+			}
+		}
+
+		const int numReadyFDs = poll(pollFDs.data(), nfds_t(pollFDs.size()), timeoutMilliseconds);
+		if(numReadyFDs < 0) { return asVFSResult(errno); }
+
+		for(const pollfd& pollFD : pollFDs)
+		{
+			if(pollFD.revents) { readyEvents.set(pollFD.fd, I16(pollFD.revents)); }
+		}
+
+		return Result::success;
+	}
+#endif
+};
+
+Poller* Platform::createPoller() { return new POSIXPoller; }
@@ -0,0 +1,700 @@
+#include <pthread.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "POSIXPrivate.h"
+#include "WAVM/Inline/Assert.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Config.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Lock.h"
+#include "WAVM/Platform/Clock.h"
+#include "WAVM/Platform/Event.h"
+#include "WAVM/Platform/Memory.h"
+#include "WAVM/Platform/Mutex.h"
+#include "WAVM/Platform/Thread.h"
+
+using namespace WAVM;
+using namespace WAVM::Platform;
+
+// Green threads are run by a pool of worker threads. Each worker thread has a queue of green
+// threads that are ready to run, and when its queue is empty, it takes green threads from a global
+// ready queue, or steals them from the other worker threads' queues. A green thread that is woken
+// by a worker thread is added to that worker thread's queue, and a green thread that is woken by
+// any other thread is added to the global queue.
+//
+// A green thread switches to its worker thread with saveExecutionState/loadExecutionState, and the
+// worker thread finishes the switch after it is back on its own stack: e.g. unlocking the mutex
+// passed to suspendGreenThread, or freeing the stack of a green thread that exited.
+
+enum
+{
+	// The maximum number of worker threads, including the worker threads that are started while
+	// other worker threads are blocked between enterBlockingCall and exitBlockingCall.
+	maxWorkers = 1024,
+
+	// How often a worker thread checks the global ready queue before its own ready queue, so
+	// green threads in the global queue aren't starved by the green threads in its own queue.
+	globalReadyQueueInterval = 61,
+};
+
+struct Scheduler;
+
+// What a worker thread does with the green thread that just switched back to it.
+enum class SwitchAction
+{
+	yield,
+	suspend,
+	exit,
+};
+
+struct Platform::GreenThread
+{
+	// The execution state of the green thread while it isn't running.
+	ExecutionContext context;
+	SignalContext* innermostSignalContext = nullptr;
+	void* userData = nullptr;
+
+	I64 (*entry)(void*) = nullptr;
+	void* entryArgument = nullptr;
+
+	// The green thread's stack, with a guard page at stackMinGuardAddr.
+	U8* stackMinGuardAddr = nullptr;
+	U8* stackMinAddr = nullptr;
+	U8* stackMaxAddr = nullptr;
+	Uptr numStackPages = 0;
+
+	// True while the green thread is suspended. Waking the green thread atomically clears it, so
+	// only one of wakeGreenThread and the green thread's timer will make it ready.
+	std::atomic<bool> isSuspended{false};
+
+	// The green thread's entry in Scheduler::timers, if it is suspended with a deadline.
+	// Protected by Scheduler::mutex.
+	bool hasTimer = false;
+	std::multimap<I128, GreenThread*>::iterator timerIt;
+
+	Event exitEvent;
+	I64 exitCode = -1;
+
+	// One reference is released when the green thread exits, and the other is released by
+	// joinThread or detachThread.
+	std::atomic<Uptr> numRefs{2};
+};
+
+struct Worker
+{
+	Scheduler& scheduler;
+	Uptr index;
+
+	// The execution state of the worker thread while it is running a green thread.
+	ExecutionContext schedulerContext;
+
+	Platform::Mutex readyQueueMutex;
+	std::deque<GreenThread*> readyQueue;
+
+	// Signaled to wake the worker thread while it is sleeping or spare.
+	Event wakeEvent;
+
+	// Whether the worker thread is waiting to be restarted by enterBlockingCall.
+	// Protected by Scheduler::mutex.
+	bool isSpare = false;
+
+	Uptr numSchedules = 0;
+
+	// Set by a green thread before it switches back to the worker thread.
+	SwitchAction switchAction = SwitchAction::yield;
+	pthread_mutex_t* suspendMutex = nullptr;
+	I128 suspendDeadline;
+
+	Worker(Scheduler& inScheduler, Uptr inIndex) : scheduler(inScheduler), index(inIndex) {}
+};
+
+struct Scheduler
+{
+	Platform::Mutex mutex;
+	std::deque<GreenThread*> readyQueue;
+	std::multimap<I128, GreenThread*> timers;
+	std::vector<Worker*> sleepingWorkers;
+	std::vector<Worker*> spareWorkers;
+
+	// The number of worker threads that run green threads when none of them are blocked.
+	Uptr numTargetWorkers = 0;
+
+	// These are only changed while the mutex is locked, but are read without locking it.
+	std::atomic<Uptr> numActiveWorkers{0};
+	std::atomic<Uptr> numBlockedWorkers{0};
+	std::atomic<Uptr> numSleepingWorkers{0};
+
+	// Worker threads are never destroyed, so the workers array can be read without locking the
+	// mutex: only the first numWorkers elements are initialized.
+	std::atomic<Uptr> numWorkers{0};
+	std::atomic<Worker*> workers[maxWorkers];
+};
+
+static thread_local Worker* currentWorker = nullptr;
+static thread_local GreenThread* currentGreenThread = nullptr;
+static thread_local void* hostThreadUserData = nullptr;
+
+// These functions provide a way to read the thread-local variables that the compiler can't cache
+// across a switch point, after which the green thread may be running on a different thread.
+WAVM_FORCENOINLINE static Worker* getCurrentWorker() { return currentWorker; }
+WAVM_FORCENOINLINE GreenThread* Platform::getCurrentGreenThread() { return currentGreenThread; }
+
+static void* workerEntry(void* workerVoid);
+
+// Starts a new worker thread. The caller must lock the scheduler's mutex.
+static void startWorkerLocked(Scheduler& scheduler)
+{
+	const Uptr index = scheduler.numWorkers.load();
+	if(index == maxWorkers) { return; }
+
+	Worker* worker = new Worker(scheduler, index);
+	scheduler.workers[index].store(worker);
+	scheduler.numWorkers.store(index + 1);
+	++scheduler.numActiveWorkers;
+
+	pthread_t id;
+	errorUnless(!pthread_create(&id, nullptr, workerEntry, worker));
+	errorUnless(!pthread_detach(id));
+}
+
+static Scheduler& getScheduler()
+{
+	// The scheduler and its worker threads are never destroyed, since green threads may still be
+	// running when the process exits.
+	static Scheduler* scheduler = [] {
+		Scheduler* newScheduler = new Scheduler;
+		newScheduler->numTargetWorkers = std::max(getNumberOfHardwareThreads(), Uptr(1));
+
+		Lock<Platform::Mutex> schedulerLock(newScheduler->mutex);
+		for(Uptr workerIndex = 0; workerIndex < newScheduler->numTargetWorkers; ++workerIndex)
+		{ startWorkerLocked(*newScheduler); }
+		return newScheduler;
+	}();
+	return *scheduler;
+}
+
+// Wakes a sleeping worker thread, if there is one. The caller must lock the scheduler's mutex.
+static void wakeSleepingWorkerLocked(Scheduler& scheduler)
+{
+	if(scheduler.sleepingWorkers.size())
+	{
+		Worker* worker = scheduler.sleepingWorkers.back();
+		scheduler.sleepingWorkers.pop_back();
+		--scheduler.numSleepingWorkers;
+		worker->wakeEvent.signal();
+	}
+}
+
+// Removes a worker thread from the list of sleeping worker threads, if it is in it. The caller
+// must lock the scheduler's mutex.
+static void removeSleepingWorkerLocked(Scheduler& scheduler, Worker* worker)
+{
+	auto workerIt
+		= std::find(scheduler.sleepingWorkers.begin(), scheduler.sleepingWorkers.end(), worker);
+	if(workerIt != scheduler.sleepingWorkers.end())
+	{
+		scheduler.sleepingWorkers.erase(workerIt);
+		--scheduler.numSleepingWorkers;
+	}
+}
+
+// Adds a green thread to the ready queue of the calling worker thread, or to the global ready
+// queue if the calling thread isn't a worker thread.
+static void makeReady(GreenThread* greenThread)
+{
+	Scheduler& scheduler = getScheduler();
+	Worker* worker = getCurrentWorker();
+	if(!worker)
+	{
+		Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+		scheduler.readyQueue.push_back(greenThread);
+		wakeSleepingWorkerLocked(scheduler);
+	}
+	else
+	{
+		{
+			Lock<Platform::Mutex> readyQueueLock(worker->readyQueueMutex);
+			worker->readyQueue.push_back(greenThread);
+		}
+
+		// A worker thread that is about to sleep increments numSleepingWorkers before it checks
+		// the ready queues, so it either sees the new green thread, or is woken here.
+		if(scheduler.numSleepingWorkers.load())
+		{
+			Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+			wakeSleepingWorkerLocked(scheduler);
+		}
+	}
+}
+
+// Moves the green threads whose deadlines have passed to the global ready queue. The caller must
+// lock the scheduler's mutex.
+static void wakeExpiredTimersLocked(Scheduler& scheduler)
+{
+	if(scheduler.timers.empty()) { return; }
+
+	const I128 now = getMonotonicClock();
+	while(scheduler.timers.size() && scheduler.timers.begin()->first <= now)
+	{
+		GreenThread* greenThread = scheduler.timers.begin()->second;
+		scheduler.timers.erase(scheduler.timers.begin());
+		greenThread->hasTimer = false;
+
+		bool isSuspended = true;
+		if(greenThread->isSuspended.compare_exchange_strong(isSuspended, false))
+		{
+			scheduler.readyQueue.push_back(greenThread);
+			wakeSleepingWorkerLocked(scheduler);
+		}
+	}
+}
+
+static GreenThread* popGlobalReadyQueue(Scheduler& scheduler)
+{
+	Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+	wakeExpiredTimersLocked(scheduler);
+	if(scheduler.readyQueue.empty()) { return nullptr; }
+
+	GreenThread* greenThread = scheduler.readyQueue.front();
+	scheduler.readyQueue.pop_front();
+	return greenThread;
+}
+
+// Takes the oldest green thread from the worker's ready queue if isOwner, or the newest if not.
+static GreenThread* popReadyQueue(Worker* worker, bool isOwner)
+{
+	Lock<Platform::Mutex> readyQueueLock(worker->readyQueueMutex);
+	if(worker->readyQueue.empty()) { return nullptr; }
+
+	GreenThread* greenThread;
+	if(isOwner)
+	{
+		greenThread = worker->readyQueue.front();
+		worker->readyQueue.pop_front();
+	}
+	else
+	{
+		greenThread = worker->readyQueue.back();
+		worker->readyQueue.pop_back();
+	}
+	return greenThread;
+}
+
+static GreenThread* findReadyGreenThread(Worker* worker)
+{
+	Scheduler& scheduler = worker->scheduler;
+	GreenThread* greenThread = nullptr;
+
+	if(++worker->numSchedules % globalReadyQueueInterval == 0)
+	{
+		greenThread = popGlobalReadyQueue(scheduler);
+		if(greenThread) { return greenThread; }
+	}
+
+	greenThread = popReadyQueue(worker, true);
+	if(greenThread) { return greenThread; }
+
+	greenThread = popGlobalReadyQueue(scheduler);
+	if(greenThread) { return greenThread; }
+
+	// Steal a green thread from another worker thread.
+	const Uptr numWorkers = scheduler.numWorkers.load();
+	for(Uptr offset = 1; offset < numWorkers; ++offset)
+	{
+		Worker* victim = scheduler.workers[(worker->index + offset) % numWorkers].load();
+		greenThread = popReadyQueue(victim, false);
+		if(greenThread) { return greenThread; }
+	}
+
+	return nullptr;
+}
+
+// Returns whether any green threads are ready to run. The caller must lock the scheduler's mutex.
+static bool hasReadyGreenThreadsLocked(Scheduler& scheduler)
+{
+	if(scheduler.readyQueue.size()) { return true; }
+	if(scheduler.timers.size() && scheduler.timers.begin()->first <= getMonotonicClock())
+	{ return true; }
+
+	const Uptr numWorkers = scheduler.numWorkers.load();
+	for(Uptr workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+	{
+		Worker* worker = scheduler.workers[workerIndex].load();
+		Lock<Platform::Mutex> readyQueueLock(worker->readyQueueMutex);
+		if(worker->readyQueue.size()) { return true; }
+	}
+	return false;
+}
+
+// Waits until a green thread may be ready to run.
+static void sleepWorker(Worker* worker)
+{
+	Scheduler& scheduler = worker->scheduler;
+
+	I128 deadline = I128::nan();
+	{
+		Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+		scheduler.sleepingWorkers.push_back(worker);
+		++scheduler.numSleepingWorkers;
+		if(hasReadyGreenThreadsLocked(scheduler))
+		{
+			removeSleepingWorkerLocked(scheduler, worker);
+			return;
+		}
+
+		// Wake up when the earliest timer expires.
+		if(scheduler.timers.size()) { deadline = scheduler.timers.begin()->first; }
+	}
+
+	if(isNaN(deadline)) { worker->wakeEvent.wait(I128::nan()); }
+	else
+	{
+		const I128 now = getMonotonicClock();
+		worker->wakeEvent.wait(deadline > now ? deadline - now : I128(0));
+	}
+
+	Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+	removeSleepingWorkerLocked(scheduler, worker);
+}
+
+// Returns whether there are more worker threads running green threads than numTargetWorkers, which
+// happens when a blocked worker thread returns from its blocking call.
+static bool isSurplusWorker(Scheduler& scheduler)
+{
+	return scheduler.numActiveWorkers.load() - scheduler.numBlockedWorkers.load()
+		   > scheduler.numTargetWorkers;
+}
+
+// Stops the worker thread until enterBlockingCall needs another worker thread.
+static void retireWorker(Worker* worker)
+{
+	Scheduler& scheduler = worker->scheduler;
+	scheduler.mutex.lock();
+	if(isSurplusWorker(scheduler))
+	{
+		// Give the worker thread's ready green threads to the other worker threads.
+		{
+			Lock<Platform::Mutex> readyQueueLock(worker->readyQueueMutex);
+			for(GreenThread* greenThread : worker->readyQueue)
+			{ scheduler.readyQueue.push_back(greenThread); }
+			worker->readyQueue.clear();
+		}
+		if(scheduler.readyQueue.size()) { wakeSleepingWorkerLocked(scheduler); }
+
+		--scheduler.numActiveWorkers;
+		worker->isSpare = true;
+		scheduler.spareWorkers.push_back(worker);
+		while(worker->isSpare)
+		{
+			scheduler.mutex.unlock();
+			worker->wakeEvent.wait(I128::nan());
+			scheduler.mutex.lock();
+		}
+	}
+	scheduler.mutex.unlock();
+}
+
+static void freeGreenThread(GreenThread* greenThread)
+{
+	freeVirtualPages(greenThread->stackMinGuardAddr, greenThread->numStackPages + 1);
+	delete greenThread;
+}
+
+static void releaseGreenThread(GreenThread* greenThread)
+{
+	if(--greenThread->numRefs == 0) { freeGreenThread(greenThread); }
+}
+
+// Switches from the worker thread to a green thread, and finishes the switch after the green
+// thread switches back to the worker thread.
+static void runGreenThread(Worker* worker, GreenThread* greenThread)
+{
+	currentGreenThread = greenThread;
+	innermostSignalContext = greenThread->innermostSignalContext;
+
+	if(!saveExecutionState(&worker->schedulerContext, 0))
+	{ loadExecutionState(&greenThread->context, 1); }
+
+	greenThread->innermostSignalContext = innermostSignalContext;
+	innermostSignalContext = nullptr;
+	currentGreenThread = nullptr;
+
+	switch(worker->switchAction)
+	{
+	case SwitchAction::yield: {
+		Lock<Platform::Mutex> readyQueueLock(worker->readyQueueMutex);
+		worker->readyQueue.push_back(greenThread);
+		break;
+	}
+	case SwitchAction::suspend: {
+		greenThread->isSuspended.store(true);
+		if(!isNaN(worker->suspendDeadline))
+		{
+			Scheduler& scheduler = worker->scheduler;
+			Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+			greenThread->timerIt = scheduler.timers.emplace(worker->suspendDeadline, greenThread);
+			greenThread->hasTimer = true;
+
+			// A sleeping worker thread may be waiting for a later timer.
+			if(greenThread->timerIt == scheduler.timers.begin())
+			{ wakeSleepingWorkerLocked(scheduler); }
+		}
+
+		// Now that the green thread is off its stack, it's safe to let another thread wake it.
+		errorUnless(!pthread_mutex_unlock(worker->suspendMutex));
+		break;
+	}
+	case SwitchAction::exit:
+		greenThread->exitEvent.signal();
+		releaseGreenThread(greenThread);
+		break;
+
+	default: WAVM_UNREACHABLE();
+	};
+}
+
+static void* workerEntry(void* workerVoid)
+{
+	Worker* worker = (Worker*)workerVoid;
+
+	// Set up the worker thread's signal stack before running a green thread: catchSignals only
+	// sets it up on the first call, which must be on the worker thread's own stack.
+	sigAltStack.init();
+
+	currentWorker = worker;
+	while(true)
+	{
+		if(isSurplusWorker(worker->scheduler)) { retireWorker(worker); }
+		else if(GreenThread* greenThread = findReadyGreenThread(worker))
+		{
+			runGreenThread(worker, greenThread);
+		}
+		else
+		{
+			sleepWorker(worker);
+		}
+	}
+}
+
+// Switches from the current green thread back to the worker thread that is running it. Returns when
+// a worker thread resumes the green thread.
+WAVM_FORCENOINLINE static void switchToWorker(SwitchAction action,
+											  pthread_mutex_t* suspendMutex = nullptr,
+											  I128 suspendDeadline = I128::nan())
+{
+	GreenThread* greenThread = getCurrentGreenThread();
+	Worker* worker = getCurrentWorker();
+	wavmAssert(greenThread && worker);
+
+	worker->switchAction = action;
+	worker->suspendMutex = suspendMutex;
+	worker->suspendDeadline = suspendDeadline;
+
+	if(!saveExecutionState(&greenThread->context, 0))
+	{ loadExecutionState(&worker->schedulerContext, 1); }
+}
+
+[[noreturn]] static void greenThreadEntry()
+{
+	GreenThread* greenThread = getCurrentGreenThread();
+	const I64 exitCode = (*greenThread->entry)(greenThread->entryArgument);
+
+	// If the green thread was forked, this is running on the forked green thread, so get the
+	// current green thread again instead of using greenThread.
+	getCurrentGreenThread()->exitCode = exitCode;
+	switchToWorker(SwitchAction::exit);
+	WAVM_UNREACHABLE();
+}
+
+static GreenThread* allocateGreenThread(Uptr numStackBytes)
+{
+	const Uptr pageSizeLog2 = getPageSizeLog2();
+	const Uptr numStackPages
+		= std::max((numStackBytes + (Uptr(1) << pageSizeLog2) - 1) >> pageSizeLog2, Uptr(1));
+
+	// Reserve a guard page below the stack, so a stack overflow will raise a signal.
+	U8* stackMinGuardAddr = allocateVirtualPages(numStackPages + 1);
+	if(!stackMinGuardAddr) { Errors::fatal("Failed to allocate a green thread's stack"); }
+	U8* stackMinAddr = stackMinGuardAddr + (Uptr(1) << pageSizeLog2);
+	errorUnless(commitVirtualPages(stackMinAddr, numStackPages));
+
+	GreenThread* greenThread = new GreenThread;
+	greenThread->stackMinGuardAddr = stackMinGuardAddr;
+	greenThread->stackMinAddr = stackMinAddr;
+	greenThread->stackMaxAddr = stackMinAddr + (numStackPages << pageSizeLog2);
+	greenThread->numStackPages = numStackPages;
+	return greenThread;
+}
+
+Thread* Platform::createGreenThread(Uptr numStackBytes,
+									I64 (*threadEntry)(void*),
+									void* argument)
+{
+	// ASAN doesn't know about the green threads' stacks, so use a host thread for each thread.
+	if(WAVM_ENABLE_ASAN) { return createThread(numStackBytes, threadEntry, argument); }
+
+	GreenThread* greenThread = allocateGreenThread(numStackBytes);
+	greenThread->entry = threadEntry;
+	greenThread->entryArgument = argument;
+
+	// Start the green thread as if greenThreadEntry was called with a null return address and
+	// frame pointer, which end the stack for both unwinding and frame pointer walks.
+	memset(&greenThread->context, 0, sizeof(ExecutionContext));
+	U64* returnAddress = reinterpret_cast<U64*>(greenThread->stackMaxAddr) - 1;
+	*returnAddress = 0;
+	greenThread->context.rsp = reinterpret_cast<U64>(returnAddress);
+	greenThread->context.rip = reinterpret_cast<U64>(&greenThreadEntry);
+
+	makeReady(greenThread);
+
+	Thread* thread = new Thread;
+	thread->greenThread = greenThread;
+	return thread;
+}
+
+void Platform::detachGreenThread(GreenThread* greenThread) { releaseGreenThread(greenThread); }
+
+I64 Platform::joinGreenThread(GreenThread* greenThread)
+{
+	greenThread->exitEvent.wait(I128::nan());
+	const I64 exitCode = greenThread->exitCode;
+	releaseGreenThread(greenThread);
+	return exitCode;
+}
+
+WAVM_NO_ASAN Thread* Platform::forkCurrentGreenThread()
+{
+	GreenThread* parent = getCurrentGreenThread();
+	GreenThread* child = allocateGreenThread(parent->numStackPages << getPageSizeLog2());
+	child->entry = parent->entry;
+	child->entryArgument = parent->entryArgument;
+
+	// Capture the current execution state in the child's context. The child will load it, and
+	// "return" from this function on the child's copy of the stack.
+	if(saveExecutionState(&child->context, 0)) { return nullptr; }
+
+	// Copy the active part of the parent's stack to the top of the child's stack.
+	const U8* minActiveStackAddr = getStackPointer() - 128;
+	const Uptr numActiveStackBytes = Uptr(parent->stackMaxAddr - minActiveStackAddr);
+	const Iptr forkedStackOffset = child->stackMaxAddr - parent->stackMaxAddr;
+	memcpy(child->stackMaxAddr - numActiveStackBytes, minActiveStackAddr, numActiveStackBytes);
+
+	// Translate the saved stack pointer, the frame pointer chain, and the signal context chain to
+	// the child's stack.
+	child->context.rsp += forkedStackOffset;
+	for(U8** framePointer = (U8**)&child->context.rbp;
+		*framePointer >= parent->stackMinAddr && *framePointer < parent->stackMaxAddr;
+		framePointer = (U8**)*framePointer)
+	{ *framePointer += forkedStackOffset; }
+
+	child->innermostSignalContext = innermostSignalContext;
+	for(SignalContext** signalContextLink = &child->innermostSignalContext; *signalContextLink;
+		signalContextLink = &(*signalContextLink)->outerContext)
+	{
+		*signalContextLink = reinterpret_cast<SignalContext*>(
+			reinterpret_cast<Uptr>(*signalContextLink) + forkedStackOffset);
+	}
+
+	makeReady(child);
+
+	Thread* thread = new Thread;
+	thread->greenThread = child;
+	return thread;
+}
+
+void Platform::yieldGreenThread() { switchToWorker(SwitchAction::yield); }
+
+void Platform::suspendGreenThread(pthread_mutex_t* mutex, I128 deadline)
+{
+	switchToWorker(SwitchAction::suspend, mutex, deadline);
+
+	// If the green thread was woken before its deadline, remove its timer.
+	if(!isNaN(deadline))
+	{
+		GreenThread* greenThread = getCurrentGreenThread();
+		Scheduler& scheduler = getScheduler();
+		Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+		if(greenThread->hasTimer)
+		{
+			scheduler.timers.erase(greenThread->timerIt);
+			greenThread->hasTimer = false;
+		}
+	}
+}
+
+void Platform::wakeGreenThread(GreenThread* greenThread)
+{
+	bool isSuspended = true;
+	if(greenThread->isSuspended.compare_exchange_strong(isSuspended, false))
+	{ makeReady(greenThread); }
+}
+
+bool Platform::getCurrentGreenThreadStack(U8*& outMinGuardAddr, U8*& outMinAddr, U8*& outMaxAddr)
+{
+	GreenThread* greenThread = currentGreenThread;
+	if(!greenThread) { return false; }
+
+	outMinGuardAddr = greenThread->stackMinGuardAddr;
+	outMinAddr = greenThread->stackMinAddr;
+	outMaxAddr = greenThread->stackMaxAddr;
+	return true;
+}
+
+void Platform::setCurrentThreadUserData(void* userData)
+{
+	GreenThread* greenThread = getCurrentGreenThread();
+	if(greenThread) { greenThread->userData = userData; }
+	else
+	{
+		hostThreadUserData = userData;
+	}
+}
+
+void* Platform::getCurrentThreadUserData()
+{
+	GreenThread* greenThread = getCurrentGreenThread();
+	return greenThread ? greenThread->userData : hostThreadUserData;
+}
+
+void Platform::enterBlockingCall()
+{
+	if(!getCurrentGreenThread()) { return; }
+
+	// If the calling green thread's worker thread was one of the numTargetWorkers worker threads
+	// running green threads, start another worker thread to replace it.
+	Scheduler& scheduler = getScheduler();
+	Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+	++scheduler.numBlockedWorkers;
+	if(scheduler.numActiveWorkers - scheduler.numBlockedWorkers < scheduler.numTargetWorkers)
+	{
+		if(scheduler.spareWorkers.size())
+		{
+			Worker* worker = scheduler.spareWorkers.back();
+			scheduler.spareWorkers.pop_back();
+			worker->isSpare = false;
+			++scheduler.numActiveWorkers;
+			worker->wakeEvent.signal();
+		}
+		else
+		{
+			startWorkerLocked(scheduler);
+		}
+	}
+}
+
+void Platform::exitBlockingCall()
+{
+	if(!getCurrentGreenThread()) { return; }
+
+	// If there are now more worker threads running green threads than numTargetWorkers, the next
+	// worker thread to look for a green thread to run will stop.
+	Scheduler& scheduler = getScheduler();
+	Lock<Platform::Mutex> schedulerLock(scheduler.mutex);
+	--scheduler.numBlockedWorkers;
+}
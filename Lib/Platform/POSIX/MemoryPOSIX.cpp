@@ -1,4 +1,6 @@
 #include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
@@ -32,6 +34,27 @@ Uptr Platform::getPageSizeLog2()
 	return preferredVirtualPageSizeLog2;
 }
 
+static Uptr internalGetHugePageSizeLog2()
+{
+#ifdef __linux__
+	// Read the size of the huge pages that the kernel uses for transparent huge pages.
+	FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+	if(!file) { return 0; }
+	U64 hugePageSize = 0;
+	const bool readSize = fscanf(file, "%" SCNu64, &hugePageSize) == 1;
+	fclose(file);
+	if(!readSize || !hugePageSize || (hugePageSize & (hugePageSize - 1))) { return 0; }
+	return floorLogTwo(hugePageSize);
+#else
+	return 0;
+#endif
+}
+Uptr Platform::getHugePageSizeLog2()
+{
+	static Uptr hugePageSizeLog2 = internalGetHugePageSizeLog2();
+	return hugePageSizeLog2;
+}
+
 static U32 memoryAccessAsPOSIXFlag(MemoryAccess access)
 {
 	switch(access)
@@ -147,6 +170,19 @@ void Platform::decommitVirtualPages(U8* baseVirtualAddress, Uptr numPages)
 {
 	errorUnless(isPageAligned(baseVirtualAddress));
 	auto numBytes = numPages << getPageSizeLog2();
+#ifdef __linux__
+	// On Linux, MADV_DONTNEED frees the physical pages of a private anonymous mapping, and they
+	// will be zero when recommitted. Unlike remapping the pages, this preserves MADV_HUGEPAGE
+	// advice, and the kernel splits any huge page that straddles the decommitted range.
+	if(mprotect(baseVirtualAddress, numBytes, PROT_NONE)
+	   || madvise(baseVirtualAddress, numBytes, MADV_DONTNEED))
+	{
+		Errors::fatalf("Decommitting 0x%" PRIxPTR "-0x%" PRIxPTR " failed: %s",
+					   reinterpret_cast<Uptr>(baseVirtualAddress),
+					   reinterpret_cast<Uptr>(baseVirtualAddress) + numBytes,
+					   strerror(errno));
+	}
+#else
 	if(mmap(baseVirtualAddress, numBytes, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
 	   == MAP_FAILED)
 	{
@@ -156,6 +192,18 @@ void Platform::decommitVirtualPages(U8* baseVirtualAddress, Uptr numPages)
 					   numBytes,
 					   strerror(errno));
 	}
+#endif
+}
+
+bool Platform::adviseHugePages(U8* baseVirtualAddress, Uptr numPages)
+{
+	errorUnless(isPageAligned(baseVirtualAddress));
+#ifdef __linux__
+	if(!getHugePageSizeLog2()) { return false; }
+	return !madvise(baseVirtualAddress, numPages << getPageSizeLog2(), MADV_HUGEPAGE);
+#else
+	return false;
+#endif
 }
 
 void Platform::freeVirtualPages(U8* baseVirtualAddress, Uptr numPages)
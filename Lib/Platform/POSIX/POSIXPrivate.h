@@ -1,10 +1,12 @@
 #pragma once
 
+#include <pthread.h>
 #include <setjmp.h>
 #include <functional>
 
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
 #include "WAVM/Platform/Signal.h"
 
 // This struct layout is replicated in POSIX.S
@@ -62,7 +64,7 @@ inline void __deregister_frame(const void* fde)
 #else
 // Defined in POSIX.S
 extern "C" I64 saveExecutionState(ExecutionContext* outContext, I64 returnCode) noexcept(false);
-[[noreturn]] extern void loadExecutionState(ExecutionContext* context, I64 returnCode);
+extern "C" [[noreturn]] void loadExecutionState(ExecutionContext* context, I64 returnCode);
 extern "C" I64 switchToForkedStackContext(ExecutionContext* forkedContext,
 										  U8* trampolineFramePointer) noexcept(false);
 extern "C" U8* getStackPointer();
@@ -74,14 +76,10 @@ extern "C" void __deregister_frame(const void* fde);
 
 namespace WAVM { namespace Platform {
 
-	struct CallStack;
-
 	struct SignalContext
 	{
 		SignalContext* outerContext;
-		jmp_buf catchJump;
-		bool (*filter)(void*, Signal, CallStack&&);
-		void* filterArgument;
+		sigjmp_buf catchJump;
 	};
 
 	struct SigAltStack
@@ -104,6 +102,39 @@ namespace WAVM { namespace Platform {
 	extern thread_local SigAltStack sigAltStack;
 	extern thread_local SignalContext* innermostSignalContext;
 
+	struct GreenThread;
+
+	struct Thread
+	{
+		pthread_t id;
+
+		// The green thread, or null if the thread is a host thread.
+		GreenThread* greenThread = nullptr;
+	};
+
+	// Returns the green thread that is running on the calling thread, or null if the calling thread
+	// isn't running a green thread.
+	GreenThread* getCurrentGreenThread();
+
+	// Gets the address extent of the stack of the green thread that is running on the calling
+	// thread. Returns false if the calling thread isn't running a green thread.
+	bool getCurrentGreenThreadStack(U8*& outMinGuardAddr, U8*& outMinAddr, U8*& outMaxAddr);
+
+	void detachGreenThread(GreenThread* greenThread);
+	I64 joinGreenThread(GreenThread* greenThread);
+	Thread* forkCurrentGreenThread();
+	void yieldGreenThread();
+
+	// Suspends the current green thread until wakeGreenThread is called with it, or until the
+	// monotonic clock reaches the deadline. The mutex must be locked by the caller, and is unlocked
+	// once the green thread has been suspended, so a thread that locks the mutex before calling
+	// wakeGreenThread can't wake the green thread before it is suspended.
+	void suspendGreenThread(pthread_mutex_t* mutex, I128 deadline);
+
+	// Wakes a green thread that is suspended in suspendGreenThread. The caller must lock the mutex
+	// that was passed to suspendGreenThread.
+	void wakeGreenThread(GreenThread* greenThread);
+
 	void dumpErrorCallStack(Uptr numOmittedFramesFromTop);
 	void getCurrentThreadStack(U8*& outMinGuardAddr, U8*& outMinAddr, U8*& outMaxAddr);
 }}
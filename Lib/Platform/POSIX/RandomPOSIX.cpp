@@ -1,13 +1,21 @@
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Inline/Errors.h"
 #include "WAVM/Platform/Random.h"
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 using namespace WAVM;
 using namespace WAVM::Platform;
 
@@ -31,13 +39,14 @@ static void readDevRandom(U8* outRandomBytes, Uptr numBytes)
 	}
 }
 
-#if 0 // __linux__
-#include <sys/random.h>
-void Platform::getCryptographicRNG(U8* outRandomBytes, Uptr numBytes)
+// Reads random bytes from the OS. The getrandom syscall is called directly, since older C
+// libraries don't have a wrapper for it.
+static void getOSRandomBytes(U8* outRandomBytes, Uptr numBytes)
 {
+#ifdef SYS_getrandom
 	while(numBytes > 0)
 	{
-		ssize_t result = getrandom(outRandomBytes, numBytes, 0);
+		const long result = syscall(SYS_getrandom, outRandomBytes, numBytes, 0);
 		if(result >= 0)
 		{
 			outRandomBytes += result;
@@ -53,10 +62,138 @@ void Platform::getCryptographicRNG(U8* outRandomBytes, Uptr numBytes)
 			Errors::fatalf("getrandom failed: %s", strerror(errno));
 		}
 	};
-}
 #else
+	readDevRandom(outRandomBytes, numBytes);
+#endif
+}
+
+// Random bytes are generated by a ChaCha20 keystream for each thread, which is keyed from the OS.
+// Each time the keystream is refilled, its first bytes become the next key, and bytes are erased
+// from the buffer as they are returned, so the state of the generator can't be used to recover
+// bytes it already returned.
+enum
+{
+	chachaKeyWords = 8,
+	chachaBlockBytes = 64,
+	numBufferedBlocks = 16,
+	numBufferBytes = numBufferedBlocks * chachaBlockBytes,
+	numBytesPerReseed = 1024 * 1024,
+};
+
+#define CHACHA_QUARTER_ROUND(a, b, c, d)                                                           \
+	a += b;                                                                                        \
+	d = rotateLeft(d ^ a, 16);                                                                     \
+	c += d;                                                                                        \
+	b = rotateLeft(b ^ c, 12);                                                                     \
+	a += b;                                                                                        \
+	d = rotateLeft(d ^ a, 8);                                                                      \
+	c += d;                                                                                        \
+	b = rotateLeft(b ^ c, 7);
+
+static inline U32 rotateLeft(U32 value, U32 numBits)
+{
+	return (value << numBits) | (value >> (32 - numBits));
+}
+
+// Computes a block of the ChaCha20 keystream (RFC 8439) with a zero nonce. Assumes the host is
+// little-endian.
+static void computeChaChaBlock(const U32 key[chachaKeyWords], U32 blockCounter, U8* outBlock)
+{
+	const U32 input[16] = {0x61707865,
+						   0x3320646e,
+						   0x79622d32,
+						   0x6b206574,
+						   key[0],
+						   key[1],
+						   key[2],
+						   key[3],
+						   key[4],
+						   key[5],
+						   key[6],
+						   key[7],
+						   blockCounter,
+						   0,
+						   0,
+						   0};
+
+	U32 x[16];
+	memcpy(x, input, sizeof(x));
+	for(Uptr doubleRoundIndex = 0; doubleRoundIndex < 10; ++doubleRoundIndex)
+	{
+		CHACHA_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+		CHACHA_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+		CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+		CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+		CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+		CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+		CHACHA_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+		CHACHA_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+	}
+	for(Uptr wordIndex = 0; wordIndex < 16; ++wordIndex) { x[wordIndex] += input[wordIndex]; }
+	memcpy(outBlock, x, chachaBlockBytes);
+}
+
+struct ChaChaRNG
+{
+	U32 key[chachaKeyWords];
+	U8 buffer[numBufferBytes];
+	Uptr nextBufferByteIndex = numBufferBytes;
+	Uptr numBytesSinceSeed = 0;
+	U64 forkGeneration = 0;
+	bool isSeeded = false;
+};
+
+// Incremented in the child process by each fork, so the child doesn't return the same bytes as
+// its parent.
+static std::atomic<U64> forkGeneration{0};
+
+static void handleForkInChild() { forkGeneration.fetch_add(1, std::memory_order_relaxed); }
+
+static thread_local ChaChaRNG threadRNG;
+
+static void refillChaChaRNG(ChaChaRNG& rng)
+{
+	for(Uptr blockIndex = 0; blockIndex < numBufferedBlocks; ++blockIndex)
+	{ computeChaChaBlock(rng.key, U32(blockIndex), rng.buffer + blockIndex * chachaBlockBytes); }
+
+	memcpy(rng.key, rng.buffer, sizeof(rng.key));
+	memset(rng.buffer, 0, sizeof(rng.key));
+	rng.nextBufferByteIndex = sizeof(rng.key);
+}
+
+static void seedChaChaRNG(ChaChaRNG& rng)
+{
+	// Register the fork handler before the first generator is seeded.
+	static const bool isForkHandlerRegistered
+		= !pthread_atfork(nullptr, nullptr, handleForkInChild);
+	errorUnless(isForkHandlerRegistered);
+
+	rng.forkGeneration = forkGeneration.load(std::memory_order_relaxed);
+	getOSRandomBytes((U8*)rng.key, sizeof(rng.key));
+	refillChaChaRNG(rng);
+	rng.numBytesSinceSeed = 0;
+	rng.isSeeded = true;
+}
+
 void Platform::getCryptographicRNG(U8* outRandomBytes, Uptr numBytes)
 {
-	readDevRandom(outRandomBytes, numBytes);
+	ChaChaRNG& rng = threadRNG;
+	if(!rng.isSeeded || rng.numBytesSinceSeed >= numBytesPerReseed
+	   || rng.forkGeneration != forkGeneration.load(std::memory_order_relaxed))
+	{ seedChaChaRNG(rng); }
+	rng.numBytesSinceSeed += numBytes;
+
+	while(numBytes)
+	{
+		if(rng.nextBufferByteIndex == numBufferBytes) { refillChaChaRNG(rng); }
+
+		const Uptr numChunkBytes = std::min(numBytes, numBufferBytes - rng.nextBufferByteIndex);
+		U8* chunk = rng.buffer + rng.nextBufferByteIndex;
+		memcpy(outRandomBytes, chunk, numChunkBytes);
+		memset(chunk, 0, numChunkBytes);
+
+		rng.nextBufferByteIndex += numChunkBytes;
+		outRandomBytes += numChunkBytes;
+		numBytes -= numChunkBytes;
+	};
 }
-#endif
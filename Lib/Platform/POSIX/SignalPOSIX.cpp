@@ -1,6 +1,13 @@
+#include <pthread.h>
 #include <signal.h>
+#include <sys/ucontext.h>
 #include <unistd.h>
+#include <algorithm>
 #include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
 
 #include "POSIXPrivate.h"
 #include "WAVM/Inline/Assert.h"
@@ -12,9 +19,140 @@ using namespace WAVM::Platform;
 
 thread_local SignalContext* Platform::innermostSignalContext = nullptr;
 
-[[noreturn]] static void signalHandler(int signalNumber, siginfo_t* signalInfo, void*)
+enum
 {
+	maxCaughtSignalFrames = 256
+};
+
+// A signal that was raised in a catchSignals thunk. The signal handler records it without
+// allocating memory or unwinding with DWARF, and then jumps back to catchSignals, which calls the
+// signal filters outside of the signal handler.
+struct CaughtSignal
+{
+	int signalNumber;
 	Signal signal;
+	Uptr numFrames;
+	Uptr frameIPs[maxCaughtSignalFrames];
+};
+
+static thread_local CaughtSignal caughtSignal;
+
+// catchSignals calls a thunk that may switch green threads, after which it may be running on a
+// different thread. These functions access the thread-local variables that catchSignals uses after
+// the thunk returns, so the compiler can't reuse their addresses from before the thunk was called.
+WAVM_FORCENOINLINE static SignalContext* getInnermostSignalContext()
+{
+	return innermostSignalContext;
+}
+WAVM_FORCENOINLINE static void setInnermostSignalContext(SignalContext* signalContext)
+{
+	innermostSignalContext = signalContext;
+}
+WAVM_FORCENOINLINE static const CaughtSignal& getCaughtSignal() { return caughtSignal; }
+
+// Reads the instruction pointer and frame pointer from the context that was interrupted by a
+// signal. Returns false if they aren't known for the current platform.
+static bool getSignalContextIPAndFP(void* context, Uptr& outIP, Uptr& outFP)
+{
+	const ucontext_t* ucontext = (const ucontext_t*)context;
+#if defined(__linux__) && defined(__x86_64__)
+	outIP = Uptr(ucontext->uc_mcontext.gregs[REG_RIP]);
+	outFP = Uptr(ucontext->uc_mcontext.gregs[REG_RBP]);
+	return true;
+#elif defined(__linux__) && defined(__aarch64__)
+	outIP = Uptr(ucontext->uc_mcontext.pc);
+	outFP = Uptr(ucontext->uc_mcontext.regs[29]);
+	return true;
+#elif defined(__APPLE__) && defined(__x86_64__)
+	outIP = Uptr(ucontext->uc_mcontext->__ss.__rip);
+	outFP = Uptr(ucontext->uc_mcontext->__ss.__rbp);
+	return true;
+#elif defined(__APPLE__) && defined(__aarch64__)
+	outIP = Uptr(ucontext->uc_mcontext->__ss.__pc);
+	outFP = Uptr(ucontext->uc_mcontext->__ss.__fp);
+	return true;
+#else
+	WAVM_SUPPRESS_UNUSED(ucontext);
+	return false;
+#endif
+}
+
+// Records the call stack of the context interrupted by a signal by walking the chain of frame
+// pointers. Both WAVM and the code it generates are compiled with frame pointers. Each frame
+// pointer is checked to be within the thread's stack before it is read, so a corrupt or missing
+// frame pointer truncates the call stack instead of faulting.
+static void captureSignalCallStack(void* context, U8* stackMinAddr, U8* stackMaxAddr)
+{
+	caughtSignal.numFrames = 0;
+
+	Uptr ip;
+	Uptr fp;
+	if(!getSignalContextIPAndFP(context, ip, fp)) { return; }
+
+	// The first frame's IP is the instruction that raised the signal; the IPs of the other frames
+	// are return addresses, so subtract one to get an address within the call instruction.
+	caughtSignal.frameIPs[caughtSignal.numFrames++] = ip;
+	while(caughtSignal.numFrames < maxCaughtSignalFrames)
+	{
+		if(fp < Uptr(stackMinAddr) || fp > Uptr(stackMaxAddr) - sizeof(Uptr) * 2
+		   || fp % sizeof(Uptr))
+		{ break; }
+
+		const Uptr* frame = (const Uptr*)fp;
+		const Uptr nextFP = frame[0];
+		const Uptr returnAddress = frame[1];
+		if(!returnAddress) { break; }
+		caughtSignal.frameIPs[caughtSignal.numFrames++] = returnAddress - 1;
+
+		// The stack grows down, so the caller's frame must be at a higher address.
+		if(nextFP <= fp) { break; }
+		fp = nextFP;
+	};
+}
+
+static const char* getSignalName(int signalNumber)
+{
+	switch(signalNumber)
+	{
+	case SIGFPE: return "SIGFPE";
+	case SIGSEGV: return "SIGSEGV";
+	case SIGBUS: return "SIGBUS";
+	default: WAVM_UNREACHABLE();
+	};
+}
+
+// Prints the call stack that was recorded when a signal was raised.
+static void printCaughtSignalCallStack()
+{
+	std::fprintf(stderr, "Call stack:\n");
+	for(Uptr frameIndex = 0; frameIndex < caughtSignal.numFrames; ++frameIndex)
+	{
+		std::string frameDescription;
+		if(!describeInstructionPointer(caughtSignal.frameIPs[frameIndex], frameDescription))
+		{ frameDescription = "<unknown function>"; }
+		std::fprintf(stderr, "  %s\n", frameDescription.c_str());
+	}
+}
+
+// Reports a caught signal that no signal filter handled, with the call stack recorded when it was
+// raised.
+[[noreturn]] static void fatalUnhandledCaughtSignal()
+{
+	printCaughtSignalCallStack();
+	Errors::fatalf("unhandled %s", getSignalName(caughtSignal.signalNumber));
+}
+
+static void signalHandler(int signalNumber, siginfo_t* signalInfo, void* context)
+{
+	Signal signal;
+
+	// Determine the bounds of the stack that was interrupted by the signal: the stack of the green
+	// thread that was running, or the thread's own stack.
+	U8* stackMinGuardAddr;
+	U8* stackMinAddr;
+	U8* stackMaxAddr;
+	if(!getCurrentGreenThreadStack(stackMinGuardAddr, stackMinAddr, stackMaxAddr))
+	{ sigAltStack.getNonSignalStack(stackMinGuardAddr, stackMinAddr, stackMaxAddr); }
 
 	// Derive the exception cause the from signal that was received.
 	switch(signalNumber)
@@ -28,10 +166,6 @@ thread_local SignalContext* Platform::innermostSignalContext = nullptr;
 	case SIGBUS:
 	{
 		// Determine whether the faulting address was an address reserved by the stack.
-		U8* stackMinGuardAddr;
-		U8* stackMinAddr;
-		U8* stackMaxAddr;
-		sigAltStack.getNonSignalStack(stackMinGuardAddr, stackMinAddr, stackMaxAddr);
 		signal.type = signalInfo->si_addr >= stackMinGuardAddr && signalInfo->si_addr < stackMaxAddr
 						  ? Signal::Type::stackOverflow
 						  : Signal::Type::accessViolation;
@@ -41,31 +175,41 @@ thread_local SignalContext* Platform::innermostSignalContext = nullptr;
 	default: Errors::fatalfWithCallStack("unknown signal number: %i", signalNumber); break;
 	};
 
-	// Capture the execution context, omitting this function and the function that called it, so the
-	// top of the callstack is the function that triggered the signal.
-	CallStack callStack = captureCallStack(2);
+	// Record the signal and its call stack.
+	caughtSignal.signalNumber = signalNumber;
+	caughtSignal.signal = signal;
+	captureSignalCallStack(context, stackMinAddr, stackMaxAddr);
 
-	// Call the signal handlers, from innermost to outermost, until one returns true.
-	for(SignalContext* signalContext = innermostSignalContext; signalContext;
-		signalContext = signalContext->outerContext)
+	// If the signal wasn't raised inside catchSignals, it can't be handled. Report it, restore the
+	// default action for the signal, and return from the handler without unwinding, so the
+	// instruction that raised the signal raises it again in place: the process is terminated by the
+	// original signal, and a core dump or debugger sees the context that raised it.
+	if(!innermostSignalContext)
 	{
-		if(signalContext->filter(signalContext->filterArgument, signal, std::move(callStack)))
-		{
-			// siglongjmp won't unwind the stack, so manually call the CallStack destructor.
-			callStack.~CallStack();
+		printCaughtSignalCallStack();
+		std::fprintf(stderr, "unhandled %s\n", getSignalName(signalNumber));
+		std::fflush(stderr);
 
-			// Jump back to the execution context that was saved in catchSignals.
-			siglongjmp(signalContext->catchJump, 1);
-		}
+		struct sigaction defaultAction;
+		sigemptyset(&defaultAction.sa_mask);
+		defaultAction.sa_handler = SIG_DFL;
+		defaultAction.sa_flags = 0;
+		sigaction(signalNumber, &defaultAction, nullptr);
+
+		// Returning won't raise the signal again if it was sent by kill or raise instead of an
+		// instruction, so raise it again: it's blocked until the handler returns.
+		if(signalInfo->si_code <= 0) { raise(signalNumber); }
+		return;
 	}
 
-	switch(signalNumber)
-	{
-	case SIGFPE: Errors::fatalfWithCallStack("unhandled SIGFPE");
-	case SIGSEGV: Errors::fatalfWithCallStack("unhandled SIGSEGV");
-	case SIGBUS: Errors::fatalfWithCallStack("unhandled SIGBUS");
-	default: WAVM_UNREACHABLE();
-	};
+	// catchSignals doesn't save the signal mask, so siglongjmp won't restore it. Restore the mask
+	// from before the signal was raised, which unblocks the signals that are blocked while the
+	// handler runs.
+	pthread_sigmask(SIG_SETMASK, &((ucontext_t*)context)->uc_sigmask, nullptr);
+
+	// Jump back to the innermost execution context that was saved in catchSignals, which will call
+	// its signal filter.
+	siglongjmp(innermostSignalContext->catchJump, 1);
 }
 
 static bool initSignals()
@@ -97,33 +241,49 @@ bool Platform::catchSignals(void (*thunk)(void*),
 	sigAltStack.init();
 
 	SignalContext signalContext;
-	signalContext.outerContext = innermostSignalContext;
-	signalContext.filter = filter;
-	signalContext.filterArgument = argument;
+	signalContext.outerContext = getInnermostSignalContext();
 
 #ifdef __WAVIX__
 	Errors::unimplemented("Wavix catchSignals");
 #else
 	// Use sigsetjmp to capture the execution state into the signal context. If a signal is raised,
-	// the signal handler will jump back to here.
-	bool isReturningFromSignalHandler = sigsetjmp(signalContext.catchJump, 1) != 0;
+	// the signal handler will jump back to here. The signal mask isn't saved, since that requires a
+	// syscall on every call to catchSignals; the signal handler restores it instead.
+	bool isReturningFromSignalHandler = sigsetjmp(signalContext.catchJump, 0) != 0;
 	if(!isReturningFromSignalHandler)
 	{
-		innermostSignalContext = &signalContext;
+		setInnermostSignalContext(&signalContext);
 
 		// Call the thunk.
 		thunk(argument);
 	}
-	innermostSignalContext = signalContext.outerContext;
+	setInnermostSignalContext(signalContext.outerContext);
+
+	if(isReturningFromSignalHandler)
+	{
+		// Copy the caught signal's call stack, and call the signal filter.
+		const CaughtSignal& recordedSignal = getCaughtSignal();
+		CallStack callStack;
+		callStack.stackFrames.reserve(recordedSignal.numFrames);
+		for(Uptr frameIndex = 0; frameIndex < recordedSignal.numFrames; ++frameIndex)
+		{ callStack.stackFrames.push_back(CallStack::Frame{recordedSignal.frameIPs[frameIndex]}); }
+
+		if(!filter(argument, recordedSignal.signal, std::move(callStack)))
+		{
+			// If the filter didn't handle the signal, pass it to the next outer signal context.
+			if(signalContext.outerContext)
+			{ siglongjmp(signalContext.outerContext->catchJump, 1); }
+			fatalUnhandledCaughtSignal();
+		}
+	}
 
 	return isReturningFromSignalHandler;
 #endif
 }
 
-static void visitFDEs(const U8* ehFrames, Uptr numBytes, void (*visitFDE)(const void*))
+template<typename VisitFDE>
+static void visitFDEs(const U8* ehFrames, Uptr numBytes, VisitFDE&& visitFDE)
 {
-	// The LLVM project libunwind implementation that WAVM uses expects __register_frame and
-	// __deregister_frame to be called for each FDE in the .eh_frame section.
 	const U8* next = ehFrames;
 	const U8* end = ehFrames + numBytes;
 	do
@@ -131,7 +291,7 @@ static void visitFDEs(const U8* ehFrames, Uptr numBytes, void (*visitFDE)(const
 		const U8* cfi = next;
 		Uptr numCFIBytes = *((const U32*)next);
 		next += 4;
-		if(numBytes == 0xffffffff)
+		if(numCFIBytes == 0xffffffff)
 		{
 			const U64 numCFIBytes64 = *((const U64*)next);
 			errorUnless(numCFIBytes64 <= UINTPTR_MAX);
@@ -145,12 +305,142 @@ static void visitFDEs(const U8* ehFrames, Uptr numBytes, void (*visitFDE)(const
 	} while(next < end);
 }
 
+#if WAVM_ENABLE_RUNTIME
+// Defined in WAVM's libunwind.
+extern "C" int _unw_get_fde_pc_range(Uptr fde, Uptr* outPCStart, Uptr* outPCEnd);
+extern "C" void _unw_set_find_dynamic_fde(Uptr (*func)(Uptr pc));
+
+// An index of the FDEs in a registered .eh_frame section, sorted by the code they cover.
+struct EHFrameIndex
+{
+	struct FDE
+	{
+		Uptr pcStart;
+		Uptr pcEnd;
+		const U8* fde;
+	};
+
+	const U8* ehFrames;
+	Uptr pcStart;
+	Uptr pcEnd;
+	std::vector<FDE> fdes;
+};
+
+// The registered .eh_frame sections, sorted by the code they cover. libunwind's own registry of
+// dynamic FDEs is searched linearly, which makes unwinding through JIT code slow when many modules
+// are loaded. Instead, libunwind calls findDynamicFDE, which binary searches for the module, and
+// then for the FDE within the module.
+struct EHFrameRegistry
+{
+	pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+	std::vector<EHFrameIndex*> indices;
+};
+
+static EHFrameRegistry& getEHFrameRegistry()
+{
+	static EHFrameRegistry registry;
+	return registry;
+}
+
+static Uptr findDynamicFDE(Uptr pc)
+{
+	EHFrameRegistry& registry = getEHFrameRegistry();
+	errorUnless(!pthread_rwlock_rdlock(&registry.lock));
+
+	Uptr result = 0;
+	auto indexIt = std::upper_bound(
+		registry.indices.begin(),
+		registry.indices.end(),
+		pc,
+		[](Uptr address, const EHFrameIndex* index) { return address < index->pcStart; });
+	if(indexIt != registry.indices.begin() && pc < (*std::prev(indexIt))->pcEnd)
+	{
+		const std::vector<EHFrameIndex::FDE>& fdes = (*std::prev(indexIt))->fdes;
+		auto fdeIt = std::upper_bound(
+			fdes.begin(), fdes.end(), pc, [](Uptr address, const EHFrameIndex::FDE& fde) {
+				return address < fde.pcStart;
+			});
+		if(fdeIt != fdes.begin() && pc < std::prev(fdeIt)->pcEnd)
+		{ result = reinterpret_cast<Uptr>(std::prev(fdeIt)->fde); }
+	}
+
+	errorUnless(!pthread_rwlock_unlock(&registry.lock));
+	return result;
+}
+
+void Platform::registerEHFrames(const U8* imageBase, const U8* ehFrames, Uptr numBytes)
+{
+	static bool installedFindDynamicFDE = (_unw_set_find_dynamic_fde(findDynamicFDE), true);
+	wavmAssert(installedFindDynamicFDE);
+
+	// Decode the range of code covered by each FDE, and sort the FDEs by it.
+	EHFrameIndex* index = new EHFrameIndex;
+	index->ehFrames = ehFrames;
+	index->pcStart = UINTPTR_MAX;
+	index->pcEnd = 0;
+	visitFDEs(ehFrames, numBytes, [index](const U8* fde) {
+		Uptr pcStart;
+		Uptr pcEnd;
+		if(_unw_get_fde_pc_range(reinterpret_cast<Uptr>(fde), &pcStart, &pcEnd))
+		{
+			index->fdes.push_back({pcStart, pcEnd, fde});
+			index->pcStart = std::min(index->pcStart, pcStart);
+			index->pcEnd = std::max(index->pcEnd, pcEnd);
+		}
+	});
+	if(index->fdes.empty())
+	{
+		delete index;
+		return;
+	}
+	std::sort(index->fdes.begin(),
+			  index->fdes.end(),
+			  [](const EHFrameIndex::FDE& left, const EHFrameIndex::FDE& right) {
+				  return left.pcStart < right.pcStart;
+			  });
+
+	// Insert the index into the registry.
+	EHFrameRegistry& registry = getEHFrameRegistry();
+	errorUnless(!pthread_rwlock_wrlock(&registry.lock));
+	auto insertIt = std::upper_bound(
+		registry.indices.begin(),
+		registry.indices.end(),
+		index,
+		[](const EHFrameIndex* left, const EHFrameIndex* right) {
+			return left->pcStart < right->pcStart;
+		});
+	registry.indices.insert(insertIt, index);
+	errorUnless(!pthread_rwlock_unlock(&registry.lock));
+}
+
+void Platform::deregisterEHFrames(const U8* imageBase, const U8* ehFrames, Uptr numBytes)
+{
+	EHFrameRegistry& registry = getEHFrameRegistry();
+	EHFrameIndex* index = nullptr;
+	errorUnless(!pthread_rwlock_wrlock(&registry.lock));
+	for(auto indexIt = registry.indices.begin(); indexIt != registry.indices.end(); ++indexIt)
+	{
+		if((*indexIt)->ehFrames == ehFrames)
+		{
+			index = *indexIt;
+			registry.indices.erase(indexIt);
+			break;
+		}
+	}
+	errorUnless(!pthread_rwlock_unlock(&registry.lock));
+
+	delete index;
+}
+#else
 void Platform::registerEHFrames(const U8* imageBase, const U8* ehFrames, Uptr numBytes)
 {
-	visitFDEs(ehFrames, numBytes, __register_frame);
+	// libunwind expects __register_frame and __deregister_frame to be called for each FDE in the
+	// .eh_frame section.
+	visitFDEs(ehFrames, numBytes, [](const U8* fde) { __register_frame(fde); });
 }
 
 void Platform::deregisterEHFrames(const U8* imageBase, const U8* ehFrames, Uptr numBytes)
 {
-	visitFDEs(ehFrames, numBytes, __deregister_frame);
+	visitFDEs(ehFrames, numBytes, [](const U8* fde) { __deregister_frame(fde); });
 }
+#endif
@@ -47,11 +47,6 @@ extern "C" void __asan_stack_free(Uptr ptr, Uptr size, Uptr real_stack);
 using namespace WAVM;
 using namespace WAVM::Platform;
 
-struct Platform::Thread
-{
-	pthread_t id;
-};
-
 struct CreateThreadArgs
 {
 	I64 (*entry)(void*);
@@ -274,16 +269,29 @@ Platform::Thread* Platform::createThread(Uptr numStackBytes,
 
 void Platform::detachThread(Thread* thread)
 {
-	errorUnless(!pthread_detach(thread->id));
+	if(thread->greenThread) { detachGreenThread(thread->greenThread); }
+	else
+	{
+		errorUnless(!pthread_detach(thread->id));
+	}
 	delete thread;
 }
 
 I64 Platform::joinThread(Thread* thread)
 {
-	void* returnValue = nullptr;
-	errorUnless(!pthread_join(thread->id, &returnValue));
+	I64 result;
+	if(thread->greenThread) { result = joinGreenThread(thread->greenThread); }
+	else
+	{
+		// If the calling thread is a green thread, let its worker thread run other green threads
+		// while it waits for the host thread to exit.
+		BlockingCallScope blockingCall;
+		void* returnValue = nullptr;
+		errorUnless(!pthread_join(thread->id, &returnValue));
+		result = reinterpret_cast<I64>(returnValue);
+	}
 	delete thread;
-	return reinterpret_cast<I64>(returnValue);
+	return result;
 }
 
 WAVM_NO_ASAN static void* forkThreadEntry(void* argsVoid)
@@ -332,6 +340,8 @@ static void memcpyNoASAN(U8* dest, const U8* source, Uptr numBytes)
 
 WAVM_NO_ASAN Thread* Platform::forkCurrentThread()
 {
+	if(getCurrentGreenThread()) { return forkCurrentGreenThread(); }
+
 	auto forkThreadArgs = new ForkThreadArgs;
 
 	if(!threadEntryContext)
@@ -428,4 +438,11 @@ WAVM_NO_ASAN Thread* Platform::forkCurrentThread()
 
 Uptr Platform::getNumberOfHardwareThreads() { return std::thread::hardware_concurrency(); }
 
-void Platform::yieldToAnotherThread() { errorUnless(sched_yield() == 0); }
+void Platform::yieldToAnotherThread()
+{
+	if(getCurrentGreenThread()) { yieldGreenThread(); }
+	else
+	{
+		errorUnless(sched_yield() == 0);
+	}
+}
@@ -8,6 +8,7 @@
 #include "WAVM/Platform/Clock.h"
 #include "WAVM/Platform/Event.h"
 #include "WAVM/Platform/File.h"
+#include "WAVM/Platform/Memory.h"
 #include "WAVM/Platform/Mutex.h"
 #include "WAVM/VFS/VFS.h"
 #include "WindowsPrivate.h"
@@ -688,6 +689,24 @@ protected:
 
 PLATFORM_API HostFS& Platform::getHostFS() { return WindowsFS::get(); }
 
+VFS::FileSystem* Platform::openHostSandboxFS(const std::string& rootPath, bool followSymbolicLinks)
+{
+	return nullptr;
+}
+
+// Private file mappings can't replace part of a reserved region on Windows, so files are never
+// mapped, and callers fall back to reading them.
+Result Platform::mapFilePages(VFD* vfd, U64 offset, U8* baseAddress, Uptr numPages)
+{
+	return Result::notPermitted;
+}
+
+void Platform::unmapFilePages(U8* baseAddress, Uptr numPages)
+{
+	decommitVirtualPages(baseAddress, numPages);
+	errorUnless(commitVirtualPages(baseAddress, numPages));
+}
+
 Result WindowsFS::open(const std::string& path,
 					   FileAccessMode accessMode,
 					   FileCreateMode createMode,
@@ -889,3 +908,30 @@ std::string Platform::getCurrentWorkingDirectory()
 
 	return result;
 }
+
+// Windows VFDs don't expose a handle that can be waited on for readiness, so every subscription is
+// immediately ready, and a wait without any subscriptions just sleeps until the deadline.
+struct WindowsPoller : Poller
+{
+	virtual Result wait(const PollSubscription* subscriptions,
+						Uptr numSubscriptions,
+						I128 deadline,
+						PollEvent* outEvents) override
+	{
+		for(Uptr subscriptionIndex = 0; subscriptionIndex < numSubscriptions; ++subscriptionIndex)
+		{ outEvents[subscriptionIndex] = PollEvent{true, false, 0}; }
+
+		if(!numSubscriptions)
+		{
+			const I128 timeout = isNaN(deadline) ? deadline : deadline - getMonotonicClock();
+			if(isNaN(timeout) || timeout > I128(0)) { sleepEvent.wait(timeout); }
+		}
+
+		return Result::success;
+	}
+
+private:
+	Event sleepEvent;
+};
+
+Poller* Platform::createPoller() { return new WindowsPoller; }
@@ -27,6 +27,10 @@ Uptr Platform::getPageSizeLog2()
 	return preferredVirtualPageSizeLog2;
 }
 
+// Windows only supports large pages that are committed up front by a process with the
+// SeLockMemoryPrivilege, which can't back reserved-but-uncommitted pages.
+Uptr Platform::getHugePageSizeLog2() { return 0; }
+
 static U32 memoryAccessAsWin32Flag(MemoryAccess access)
 {
 	switch(access)
@@ -133,6 +137,8 @@ void Platform::decommitVirtualPages(U8* baseVirtualAddress, Uptr numPages)
 	if(baseVirtualAddress && !result) { Errors::fatal("VirtualFree(MEM_DECOMMIT) failed"); }
 }
 
+bool Platform::adviseHugePages(U8* baseVirtualAddress, Uptr numPages) { return false; }
+
 void Platform::freeVirtualPages(U8* baseVirtualAddress, Uptr numPages)
 {
 	errorUnless(isPageAligned(baseVirtualAddress));
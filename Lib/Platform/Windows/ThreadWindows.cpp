@@ -19,6 +19,7 @@ using namespace WAVM::Platform;
 
 static thread_local bool isThreadInitialized = false;
 static thread_local U8* threadEntryFramePointer = nullptr;
+static thread_local void* threadUserData = nullptr;
 
 struct Platform::Thread
 {
@@ -95,6 +96,22 @@ static DWORD WINAPI createThreadEntry(void* argsVoid)
 	return 0;
 }
 
+Thread* Platform::createGreenThread(Uptr numStackBytes,
+									I64 (*threadEntry)(void*),
+									void* argument)
+{
+	// Green threads aren't implemented on Windows, so use a host thread for each thread.
+	return createThread(numStackBytes, threadEntry, argument);
+}
+
+void Platform::setCurrentThreadUserData(void* userData) { threadUserData = userData; }
+
+void* Platform::getCurrentThreadUserData() { return threadUserData; }
+
+void Platform::enterBlockingCall() {}
+
+void Platform::exitBlockingCall() {}
+
 struct ProcessorGroupInfo
 {
 	U32 numProcessors;
@@ -2,7 +2,6 @@
 #include <algorithm>
 #include <atomic>
 #include <cmath>
-#include <memory>
 #include <utility>
 #include <vector>
 
@@ -37,9 +36,6 @@ struct WaitList
 	WaitList() : numReferences(1) {}
 };
 
-// An event that is reused within a thread when it waits on a WaitList.
-thread_local std::unique_ptr<Platform::Event> threadWakeEvent = nullptr;
-
 // A map from address to a list of threads waiting on that address.
 static Platform::Mutex addressToWaitListMapMutex;
 static HashMap<Uptr, WaitList*> addressToWaitListMap;
@@ -105,6 +101,11 @@ static U32 waitOnAddress(Value* valuePointer, Value expectedValue, I64 timeout)
 	const Uptr address = reinterpret_cast<Uptr>(valuePointer);
 	WaitList* waitList = openWaitList(address);
 
+	// The event that wakes this thread. It isn't a thread_local event that is reused by each wait,
+	// since a green thread may wait on a different host thread, and share it with other green
+	// threads.
+	Platform::Event wakeEvent;
+
 	// Lock the wait list, and check that *valuePointer is still what the caller expected it to be.
 	{
 		Lock<Platform::Mutex> waitListLock(waitList->mutex);
@@ -124,25 +125,21 @@ static U32 waitOnAddress(Value* valuePointer, Value expectedValue, I64 timeout)
 		}
 		else
 		{
-			// If the thread hasn't yet created a wake event, do so.
-			if(!threadWakeEvent)
-			{ threadWakeEvent = std::unique_ptr<Platform::Event>(new Platform::Event()); }
-
 			// Add the wake event to the wait list, and unlock the wait list.
-			waitList->wakeEvents.push_back(threadWakeEvent.get());
+			waitList->wakeEvents.push_back(&wakeEvent);
 			waitListLock.unlock();
 		}
 	}
 
 	// Wait for the thread's wake event to be signaled.
 	bool timedOut = false;
-	if(!threadWakeEvent->wait(timeout < 0 ? I128::nan() : I128(timeout)))
+	if(!wakeEvent.wait(timeout < 0 ? I128::nan() : I128(timeout)))
 	{
 		// If the wait timed out, lock the wait list and check if the thread's wake event is still
 		// in the wait list.
 		Lock<Platform::Mutex> waitListLock(waitList->mutex);
-		auto wakeEventIt = std::find(
-			waitList->wakeEvents.begin(), waitList->wakeEvents.end(), threadWakeEvent.get());
+		auto wakeEventIt
+			= std::find(waitList->wakeEvents.begin(), waitList->wakeEvents.end(), &wakeEvent);
 		if(wakeEventIt != waitList->wakeEvents.end())
 		{
 			// If the event was still on the wait list, remove it, and return the "timed out"
@@ -150,13 +147,10 @@ static U32 waitOnAddress(Value* valuePointer, Value expectedValue, I64 timeout)
 			waitList->wakeEvents.erase(wakeEventIt);
 			timedOut = true;
 		}
-		else
-		{
-			// In between the wait timing out and locking the wait list, some other thread tried to
-			// wake this thread. The event will now be signaled, so use an immediately expiring wait
-			// on it to reset it.
-			errorUnless(threadWakeEvent->wait(Platform::getMonotonicClock()));
-		}
+
+		// Otherwise, some other thread woke this thread in between the wait timing out and locking
+		// the wait list. The event was signaled while the wait list was locked, so it's safe to
+		// destroy it.
 	}
 
 	closeWaitList(address, waitList);
@@ -194,6 +188,17 @@ static U32 wakeAddress(void* pointer, U32 numToWake)
 	return U32(actualNumToWake);
 }
 
+U32 Runtime::waitOnMemoryAddress(Memory* memory, Uptr offset, U32 expectedValue, I64 timeout)
+{
+	U32* valuePointer = &memoryRef<U32>(memory, offset);
+	return waitOnAddress(valuePointer, expectedValue, timeout);
+}
+
+U32 Runtime::wakeMemoryAddress(Memory* memory, Uptr offset, U32 numToWake)
+{
+	return wakeAddress(&memoryRef<U32>(memory, offset), numToWake);
+}
+
 WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsAtomics,
 							   "misalignedAtomicTrap",
 							   void,
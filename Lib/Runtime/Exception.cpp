@@ -51,7 +51,7 @@ bool Runtime::describeInstructionPointer(Uptr ip, std::string& outDescription)
 	if(!function) { return Platform::describeInstructionPointer(ip, outDescription); }
 	else
 	{
-		outDescription = function->mutableData->debugName;
+		outDescription = function->mutableData->getDebugName();
 		outDescription += '+';
 
 		// Find the highest entry in the offsetToOpIndexMap whose offset is <= the
@@ -267,8 +267,10 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsException,
 	}
 	auto args = reinterpret_cast<const IR::UntaggedValue*>(Uptr(argsBits));
 
+	// Don't capture the call stack until the exception is thrown out of the function that created
+	// it: exceptions that are caught within the same function never need it.
 	Exception* exception = createException(
-		exceptionType, args, exceptionType->sig.params.size(), Platform::captureCallStack(1));
+		exceptionType, args, exceptionType->sig.params.size(), Platform::CallStack());
 
 	return reinterpret_cast<Uptr>(exception);
 }
@@ -290,6 +292,8 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsException,
 							   Uptr exceptionBits)
 {
 	Exception* exception = reinterpret_cast<Exception*>(exceptionBits);
+	if(!exception->callStack.stackFrames.size())
+	{ exception->callStack.stackFrames = Platform::captureCallStack(1).stackFrames; }
 	throw exception;
 }
 
@@ -358,13 +362,20 @@ void Runtime::catchRuntimeExceptions(const std::function<void()>& thunk,
 	}
 }
 
+// The exception translated from a signal by catchRuntimeExceptionsOnRelocatableStack. The thunk may
+// switch green threads, so catchSignals may return on a different thread than it was called on:
+// this function keeps the compiler from reusing the thread-local's address from before the thunk.
+WAVM_FORCENOINLINE static Exception*& getTranslatedSignalException()
+{
+	static thread_local Exception* translatedSignalException = nullptr;
+	return translatedSignalException;
+}
+
 void Runtime::catchRuntimeExceptionsOnRelocatableStack(void (*thunk)(),
 													   void (*catchThunk)(Exception*))
 {
 	try
 	{
-		static thread_local Exception* translatedSignalException = nullptr;
-
 		if(Platform::catchSignals(
 			   [](void* thunkVoid) {
 				   auto thunk = (void (*)())thunkVoid;
@@ -372,10 +383,10 @@ void Runtime::catchRuntimeExceptionsOnRelocatableStack(void (*thunk)(),
 			   },
 			   [](void*, Platform::Signal signal, Platform::CallStack&& callStack) {
 				   return translateSignalToRuntimeException(
-					   signal, std::move(callStack), translatedSignalException);
+					   signal, std::move(callStack), getTranslatedSignalException());
 			   },
 			   (void*)thunk))
-		{ throw translatedSignalException; }
+		{ throw getTranslatedSignalException(); }
 	}
 	catch(Exception* exception)
 	{
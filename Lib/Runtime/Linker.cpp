@@ -2,6 +2,7 @@
 #include "WAVM/IR/Module.h"
 #include "WAVM/IR/Validate.h"
 #include "WAVM/Inline/Assert.h"
+#include "WAVM/Inline/HashMap.h"
 #include "WAVM/Logging/Logging.h"
 #include "WAVM/Runtime/Runtime.h"
 
@@ -192,3 +193,125 @@ LinkResult Runtime::linkModule(const IR::Module& module, Resolver& resolver)
 	linkResult.success = linkResult.missingImports.size() == 0;
 	return linkResult;
 }
+
+static LinkResult::MissingImport getMissingImport(const IR::Module& module, Uptr importIndex)
+{
+	const KindAndIndex& kindIndex = module.imports[importIndex];
+	switch(kindIndex.kind)
+	{
+	case ExternKind::function:
+	{
+		const auto& functionImport = module.functions.imports[kindIndex.index];
+		return {functionImport.moduleName,
+				functionImport.exportName,
+				module.types[functionImport.type.index]};
+	}
+	case ExternKind::table:
+	{
+		const auto& tableImport = module.tables.imports[kindIndex.index];
+		return {tableImport.moduleName, tableImport.exportName, tableImport.type};
+	}
+	case ExternKind::memory:
+	{
+		const auto& memoryImport = module.memories.imports[kindIndex.index];
+		return {memoryImport.moduleName, memoryImport.exportName, memoryImport.type};
+	}
+	case ExternKind::global:
+	{
+		const auto& globalImport = module.globals.imports[kindIndex.index];
+		return {globalImport.moduleName, globalImport.exportName, globalImport.type};
+	}
+	case ExternKind::exceptionType:
+	{
+		const auto& exceptionTypeImport = module.exceptionTypes.imports[kindIndex.index];
+		return {exceptionTypeImport.moduleName,
+				exceptionTypeImport.exportName,
+				exceptionTypeImport.type};
+	}
+
+	case ExternKind::invalid:
+	default: WAVM_UNREACHABLE();
+	};
+}
+
+LinkPlan Runtime::createLinkPlan(const IR::Module& module,
+								 Resolver& resolver,
+								 const std::vector<ModuleInstance*>& moduleInstances)
+{
+	// Map each object exported by the module instances to its first source.
+	struct ExportSource
+	{
+		Uptr moduleInstanceIndex;
+		Uptr exportIndex;
+	};
+	HashMap<Object*, ExportSource> exportSourceMap;
+	for(Uptr moduleInstanceIndex = 0; moduleInstanceIndex < moduleInstances.size();
+		++moduleInstanceIndex)
+	{
+		const std::vector<Object*>& exports
+			= getInstanceExports(moduleInstances[moduleInstanceIndex]);
+		for(Uptr exportIndex = 0; exportIndex < exports.size(); ++exportIndex)
+		{
+			exportSourceMap.add(exports[exportIndex], ExportSource{moduleInstanceIndex, exportIndex});
+		}
+	}
+
+	// Link the module using the resolver, and find the source of each resolved import.
+	LinkResult linkResult = linkModule(module, resolver);
+
+	LinkPlan linkPlan;
+	linkPlan.missingImports = std::move(linkResult.missingImports);
+	for(Uptr importIndex = 0; importIndex < linkResult.resolvedImports.size(); ++importIndex)
+	{
+		Object* importObject = linkResult.resolvedImports[importIndex];
+		const ExportSource* importSource
+			= importObject ? exportSourceMap.get(importObject) : nullptr;
+		LinkResult::MissingImport import = getMissingImport(module, importIndex);
+		if(!importSource && importObject) { linkPlan.missingImports.push_back(import); }
+		linkPlan.importSources.push_back(
+			{importSource ? importSource->moduleInstanceIndex : UINTPTR_MAX,
+			 importSource ? importSource->exportIndex : UINTPTR_MAX,
+			 std::move(import.moduleName),
+			 std::move(import.exportName),
+			 import.type});
+	}
+
+	linkPlan.success = linkPlan.missingImports.size() == 0;
+	return linkPlan;
+}
+
+LinkResult Runtime::linkModule(const LinkPlan& linkPlan,
+							   const std::vector<ModuleInstance*>& moduleInstances)
+{
+	LinkResult linkResult{linkPlan.missingImports, {}, false};
+	linkResult.resolvedImports.reserve(linkPlan.importSources.size());
+	for(const LinkPlan::ImportSource& importSource : linkPlan.importSources)
+	{
+		// Look up the planned export, and check that it still matches the import's type: the
+		// module instances may not be instances of the modules the plan was created with.
+		Object* importObject = nullptr;
+		if(importSource.moduleInstanceIndex < moduleInstances.size())
+		{
+			const std::vector<Object*>& exports
+				= getInstanceExports(moduleInstances[importSource.moduleInstanceIndex]);
+			if(importSource.exportIndex < exports.size())
+			{ importObject = exports[importSource.exportIndex]; }
+		}
+
+		if(importObject && isA(importObject, importSource.type))
+		{ linkResult.resolvedImports.push_back(importObject); }
+		else
+		{
+			// Imports that had no source when the plan was created are already in missingImports.
+			if(importSource.moduleInstanceIndex != UINTPTR_MAX)
+			{
+				linkResult.missingImports.push_back(
+					{importSource.moduleName, importSource.exportName, importSource.type});
+			}
+			linkResult.resolvedImports.push_back(nullptr);
+		}
+	}
+
+	linkResult.success = linkResult.missingImports.size() == 0;
+	return linkResult;
+}
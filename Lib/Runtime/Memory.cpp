@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <string.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -11,11 +12,14 @@
 #include "WAVM/Inline/Assert.h"
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Inline/Lock.h"
+#include "WAVM/Platform/File.h"
 #include "WAVM/Platform/Intrinsic.h"
 #include "WAVM/Platform/Memory.h"
 #include "WAVM/Platform/Mutex.h"
+#include "WAVM/Platform/Signal.h"
 #include "WAVM/Runtime/Runtime.h"
 #include "WAVM/Runtime/RuntimeData.h"
+#include "WAVM/VFS/VFS.h"
 
 using namespace WAVM;
 using namespace WAVM::Runtime;
@@ -28,6 +32,8 @@ namespace WAVM { namespace Runtime {
 static Platform::Mutex memoriesMutex;
 static std::vector<Memory*> memories;
 
+static std::atomic<bool> hugePagesEnabled{false};
+
 enum
 {
 	numGuardPages = 1
@@ -43,18 +49,47 @@ static Memory* createMemoryImpl(Compartment* compartment,
 								IR::MemoryType type,
 								Uptr numPages,
 								std::string&& debugName,
-								ResourceQuotaRefParam resourceQuota)
+								ResourceQuotaRefParam resourceQuota,
+								MemoryBoundsCheckMode boundsCheckMode)
 {
 	Memory* memory = new Memory(compartment, type, std::move(debugName), resourceQuota);
+	memory->boundsCheckMode = boundsCheckMode;
 
-	// On a 64-bit runtime, allocate 8GB of address space for the memory.
-	// This allows eliding bounds checks on memory accesses, since a 32-bit index + 32-bit offset
-	// will always be within the reserved address-space.
 	const Uptr pageBytesLog2 = Platform::getPageSizeLog2();
-	const Uptr memoryMaxBytes = Uptr(8ull * 1024 * 1024 * 1024);
+	Uptr memoryMaxBytes;
+	if(boundsCheckMode == MemoryBoundsCheckMode::guardRegion)
+	{
+		// On a 64-bit runtime, allocate 8GB of address space for the memory.
+		// This allows eliding bounds checks on memory accesses, since a 32-bit index + 32-bit
+		// offset will always be within the reserved address-space.
+		memoryMaxBytes = Uptr(8ull * 1024 * 1024 * 1024);
+	}
+	else
+	{
+		// Only allocate address space for the memory's maximum size. The compiled code checks that
+		// the first byte of each access is within the reserved address-space, and the guard page
+		// catches the remaining bytes of an access that straddles the end of it.
+		const U64 maxPages = std::min(type.size.max, U64(IR::maxMemoryPages));
+		memoryMaxBytes = Uptr(maxPages) * IR::numBytesPerPage;
+	}
 	const Uptr memoryMaxPages = memoryMaxBytes >> pageBytesLog2;
 
-	memory->baseAddress = Platform::allocateVirtualPages(memoryMaxPages + numGuardPages);
+	// If huge pages are enabled, align the memory to a huge page, and advise the OS to back it with
+	// huge pages. Pages are still committed and decommitted at the granularity of WebAssembly
+	// pages, so an access beyond the memory's current size still faults: only the huge pages that
+	// are entirely within the committed part of the memory will be backed by a huge page.
+	const Uptr hugePageSizeLog2 = Platform::getHugePageSizeLog2();
+	if(hugePagesEnabled.load(std::memory_order_relaxed) && hugePageSizeLog2 > pageBytesLog2)
+	{
+		memory->baseAddressAlignmentLog2 = hugePageSizeLog2;
+		memory->baseAddress = Platform::allocateAlignedVirtualPages(
+			memoryMaxPages + numGuardPages, hugePageSizeLog2, memory->unalignedBaseAddress);
+		if(memory->baseAddress) { Platform::adviseHugePages(memory->baseAddress, memoryMaxPages); }
+	}
+	else
+	{
+		memory->baseAddress = Platform::allocateVirtualPages(memoryMaxPages + numGuardPages);
+	}
 	memory->numReservedBytes = memoryMaxBytes;
 	if(!memory->baseAddress)
 	{
@@ -81,11 +116,16 @@ static Memory* createMemoryImpl(Compartment* compartment,
 Memory* Runtime::createMemory(Compartment* compartment,
 							  IR::MemoryType type,
 							  std::string&& debugName,
-							  ResourceQuotaRefParam resourceQuota)
+							  ResourceQuotaRefParam resourceQuota,
+							  MemoryBoundsCheckMode boundsCheckMode)
 {
 	wavmAssert(type.size.min <= UINTPTR_MAX);
-	Memory* memory = createMemoryImpl(
-		compartment, type, Uptr(type.size.min), std::move(debugName), resourceQuota);
+	Memory* memory = createMemoryImpl(compartment,
+									  type,
+									  Uptr(type.size.min),
+									  std::move(debugName),
+									  resourceQuota,
+									  boundsCheckMode);
 	if(!memory) { return nullptr; }
 
 	// Add the memory to the compartment's memories IndexMap.
@@ -109,8 +149,12 @@ Memory* Runtime::cloneMemory(Memory* memory, Compartment* newCompartment)
 	Lock<Platform::Mutex> resizingLock(memory->resizingMutex);
 	const Uptr numPages = memory->numPages.load(std::memory_order_acquire);
 	std::string debugName = memory->debugName;
-	Memory* newMemory = createMemoryImpl(
-		newCompartment, memory->type, numPages, std::move(debugName), memory->resourceQuota);
+	Memory* newMemory = createMemoryImpl(newCompartment,
+										 memory->type,
+										 numPages,
+										 std::move(debugName),
+										 memory->resourceQuota,
+										 memory->boundsCheckMode);
 	if(!newMemory) { return nullptr; }
 
 	// Copy the memory contents to the new memory.
@@ -158,12 +202,14 @@ Runtime::Memory::~Memory()
 	}
 
 	// Free the virtual address space.
-	const Uptr pageBytesLog2 = Platform::getPageSizeLog2();
-	if(numReservedBytes > 0)
+	const Uptr numReservedPages
+		= (numReservedBytes >> Platform::getPageSizeLog2()) + numGuardPages;
+	if(baseAddress && baseAddressAlignmentLog2)
 	{
-		Platform::freeVirtualPages(baseAddress,
-								   (numReservedBytes >> pageBytesLog2) + numGuardPages);
+		Platform::freeAlignedVirtualPages(
+			unalignedBaseAddress, numReservedPages, baseAddressAlignmentLog2);
 	}
+	else if(baseAddress) { Platform::freeVirtualPages(baseAddress, numReservedPages); }
 
 	// Free the allocated quota.
 	if(resourceQuota) { resourceQuota->memoryPages.free(numPages); }
@@ -172,12 +218,13 @@ Runtime::Memory::~Memory()
 bool Runtime::isAddressOwnedByMemory(U8* address, Memory*& outMemory, Uptr& outMemoryAddress)
 {
 	// Iterate over all memories and check if the address is within the reserved address space for
-	// each.
+	// each, including the guard pages.
+	const Uptr numGuardBytes = Uptr(numGuardPages) << Platform::getPageSizeLog2();
 	Lock<Platform::Mutex> memoriesLock(memoriesMutex);
 	for(auto memory : memories)
 	{
 		U8* startAddress = memory->baseAddress;
-		U8* endAddress = memory->baseAddress + memory->numReservedBytes;
+		U8* endAddress = memory->baseAddress + memory->numReservedBytes + numGuardBytes;
 		if(address >= startAddress && address < endAddress)
 		{
 			outMemory = memory;
@@ -193,6 +240,13 @@ Uptr Runtime::getMemoryNumPages(const Memory* memory)
 	return memory->numPages.load(std::memory_order_seq_cst);
 }
 IR::MemoryType Runtime::getMemoryType(const Memory* memory) { return memory->type; }
+Uptr Runtime::getMemoryNumReservedBytes(const Memory* memory) { return memory->numReservedBytes; }
+
+void Runtime::setHugePagesEnabled(bool enable)
+{
+	hugePagesEnabled.store(enable, std::memory_order_relaxed);
+	LLVMJIT::setCodeHugePagesEnabled(enable);
+}
 
 bool Runtime::growMemory(Memory* memory, Uptr numPagesToGrow, Uptr* outOldNumPages)
 {
@@ -234,14 +288,90 @@ bool Runtime::growMemory(Memory* memory, Uptr numPagesToGrow, Uptr* outOldNumPag
 	return true;
 }
 
+// Replaces pages of a memory, which may have been mapped from a file, with zeroed anonymous pages.
+static void replaceMappedFilePages(Memory* memory, U8* baseAddress, Uptr numPlatformPages)
+{
+	Platform::unmapFilePages(baseAddress, numPlatformPages);
+
+	// Replacing the pages discards the advice to back them with huge pages, so advise it again.
+	if(memory->baseAddressAlignmentLog2)
+	{ Platform::adviseHugePages(baseAddress, numPlatformPages); }
+}
+
 void Runtime::unmapMemoryPages(Memory* memory, Uptr pageIndex, Uptr numPages)
 {
 	wavmAssert(pageIndex + numPages > pageIndex);
 	wavmAssert((pageIndex + numPages) * IR::numBytesPerPage <= memory->numReservedBytes);
 
+	U8* baseAddress = memory->baseAddress + pageIndex * IR::numBytesPerPage;
+	const Uptr numPlatformPages = numPages << getPlatformPagesPerWebAssemblyPageLog2();
+
+	// Decommitting a page that is mapped from a file only discards the private copy of it, so if
+	// the page was committed again, it would contain the file's data instead of zeroes. Replace
+	// any pages that were mapped from a file with anonymous pages before decommitting them.
+	if(memory->hasMappedFiles.load(std::memory_order_acquire))
+	{ replaceMappedFilePages(memory, baseAddress, numPlatformPages); }
+
 	// Decommit the pages.
-	Platform::decommitVirtualPages(memory->baseAddress + pageIndex * IR::numBytesPerPage,
-								   numPages << getPlatformPagesPerWebAssemblyPageLog2());
+	Platform::decommitVirtualPages(baseAddress, numPlatformPages);
+}
+
+VFS::Result Runtime::mapFileIntoMemory(Memory* memory,
+									   Uptr pageIndex,
+									   Uptr numPages,
+									   VFS::VFD* vfd,
+									   U64 fileOffset)
+{
+	if(fileOffset & (IR::numBytesPerPage - 1)) { return VFS::Result::invalidOffset; }
+
+	// Hold the resizing mutex while replacing the pages, so the memory's size can't change.
+	Lock<Platform::Mutex> resizingLock(memory->resizingMutex);
+	const Uptr memoryNumPages = memory->numPages.load(std::memory_order_acquire);
+	if(pageIndex > memoryNumPages || numPages > memoryNumPages - pageIndex)
+	{ return VFS::Result::inaccessibleBuffer; }
+
+	U8* baseAddress = memory->baseAddress + pageIndex * IR::numBytesPerPage;
+	const Uptr numPlatformPages = numPages << getPlatformPagesPerWebAssemblyPageLog2();
+	memory->hasMappedFiles.store(true, std::memory_order_release);
+	const VFS::Result mapResult
+		= Platform::mapFilePages(vfd, fileOffset, baseAddress, numPlatformPages);
+	if(mapResult != VFS::Result::notPermitted) { return mapResult; }
+
+	// If the file can't be mapped, read it into the pages, and zero the pages after its end.
+	const Uptr numBytes = numPages * IR::numBytesPerPage;
+	Uptr numBytesRead = 0;
+	while(numBytesRead < numBytes)
+	{
+		const U64 readOffset = fileOffset + numBytesRead;
+		Uptr numChunkBytes = 0;
+		VFS::IOReadBuffer buffer{baseAddress + numBytesRead, numBytes - numBytesRead};
+		const VFS::Result readResult = vfd->readv(&buffer, 1, &numChunkBytes, &readOffset);
+		if(readResult != VFS::Result::success) { return readResult; }
+		if(!numChunkBytes) { break; }
+		numBytesRead += numChunkBytes;
+	};
+
+	const Uptr platformPageSize = Uptr(1) << Platform::getPageSizeLog2();
+	const Uptr numZeroedBytes
+		= std::min(numBytes, (numBytesRead + platformPageSize - 1) & ~(platformPageSize - 1));
+	memset(baseAddress + numBytesRead, 0, numZeroedBytes - numBytesRead);
+	if(numZeroedBytes < numBytes)
+	{
+		replaceMappedFilePages(memory,
+							   baseAddress + numZeroedBytes,
+							   (numBytes - numZeroedBytes) >> Platform::getPageSizeLog2());
+	}
+	return VFS::Result::success;
+}
+
+void Runtime::unmapFileFromMemory(Memory* memory, Uptr pageIndex, Uptr numPages)
+{
+	wavmAssert(pageIndex + numPages > pageIndex);
+	wavmAssert((pageIndex + numPages) * IR::numBytesPerPage <= memory->numReservedBytes);
+
+	replaceMappedFilePages(memory,
+						   memory->baseAddress + pageIndex * IR::numBytesPerPage,
+						   numPages << getPlatformPagesPerWebAssemblyPageLog2());
 }
 
 U8* Runtime::getMemoryBaseAddress(Memory* memory) { return memory->baseAddress; }
@@ -287,6 +417,34 @@ U8* Runtime::getValidatedMemoryOffsetRange(Memory* memory, Uptr address, Uptr nu
 		numBytes);
 }
 
+bool Runtime::catchMemoryFaults(Memory* memory, void (*thunk)(void*), void* argument)
+{
+	struct CatchContext
+	{
+		Memory* memory;
+		void (*thunk)(void*);
+		void* argument;
+	};
+	CatchContext catchContext{memory, thunk, argument};
+	return Platform::catchSignals(
+		[](void* catchContextVoid) {
+			CatchContext& catchContext = *(CatchContext*)catchContextVoid;
+			catchContext.thunk(catchContext.argument);
+		},
+		[](void* catchContextVoid, Platform::Signal signal, Platform::CallStack&&) {
+			if(signal.type != Platform::Signal::Type::accessViolation) { return false; }
+
+			// Only catch faults in the memory's reserved pages or the guard pages following them.
+			const CatchContext& catchContext = *(const CatchContext*)catchContextVoid;
+			const Uptr numGuardBytes = Uptr(numGuardPages) << Platform::getPageSizeLog2();
+			const U8* address = (const U8*)signal.accessViolation.address;
+			const U8* startAddress = catchContext.memory->baseAddress;
+			return address >= startAddress
+				   && address < startAddress + catchContext.memory->numReservedBytes + numGuardBytes;
+		},
+		&catchContext);
+}
+
 void Runtime::initDataSegment(ModuleInstance* moduleInstance,
 							  Uptr dataSegmentIndex,
 							  const std::vector<U8>* dataVector,
@@ -346,6 +504,17 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory, "memory.size", U32, memory_
 	return U32(numMemoryPages);
 }
 
+WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
+							   "outOfBoundsMemoryTrap",
+							   void,
+							   outOfBoundsMemoryTrap,
+							   U64 address,
+							   Uptr memoryId)
+{
+	Memory* memory = getMemoryFromRuntimeData(contextRuntimeData, memoryId);
+	throwException(ExceptionTypes::outOfBoundsMemoryAccess, {asObject(memory), address});
+}
+
 WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
 							   "memory.init",
 							   void,
@@ -400,6 +569,24 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
 	}
 }
 
+// Returns true if the range is within the memory's committed pages. Memories never shrink, so a
+// concurrent memory.grow can't invalidate the check, though unmapMemoryPages may still decommit
+// pages in the range.
+static bool isCommittedMemoryRange(Memory* memory, U32 address, U32 numBytes)
+{
+	const U64 numCommittedBytes
+		= U64(memory->numPages.load(std::memory_order_acquire)) * IR::numBytesPerPage;
+	return U64(address) + U64(numBytes) <= numCommittedBytes;
+}
+
+// The bulk memory intrinsics are only called by WebAssembly code, which runs inside the
+// catchSignals of whatever invoked it. When a range is within the memory's committed pages, they
+// use the C library's vectorized memmove and memset without a signal context of their own: a fault
+// on a page decommitted by unmapMemoryPages goes to the enclosing catchSignals, which translates it
+// to an out-of-bounds trap just like a fault in the generated code. Ranges that extend past the
+// committed pages are copied or filled bytewise inside unwindSignalsAsExceptions, so every byte
+// before the first out-of-bounds byte is written before the trap.
+
 WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
 							   "memory.copy",
 							   void,
@@ -416,7 +603,13 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
 	U8* destPointer = getReservedMemoryOffsetRange(destMemory, destAddress, numBytes);
 	U8* sourcePointer = getReservedMemoryOffsetRange(sourceMemory, sourceAddress, numBytes);
 
-	unwindSignalsAsExceptions([=] { bytewiseMemMove(destPointer, sourcePointer, numBytes); });
+	if(isCommittedMemoryRange(sourceMemory, sourceAddress, numBytes)
+	   && isCommittedMemoryRange(destMemory, destAddress, numBytes))
+	{ memmove(destPointer, sourcePointer, numBytes); }
+	else
+	{
+		unwindSignalsAsExceptions([=] { bytewiseMemMove(destPointer, sourcePointer, numBytes); });
+	}
 }
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
@@ -431,5 +624,10 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsicsMemory,
 	Memory* memory = getMemoryFromRuntimeData(contextRuntimeData, memoryId);
 
 	U8* destPointer = getReservedMemoryOffsetRange(memory, destAddress, numBytes);
-	unwindSignalsAsExceptions([=] { bytewiseMemSet(destPointer, U8(value), numBytes); });
+	if(isCommittedMemoryRange(memory, destAddress, numBytes))
+	{ memset(destPointer, U8(value), numBytes); }
+	else
+	{
+		unwindSignalsAsExceptions([=] { bytewiseMemSet(destPointer, U8(value), numBytes); });
+	}
 }
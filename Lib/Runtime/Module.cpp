@@ -15,6 +15,7 @@
 #include "WAVM/Inline/Lock.h"
 #include "WAVM/Inline/Serialization.h"
 #include "WAVM/LLVMJIT/LLVMJIT.h"
+#include "WAVM/Logging/Logging.h"
 #include "WAVM/Platform/Intrinsic.h"
 #include "WAVM/Platform/Mutex.h"
 #include "WAVM/Runtime/Runtime.h"
@@ -52,22 +53,182 @@ static Value evaluateInitializer(const std::vector<Global*>& moduleGlobals,
 	};
 }
 
-ModuleRef Runtime::compileModule(const IR::Module& irModule)
+Runtime::Module::Module(IR::Module&& inIR,
+						std::vector<U8>&& inObjectCode,
+						MemoryBoundsCheckMode inMemoryBoundsCheckMode)
+: ir(std::move(inIR))
+, memoryBoundsCheckMode(inMemoryBoundsCheckMode)
+, objectCode(std::make_shared<const std::vector<U8>>(std::move(inObjectCode)))
 {
-	std::vector<U8> objectCode = LLVMJIT::compileModule(irModule);
-	return std::make_shared<Module>(IR::Module(irModule), std::move(objectCode));
+	// Parse the name section once, and keep only the names of definitions that instantiateModule
+	// uses for debug names.
+	DisassemblyNames disassemblyNames;
+	getDisassemblyNames(ir, disassemblyNames);
+
+	auto functionNames = std::make_shared<std::vector<std::string>>();
+	for(Uptr functionDefIndex = 0; functionDefIndex < ir.functions.defs.size(); ++functionDefIndex)
+	{
+		std::string& debugName
+			= disassemblyNames.functions[ir.functions.imports.size() + functionDefIndex].name;
+		if(!debugName.size())
+		{ debugName = "<function #" + std::to_string(functionDefIndex) + ">"; }
+		functionNames->push_back(std::move(debugName));
+	}
+	functionDefDebugNames = std::move(functionNames);
+
+	tableDefDebugNames.assign(disassemblyNames.tables.begin() + ir.tables.imports.size(),
+							  disassemblyNames.tables.end());
+	memoryDefDebugNames.assign(disassemblyNames.memories.begin() + ir.memories.imports.size(),
+							   disassemblyNames.memories.end());
+	exceptionTypeDefDebugNames.assign(
+		disassemblyNames.exceptionTypes.begin() + ir.exceptionTypes.imports.size(),
+		disassemblyNames.exceptionTypes.end());
+}
+
+ModuleRef Runtime::compileModule(const IR::Module& irModule,
+								 MemoryBoundsCheckMode boundsCheckMode,
+								 CodegenMode codegenMode)
+{
+	std::vector<U8> objectCode = LLVMJIT::compileModule(irModule, boundsCheckMode, codegenMode);
+	return std::make_shared<Module>(IR::Module(irModule), std::move(objectCode), boundsCheckMode);
+}
+
+// Re-materializes the IR and object code of a module whose code was released.
+static void loadReleasedModuleCode(const Runtime::Module& module,
+								   const ModuleCodeLoader& codeLoader,
+								   IR::Module& outIRModule,
+								   std::vector<U8>& outObjectCode)
+{
+	codeLoader(outIRModule, outObjectCode);
+	errorUnless(outIRModule.functions.defs.size() == module.ir.functions.defs.size());
+	errorUnless(outObjectCode.size());
 }
 
-std::vector<U8> Runtime::getObjectCode(ModuleConstRefParam module) { return module->objectCode; }
+// Returns the module's object code, re-materializing it if it was released. The module's codeMutex
+// is only locked to take a snapshot of the object code or the code loader, so loading the code, and
+// whatever the caller does with it, doesn't block releaseModuleCode or other users of the module.
+static std::shared_ptr<const std::vector<U8>> getObjectCodeSnapshot(const Runtime::Module& module)
+{
+	std::shared_ptr<const ModuleCodeLoader> codeLoader;
+	{
+		Lock<Platform::Mutex> codeLock(module.codeMutex);
+		if(module.objectCode) { return module.objectCode; }
+		codeLoader = module.codeLoader;
+	}
+
+	IR::Module loadedIRModule;
+	std::shared_ptr<std::vector<U8>> loadedObjectCode = std::make_shared<std::vector<U8>>();
+	loadReleasedModuleCode(module, *codeLoader, loadedIRModule, *loadedObjectCode);
+	return loadedObjectCode;
+}
+
+std::vector<U8> Runtime::getObjectCode(ModuleConstRefParam module)
+{
+	return *getObjectCodeSnapshot(*module);
+}
 
 ModuleRef Runtime::loadPrecompiledModule(const IR::Module& irModule,
-										 const std::vector<U8>& objectCode)
+										 const std::vector<U8>& objectCode,
+										 MemoryBoundsCheckMode boundsCheckMode)
+{
+	return std::make_shared<Module>(
+		IR::Module(irModule), std::vector<U8>(objectCode), boundsCheckMode);
+}
+
+static const char precompiledObjectSectionName[] = "wavm.precompiled_object";
+
+void Runtime::addPrecompiledObjectSection(IR::Module& irModule,
+										  const std::vector<U8>& objectCode,
+										  MemoryBoundsCheckMode boundsCheckMode)
 {
-	return std::make_shared<Module>(IR::Module(irModule), std::vector<U8>(objectCode));
+	// The section is the bounds check mode the object code was compiled with, followed by the
+	// object code.
+	std::vector<U8> sectionData;
+	sectionData.reserve(objectCode.size() + 1);
+	sectionData.push_back(U8(boundsCheckMode));
+	sectionData.insert(sectionData.end(), objectCode.begin(), objectCode.end());
+	irModule.userSections.push_back({precompiledObjectSectionName, std::move(sectionData)});
+}
+
+ModuleRef Runtime::loadPrecompiledModule(const IR::Module& irModule,
+										 MemoryBoundsCheckMode boundsCheckMode)
+{
+	const UserSection* precompiledObjectSection = nullptr;
+	for(const UserSection& userSection : irModule.userSections)
+	{
+		if(userSection.name == precompiledObjectSectionName)
+		{
+			precompiledObjectSection = &userSection;
+			break;
+		}
+	}
+
+	if(!precompiledObjectSection)
+	{
+		Log::printf(Log::error,
+					"Module did not contain '%s' section.\n",
+					precompiledObjectSectionName);
+		return nullptr;
+	}
+
+	const std::vector<U8>& sectionData = precompiledObjectSection->data;
+	if(sectionData.size() < 2
+	   || (sectionData[0] != U8(MemoryBoundsCheckMode::guardRegion)
+		   && sectionData[0] != U8(MemoryBoundsCheckMode::explicitChecks)))
+	{
+		Log::printf(Log::error,
+					"Module's '%s' section is malformed, or was created by an incompatible "
+					"version of WAVM.\n",
+					precompiledObjectSectionName);
+		return nullptr;
+	}
+	else if(MemoryBoundsCheckMode(sectionData[0]) != boundsCheckMode)
+	{
+		Log::printf(Log::error,
+					"Module's '%s' section was compiled with a different memory bounds check "
+					"mode.\n",
+					precompiledObjectSectionName);
+		return nullptr;
+	}
+
+	return std::make_shared<Module>(IR::Module(irModule),
+									std::vector<U8>(sectionData.begin() + 1, sectionData.end()),
+									boundsCheckMode);
 }
 
 const IR::Module& Runtime::getModuleIR(ModuleConstRefParam module) { return module->ir; }
 
+IR::Module Runtime::getModuleIRWithCode(ModuleConstRefParam module)
+{
+	std::shared_ptr<const ModuleCodeLoader> codeLoader;
+	{
+		Lock<Platform::Mutex> codeLock(module->codeMutex);
+		if(!module->codeLoader) { return module->ir; }
+		codeLoader = module->codeLoader;
+	}
+
+	IR::Module loadedIRModule;
+	std::vector<U8> loadedObjectCode;
+	loadReleasedModuleCode(*module, *codeLoader, loadedIRModule, loadedObjectCode);
+	return loadedIRModule;
+}
+
+void Runtime::releaseModuleCode(ModuleRefParam module, ModuleCodeLoader&& codeLoader)
+{
+	wavmAssert(codeLoader);
+
+	Lock<Platform::Mutex> codeLock(module->codeMutex);
+
+	// Swap the released vectors with empty vectors to free their storage.
+	for(FunctionDef& functionDef : module->ir.functions.defs)
+	{
+		std::vector<U8>().swap(functionDef.code);
+		std::vector<std::vector<Uptr>>().swap(functionDef.branchTables);
+	}
+	module->objectCode.reset();
+	module->codeLoader = std::make_shared<const ModuleCodeLoader>(std::move(codeLoader));
+}
+
 ModuleInstance::~ModuleInstance()
 {
 	if(id != UINTPTR_MAX)
@@ -125,6 +286,19 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 		case ExternKind::memory: {
 			Memory* memory = asMemory(importObject);
 			errorUnless(isSubtype(memory->type, module->ir.memories.getType(kindIndex.index)));
+
+			// Code compiled without explicit bounds checks relies on the memory reserving enough
+			// address space for any 32-bit address + 32-bit offset, so it can't be linked with a
+			// memory created with explicit bounds checks.
+			if(module->memoryBoundsCheckMode == MemoryBoundsCheckMode::guardRegion
+			   && memory->boundsCheckMode == MemoryBoundsCheckMode::explicitChecks)
+			{
+				{
+					Lock<Platform::Mutex> compartmentLock(compartment->mutex);
+					compartment->moduleInstances.removeOrFail(id);
+				}
+				throwException(ExceptionTypes::invalidArgument);
+			}
 			memories.push_back(memory);
 			break;
 		}
@@ -153,15 +327,10 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 	wavmAssert(globals.size() == module->ir.globals.imports.size());
 	wavmAssert(exceptionTypes.size() == module->ir.exceptionTypes.imports.size());
 
-	// Deserialize the disassembly names.
-	DisassemblyNames disassemblyNames;
-	getDisassemblyNames(module->ir, disassemblyNames);
-
 	// Instantiate the module's memory and table definitions.
 	for(Uptr tableDefIndex = 0; tableDefIndex < module->ir.tables.defs.size(); ++tableDefIndex)
 	{
-		std::string debugName
-			= disassemblyNames.tables[module->ir.tables.imports.size() + tableDefIndex];
+		std::string debugName = module->tableDefDebugNames[tableDefIndex];
 		auto table = createTable(compartment,
 								 module->ir.tables.defs[tableDefIndex].type,
 								 nullptr,
@@ -177,12 +346,12 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 	}
 	for(Uptr memoryDefIndex = 0; memoryDefIndex < module->ir.memories.defs.size(); ++memoryDefIndex)
 	{
-		std::string debugName
-			= disassemblyNames.memories[module->ir.memories.imports.size() + memoryDefIndex];
+		std::string debugName = module->memoryDefDebugNames[memoryDefIndex];
 		auto memory = createMemory(compartment,
 								   module->ir.memories.defs[memoryDefIndex].type,
 								   std::move(debugName),
-								   resourceQuota);
+								   resourceQuota,
+								   module->memoryBoundsCheckMode);
 		if(!memory)
 		{
 			Lock<Platform::Mutex> compartmentLock(compartment->mutex);
@@ -215,9 +384,7 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 	{
 		const ExceptionTypeDef& exceptionTypeDef
 			= module->ir.exceptionTypes.defs[exceptionTypeDefIndex];
-		std::string debugName
-			= disassemblyNames
-				  .exceptionTypes[module->ir.exceptionTypes.imports.size() + exceptionTypeDefIndex];
+		std::string debugName = module->exceptionTypeDefDebugNames[exceptionTypeDefIndex];
 		exceptionTypes.push_back(
 			createExceptionType(compartment, exceptionTypeDef.type, std::move(debugName)));
 	}
@@ -248,7 +415,8 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 	for(Table* table : tables) { jitTables.push_back({table->id}); }
 
 	std::vector<LLVMJIT::MemoryBinding> jitMemories;
-	for(Memory* memory : memories) { jitMemories.push_back({memory->id}); }
+	for(Memory* memory : memories)
+	{ jitMemories.push_back({memory->id, memory->numReservedBytes}); }
 
 	std::vector<LLVMJIT::GlobalBinding> jitGlobals;
 	for(Global* global : globals)
@@ -267,27 +435,30 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 	for(ExceptionType* exceptionType : exceptionTypes)
 	{ jitExceptionTypes.push_back({exceptionType->id}); }
 
-	// Create a FunctionMutableData for each function definition.
+	// Create a FunctionMutableData for each function definition. Their debug names share a prefix
+	// for this instance, and point into the module's cached function names.
+	auto debugNamePrefix = std::make_shared<const std::string>("wasm!" + moduleDebugName + '!');
+	const std::vector<std::string>& functionDefDebugNames = *module->functionDefDebugNames;
 	std::vector<FunctionMutableData*> functionDefMutableDatas;
 	for(Uptr functionDefIndex = 0; functionDefIndex < module->ir.functions.defs.size();
 		++functionDefIndex)
 	{
-		std::string debugName
-			= disassemblyNames.functions[module->ir.functions.imports.size() + functionDefIndex]
-				  .name;
-		if(!debugName.size())
-		{ debugName = "<function #" + std::to_string(functionDefIndex) + ">"; }
-		debugName = "wasm!" + moduleDebugName + '!' + debugName;
-
-		functionDefMutableDatas.push_back(new FunctionMutableData(std::move(debugName)));
+		functionDefMutableDatas.push_back(new FunctionMutableData(
+			std::shared_ptr<const std::string>(debugNamePrefix),
+			std::shared_ptr<const std::string>(module->functionDefDebugNames,
+											   &functionDefDebugNames[functionDefIndex])));
 	}
 
 	// Load the compiled module's object code with this module instance's imports.
 	std::vector<FunctionType> jitTypes = module->ir.types;
 	std::vector<Runtime::Function*> jitFunctionDefs;
 	jitFunctionDefs.resize(module->ir.functions.defs.size(), nullptr);
+	// Take a snapshot of the module's object code, so releaseModuleCode can't free it while it's
+	// loaded. If the module's code was released, load its object code again just for this
+	// instantiation.
+	std::shared_ptr<const std::vector<U8>> objectCode = getObjectCodeSnapshot(*module);
 	std::shared_ptr<LLVMJIT::Module> jitModule
-		= LLVMJIT::loadModule(module->objectCode,
+		= LLVMJIT::loadModule(*objectCode,
 							  std::move(wavmIntrinsicsExportMap),
 							  std::move(jitTypes),
 							  std::move(jitFunctionImports),
@@ -298,6 +469,7 @@ ModuleInstance* Runtime::instantiateModule(Compartment* compartment,
 							  {id},
 							  reinterpret_cast<Uptr>(getOutOfBoundsElement()),
 							  functionDefMutableDatas);
+	objectCode.reset();
 
 	// LLVMJIT::loadModule filled in the functionDefMutableDatas' function pointers with the
 	// compiled functions. Add those functions to the module.
@@ -121,12 +121,8 @@ struct GCState
 		{
 		case ObjectKind::table:
 		{
-			Table* table = asTable(object);
-
-			Lock<Platform::Mutex> resizingLock(table->resizingMutex);
-			const Uptr numElements = getTableNumElements(table);
-			for(Uptr elementIndex = 0; elementIndex < numElements; ++elementIndex)
-			{ visitReference(getTableElement(table, elementIndex)); }
+			visitTableElements(asTable(object),
+							   [this](Object* element) { visitReference(element); });
 			break;
 		}
 		case ObjectKind::global:
@@ -52,7 +52,9 @@ namespace WAVM { namespace Runtime {
 		Uptr numReservedBytes = 0;
 		Uptr numReservedElements = 0;
 
-		mutable Platform::Mutex resizingMutex;
+		// Growing the table reserves the new elements by incrementing numReservedGrowElements,
+		// initializes them, then publishes them by incrementing numElements.
+		std::atomic<Uptr> numReservedGrowElements{0};
 		std::atomic<Uptr> numElements{0};
 
 		ResourceQuotaRef resourceQuota;
@@ -75,6 +77,26 @@ namespace WAVM { namespace Runtime {
 	// at the end of the array will, when re-adding this Function's address, point to this Object.
 	extern Object* getOutOfBoundsElement();
 
+	// This is used as a sentinel value for table elements that are null.
+	extern Object* getUninitializedElement();
+
+	// Calls visitElement for each non-null element of a table. This reads the elements directly,
+	// which is safe because the elements below numElements are always committed and initialized.
+	template<typename VisitElement>
+	void visitTableElements(const Table* table, VisitElement&& visitElement)
+	{
+		const Uptr outOfBoundsElementAddress = reinterpret_cast<Uptr>(getOutOfBoundsElement());
+		Object* uninitializedElement = getUninitializedElement();
+		const Uptr numElements = table->numElements.load(std::memory_order_acquire);
+		for(Uptr elementIndex = 0; elementIndex < numElements; ++elementIndex)
+		{
+			const Uptr biasedValue
+				= table->elements[elementIndex].biasedValue.load(std::memory_order_acquire);
+			Object* object = reinterpret_cast<Object*>(biasedValue + outOfBoundsElementAddress);
+			if(object != uninitializedElement) { visitElement(object); }
+		}
+	}
+
 	// An instance of a WebAssembly Memory.
 	struct Memory : GCObject
 	{
@@ -85,9 +107,20 @@ namespace WAVM { namespace Runtime {
 		U8* baseAddress = nullptr;
 		Uptr numReservedBytes = 0;
 
+		// If the memory's address space was aligned to a huge page, the alignment and the address
+		// that must be passed to Platform::freeAlignedVirtualPages.
+		U8* unalignedBaseAddress = nullptr;
+		Uptr baseAddressAlignmentLog2 = 0;
+
+		MemoryBoundsCheckMode boundsCheckMode = MemoryBoundsCheckMode::guardRegion;
+
 		mutable Platform::Mutex resizingMutex;
 		std::atomic<Uptr> numPages{0};
 
+		// Whether mapFileIntoMemory has been called for the memory, so some of its pages may be
+		// mapped from a file instead of being anonymous pages.
+		std::atomic<bool> hasMappedFiles{false};
+
 		ResourceQuotaRef resourceQuota;
 
 		Memory(Compartment* inCompartment,
@@ -154,12 +187,28 @@ namespace WAVM { namespace Runtime {
 	struct Module
 	{
 		IR::Module ir;
-		std::vector<U8> objectCode;
+		MemoryBoundsCheckMode memoryBoundsCheckMode;
 
-		Module(IR::Module&& inIR, std::vector<U8>&& inObjectCode)
-		: ir(inIR), objectCode(std::move(inObjectCode))
-		{
-		}
+		// The module's object code, or null if it was released by releaseModuleCode. It's shared
+		// so users of the object code can take a snapshot of it without keeping codeMutex locked.
+		std::shared_ptr<const std::vector<U8>> objectCode;
+
+		// Set if the module's function bodies and object code were released by releaseModuleCode.
+		std::shared_ptr<const ModuleCodeLoader> codeLoader;
+
+		// Protects the function bodies in ir, objectCode, and codeLoader from releaseModuleCode.
+		mutable Platform::Mutex codeMutex;
+
+		// The debug names of the module's definitions, parsed from its name section once instead
+		// of on each instantiation.
+		std::shared_ptr<const std::vector<std::string>> functionDefDebugNames;
+		std::vector<std::string> tableDefDebugNames;
+		std::vector<std::string> memoryDefDebugNames;
+		std::vector<std::string> exceptionTypeDefDebugNames;
+
+		Module(IR::Module&& inIR,
+			   std::vector<U8>&& inObjectCode,
+			   MemoryBoundsCheckMode inMemoryBoundsCheckMode);
 	};
 
 	// An instance of a WebAssembly module.
@@ -262,50 +311,43 @@ namespace WAVM { namespace Runtime {
 
 	struct ResourceQuota
 	{
+		// A current and maximum value that may be updated concurrently without locking. allocate
+		// uses a compare-and-swap loop, so it never allows current to exceed max.
 		template<typename Value> struct CurrentAndMax
 		{
-			CurrentAndMax(Value inMax) : current{0}, max(inMax) {}
+			CurrentAndMax(Value inMax) : current{0}, max{inMax} {}
 
 			bool allocate(Value delta)
 			{
-				Lock<Platform::Mutex> lock(mutex);
-
-				// Make sure the delta doesn't make current overflow.
-				if(current + delta < current) { return false; }
-
-				if(current + delta > max) { return false; }
-
-				current += delta;
-				return true;
+				Value oldCurrent = current.load(std::memory_order_relaxed);
+				while(true)
+				{
+					// Make sure the delta doesn't make current overflow.
+					const Value newCurrent = oldCurrent + delta;
+					if(newCurrent < oldCurrent) { return false; }
+
+					if(newCurrent > max.load(std::memory_order_relaxed)) { return false; }
+
+					if(current.compare_exchange_weak(
+						   oldCurrent, newCurrent, std::memory_order_relaxed))
+					{ return true; }
+				};
 			}
 
 			void free(Value delta)
 			{
-				Lock<Platform::Mutex> lock(mutex);
-				wavmAssert(current - delta <= current);
-				current -= delta;
+				const Value oldCurrent = current.fetch_sub(delta, std::memory_order_relaxed);
+				wavmAssert(oldCurrent - delta <= oldCurrent);
+				WAVM_SUPPRESS_UNUSED(oldCurrent);
 			}
 
-			Value getCurrent() const
-			{
-				Lock<Platform::Mutex> lock(mutex);
-				return current;
-			}
-			Value getMax() const
-			{
-				Lock<Platform::Mutex> lock(mutex);
-				return max;
-			}
-			void setMax(Value newMax)
-			{
-				Lock<Platform::Mutex> lock(mutex);
-				max = newMax;
-			}
+			Value getCurrent() const { return current.load(std::memory_order_relaxed); }
+			Value getMax() const { return max.load(std::memory_order_relaxed); }
+			void setMax(Value newMax) { max.store(newMax, std::memory_order_relaxed); }
 
 		private:
-			mutable Platform::Mutex mutex;
-			Value current;
-			Value max;
+			std::atomic<Value> current;
+			std::atomic<Value> max;
 		};
 
 		CurrentAndMax<Uptr> memoryPages{UINTPTR_MAX};
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <string.h>
+#include <memory>
 #include <vector>
 
 #include "RuntimePrivate.h"
@@ -12,6 +13,7 @@
 #include "WAVM/Platform/Intrinsic.h"
 #include "WAVM/Platform/Memory.h"
 #include "WAVM/Platform/Mutex.h"
+#include "WAVM/Platform/Thread.h"
 #include "WAVM/Runtime/Runtime.h"
 #include "WAVM/Runtime/RuntimeData.h"
 
@@ -22,13 +24,41 @@ namespace WAVM { namespace Runtime {
 	WAVM_DEFINE_INTRINSIC_MODULE(wavmIntrinsicsTable)
 }}
 
-// Global lists of tables; used to query whether an address is reserved by one of them.
-static Platform::Mutex tablesMutex;
-static std::vector<Table*> tables;
+// A global array of the address ranges reserved by tables, sorted by address; used to query
+// whether an address is reserved by one of them. The array is read without locking, so it may be
+// queried while handling a signal: writers hold tableRangesMutex and make tableRangesSequence odd
+// while they modify the array, and readers retry if tableRangesSequence changed while reading.
+// Readers only retry a bounded number of times, and don't wait for a write by their own thread,
+// so a signal handler can't wait forever on a writer that it interrupted.
+struct TableRange
+{
+	std::atomic<U8*> begin{nullptr};
+	std::atomic<U8*> end{nullptr};
+	std::atomic<Table*> table{nullptr};
+};
+
+struct TableRangeArray
+{
+	const Uptr capacity;
+	std::unique_ptr<TableRange[]> ranges;
+
+	TableRangeArray(Uptr inCapacity) : capacity(inCapacity), ranges(new TableRange[inCapacity]) {}
+};
+
+static Platform::Mutex tableRangesMutex;
+static std::atomic<Uptr> tableRangesSequence{0};
+static std::atomic<TableRangeArray*> tableRanges{nullptr};
+static std::atomic<Uptr> numTableRanges{0};
+static thread_local bool isWritingTableRanges = false;
+
+// When the array is grown, the old arrays are kept so readers may safely finish searching them.
+// The array capacity is doubled each time, so this at most doubles the memory used by the arrays.
+static std::vector<std::unique_ptr<TableRangeArray>> allTableRangeArrays;
 
 enum
 {
-	numGuardPages = 1
+	numGuardPages = 1,
+	maxTableRangesReadAttempts = 1000
 };
 
 static Uptr getNumPlatformPages(Uptr numBytes)
@@ -36,6 +66,106 @@ static Uptr getNumPlatformPages(Uptr numBytes)
 	return (numBytes + (Uptr(1) << Platform::getPageSizeLog2()) - 1) >> Platform::getPageSizeLog2();
 }
 
+static void beginWriteTableRanges()
+{
+	wavmAssertMutexIsLockedByCurrentThread(tableRangesMutex);
+	isWritingTableRanges = true;
+	tableRangesSequence.store(tableRangesSequence.load(std::memory_order_relaxed) + 1,
+							  std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void endWriteTableRanges()
+{
+	tableRangesSequence.store(tableRangesSequence.load(std::memory_order_relaxed) + 1,
+							  std::memory_order_release);
+	isWritingTableRanges = false;
+}
+
+static void copyTableRange(TableRange& dest, const TableRange& source)
+{
+	dest.begin.store(source.begin.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	dest.end.store(source.end.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	dest.table.store(source.table.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Returns the index of the first range in the array that begins at or after address.
+static Uptr lowerBoundTableRange(const TableRangeArray* array, Uptr numRanges, U8* address)
+{
+	Uptr lowIndex = 0;
+	Uptr highIndex = numRanges;
+	while(lowIndex < highIndex)
+	{
+		const Uptr middleIndex = lowIndex + (highIndex - lowIndex) / 2;
+		if(array->ranges[middleIndex].begin.load(std::memory_order_relaxed) < address)
+		{ lowIndex = middleIndex + 1; }
+		else
+		{
+			highIndex = middleIndex;
+		}
+	}
+	return lowIndex;
+}
+
+static void addTableRange(Table* table)
+{
+	U8* begin = (U8*)table->elements;
+	U8* end = begin + table->numReservedBytes;
+
+	Lock<Platform::Mutex> tableRangesLock(tableRangesMutex);
+	TableRangeArray* array = tableRanges.load(std::memory_order_relaxed);
+	const Uptr numRanges = numTableRanges.load(std::memory_order_relaxed);
+
+	// If the array is full, allocate a larger array. The new array isn't visible to readers until
+	// it's stored to tableRanges, so it can be initialized before beginning the write.
+	TableRangeArray* newArray = array;
+	if(!array || numRanges == array->capacity)
+	{
+		newArray = new TableRangeArray(array ? array->capacity * 2 : 16);
+		allTableRangeArrays.emplace_back(newArray);
+		for(Uptr rangeIndex = 0; rangeIndex < numRanges; ++rangeIndex)
+		{ copyTableRange(newArray->ranges[rangeIndex], array->ranges[rangeIndex]); }
+	}
+
+	beginWriteTableRanges();
+
+	// Shift the ranges after the new range up to make room for it.
+	const Uptr insertIndex = lowerBoundTableRange(newArray, numRanges, begin);
+	for(Uptr rangeIndex = numRanges; rangeIndex > insertIndex; --rangeIndex)
+	{ copyTableRange(newArray->ranges[rangeIndex], newArray->ranges[rangeIndex - 1]); }
+
+	TableRange& range = newArray->ranges[insertIndex];
+	range.begin.store(begin, std::memory_order_relaxed);
+	range.end.store(end, std::memory_order_relaxed);
+	range.table.store(table, std::memory_order_relaxed);
+
+	tableRanges.store(newArray, std::memory_order_relaxed);
+	numTableRanges.store(numRanges + 1, std::memory_order_relaxed);
+
+	endWriteTableRanges();
+}
+
+static void removeTableRange(Table* table)
+{
+	Lock<Platform::Mutex> tableRangesLock(tableRangesMutex);
+	TableRangeArray* array = tableRanges.load(std::memory_order_relaxed);
+	const Uptr numRanges = numTableRanges.load(std::memory_order_relaxed);
+
+	const Uptr removeIndex = lowerBoundTableRange(array, numRanges, (U8*)table->elements);
+	if(removeIndex == numRanges
+	   || array->ranges[removeIndex].table.load(std::memory_order_relaxed) != table)
+	{ return; }
+
+	beginWriteTableRanges();
+
+	// Shift the ranges after the removed range down over it.
+	for(Uptr rangeIndex = removeIndex; rangeIndex + 1 < numRanges; ++rangeIndex)
+	{ copyTableRange(array->ranges[rangeIndex], array->ranges[rangeIndex + 1]); }
+	numTableRanges.store(numRanges - 1, std::memory_order_relaxed);
+
+	endWriteTableRanges();
+}
+
 static Function* makeDummyFunction(const char* debugName)
 {
 	FunctionMutableData* functionMutableData = new FunctionMutableData(debugName);
@@ -51,7 +181,7 @@ Object* Runtime::getOutOfBoundsElement()
 	return asObject(function);
 }
 
-static Object* getUninitializedElement()
+Object* Runtime::getUninitializedElement()
 {
 	static Function* function = makeDummyFunction("uninitialized table element");
 	return asObject(function);
@@ -92,10 +222,7 @@ static Table* createTableImpl(Compartment* compartment,
 	}
 
 	// Add the table to the global array.
-	{
-		Lock<Platform::Mutex> tablesLock(tablesMutex);
-		tables.push_back(table);
-	}
+	addTableRange(table);
 	return table;
 }
 
@@ -113,34 +240,46 @@ static bool growTableImpl(Table* table,
 		if(table->resourceQuota && !table->resourceQuota->tableElems.allocate(numElementsToGrow))
 		{ return false; }
 
-		Lock<Platform::Mutex> resizingLock(table->resizingMutex);
-
-		oldNumElements = table->numElements.load(std::memory_order_acquire);
-
-		// If the growth would cause the table's size to exceed its maximum, return -1.
-		if(numElementsToGrow > table->type.size.max
-		   || oldNumElements > table->type.size.max - numElementsToGrow
-		   || numElementsToGrow > IR::maxTableElems
-		   || oldNumElements > IR::maxTableElems - numElementsToGrow)
+		// Reserve the new elements by atomically incrementing numReservedGrowElements. Concurrent
+		// growths of the table will reserve disjoint ranges of elements.
+		oldNumElements = table->numReservedGrowElements.load(std::memory_order_acquire);
+		Uptr newNumElements;
+		while(true)
 		{
-			if(table->resourceQuota) { table->resourceQuota->tableElems.free(numElementsToGrow); }
-			return false;
-		}
+			// If the growth would cause the table's size to exceed its maximum, return -1.
+			if(numElementsToGrow > table->type.size.max
+			   || oldNumElements > table->type.size.max - numElementsToGrow
+			   || numElementsToGrow > IR::maxTableElems
+			   || oldNumElements > IR::maxTableElems - numElementsToGrow)
+			{
+				if(table->resourceQuota)
+				{ table->resourceQuota->tableElems.free(numElementsToGrow); }
+				return false;
+			}
 
-		// Try to commit pages for the new elements, and return -1 if the commit fails.
-		const Uptr newNumElements = oldNumElements + numElementsToGrow;
-		const Uptr previousNumPlatformPages
-			= getNumPlatformPages(oldNumElements * sizeof(Table::Element));
-		const Uptr newNumPlatformPages
-			= getNumPlatformPages(newNumElements * sizeof(Table::Element));
-		if(newNumPlatformPages != previousNumPlatformPages
-		   && !Platform::commitVirtualPages(
-			   (U8*)table->elements + (previousNumPlatformPages << Platform::getPageSizeLog2()),
-			   newNumPlatformPages - previousNumPlatformPages))
-		{
-			if(table->resourceQuota) { table->resourceQuota->tableElems.free(numElementsToGrow); }
-			return false;
-		}
+			// Try to commit pages for the new elements before reserving them, and return -1 if the
+			// commit fails. If this thread loses the race to reserve the elements, the pages may
+			// be committed without being used, but committed pages past the end of the table are
+			// zero, and so are still read as the out-of-bounds sentinel value.
+			newNumElements = oldNumElements + numElementsToGrow;
+			const Uptr previousNumPlatformPages
+				= getNumPlatformPages(oldNumElements * sizeof(Table::Element));
+			const Uptr newNumPlatformPages
+				= getNumPlatformPages(newNumElements * sizeof(Table::Element));
+			if(newNumPlatformPages != previousNumPlatformPages
+			   && !Platform::commitVirtualPages(
+				   (U8*)table->elements + (previousNumPlatformPages << Platform::getPageSizeLog2()),
+				   newNumPlatformPages - previousNumPlatformPages))
+			{
+				if(table->resourceQuota)
+				{ table->resourceQuota->tableElems.free(numElementsToGrow); }
+				return false;
+			}
+
+			if(table->numReservedGrowElements.compare_exchange_weak(
+				   oldNumElements, newNumElements, std::memory_order_acq_rel))
+			{ break; }
+		};
 
 		if(initializeNewElements)
 		{
@@ -154,6 +293,10 @@ static bool growTableImpl(Table* table,
 			}
 		}
 
+		// Publish the new elements once any concurrent growths that reserved the elements before
+		// them have published their elements, so numElements only covers initialized elements.
+		while(table->numElements.load(std::memory_order_acquire) != oldNumElements)
+		{ Platform::yieldToAnotherThread(); };
 		table->numElements.store(newNumElements, std::memory_order_release);
 	}
 
@@ -203,9 +346,8 @@ Table* Runtime::createTable(Compartment* compartment,
 
 Table* Runtime::cloneTable(Table* table, Compartment* newCompartment)
 {
-	Lock<Platform::Mutex> resizingLock(table->resizingMutex);
-
-	// Create the new table.
+	// Create the new table. Elements added by concurrent growths of the original table after this
+	// point aren't copied to the new table.
 	const Uptr numElements = table->numElements.load(std::memory_order_acquire);
 	std::string debugName = table->debugName;
 	Table* newTable
@@ -228,8 +370,6 @@ Table* Runtime::cloneTable(Table* table, Compartment* newCompartment)
 			std::memory_order_release);
 	}
 
-	resizingLock.unlock();
-
 	// Insert the table in the new compartment's tables array with the same index as it had in the
 	// original compartment's tables IndexMap.
 	{
@@ -257,17 +397,7 @@ Table::~Table()
 	}
 
 	// Remove the table from the global array.
-	{
-		Lock<Platform::Mutex> tablesLock(tablesMutex);
-		for(Uptr tableIndex = 0; tableIndex < tables.size(); ++tableIndex)
-		{
-			if(tables[tableIndex] == this)
-			{
-				tables.erase(tables.begin() + tableIndex);
-				break;
-			}
-		}
-	}
+	if(elements) { removeTableRange(this); }
 
 	// Free the virtual address space.
 	const Uptr pageBytesLog2 = Platform::getPageSizeLog2();
@@ -283,20 +413,56 @@ Table::~Table()
 
 bool Runtime::isAddressOwnedByTable(U8* address, Table*& outTable, Uptr& outTableIndex)
 {
-	// Iterate over all tables and check if the address is within the reserved address space for
-	// each.
-	Lock<Platform::Mutex> tablesLock(tablesMutex);
-	for(auto table : tables)
+	// If this thread was interrupted while modifying the array, the write can't finish until this
+	// returns, so treat the address as not owned by a table.
+	if(isWritingTableRanges) { return false; }
+
+	for(Uptr attemptIndex = 0; attemptIndex < maxTableRangesReadAttempts; ++attemptIndex)
 	{
-		U8* startAddress = (U8*)table->elements;
-		U8* endAddress = ((U8*)table->elements) + table->numReservedBytes;
-		if(address >= startAddress && address < endAddress)
+		// If a writer is modifying the array, wait for it to finish.
+		const Uptr sequence = tableRangesSequence.load(std::memory_order_acquire);
+		if(sequence & 1)
 		{
-			outTable = table;
-			outTableIndex = (address - startAddress) / sizeof(Table::Element);
-			return true;
+			Platform::yieldToAnotherThread();
+			continue;
 		}
-	}
+
+		// Binary search for the last range that begins at or before the address. The number of
+		// ranges may have been read after the array was replaced by a larger array, so clamp it to
+		// the capacity of the array.
+		TableRangeArray* array = tableRanges.load(std::memory_order_acquire);
+		Uptr numRanges = numTableRanges.load(std::memory_order_acquire);
+		bool isOwned = false;
+		Table* table = nullptr;
+		U8* begin = nullptr;
+		if(array)
+		{
+			if(numRanges > array->capacity) { numRanges = array->capacity; }
+			const Uptr rangeIndex = lowerBoundTableRange(array, numRanges, address + 1);
+			if(rangeIndex > 0)
+			{
+				const TableRange& range = array->ranges[rangeIndex - 1];
+				begin = range.begin.load(std::memory_order_relaxed);
+				table = range.table.load(std::memory_order_relaxed);
+				isOwned = address >= begin && address < range.end.load(std::memory_order_relaxed);
+			}
+		}
+
+		// If the array wasn't modified while searching it, the result is valid.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(tableRangesSequence.load(std::memory_order_relaxed) == sequence)
+		{
+			if(isOwned)
+			{
+				outTable = table;
+				outTableIndex = (address - begin) / sizeof(Table::Element);
+			}
+			return isOwned;
+		}
+	};
+
+	// If the array was modified by other threads for every attempt, treat the address as not owned
+	// by a table rather than waiting indefinitely.
 	return false;
 }
 
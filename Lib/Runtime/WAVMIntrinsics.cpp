@@ -51,10 +51,11 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsics,
 							   debugEnterFunction,
 							   const Function* function)
 {
+	const std::string debugName = function->mutableData->getDebugName();
 	Log::printf(Log::debug,
 				"ENTER: %*s\n",
-				U32(indentLevel * 4 + function->mutableData->debugName.size()),
-				function->mutableData->debugName.c_str());
+				U32(indentLevel * 4 + debugName.size()),
+				debugName.c_str());
 	++indentLevel;
 }
 
@@ -65,10 +66,11 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsics,
 							   const Function* function)
 {
 	--indentLevel;
+	const std::string debugName = function->mutableData->getDebugName();
 	Log::printf(Log::debug,
 				"EXIT:  %*s\n",
-				U32(indentLevel * 4 + function->mutableData->debugName.size()),
-				function->mutableData->debugName.c_str());
+				U32(indentLevel * 4 + debugName.size()),
+				debugName.c_str());
 }
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(wavmIntrinsics, "debugBreak", void, debugBreak)
@@ -69,10 +69,6 @@ struct ExitThreadException
 static Platform::Mutex threadsMutex;
 static IndexMap<Uptr, IntrusiveSharedPtr<Thread>> threads(1, UINTPTR_MAX);
 
-// A shared pointer to the current thread. This is used to decrement the thread's reference count
-// when the thread exits.
-thread_local IntrusiveSharedPtr<Thread> currentThread = nullptr;
-
 // Adds the thread to the global thread array, assigning it an ID corresponding to its index in the
 // array.
 WAVM_FORCENOINLINE static Uptr allocateThreadId(Thread* thread)
@@ -83,10 +79,20 @@ WAVM_FORCENOINLINE static Uptr allocateThreadId(Thread* thread)
 	return thread->id;
 }
 
-// These functions just provide a way to read/write the currentThread thread-local variable in a
-// way that the compiler can't cache across a call to Platform::forkCurrentThread.
-WAVM_FORCENOINLINE static void setCurrentThread(Thread* thread) { currentThread = thread; }
-WAVM_FORCENOINLINE static Thread* getCurrentThread() { return currentThread; }
+// The current thread is stored in the platform thread's user data, which unlike a thread_local
+// variable, is private to each green thread. The current thread holds a reference to the Thread,
+// which setCurrentThread releases when it is replaced.
+WAVM_FORCENOINLINE static Thread* getCurrentThread()
+{
+	return (Thread*)Platform::getCurrentThreadUserData();
+}
+WAVM_FORCENOINLINE static void setCurrentThread(Thread* thread)
+{
+	Thread* oldThread = getCurrentThread();
+	if(thread) { thread->addRef(); }
+	Platform::setCurrentThreadUserData(thread);
+	if(oldThread) { oldThread->removeRef(); }
+}
 
 // Validates that a thread ID is valid. i.e. 0 < threadId < threads.size(), and threads[threadId] !=
 // null If the thread ID is invalid, throws an invalid argument exception. The caller must have
@@ -142,6 +148,9 @@ static I64 threadEntry(void* threadVoid)
 			}
 		});
 
+	// Release the current thread's reference to the Thread.
+	setCurrentThread(nullptr);
+
 	return 0;
 }
 
@@ -169,8 +178,9 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(threadTest,
 	// threadFunc calls the corresponding removeRef.
 	thread->addRef();
 
-	// Spawn and detach a platform thread that calls threadFunc.
-	thread->platformThread = Platform::createThread(numStackBytes, threadEntry, thread);
+	// Spawn a green thread that calls threadFunc, so a guest can create many more threads than
+	// there are host threads.
+	thread->platformThread = Platform::createGreenThread(numStackBytes, threadEntry, thread);
 
 	return thread->id;
 }
@@ -181,6 +191,7 @@ WAVM_DEFINE_INTRINSIC_FUNCTION_WITH_CONTEXT_SWITCH(threadTest, "forkThread", I64
 	auto compartment = getCompartmentFromContextRuntimeData(contextRuntimeData);
 	auto newContext = cloneContext(oldContext, compartment);
 
+	Thread* currentThread = getCurrentThread();
 	wavmAssert(currentThread);
 	Thread* childThread
 		= new Thread(newContext, currentThread->entryFunction, currentThread->argument);
@@ -201,12 +212,11 @@ WAVM_DEFINE_INTRINSIC_FUNCTION_WITH_CONTEXT_SWITCH(threadTest, "forkThread", I64
 	}
 	else
 	{
-		// Move the childThread pointer into the thread-local currentThread variable. Since some
-		// compilers will cache a pointer to thread-local data that's accessed multiple times in one
-		// function, and currentThread is accessed before calling forkCurrentThread, we can't
-		// directly write to it in this function in case the compiler tries to write to the original
-		// thread's currentThread variable. Instead, call a WAVM_FORCENOINLINE function
-		// (setCurrentThread) to set the variable.
+		// Make childThread the forked thread's current thread. This must be done with a
+		// WAVM_FORCENOINLINE function (setCurrentThread), since some compilers will cache a pointer
+		// to thread-local data that's accessed multiple times in one function, and the forked
+		// thread may be running on a different host thread than the thread that called
+		// forkCurrentThread.
 		setCurrentThread(childThread);
 		childThread->removeRef();
 		childThread = nullptr;
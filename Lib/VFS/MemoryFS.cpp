@@ -0,0 +1,741 @@
+#include "WAVM/VFS/MemoryFS.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "./VFSPrivate.h"
+#include "WAVM/Inline/Assert.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Lock.h"
+#include "WAVM/Platform/Clock.h"
+#include "WAVM/Platform/Mutex.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+// Files are stored as extents: separately allocated ranges of bytes, ordered by their offset in
+// the file. An extent that is appended to a file is twice the size of the extent before it, up to
+// maxExtentBytes, so small files use little memory and large files use few extents. Ranges of a
+// file that aren't in an extent are holes, which read as zeroes.
+static constexpr U64 extentAlignmentBytes = 4096;
+static constexpr U64 maxExtentBytes = 1024 * 1024;
+
+static std::atomic<U64> nextDeviceNumber{1};
+
+// The state shared by a MemoryFS and its files, which may outlive the MemoryFS.
+struct MemoryFSState
+{
+	const U64 deviceNumber;
+	const U64 maxFileBytes;
+	std::atomic<U64> numFileBytes{0};
+	std::atomic<U64> nextFileNumber{1};
+
+	// Protects the entries of every directory in the filesystem. Lock it before any node's mutex.
+	Platform::Mutex namespaceMutex;
+
+	MemoryFSState(U64 inMaxFileBytes)
+	: deviceNumber(nextDeviceNumber++), maxFileBytes(inMaxFileBytes)
+	{
+	}
+
+	bool tryAllocateFileBytes(U64 numBytes)
+	{
+		U64 previousNumFileBytes = numFileBytes.load(std::memory_order_relaxed);
+		do
+		{
+			if(numBytes > maxFileBytes || previousNumFileBytes > maxFileBytes - numBytes)
+			{ return false; }
+		} while(!numFileBytes.compare_exchange_weak(previousNumFileBytes,
+													previousNumFileBytes + numBytes,
+													std::memory_order_relaxed));
+		return true;
+	}
+
+	void freeFileBytes(U64 numBytes)
+	{
+		const U64 previousNumFileBytes
+			= numFileBytes.fetch_sub(numBytes, std::memory_order_relaxed);
+		wavmAssert(previousNumFileBytes >= numBytes);
+	}
+};
+
+struct MemoryNode
+{
+	const std::shared_ptr<MemoryFSState> fsState;
+	const FileType type;
+	const U64 fileNumber;
+
+	// Protects the node's times, and the contents of a file. numLinks is protected by the
+	// filesystem's namespaceMutex, which must be locked before this mutex.
+	Platform::Mutex mutex;
+	I128 lastAccessTime;
+	I128 lastWriteTime;
+	I128 creationTime;
+	U32 numLinks = 1;
+
+	MemoryNode(const std::shared_ptr<MemoryFSState>& inFSState, FileType inType)
+	: fsState(inFSState), type(inType), fileNumber(inFSState->nextFileNumber++)
+	{
+		creationTime = lastWriteTime = lastAccessTime = Platform::getRealtimeClock();
+	}
+	virtual ~MemoryNode() {}
+
+	virtual U64 getNumBytes() = 0;
+
+	void getFileInfo(FileInfo& outInfo)
+	{
+		Lock<Platform::Mutex> nodeLock(mutex);
+		outInfo.deviceNumber = fsState->deviceNumber;
+		outInfo.fileNumber = fileNumber;
+		outInfo.type = type;
+		outInfo.numLinks = numLinks;
+		outInfo.numBytes = getNumBytes();
+		outInfo.lastAccessTime = lastAccessTime;
+		outInfo.lastWriteTime = lastWriteTime;
+		outInfo.creationTime = creationTime;
+	}
+
+	void setFileTimes(bool setLastAccessTime,
+					  I128 newLastAccessTime,
+					  bool setLastWriteTime,
+					  I128 newLastWriteTime)
+	{
+		Lock<Platform::Mutex> nodeLock(mutex);
+		if(setLastAccessTime) { lastAccessTime = newLastAccessTime; }
+		if(setLastWriteTime) { lastWriteTime = newLastWriteTime; }
+	}
+};
+
+struct MemoryFile : MemoryNode
+{
+	struct Extent
+	{
+		std::unique_ptr<U8[]> data;
+		U64 numBytes;
+	};
+
+	// The file's extents, keyed by their offset in the file. The extents don't overlap, and the
+	// bytes of an extent beyond the end of the file are always zero.
+	std::map<U64, Extent> extents;
+	U64 numBytes = 0;
+
+	MemoryFile(const std::shared_ptr<MemoryFSState>& inFSState)
+	: MemoryNode(inFSState, FileType::file)
+	{
+	}
+
+	~MemoryFile()
+	{
+		for(const auto& offsetExtentPair : extents)
+		{ fsState->freeFileBytes(offsetExtentPair.second.numBytes); }
+	}
+
+	virtual U64 getNumBytes() override { return numBytes; }
+
+	// Calls visitRange(data, numRangeBytes) for each range of bytes in [offset, offset+numBytes),
+	// in order. data is null for ranges that are in a hole.
+	template<typename VisitRange>
+	void visitRanges(U64 offset, U64 numVisitBytes, VisitRange&& visitRange)
+	{
+		auto extentIt = extents.upper_bound(offset);
+		if(extentIt != extents.begin())
+		{
+			auto previousExtentIt = std::prev(extentIt);
+			if(offset < previousExtentIt->first + previousExtentIt->second.numBytes)
+			{ extentIt = previousExtentIt; }
+		}
+
+		while(numVisitBytes)
+		{
+			U64 numRangeBytes;
+			if(extentIt != extents.end() && extentIt->first <= offset)
+			{
+				const U64 extentOffset = offset - extentIt->first;
+				numRangeBytes = std::min(numVisitBytes, extentIt->second.numBytes - extentOffset);
+				visitRange(extentIt->second.data.get() + extentOffset, numRangeBytes);
+				++extentIt;
+			}
+			else
+			{
+				numRangeBytes = numVisitBytes;
+				if(extentIt != extents.end())
+				{ numRangeBytes = std::min(numRangeBytes, extentIt->first - offset); }
+				visitRange(nullptr, numRangeBytes);
+			}
+			offset += numRangeBytes;
+			numVisitBytes -= numRangeBytes;
+		};
+	}
+
+	// Allocates extents to fill any holes in [offset, offset+numAllocBytes). If the quota is
+	// exhausted, frees the extents it allocated, so a failed write doesn't use any of the quota.
+	Result allocateExtents(U64 offset, U64 numAllocBytes)
+	{
+		std::vector<U64> newExtentOffsets;
+		auto extentIt = extents.upper_bound(offset);
+		if(extentIt != extents.begin())
+		{
+			auto previousExtentIt = std::prev(extentIt);
+			if(offset < previousExtentIt->first + previousExtentIt->second.numBytes)
+			{ extentIt = previousExtentIt; }
+		}
+
+		const U64 endOffset = offset + numAllocBytes;
+		while(offset < endOffset)
+		{
+			if(extentIt != extents.end() && extentIt->first <= offset)
+			{
+				offset = extentIt->first + extentIt->second.numBytes;
+				++extentIt;
+				continue;
+			}
+
+			// Allocate an extent for the hole, at least doubling the size of the preceding
+			// extent if the hole starts at its end.
+			U64 numExtentBytes = endOffset - offset;
+			if(extentIt != extents.begin())
+			{
+				const auto& previousExtent = *std::prev(extentIt);
+				if(previousExtent.first + previousExtent.second.numBytes == offset)
+				{
+					numExtentBytes
+						= std::max(numExtentBytes,
+								   std::min(maxExtentBytes, previousExtent.second.numBytes * 2));
+				}
+			}
+			numExtentBytes
+				= (numExtentBytes + extentAlignmentBytes - 1) & ~(extentAlignmentBytes - 1);
+			if(extentIt != extents.end())
+			{ numExtentBytes = std::min(numExtentBytes, extentIt->first - offset); }
+
+			if(!fsState->tryAllocateFileBytes(numExtentBytes))
+			{
+				for(U64 newExtentOffset : newExtentOffsets)
+				{
+					auto newExtentIt = extents.find(newExtentOffset);
+					fsState->freeFileBytes(newExtentIt->second.numBytes);
+					extents.erase(newExtentIt);
+				}
+				return Result::outOfQuota;
+			}
+			extents.emplace_hint(
+				extentIt,
+				offset,
+				Extent{std::unique_ptr<U8[]>(new U8[numExtentBytes]()), numExtentBytes});
+			newExtentOffsets.push_back(offset);
+			offset += numExtentBytes;
+		};
+
+		return Result::success;
+	}
+
+	void setNumBytes(U64 newNumBytes)
+	{
+		if(newNumBytes < numBytes)
+		{
+			// Free the extents beyond the new end of the file, and zero the part of the last
+			// extent beyond the new end of the file, in case the file is extended again.
+			auto extentIt = extents.lower_bound(newNumBytes);
+			while(extentIt != extents.end())
+			{
+				fsState->freeFileBytes(extentIt->second.numBytes);
+				extentIt = extents.erase(extentIt);
+			};
+			visitRanges(newNumBytes, numBytes - newNumBytes, [](U8* data, U64 numRangeBytes) {
+				if(data) { memset(data, 0, numRangeBytes); }
+			});
+		}
+		numBytes = newNumBytes;
+	}
+};
+
+struct MemoryDir : MemoryNode
+{
+	// The directory's entries and parent are protected by the filesystem's namespaceMutex. The
+	// parent is null once the directory is removed, and the root directory is its own parent.
+	std::map<std::string, std::shared_ptr<MemoryNode>> entries;
+	MemoryDir* parent = nullptr;
+
+	MemoryDir(const std::shared_ptr<MemoryFSState>& inFSState)
+	: MemoryNode(inFSState, FileType::directory)
+	{
+	}
+
+	virtual U64 getNumBytes() override { return 0; }
+};
+
+// Lists a directory's entries. Assumes the filesystem's namespaceMutex is locked.
+static DirEntStream* openMemoryDir(MemoryDir* dir)
+{
+	std::vector<DirEnt> dirEnts;
+	dirEnts.push_back({dir->fileNumber, ".", FileType::directory});
+	if(dir->parent) { dirEnts.push_back({dir->parent->fileNumber, "..", FileType::directory}); }
+	for(const auto& nameNodePair : dir->entries)
+	{
+		dirEnts.push_back(
+			{nameNodePair.second->fileNumber, nameNodePair.first, nameNodePair.second->type});
+	}
+	return new SnapshotDirEntStream(std::move(dirEnts));
+}
+
+struct MemoryVFD : VFD
+{
+	MemoryVFD(std::shared_ptr<MemoryNode>&& inNode,
+			  FileAccessMode inAccessMode,
+			  const VFDFlags& inFlags)
+	: node(std::move(inNode)), accessMode(inAccessMode), flags(inFlags)
+	{
+	}
+
+	virtual Result close() override
+	{
+		delete this;
+		return Result::success;
+	}
+
+	virtual Result seek(I64 offset, SeekOrigin origin, U64* outAbsoluteOffset = nullptr) override
+	{
+		Lock<Platform::Mutex> nodeLock(node->mutex);
+
+		I64 baseOffset = 0;
+		switch(origin)
+		{
+		case SeekOrigin::begin: baseOffset = 0; break;
+		case SeekOrigin::cur: baseOffset = I64(currentOffset); break;
+		case SeekOrigin::end: baseOffset = I64(node->getNumBytes()); break;
+		default: WAVM_UNREACHABLE();
+		};
+
+		if((offset > 0 && baseOffset > INT64_MAX - offset) || baseOffset + offset < 0)
+		{ return Result::invalidOffset; }
+		currentOffset = U64(baseOffset + offset);
+
+		if(outAbsoluteOffset) { *outAbsoluteOffset = currentOffset; }
+		return Result::success;
+	}
+
+	virtual Result readv(const IOReadBuffer* buffers,
+						 Uptr numBuffers,
+						 Uptr* outNumBytesRead = nullptr,
+						 const U64* offset = nullptr) override
+	{
+		if(node->type == FileType::directory) { return Result::isDirectory; }
+		if(accessMode == FileAccessMode::writeOnly) { return Result::notPermitted; }
+		MemoryFile* file = static_cast<MemoryFile*>(node.get());
+
+		Lock<Platform::Mutex> nodeLock(file->mutex);
+		U64 readOffset = offset ? *offset : currentOffset;
+
+		// Copy directly from the file's extents to the buffers.
+		Uptr numBytesRead = 0;
+		for(Uptr bufferIndex = 0; bufferIndex < numBuffers && readOffset < file->numBytes;
+			++bufferIndex)
+		{
+			U8* bufferBytes = (U8*)buffers[bufferIndex].data;
+			const U64 numBufferBytes
+				= std::min(U64(buffers[bufferIndex].numBytes), file->numBytes - readOffset);
+			file->visitRanges(
+				readOffset, numBufferBytes, [&bufferBytes](U8* data, U64 numRangeBytes) {
+					if(data) { memcpy(bufferBytes, data, numRangeBytes); }
+					else
+					{
+						memset(bufferBytes, 0, numRangeBytes);
+					}
+					bufferBytes += numRangeBytes;
+				});
+			readOffset += numBufferBytes;
+			numBytesRead += Uptr(numBufferBytes);
+		}
+
+		if(!offset) { currentOffset = readOffset; }
+		file->lastAccessTime = Platform::getRealtimeClock();
+
+		if(outNumBytesRead) { *outNumBytesRead = numBytesRead; }
+		return Result::success;
+	}
+
+	virtual Result writev(const IOWriteBuffer* buffers,
+						  Uptr numBuffers,
+						  Uptr* outNumBytesWritten = nullptr,
+						  const U64* offset = nullptr) override
+	{
+		if(node->type == FileType::directory) { return Result::isDirectory; }
+		if(accessMode != FileAccessMode::writeOnly && accessMode != FileAccessMode::readWrite)
+		{ return Result::notPermitted; }
+		MemoryFile* file = static_cast<MemoryFile*>(node.get());
+
+		Lock<Platform::Mutex> nodeLock(file->mutex);
+		U64 writeOffset = offset ? *offset : flags.append ? file->numBytes : currentOffset;
+
+		// Allocate extents for each buffer, and copy the buffer directly to them. If the quota
+		// is exhausted, return the number of bytes written before that.
+		Result result = Result::success;
+		Uptr numBytesWritten = 0;
+		for(Uptr bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+		{
+			const U8* bufferBytes = (const U8*)buffers[bufferIndex].data;
+			const U64 numBufferBytes = buffers[bufferIndex].numBytes;
+			if(writeOffset + numBufferBytes < writeOffset)
+			{
+				result = Result::exceededFileSizeLimit;
+				break;
+			}
+
+			result = file->allocateExtents(writeOffset, numBufferBytes);
+			if(result != Result::success) { break; }
+
+			file->visitRanges(
+				writeOffset, numBufferBytes, [&bufferBytes](U8* data, U64 numRangeBytes) {
+					// allocateExtents filled any holes in the range, so data is never null here.
+					wavmAssert(data);
+					if(data) { memcpy(data, bufferBytes, numRangeBytes); }
+					bufferBytes += numRangeBytes;
+				});
+			writeOffset += numBufferBytes;
+			numBytesWritten += Uptr(numBufferBytes);
+			file->numBytes = std::max(file->numBytes, writeOffset);
+		}
+
+		if(numBytesWritten)
+		{
+			if(!offset) { currentOffset = writeOffset; }
+			file->lastWriteTime = Platform::getRealtimeClock();
+			result = Result::success;
+		}
+
+		if(outNumBytesWritten) { *outNumBytesWritten = numBytesWritten; }
+		return result;
+	}
+
+	virtual Result sync(SyncType type) override { return Result::success; }
+
+	virtual Result getVFDInfo(VFDInfo& outInfo) override
+	{
+		Lock<Platform::Mutex> nodeLock(node->mutex);
+		outInfo.type = node->type;
+		outInfo.flags = flags;
+		return Result::success;
+	}
+
+	virtual Result getFileInfo(FileInfo& outInfo) override
+	{
+		Lock<Platform::Mutex> namespaceLock(node->fsState->namespaceMutex);
+		node->getFileInfo(outInfo);
+		return Result::success;
+	}
+
+	virtual Result setVFDFlags(const VFDFlags& newFlags) override
+	{
+		Lock<Platform::Mutex> nodeLock(node->mutex);
+		flags = newFlags;
+		return Result::success;
+	}
+
+	virtual Result setFileSize(U64 numBytes) override
+	{
+		if(node->type == FileType::directory) { return Result::isDirectory; }
+		if(accessMode != FileAccessMode::writeOnly && accessMode != FileAccessMode::readWrite)
+		{ return Result::notPermitted; }
+		MemoryFile* file = static_cast<MemoryFile*>(node.get());
+
+		Lock<Platform::Mutex> nodeLock(file->mutex);
+		file->setNumBytes(numBytes);
+		file->lastWriteTime = Platform::getRealtimeClock();
+		return Result::success;
+	}
+
+	virtual Result setFileTimes(bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override
+	{
+		node->setFileTimes(setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime);
+		return Result::success;
+	}
+
+	virtual Result openDir(DirEntStream*& outStream) override
+	{
+		if(node->type != FileType::directory) { return Result::isNotDirectory; }
+
+		Lock<Platform::Mutex> namespaceLock(node->fsState->namespaceMutex);
+		outStream = openMemoryDir(static_cast<MemoryDir*>(node.get()));
+		return Result::success;
+	}
+
+private:
+	const std::shared_ptr<MemoryNode> node;
+	const FileAccessMode accessMode;
+
+	// Protected by the node's mutex.
+	VFDFlags flags;
+	U64 currentOffset = 0;
+};
+
+struct MemoryFS : FileSystem
+{
+	MemoryFS(U64 maxFileBytes)
+	: fsState(std::make_shared<MemoryFSState>(maxFileBytes))
+	, rootDir(std::make_shared<MemoryDir>(fsState))
+	{
+		rootDir->parent = rootDir.get();
+	}
+
+	~MemoryFS()
+	{
+		// Detach all the directories from their parents, in case VFDs for them are still open.
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+		removeAllEntries(rootDir.get());
+	}
+
+	virtual Result open(const std::string& path,
+						FileAccessMode accessMode,
+						FileCreateMode createMode,
+						VFD*& outFD,
+						const VFDFlags& flags = VFDFlags{}) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+
+		std::shared_ptr<MemoryNode> node = lookup.node;
+		if(!node)
+		{
+			switch(createMode)
+			{
+			case FileCreateMode::createAlways:
+			case FileCreateMode::createNew:
+			case FileCreateMode::openAlways: break;
+			case FileCreateMode::openExisting:
+			case FileCreateMode::truncateExisting: return Result::doesNotExist;
+			default: WAVM_UNREACHABLE();
+			};
+
+			node = std::make_shared<MemoryFile>(fsState);
+			lookup.parentDir->entries.emplace(lookup.leafName, node);
+			touchDir(lookup.parentDir);
+		}
+		else
+		{
+			if(createMode == FileCreateMode::createNew) { return Result::alreadyExists; }
+
+			const bool truncate = createMode == FileCreateMode::createAlways
+								  || createMode == FileCreateMode::truncateExisting;
+			if(node->type == FileType::directory)
+			{
+				if(truncate || accessMode == FileAccessMode::writeOnly
+				   || accessMode == FileAccessMode::readWrite)
+				{ return Result::isDirectory; }
+			}
+			else if(truncate)
+			{
+				MemoryFile* file = static_cast<MemoryFile*>(node.get());
+				Lock<Platform::Mutex> nodeLock(file->mutex);
+				file->setNumBytes(0);
+				file->lastWriteTime = Platform::getRealtimeClock();
+			}
+		}
+
+		outFD = new MemoryVFD(std::move(node), accessMode, flags);
+		return Result::success;
+	}
+
+	virtual Result getFileInfo(const std::string& path, FileInfo& outInfo) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(!lookup.node) { return Result::doesNotExist; }
+
+		lookup.node->getFileInfo(outInfo);
+		return Result::success;
+	}
+
+	virtual Result setFileTimes(const std::string& path,
+								bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(!lookup.node) { return Result::doesNotExist; }
+
+		lookup.node->setFileTimes(
+			setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime);
+		return Result::success;
+	}
+
+	virtual Result openDir(const std::string& path, DirEntStream*& outStream) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(!lookup.node) { return Result::doesNotExist; }
+		if(lookup.node->type != FileType::directory) { return Result::isNotDirectory; }
+
+		outStream = openMemoryDir(static_cast<MemoryDir*>(lookup.node.get()));
+		return Result::success;
+	}
+
+	virtual Result unlinkFile(const std::string& path) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(!lookup.node) { return Result::doesNotExist; }
+		if(lookup.node->type == FileType::directory) { return Result::isDirectory; }
+
+		// The file's contents are freed when the last VFD for it is closed.
+		lookup.node->numLinks = 0;
+		lookup.parentDir->entries.erase(lookup.leafName);
+		touchDir(lookup.parentDir);
+		return Result::success;
+	}
+
+	virtual Result removeDir(const std::string& path) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(!lookup.node) { return Result::doesNotExist; }
+		if(lookup.node->type != FileType::directory) { return Result::isNotDirectory; }
+		if(lookup.node == rootDir || !lookup.parentDir) { return Result::busy; }
+
+		MemoryDir* dir = static_cast<MemoryDir*>(lookup.node.get());
+		if(dir->entries.size()) { return Result::isNotEmpty; }
+
+		dir->parent = nullptr;
+		dir->numLinks = 0;
+		lookup.parentDir->entries.erase(lookup.leafName);
+		touchDir(lookup.parentDir);
+		return Result::success;
+	}
+
+	virtual Result createDir(const std::string& path) override
+	{
+		Lock<Platform::Mutex> namespaceLock(fsState->namespaceMutex);
+
+		PathLookup lookup;
+		Result result = lookupPath(path, lookup);
+		if(result != Result::success) { return result; }
+		if(lookup.node) { return Result::alreadyExists; }
+
+		std::shared_ptr<MemoryDir> dir = std::make_shared<MemoryDir>(fsState);
+		dir->parent = lookup.parentDir;
+		lookup.parentDir->entries.emplace(lookup.leafName, std::move(dir));
+		touchDir(lookup.parentDir);
+		return Result::success;
+	}
+
+private:
+	const std::shared_ptr<MemoryFSState> fsState;
+	const std::shared_ptr<MemoryDir> rootDir;
+
+	struct PathLookup
+	{
+		// The node the path refers to, or null if the last component of the path doesn't exist.
+		std::shared_ptr<MemoryNode> node;
+
+		// The directory containing the last component of the path, and the component's name. If
+		// the path refers to a directory through "." or "..", parentDir is null.
+		MemoryDir* parentDir = nullptr;
+		std::string leafName;
+	};
+
+	// Looks up a path. Assumes the filesystem's namespaceMutex is locked.
+	Result lookupPath(const std::string& path, PathLookup& outLookup)
+	{
+		std::shared_ptr<MemoryNode> node = rootDir;
+		Uptr componentBegin = 0;
+		while(true)
+		{
+			while(componentBegin < path.size() && path[componentBegin] == '/')
+			{ ++componentBegin; };
+			if(componentBegin == path.size()) { break; }
+
+			Uptr componentEnd = path.find('/', componentBegin);
+			if(componentEnd == std::string::npos) { componentEnd = path.size(); }
+
+			// Only directories may have another component after them.
+			if(!node) { return Result::doesNotExist; }
+			if(node->type != FileType::directory) { return Result::isNotDirectory; }
+			MemoryDir* dir = static_cast<MemoryDir*>(node.get());
+
+			const Uptr numComponentChars = componentEnd - componentBegin;
+			outLookup.parentDir = nullptr;
+			if(!path.compare(componentBegin, numComponentChars, ".")) {}
+			else if(!path.compare(componentBegin, numComponentChars, ".."))
+			{
+				if(!dir->parent) { return Result::doesNotExist; }
+				node = dir->parent == rootDir.get() ? rootDir : findDirInParent(dir->parent);
+			}
+			else
+			{
+				outLookup.parentDir = dir;
+				outLookup.leafName.assign(path, componentBegin, numComponentChars);
+				auto entryIt = dir->entries.find(outLookup.leafName);
+				node = entryIt == dir->entries.end() ? nullptr : entryIt->second;
+			}
+
+			componentBegin = componentEnd;
+		};
+
+		if(!node && !outLookup.parentDir->parent) { return Result::doesNotExist; }
+
+		outLookup.node = std::move(node);
+		return Result::success;
+	}
+
+	// Finds the shared_ptr for a directory in its parent's entries. Assumes the filesystem's
+	// namespaceMutex is locked.
+	static std::shared_ptr<MemoryNode> findDirInParent(MemoryDir* dir)
+	{
+		for(const auto& nameNodePair : dir->parent->entries)
+		{
+			if(nameNodePair.second.get() == dir) { return nameNodePair.second; }
+		}
+		WAVM_UNREACHABLE();
+	}
+
+	static void touchDir(MemoryDir* dir)
+	{
+		Lock<Platform::Mutex> nodeLock(dir->mutex);
+		dir->lastWriteTime = Platform::getRealtimeClock();
+	}
+
+	static void removeAllEntries(MemoryDir* dir)
+	{
+		for(const auto& nameNodePair : dir->entries)
+		{
+			nameNodePair.second->numLinks = 0;
+			if(nameNodePair.second->type == FileType::directory)
+			{
+				MemoryDir* childDir = static_cast<MemoryDir*>(nameNodePair.second.get());
+				removeAllEntries(childDir);
+				childDir->parent = nullptr;
+			}
+		}
+		dir->entries.clear();
+	}
+};
+
+FileSystem* VFS::makeMemoryFS(U64 maxFileBytes) { return new MemoryFS(maxFileBytes); }
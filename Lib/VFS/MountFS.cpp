@@ -0,0 +1,108 @@
+#include "WAVM/VFS/MountFS.h"
+#include <string>
+#include "WAVM/Inline/I128.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+struct MountFS : FileSystem
+{
+	MountFS(FileSystem* inRootFS, const std::string& inMountPath, FileSystem* inMountedFS)
+	: rootFS(inRootFS), mountedFS(inMountedFS), mountPath(inMountPath)
+	{
+		while(mountPath.size() && mountPath.back() == '/') { mountPath.pop_back(); }
+		if(mountPath.empty() || mountPath.front() != '/') { mountPath.insert(0, 1, '/'); }
+	}
+
+	virtual Result open(const std::string& path,
+						FileAccessMode accessMode,
+						FileCreateMode createMode,
+						VFD*& outFD,
+						const VFDFlags& flags) override
+	{
+		if(!isMounted(path)) { return rootFS->open(path, accessMode, createMode, outFD, flags); }
+		return mountedFS->open(getMountedPath(path), accessMode, createMode, outFD, flags);
+	}
+
+	virtual Result getFileInfo(const std::string& path, FileInfo& outInfo) override
+	{
+		if(!isMounted(path)) { return rootFS->getFileInfo(path, outInfo); }
+		return mountedFS->getFileInfo(getMountedPath(path), outInfo);
+	}
+	virtual Result setFileTimes(const std::string& path,
+								bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override
+	{
+		if(!isMounted(path))
+		{
+			return rootFS->setFileTimes(
+				path, setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime);
+		}
+		return mountedFS->setFileTimes(getMountedPath(path),
+									   setLastAccessTime,
+									   lastAccessTime,
+									   setLastWriteTime,
+									   lastWriteTime);
+	}
+
+	virtual Result openDir(const std::string& path, DirEntStream*& outStream) override
+	{
+		if(!isMounted(path)) { return rootFS->openDir(path, outStream); }
+		return mountedFS->openDir(getMountedPath(path), outStream);
+	}
+
+	virtual Result unlinkFile(const std::string& path) override
+	{
+		if(!isMounted(path)) { return rootFS->unlinkFile(path); }
+		return mountedFS->unlinkFile(getMountedPath(path));
+	}
+
+	virtual Result removeDir(const std::string& path) override
+	{
+		if(!isMounted(path)) { return rootFS->removeDir(path); }
+
+		// The mount point itself can't be removed.
+		if(getMountedPath(path) == "/") { return Result::busy; }
+		return mountedFS->removeDir(getMountedPath(path));
+	}
+
+	virtual Result createDir(const std::string& path) override
+	{
+		if(!isMounted(path)) { return rootFS->createDir(path); }
+		return mountedFS->createDir(getMountedPath(path));
+	}
+
+private:
+	FileSystem* rootFS;
+	FileSystem* mountedFS;
+
+	// The mount path has a leading '/', and no trailing '/' unless it is the root "/".
+	std::string mountPath;
+
+	bool isRootMount() const { return mountPath.size() == 1; }
+
+	// Returns true if the path is the mount path, or beneath it. Paths are expected to be
+	// canonical, as they are when they come from WASI.
+	bool isMounted(const std::string& path) const
+	{
+		if(isRootMount()) { return true; }
+		return !path.compare(0, mountPath.size(), mountPath)
+			   && (path.size() == mountPath.size() || path[mountPath.size()] == '/');
+	}
+
+	std::string getMountedPath(const std::string& path) const
+	{
+		if(isRootMount()) { return path; }
+		return path.size() == mountPath.size() ? std::string("/") : path.substr(mountPath.size());
+	}
+};
+
+FileSystem* VFS::makeMountFS(FileSystem* rootFS,
+							 const std::string& mountPath,
+							 FileSystem* mountedFS)
+{
+	return new MountFS(rootFS, mountPath, mountedFS);
+}
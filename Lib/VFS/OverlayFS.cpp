@@ -0,0 +1,522 @@
+#include "WAVM/VFS/OverlayFS.h"
+#include <list>
+#include <string>
+#include <vector>
+#include "./VFSPrivate.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/HashMap.h"
+#include "WAVM/Inline/HashSet.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Lock.h"
+#include "WAVM/Platform/Mutex.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+enum
+{
+	copyUpBufferBytes = 65536,
+	maxCachedLowerLookups = 4096
+};
+
+struct OverlayFS;
+
+// A VFD for a directory in the overlay, or for a file in the lower layer that was opened to be
+// read. Reads go to the layer that the file or directory was opened from, but it can't be written,
+// and metadata writes go through the overlay, which copies the file or directory up first, so the
+// lower layer is never modified.
+struct OverlayVFD : VFD
+{
+	OverlayVFD(OverlayFS* inFS, VFD* inInnerVFD, std::string&& inPath, FileType inType)
+	: fs(inFS), innerVFD(inInnerVFD), path(std::move(inPath)), type(inType)
+	{
+	}
+
+	virtual Result close() override
+	{
+		Result result = innerVFD->close();
+		if(result == Result::success) { delete this; }
+		return result;
+	}
+
+	virtual Result seek(I64 offset, SeekOrigin origin, U64* outAbsoluteOffset = nullptr) override
+	{
+		return innerVFD->seek(offset, origin, outAbsoluteOffset);
+	}
+	virtual Result readv(const IOReadBuffer* buffers,
+						 Uptr numBuffers,
+						 Uptr* outNumBytesRead = nullptr,
+						 const U64* offset = nullptr) override
+	{
+		return innerVFD->readv(buffers, numBuffers, outNumBytesRead, offset);
+	}
+	virtual Result writev(const IOWriteBuffer* buffers,
+						  Uptr numBuffers,
+						  Uptr* outNumBytesWritten = nullptr,
+						  const U64* offset = nullptr) override
+	{
+		return type == FileType::directory ? Result::isDirectory : Result::notPermitted;
+	}
+	virtual Result sync(SyncType syncType) override { return innerVFD->sync(syncType); }
+	virtual Result getVFDInfo(VFDInfo& outInfo) override { return innerVFD->getVFDInfo(outInfo); }
+	virtual Result getFileInfo(FileInfo& outInfo) override;
+	virtual Result setVFDFlags(const VFDFlags& flags) override
+	{
+		return innerVFD->setVFDFlags(flags);
+	}
+	virtual Result setFileSize(U64 numBytes) override
+	{
+		return type == FileType::directory ? Result::isDirectory : Result::notPermitted;
+	}
+	virtual Result setFileTimes(bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override;
+	virtual Result openDir(DirEntStream*& outStream) override;
+	virtual I32 getPollableHostFD() override { return innerVFD->getPollableHostFD(); }
+	virtual I32 getMappableHostFD() override { return innerVFD->getMappableHostFD(); }
+
+private:
+	OverlayFS* fs;
+	VFD* innerVFD;
+	std::string path;
+	FileType type;
+
+	// Whether setFileTimes copied the file or directory up, so innerVFD may no longer be the file
+	// or directory that is in the overlay.
+	bool isCopiedUp = false;
+};
+
+struct OverlayFS : FileSystem
+{
+	OverlayFS(FileSystem* inLowerFS, FileSystem* inUpperFS)
+	: lowerFS(inLowerFS), upperFS(inUpperFS)
+	{
+	}
+
+	virtual Result open(const std::string& inPath,
+						FileAccessMode accessMode,
+						FileCreateMode createMode,
+						VFD*& outFD,
+						const VFDFlags& flags) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		std::string path = normalizePath(inPath);
+
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result == Result::doesNotExist)
+		{
+			if(createMode == FileCreateMode::openExisting
+			   || createMode == FileCreateMode::truncateExisting)
+			{ return Result::doesNotExist; }
+
+			// Create the file in the upper layer, copying its parent directories up if necessary.
+			result = copyUpDir(getParentPath(path));
+			if(result != Result::success) { return result; }
+			result = upperFS->open(path, accessMode, createMode, outFD, flags);
+			if(result == Result::success) { unhideRecreatedLowerPath(path); }
+			return result;
+		}
+		else if(result != Result::success)
+		{
+			return result;
+		}
+
+		if(createMode == FileCreateMode::createNew) { return Result::alreadyExists; }
+		const bool isWrite = accessMode == FileAccessMode::writeOnly
+							 || accessMode == FileAccessMode::readWrite
+							 || createMode == FileCreateMode::createAlways
+							 || createMode == FileCreateMode::truncateExisting;
+		if(info.type == FileType::directory)
+		{
+			if(isWrite) { return Result::isDirectory; }
+
+			VFD* innerVFD = nullptr;
+			result = (isUpper ? upperFS : lowerFS)
+						 ->open(path, accessMode, FileCreateMode::openExisting, innerVFD, flags);
+			if(result != Result::success) { return result; }
+			outFD = new OverlayVFD(this, innerVFD, std::move(path), FileType::directory);
+			return Result::success;
+		}
+
+		// Files that are only read are read directly from the lower layer, so all the overlays
+		// that share it share its cached file data.
+		if(!isUpper)
+		{
+			if(!isWrite)
+			{
+				VFD* innerVFD = nullptr;
+				result = lowerFS->open(
+					path, accessMode, FileCreateMode::openExisting, innerVFD, flags);
+				if(result != Result::success) { return result; }
+				outFD = new OverlayVFD(this, innerVFD, std::move(path), info.type);
+				return Result::success;
+			}
+
+			result = copyUpFile(path, info);
+			if(result != Result::success) { return result; }
+		}
+		return upperFS->open(path, accessMode, createMode, outFD, flags);
+	}
+
+	virtual Result getFileInfo(const std::string& inPath, FileInfo& outInfo) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		bool isUpper = false;
+		return lookup(normalizePath(inPath), outInfo, isUpper);
+	}
+
+	virtual Result setFileTimes(const std::string& inPath,
+								bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		const std::string path = normalizePath(inPath);
+
+		Result result = copyUp(path);
+		if(result != Result::success) { return result; }
+		return upperFS->setFileTimes(
+			path, setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime);
+	}
+
+	virtual Result openDir(const std::string& inPath, DirEntStream*& outStream) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		const std::string path = normalizePath(inPath);
+
+		std::vector<DirEnt> dirEnts;
+		Result result = listDir(path, dirEnts);
+		if(result != Result::success) { return result; }
+		outStream = new SnapshotDirEntStream(std::move(dirEnts));
+		return Result::success;
+	}
+
+	virtual Result unlinkFile(const std::string& inPath) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		const std::string path = normalizePath(inPath);
+
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result != Result::success) { return result; }
+		if(info.type == FileType::directory) { return Result::isDirectory; }
+
+		if(isUpper)
+		{
+			result = upperFS->unlinkFile(path);
+			if(result != Result::success) { return result; }
+		}
+		hideLowerPath(path);
+		return Result::success;
+	}
+
+	virtual Result removeDir(const std::string& inPath) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		const std::string path = normalizePath(inPath);
+		if(path.empty()) { return Result::busy; }
+
+		std::vector<DirEnt> dirEnts;
+		Result result = listDir(path, dirEnts);
+		if(result != Result::success) { return result; }
+		for(const DirEnt& dirEnt : dirEnts)
+		{
+			if(dirEnt.name != "." && dirEnt.name != "..") { return Result::isNotEmpty; }
+		}
+
+		FileInfo upperInfo;
+		if(upperFS->getFileInfo(path, upperInfo) == Result::success)
+		{
+			result = upperFS->removeDir(path);
+			if(result != Result::success) { return result; }
+		}
+		hideLowerPath(path);
+		return Result::success;
+	}
+
+	virtual Result createDir(const std::string& inPath) override
+	{
+		Lock<Platform::Mutex> lock(mutex);
+		const std::string path = normalizePath(inPath);
+
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result == Result::success) { return Result::alreadyExists; }
+		else if(result != Result::doesNotExist)
+		{
+			return result;
+		}
+
+		result = copyUpDir(getParentPath(path));
+		if(result != Result::success) { return result; }
+		result = upperFS->createDir(path);
+		if(result == Result::success) { unhideRecreatedLowerPath(path); }
+		return result;
+	}
+
+private:
+	struct CachedLowerLookup
+	{
+		std::string path;
+		FileInfo info;
+	};
+
+	FileSystem* lowerFS;
+	FileSystem* upperFS;
+
+	// Protects the overlay's state, and serializes changes to the upper layer that depend on its
+	// current state, like copying a file up.
+	Platform::Mutex mutex;
+
+	// Paths that were removed from the overlay while they were in the lower layer. Everything
+	// beneath them is hidden too, so a directory that is removed and created again is empty. Only
+	// paths that are in the lower layer are added, so this can't grow larger than the lower layer.
+	HashSet<std::string> hiddenLowerPaths;
+
+	// The lower layer is read-only, so the results of looking up paths in it never change. Only
+	// the maxCachedLowerLookups most recently used paths that were found are cached: the paths
+	// are chosen by the guest, so caching every path, or paths that weren't found, would let it
+	// use unbounded memory. lowerLookupLRU is ordered from most to least recently used.
+	std::list<CachedLowerLookup> lowerLookupLRU;
+	HashMap<std::string, std::list<CachedLowerLookup>::iterator> lowerLookupCache;
+
+	static std::string normalizePath(const std::string& path)
+	{
+		Uptr numChars = path.size();
+		while(numChars && path[numChars - 1] == '/') { --numChars; };
+		return path.substr(0, numChars);
+	}
+
+	static std::string getParentPath(const std::string& path)
+	{
+		const Uptr separatorIndex = path.rfind('/');
+		return separatorIndex == std::string::npos ? std::string() : path.substr(0, separatorIndex);
+	}
+
+	bool isLowerPathHidden(const std::string& path) const
+	{
+		if(!hiddenLowerPaths.size()) { return false; }
+
+		Uptr separatorIndex = 0;
+		do
+		{
+			separatorIndex = path.find('/', separatorIndex + 1);
+			if(hiddenLowerPaths.contains(path.substr(0, separatorIndex))) { return true; }
+		} while(separatorIndex != std::string::npos);
+		return false;
+	}
+
+	void hideLowerPath(const std::string& path)
+	{
+		FileInfo lowerInfo;
+		if(lookupLower(path, lowerInfo) == Result::success) { hiddenLowerPaths.add(path); }
+	}
+
+	// Called when a hidden path is created in the upper layer. If the path is a file in the lower
+	// layer, the upper layer's file or directory shadows it, so it no longer needs to be hidden. A
+	// lower layer directory stays hidden, so the files beneath it stay hidden.
+	void unhideRecreatedLowerPath(const std::string& path)
+	{
+		if(!hiddenLowerPaths.contains(path)) { return; }
+
+		FileInfo lowerInfo;
+		if(lowerFS->getFileInfo(path, lowerInfo) != Result::success
+		   || lowerInfo.type != FileType::directory)
+		{ hiddenLowerPaths.removeOrFail(path); }
+	}
+
+	Result lookupLower(const std::string& path, FileInfo& outInfo)
+	{
+		if(isLowerPathHidden(path)) { return Result::doesNotExist; }
+
+		std::list<CachedLowerLookup>::iterator* cachedLookup = lowerLookupCache.get(path);
+		if(cachedLookup)
+		{
+			lowerLookupLRU.splice(lowerLookupLRU.begin(), lowerLookupLRU, *cachedLookup);
+			outInfo = (*cachedLookup)->info;
+			return Result::success;
+		}
+
+		Result result = lowerFS->getFileInfo(path, outInfo);
+		if(result == Result::success)
+		{
+			if(lowerLookupCache.size() >= maxCachedLowerLookups)
+			{
+				lowerLookupCache.removeOrFail(lowerLookupLRU.back().path);
+				lowerLookupLRU.pop_back();
+			}
+			lowerLookupLRU.push_front(CachedLowerLookup{path, outInfo});
+			lowerLookupCache.addOrFail(path, lowerLookupLRU.begin());
+		}
+		return result;
+	}
+
+	// Looks up a path in the upper layer, then in the lower layer.
+	Result lookup(const std::string& path, FileInfo& outInfo, bool& outIsUpper)
+	{
+		Result result = upperFS->getFileInfo(path, outInfo);
+		if(result != Result::doesNotExist)
+		{
+			outIsUpper = result == Result::success;
+			return result;
+		}
+
+		outIsUpper = false;
+		return lookupLower(path, outInfo);
+	}
+
+	// Ensures that a directory exists in the upper layer.
+	Result copyUpDir(const std::string& path)
+	{
+		if(path.empty()) { return Result::success; }
+
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result != Result::success) { return result; }
+		if(info.type != FileType::directory) { return Result::isNotDirectory; }
+		if(isUpper) { return Result::success; }
+
+		result = copyUpDir(getParentPath(path));
+		if(result != Result::success) { return result; }
+		result = upperFS->createDir(path);
+		if(result != Result::success) { return result; }
+		return upperFS->setFileTimes(path, true, info.lastAccessTime, true, info.lastWriteTime);
+	}
+
+	// Copies a file from the lower layer to the upper layer.
+	Result copyUpFile(const std::string& path, const FileInfo& lowerInfo)
+	{
+		Result result = copyUpDir(getParentPath(path));
+		if(result != Result::success) { return result; }
+
+		VFD* lowerVFD = nullptr;
+		result = lowerFS->open(
+			path, FileAccessMode::readOnly, FileCreateMode::openExisting, lowerVFD);
+		if(result != Result::success) { return result; }
+
+		VFD* upperVFD = nullptr;
+		result = upperFS->open(
+			path, FileAccessMode::writeOnly, FileCreateMode::createNew, upperVFD);
+		if(result != Result::success)
+		{
+			lowerVFD->close();
+			return result;
+		}
+
+		std::vector<U8> buffer(copyUpBufferBytes);
+		while(true)
+		{
+			Uptr numBytesRead = 0;
+			result = lowerVFD->read(buffer.data(), buffer.size(), &numBytesRead);
+			if(result != Result::success || !numBytesRead) { break; }
+
+			Uptr numBytesWritten = 0;
+			result = upperVFD->write(buffer.data(), numBytesRead, &numBytesWritten);
+			if(result == Result::success && numBytesWritten != numBytesRead)
+			{ result = Result::outOfFreeSpace; }
+			if(result != Result::success) { break; }
+		};
+		if(result == Result::success)
+		{
+			result = upperVFD->setFileTimes(
+				true, lowerInfo.lastAccessTime, true, lowerInfo.lastWriteTime);
+		}
+
+		lowerVFD->close();
+		upperVFD->close();
+
+		// Don't leave a partial copy of the file in the upper layer.
+		if(result != Result::success) { upperFS->unlinkFile(path); }
+		return result;
+	}
+
+	// Ensures that a file or directory exists in the upper layer.
+	Result copyUp(const std::string& path)
+	{
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result != Result::success || isUpper) { return result; }
+		return info.type == FileType::directory ? copyUpDir(path) : copyUpFile(path, info);
+	}
+
+	// Lists the entries of a directory in both layers. Entries in the upper layer shadow entries
+	// with the same name in the lower layer.
+	Result listDir(const std::string& path, std::vector<DirEnt>& outDirEnts)
+	{
+		FileInfo info;
+		bool isUpper = false;
+		Result result = lookup(path, info, isUpper);
+		if(result != Result::success) { return result; }
+		if(info.type != FileType::directory) { return Result::isNotDirectory; }
+
+		HashSet<std::string> upperNames;
+		DirEntStream* dirEntStream = nullptr;
+		DirEnt dirEnt;
+		if(isUpper)
+		{
+			result = upperFS->openDir(path, dirEntStream);
+			if(result != Result::success) { return result; }
+			while(dirEntStream->getNext(dirEnt))
+			{
+				upperNames.add(dirEnt.name);
+				outDirEnts.push_back(std::move(dirEnt));
+			};
+			dirEntStream->close();
+		}
+
+		FileInfo lowerInfo;
+		if(lookupLower(path, lowerInfo) == Result::success
+		   && lowerInfo.type == FileType::directory)
+		{
+			result = lowerFS->openDir(path, dirEntStream);
+			if(result != Result::success) { return result; }
+			while(dirEntStream->getNext(dirEnt))
+			{
+				if(upperNames.contains(dirEnt.name)
+				   || (hiddenLowerPaths.size()
+					   && hiddenLowerPaths.contains(path + '/' + dirEnt.name)))
+				{ continue; }
+				outDirEnts.push_back(std::move(dirEnt));
+			};
+			dirEntStream->close();
+		}
+
+		return Result::success;
+	}
+};
+
+Result OverlayVFD::getFileInfo(FileInfo& outInfo)
+{
+	return isCopiedUp ? fs->getFileInfo(path, outInfo) : innerVFD->getFileInfo(outInfo);
+}
+
+Result OverlayVFD::setFileTimes(bool setLastAccessTime,
+								I128 lastAccessTime,
+								bool setLastWriteTime,
+								I128 lastWriteTime)
+{
+	Result result
+		= fs->setFileTimes(path, setLastAccessTime, lastAccessTime, setLastWriteTime, lastWriteTime);
+	if(result == Result::success) { isCopiedUp = true; }
+	return result;
+}
+
+Result OverlayVFD::openDir(DirEntStream*& outStream)
+{
+	if(type != FileType::directory) { return Result::isNotDirectory; }
+	return fs->openDir(path, outStream);
+}
+
+FileSystem* VFS::makeOverlayFS(FileSystem* lowerFS, FileSystem* upperFS)
+{
+	return new OverlayFS(lowerFS, upperFS);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/VFS/VFS.h"
+
+namespace WAVM { namespace VFS {
+	// A DirEntStream over a snapshot of a directory's entries.
+	struct SnapshotDirEntStream : DirEntStream
+	{
+		SnapshotDirEntStream(std::vector<DirEnt>&& inDirEnts) : dirEnts(std::move(inDirEnts)) {}
+
+		virtual void close() override { delete this; }
+
+		virtual bool getNext(DirEnt& outEntry) override
+		{
+			if(nextDirEntIndex >= dirEnts.size()) { return false; }
+			outEntry = dirEnts[nextDirEntIndex++];
+			return true;
+		}
+
+		virtual void restart() override { nextDirEntIndex = 0; }
+		virtual U64 tell() override { return nextDirEntIndex; }
+		virtual bool seek(U64 offset) override
+		{
+			if(offset > dirEnts.size()) { return false; }
+			nextDirEntIndex = Uptr(offset);
+			return true;
+		}
+
+	private:
+		std::vector<DirEnt> dirEnts;
+		Uptr nextDirEntIndex = 0;
+	};
+}}
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "WAVM/WASI/WASI.h"
 #include "./WASIPrivate.h"
 #include "./WASITypes.h"
@@ -8,6 +12,7 @@
 #include "WAVM/Platform/Clock.h"
 #include "WAVM/Platform/Defines.h"
 #include "WAVM/Platform/Diagnostics.h"
+#include "WAVM/Platform/Event.h"
 #include "WAVM/Platform/File.h"
 #include "WAVM/Platform/Intrinsic.h"
 #include "WAVM/Platform/Random.h"
@@ -67,13 +72,155 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wasi,
 							   WASIAddress numSubscriptions,
 							   WASIAddress outNumEventsAddress)
 {
-	UNIMPLEMENTED_SYSCALL("poll_oneoff",
-						  "(" WASIADDRESS_FORMAT ", " WASIADDRESS_FORMAT ", %u, " WASIADDRESS_FORMAT
-						  ")",
-						  inAddress,
-						  outAddress,
-						  numSubscriptions,
-						  outNumEventsAddress);
+	TRACE_SYSCALL("poll_oneoff",
+				  "(" WASIADDRESS_FORMAT ", " WASIADDRESS_FORMAT ", %u, " WASIADDRESS_FORMAT ")",
+				  inAddress,
+				  outAddress,
+				  numSubscriptions,
+				  outNumEventsAddress);
+
+	Process* process = getProcessFromContextRuntimeData(contextRuntimeData);
+	if(!numSubscriptions) { return TRACE_SYSCALL_RETURN(__WASI_EINVAL); }
+
+	const __wasi_subscription_t* subscriptionsInMemory
+		= memoryArrayPtr<__wasi_subscription_t>(process->memory, inAddress, numSubscriptions);
+	const std::vector<__wasi_subscription_t> subscriptions(
+		subscriptionsInMemory, subscriptionsInMemory + numSubscriptions);
+
+	// Subscriptions that can't be polled produce an event with an error, so are immediately ready.
+	std::vector<__wasi_event_t> events;
+	auto addEvent = [&events](const __wasi_subscription_t& subscription,
+							  __wasi_errno_t error,
+							  __wasi_filesize_t numBytes = 0,
+							  __wasi_eventrwflags_t flags = 0) {
+		__wasi_event_t event{};
+		event.userdata = subscription.userdata;
+		event.error = error;
+		event.type = subscription.type;
+		event.u.fd_readwrite.nbytes = numBytes;
+		event.u.fd_readwrite.flags = flags;
+		events.push_back(event);
+	};
+
+	// Translate the clock subscriptions to deadlines on the monotonic clock, and the FD
+	// subscriptions to VFDs that are waited on by the process's poller.
+	const I128 startTime = Platform::getMonotonicClock();
+	I128 deadline = I128::nan();
+	std::vector<std::pair<Uptr, I128>> clockDeadlines;
+	std::vector<Platform::PollSubscription> pollSubscriptions;
+	std::vector<Uptr> pollSubscriptionIndices;
+	for(Uptr subscriptionIndex = 0; subscriptionIndex < numSubscriptions; ++subscriptionIndex)
+	{
+		const __wasi_subscription_t& subscription = subscriptions[subscriptionIndex];
+		switch(subscription.type)
+		{
+		case __WASI_EVENTTYPE_CLOCK: {
+			const I128 timeout = I128(U64(subscription.u.clock.timeout));
+			const bool isAbsolute = subscription.u.clock.flags & __WASI_SUBSCRIPTION_CLOCK_ABSTIME;
+
+			// Absolute timeouts on other clocks are converted to the monotonic clock when the
+			// wait starts. The CPU time clocks are approximated by the monotonic clock, since they
+			// don't advance while the process is blocked.
+			I128 clockDeadline;
+			switch(subscription.u.clock.clock_id)
+			{
+			case __WASI_CLOCK_REALTIME: {
+				const I128 realtime = Platform::getRealtimeClock();
+				clockDeadline = startTime + (isAbsolute ? timeout - realtime : timeout);
+				break;
+			}
+			case __WASI_CLOCK_MONOTONIC:
+				clockDeadline = isAbsolute ? timeout : startTime + timeout;
+				break;
+			case __WASI_CLOCK_PROCESS_CPUTIME_ID:
+			case __WASI_CLOCK_THREAD_CPUTIME_ID: {
+				const I128 processTime = Platform::getProcessClock() - process->processClockOrigin;
+				clockDeadline = startTime + (isAbsolute ? timeout - processTime : timeout);
+				break;
+			}
+			default: addEvent(subscription, __WASI_EINVAL); continue;
+			};
+
+			clockDeadlines.emplace_back(subscriptionIndex, clockDeadline);
+			if(isNaN(deadline) || clockDeadline < deadline) { deadline = clockDeadline; }
+			break;
+		}
+		case __WASI_EVENTTYPE_FD_READ:
+		case __WASI_EVENTTYPE_FD_WRITE: {
+			FDE* fde = nullptr;
+			const __wasi_errno_t fdError = validateFD(
+				process, subscription.u.fd_readwrite.fd, __WASI_RIGHT_POLL_FD_READWRITE, 0, fde);
+			if(fdError != __WASI_ESUCCESS)
+			{
+				addEvent(subscription, fdError);
+				continue;
+			}
+
+			pollSubscriptions.push_back(
+				{fde->vfd,
+				 subscription.type == __WASI_EVENTTYPE_FD_READ ? Platform::PollEventType::read
+															   : Platform::PollEventType::write});
+			pollSubscriptionIndices.push_back(subscriptionIndex);
+			break;
+		}
+		default: return TRACE_SYSCALL_RETURN(__WASI_EINVAL);
+		};
+	}
+
+	// Wait until at least one event is ready. Don't block if an error event is already ready.
+	if(!process->poller) { process->poller = Platform::createPoller(); }
+	std::vector<Platform::PollEvent> pollEvents(pollSubscriptions.size());
+	while(true)
+	{
+		if(pollSubscriptions.empty())
+		{
+			// If there are only clock subscriptions, wait on an event that is never signaled, so a
+			// green thread gives up its worker thread while it sleeps. If there are no
+			// subscriptions, the deadline is NaN, and this waits forever.
+			I128 waitDuration = events.size() ? I128(0) : deadline - Platform::getMonotonicClock();
+			if(!isNaN(waitDuration) && waitDuration < 0) { waitDuration = 0; }
+			Platform::Event sleepEvent;
+			sleepEvent.wait(waitDuration);
+		}
+		else
+		{
+			Platform::BlockingCallScope blockingCall;
+			const VFS::Result result = process->poller->wait(pollSubscriptions.data(),
+															 pollSubscriptions.size(),
+															 events.size() ? startTime : deadline,
+															 pollEvents.data());
+			if(result != VFS::Result::success)
+			{ return TRACE_SYSCALL_RETURN(asWASIErrNo(result)); }
+		}
+
+		for(Uptr pollIndex = 0; pollIndex < pollSubscriptions.size(); ++pollIndex)
+		{
+			const Platform::PollEvent& pollEvent = pollEvents[pollIndex];
+			if(pollEvent.isReady)
+			{
+				addEvent(subscriptions[pollSubscriptionIndices[pollIndex]],
+						 __WASI_ESUCCESS,
+						 pollEvent.numBytes,
+						 pollEvent.isHungUp ? __WASI_EVENT_FD_READWRITE_HANGUP : 0);
+			}
+		}
+
+		const I128 endTime = Platform::getMonotonicClock();
+		for(const auto& clockDeadline : clockDeadlines)
+		{
+			if(clockDeadline.second <= endTime)
+			{ addEvent(subscriptions[clockDeadline.first], __WASI_ESUCCESS); }
+		}
+
+		if(events.size()) { break; }
+	}
+
+	__wasi_event_t* eventsInMemory
+		= memoryArrayPtr<__wasi_event_t>(process->memory, outAddress, events.size());
+	std::copy(events.begin(), events.end(), eventsInMemory);
+	memoryRef<WASIAddress>(process->memory, outNumEventsAddress) = WASIAddress(events.size());
+
+	return TRACE_SYSCALL_RETURN(__WASI_ESUCCESS, "(%" PRIuPTR ")", Uptr(events.size()));
 }
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(wasi, "proc_exit", void, wasi_proc_exit, __wasi_exitcode_t exitCode)
@@ -169,6 +316,8 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wasi, "sched_yield", __wasi_errno_return_t, wasi_
 
 WASI::Process::~Process()
 {
+	if(poller) { delete poller; }
+
 	for(const WASI::FDE& fd : fds)
 	{
 		if(fd.close() != VFS::Result::success)
@@ -210,6 +359,10 @@ WASI::RunResult WASI::run(Runtime::ModuleConstRefParam module,
 									   WAVM_INTRINSIC_MODULE_REF(wasiClocks),
 									   WAVM_INTRINSIC_MODULE_REF(wasiFile)},
 									  "wasi_unstable"));
+	process->resolver.moduleNameToInstanceMap.set(
+		"wavm_wasi_unstable",
+		Intrinsics::instantiateModule(
+			process->compartment, {WAVM_INTRINSIC_MODULE_REF(wasiMapping)}, "wavm_wasi_unstable"));
 
 	__wasi_rights_t stdioRights = __WASI_RIGHT_FD_READ | __WASI_RIGHT_FD_FDSTAT_SET_FLAGS
 								  | __WASI_RIGHT_FD_WRITE | __WASI_RIGHT_FD_FILESTAT_GET
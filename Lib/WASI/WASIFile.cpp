@@ -1,8 +1,12 @@
+#include <memory>
+
 #include "./WASIPrivate.h"
 #include "./WASITypes.h"
+#include "WAVM/IR/IR.h"
 #include "WAVM/Inline/BasicTypes.h"
 #include "WAVM/Logging/Logging.h"
 #include "WAVM/Platform/Clock.h"
+#include "WAVM/Platform/Thread.h"
 #include "WAVM/Runtime/Runtime.h"
 #include "WAVM/VFS/VFS.h"
 
@@ -15,7 +19,7 @@ namespace WAVM { namespace WASI {
 	WAVM_DEFINE_INTRINSIC_MODULE(wasiFile)
 }}
 
-static __wasi_errno_t asWASIErrNo(VFS::Result result)
+__wasi_errno_t WASI::asWASIErrNo(VFS::Result result)
 {
 	switch(result)
 	{
@@ -58,11 +62,11 @@ static __wasi_errno_t asWASIErrNo(VFS::Result result)
 	};
 }
 
-static __wasi_errno_t validateFD(Process* process,
-								 __wasi_fd_t fd,
-								 __wasi_rights_t requiredRights,
-								 __wasi_rights_t requiredInheritingRights,
-								 WASI::FDE*& outFDE)
+__wasi_errno_t WASI::validateFD(Process* process,
+								__wasi_fd_t fd,
+								__wasi_rights_t requiredRights,
+								__wasi_rights_t requiredInheritingRights,
+								WASI::FDE*& outFDE)
 {
 	if(fd < process->fds.getMinIndex() || fd > process->fds.getMaxIndex()) { return __WASI_EBADF; }
 	WASI::FDE* fde = process->fds.get(fd);
@@ -127,9 +131,10 @@ static bool getCanonicalPath(const std::string& basePath,
 {
 	outAbsolutePath = basePath;
 	if(outAbsolutePath.back() == '/') { outAbsolutePath.pop_back(); }
+	const Uptr numBasePathChars = outAbsolutePath.size();
 
-	std::vector<std::string> relativePathComponents;
-
+	// Append each component of the relative path directly to the absolute path, so canonicalizing
+	// the path doesn't allocate a string for each component.
 	Uptr componentStart = 0;
 	while(componentStart < relativePath.size())
 	{
@@ -142,32 +147,25 @@ static bool getCanonicalPath(const std::string& basePath,
 
 		if(nextPathSeparator != componentStart)
 		{
-			std::string component
-				= relativePath.substr(componentStart, nextPathSeparator - componentStart);
-
-			if(component == "..")
+			const Uptr numComponentChars = nextPathSeparator - componentStart;
+			if(!relativePath.compare(componentStart, numComponentChars, ".."))
 			{
-				if(!relativePathComponents.size()) { return false; }
+				if(outAbsolutePath.size() == numBasePathChars) { return false; }
 				else
 				{
-					relativePathComponents.pop_back();
+					outAbsolutePath.resize(outAbsolutePath.rfind('/'));
 				}
 			}
-			else if(component != ".")
+			else if(relativePath.compare(componentStart, numComponentChars, "."))
 			{
-				relativePathComponents.push_back(component);
+				outAbsolutePath += '/';
+				outAbsolutePath.append(relativePath, componentStart, numComponentChars);
 			}
 
 			componentStart = nextPathSeparator + 1;
 		}
 	};
 
-	for(const std::string& component : relativePathComponents)
-	{
-		outAbsolutePath += '/';
-		outAbsolutePath += component;
-	}
-
 	return true;
 }
 
@@ -322,6 +320,52 @@ WAVM_DEFINE_INTRINSIC_FUNCTION(wasiFile,
 	return TRACE_SYSCALL_RETURN(asWASIErrNo(fde->vfd->sync(SyncType::contents)));
 }
 
+enum
+{
+	numLocalIOVs = 16
+};
+
+// Translates an array of WASI IOVs in the process memory to an array of VFS IO buffers. Returns
+// false if any of the IOVs or the buffers they point to are outside the memory's committed pages.
+// The memory's pages may be concurrently unmapped, so this must be called by catchMemoryFaults.
+template<typename IOV, typename IOBuffer, typename Data>
+static bool translateIOVs(Memory* memory,
+						  WASIAddress iovsAddress,
+						  I32 numIOVs,
+						  IOBuffer* outBuffers,
+						  U64& outNumBufferBytes)
+{
+	U8* memoryBase = getMemoryBaseAddress(memory);
+	const U64 memoryNumBytes = U64(getMemoryNumPages(memory)) * IR::numBytesPerPage;
+	if(U64(iovsAddress) + U64(numIOVs) * sizeof(IOV) > memoryNumBytes) { return false; }
+
+	const IOV* iovs = (const IOV*)(memoryBase + iovsAddress);
+	outNumBufferBytes = 0;
+	for(I32 iovIndex = 0; iovIndex < numIOVs; ++iovIndex)
+	{
+		const IOV iov = iovs[iovIndex];
+		if(U64(iov.buf) + U64(iov.buf_len) > memoryNumBytes) { return false; }
+		outBuffers[iovIndex].data = (Data*)(memoryBase + iov.buf);
+		outBuffers[iovIndex].numBytes = iov.buf_len;
+		outNumBufferBytes += iov.buf_len;
+	}
+	return true;
+}
+
+// The state shared by readImpl/writeImpl and the thunk they pass to catchMemoryFaults.
+template<typename IOBuffer> struct IOContext
+{
+	Process* process;
+	VFD* vfd;
+	WASIAddress iovsAddress;
+	I32 numIOVs;
+	IOBuffer* buffers;
+	const __wasi_filesize_t* offset;
+
+	Uptr numBytes = 0;
+	__wasi_errno_t result = __WASI_ESUCCESS;
+};
+
 static __wasi_errno_t readImpl(Process* process,
 							   __wasi_fd_t fd,
 							   WASIAddress iovsAddress,
@@ -337,47 +381,52 @@ static __wasi_errno_t readImpl(Process* process,
 
 	if(numIOVs < 0 || numIOVs > __WASI_IOV_MAX) { return __WASI_EINVAL; }
 
-	// Allocate memory for the IOReadBuffers.
-	IOReadBuffer* vfsReadBuffers = (IOReadBuffer*)malloc(numIOVs * sizeof(IOReadBuffer));
-
-	// Catch any out-of-bounds memory access exceptions that are thrown.
-	__wasi_errno_t result = __WASI_ESUCCESS;
-	Runtime::catchRuntimeExceptions(
-		[&] {
-			// Translate the IOVs to IOReadBuffers.
-			const __wasi_iovec_t* iovs
-				= memoryArrayPtr<__wasi_iovec_t>(process->memory, iovsAddress, numIOVs);
-			U64 numBufferBytes = 0;
-			for(I32 iovIndex = 0; iovIndex < numIOVs; ++iovIndex)
-			{
-				__wasi_iovec_t iov = iovs[iovIndex];
-				vfsReadBuffers[iovIndex].data
-					= memoryArrayPtr<U8>(process->memory, iov.buf, iov.buf_len);
-				vfsReadBuffers[iovIndex].numBytes = iov.buf_len;
-				numBufferBytes += iov.buf_len;
-			}
-			if(numBufferBytes > WASIADDRESS_MAX) { result = __WASI_EOVERFLOW; }
-			else
-			{
-				// Do the read.
-				result = asWASIErrNo(
-					fde->vfd->readv(vfsReadBuffers, numIOVs, &outNumBytesRead, offset));
-			}
-		},
-		[&](Exception* exception) {
-			// If we catch an out-of-bounds memory exception, return EFAULT.
-			errorUnless(getExceptionType(exception) == ExceptionTypes::outOfBoundsMemoryAccess);
-			Log::printf(Log::debug,
-						"Caught runtime exception while reading memory at address 0x%" PRIx64,
-						getExceptionArgument(exception, 1).i64);
-			destroyException(exception);
-			result = __WASI_EFAULT;
-		});
+	// Use a buffer on the stack for the IOReadBuffers, unless there are too many IOVs to fit.
+	IOReadBuffer localReadBuffers[numLocalIOVs];
+	std::unique_ptr<IOReadBuffer[]> heapReadBuffers;
+	IOReadBuffer* vfsReadBuffers = localReadBuffers;
+	if(numIOVs > numLocalIOVs)
+	{
+		heapReadBuffers.reset(new IOReadBuffer[numIOVs]);
+		vfsReadBuffers = heapReadBuffers.get();
+	}
 
-	// Free the VFS read buffers.
-	free(vfsReadBuffers);
+	// Reading from a pipe or terminal may block until input is available. The blocking call scope
+	// is outside catchMemoryFaults, since a fault skips the destructors of the thunk's locals.
+	Platform::BlockingCallScope blockingCall;
+
+	// Translate the IOVs and do the read in catchMemoryFaults, which returns EFAULT for a fault in
+	// the process memory without the allocation and C++ exception of catchRuntimeExceptions.
+	IOContext<IOReadBuffer> context{process, fde->vfd, iovsAddress, numIOVs, vfsReadBuffers, offset};
+	if(catchMemoryFaults(
+		   process->memory,
+		   [](void* contextVoid) {
+			   IOContext<IOReadBuffer>& context = *(IOContext<IOReadBuffer>*)contextVoid;
+			   U64 numBufferBytes = 0;
+			   if(!translateIOVs<__wasi_iovec_t, IOReadBuffer, U8>(context.process->memory,
+																   context.iovsAddress,
+																   context.numIOVs,
+																   context.buffers,
+																   numBufferBytes))
+			   { context.result = __WASI_EFAULT; }
+			   else if(numBufferBytes > WASIADDRESS_MAX)
+			   {
+				   context.result = __WASI_EOVERFLOW;
+			   }
+			   else
+			   {
+				   context.result = asWASIErrNo(context.vfd->readv(
+					   context.buffers, context.numIOVs, &context.numBytes, context.offset));
+			   }
+		   },
+		   &context))
+	{
+		Log::printf(Log::debug, "Caught memory fault while reading to memory");
+		return __WASI_EFAULT;
+	}
 
-	return result;
+	outNumBytesRead = context.numBytes;
+	return context.result;
 }
 
 static __wasi_errno_t writeImpl(Process* process,
@@ -395,47 +444,52 @@ static __wasi_errno_t writeImpl(Process* process,
 
 	if(numIOVs < 0 || numIOVs > __WASI_IOV_MAX) { return __WASI_EINVAL; }
 
-	// Allocate memory for the IOWriteBuffers.
-	IOWriteBuffer* vfsWriteBuffers = (IOWriteBuffer*)malloc(numIOVs * sizeof(IOWriteBuffer));
-
-	// Catch any out-of-bounds memory access exceptions that are thrown.
-	__wasi_errno_t result = __WASI_ESUCCESS;
-	Runtime::catchRuntimeExceptions(
-		[&] {
-			// Translate the IOVs to IOWriteBuffers
-			const __wasi_ciovec_t* iovs
-				= memoryArrayPtr<__wasi_ciovec_t>(process->memory, iovsAddress, numIOVs);
-			U64 numBufferBytes = 0;
-			for(I32 iovIndex = 0; iovIndex < numIOVs; ++iovIndex)
-			{
-				__wasi_ciovec_t iov = iovs[iovIndex];
-				vfsWriteBuffers[iovIndex].data
-					= memoryArrayPtr<const U8>(process->memory, iov.buf, iov.buf_len);
-				vfsWriteBuffers[iovIndex].numBytes = iov.buf_len;
-				numBufferBytes += iov.buf_len;
-			}
-			if(numBufferBytes > WASIADDRESS_MAX) { result = __WASI_EOVERFLOW; }
-			else
-			{
-				// Do the writes.
-				result = asWASIErrNo(
-					fde->vfd->writev(vfsWriteBuffers, numIOVs, &outNumBytesWritten, offset));
-			}
-		},
-		[&](Exception* exception) {
-			// If we catch an out-of-bounds memory exception, return EFAULT.
-			errorUnless(getExceptionType(exception) == ExceptionTypes::outOfBoundsMemoryAccess);
-			Log::printf(Log::debug,
-						"Caught runtime exception while reading memory at address 0x%" PRIx64,
-						getExceptionArgument(exception, 1).i64);
-			destroyException(exception);
-			result = __WASI_EFAULT;
-		});
+	// Use a buffer on the stack for the IOWriteBuffers, unless there are too many IOVs to fit.
+	IOWriteBuffer localWriteBuffers[numLocalIOVs];
+	std::unique_ptr<IOWriteBuffer[]> heapWriteBuffers;
+	IOWriteBuffer* vfsWriteBuffers = localWriteBuffers;
+	if(numIOVs > numLocalIOVs)
+	{
+		heapWriteBuffers.reset(new IOWriteBuffer[numIOVs]);
+		vfsWriteBuffers = heapWriteBuffers.get();
+	}
 
-	// Free the VFS write buffers.
-	free(vfsWriteBuffers);
+	// Writing to a full pipe may block until it is read.
+	Platform::BlockingCallScope blockingCall;
+
+	// Translate the IOVs and do the write in catchMemoryFaults (see readImpl).
+	IOContext<IOWriteBuffer> context{
+		process, fde->vfd, iovsAddress, numIOVs, vfsWriteBuffers, offset};
+	if(catchMemoryFaults(
+		   process->memory,
+		   [](void* contextVoid) {
+			   IOContext<IOWriteBuffer>& context = *(IOContext<IOWriteBuffer>*)contextVoid;
+			   U64 numBufferBytes = 0;
+			   if(!translateIOVs<__wasi_ciovec_t, IOWriteBuffer, const U8>(
+					  context.process->memory,
+					  context.iovsAddress,
+					  context.numIOVs,
+					  context.buffers,
+					  numBufferBytes))
+			   { context.result = __WASI_EFAULT; }
+			   else if(numBufferBytes > WASIADDRESS_MAX)
+			   {
+				   context.result = __WASI_EOVERFLOW;
+			   }
+			   else
+			   {
+				   context.result = asWASIErrNo(context.vfd->writev(
+					   context.buffers, context.numIOVs, &context.numBytes, context.offset));
+			   }
+		   },
+		   &context))
+	{
+		Log::printf(Log::debug, "Caught memory fault while writing from memory");
+		return __WASI_EFAULT;
+	}
 
-	return result;
+	outNumBytesWritten = context.numBytes;
+	return context.result;
 }
 
 WAVM_DEFINE_INTRINSIC_FUNCTION(wasiFile,
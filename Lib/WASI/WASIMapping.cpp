@@ -0,0 +1,89 @@
+#include "./WASIPrivate.h"
+#include "./WASITypes.h"
+#include "WAVM/IR/IR.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Runtime/Intrinsics.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::WASI;
+using namespace WAVM::Runtime;
+
+// A WAVM extension to WASI that maps files into the process's memory, so reading a large file
+// doesn't copy it into the memory.
+namespace WAVM { namespace WASI {
+	WAVM_DEFINE_INTRINSIC_MODULE(wasiMapping)
+}}
+
+// Validates that a range of the process's memory is a whole number of WebAssembly pages within its
+// current size.
+static __wasi_errno_t getMemoryPageRange(Process* process,
+										 WASIAddress address,
+										 WASIAddress numBytes,
+										 Uptr& outPageIndex,
+										 Uptr& outNumPages)
+{
+	if((address | numBytes) & (IR::numBytesPerPage - 1)) { return __WASI_EINVAL; }
+
+	outPageIndex = address / IR::numBytesPerPage;
+	outNumPages = numBytes / IR::numBytesPerPage;
+	const Uptr memoryNumPages = getMemoryNumPages(process->memory);
+	if(outPageIndex > memoryNumPages || outNumPages > memoryNumPages - outPageIndex)
+	{ return __WASI_EFAULT; }
+	return __WASI_ESUCCESS;
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(wasiMapping,
+							   "fd_map",
+							   __wasi_errno_return_t,
+							   wasi_fd_map,
+							   __wasi_fd_t fd,
+							   __wasi_filesize_t offset,
+							   WASIAddress address,
+							   WASIAddress numBytes)
+{
+	TRACE_SYSCALL("fd_map",
+				  "(%u, %" PRIu64 ", " WASIADDRESS_FORMAT ", %u)",
+				  fd,
+				  offset,
+				  address,
+				  numBytes);
+
+	Process* process = getProcessFromContextRuntimeData(contextRuntimeData);
+
+	WASI::FDE* fde = nullptr;
+	const __wasi_errno_t fdError = validateFD(process, fd, __WASI_RIGHT_FD_READ, 0, fde);
+	if(fdError != __WASI_ESUCCESS) { return TRACE_SYSCALL_RETURN(fdError); }
+
+	Uptr pageIndex = 0;
+	Uptr numPages = 0;
+	const __wasi_errno_t rangeError
+		= getMemoryPageRange(process, address, numBytes, pageIndex, numPages);
+	if(rangeError != __WASI_ESUCCESS) { return TRACE_SYSCALL_RETURN(rangeError); }
+
+	const VFS::Result result
+		= mapFileIntoMemory(process->memory, pageIndex, numPages, fde->vfd, offset);
+	return TRACE_SYSCALL_RETURN(asWASIErrNo(result));
+}
+
+WAVM_DEFINE_INTRINSIC_FUNCTION(wasiMapping,
+							   "unmap",
+							   __wasi_errno_return_t,
+							   wasi_unmap,
+							   WASIAddress address,
+							   WASIAddress numBytes)
+{
+	TRACE_SYSCALL("unmap", "(" WASIADDRESS_FORMAT ", %u)", address, numBytes);
+
+	Process* process = getProcessFromContextRuntimeData(contextRuntimeData);
+
+	Uptr pageIndex = 0;
+	Uptr numPages = 0;
+	const __wasi_errno_t rangeError
+		= getMemoryPageRange(process, address, numBytes, pageIndex, numPages);
+	if(rangeError != __WASI_ESUCCESS) { return TRACE_SYSCALL_RETURN(rangeError); }
+
+	unmapFileFromMemory(process->memory, pageIndex, numPages);
+	return TRACE_SYSCALL_RETURN(__WASI_ESUCCESS);
+}
@@ -50,6 +50,10 @@ namespace WAVM { namespace VFS {
 	struct VFD;
 }}
 
+namespace WAVM { namespace Platform {
+	struct Poller;
+}}
+
 namespace WAVM { namespace WASI {
 	struct FDE
 	{
@@ -108,6 +112,9 @@ namespace WAVM { namespace WASI {
 
 		I128 processClockOrigin;
 
+		// Created by the first call to poll_oneoff, and reused by later calls.
+		Platform::Poller* poller = nullptr;
+
 		~Process();
 	};
 
@@ -126,6 +133,14 @@ namespace WAVM { namespace WASI {
 			Runtime::getCompartmentFromContextRuntimeData(contextRuntimeData));
 	}
 
+	__wasi_errno_t asWASIErrNo(VFS::Result result);
+
+	__wasi_errno_t validateFD(Process* process,
+							  __wasi_fd_t fd,
+							  __wasi_rights_t requiredRights,
+							  __wasi_rights_t requiredInheritingRights,
+							  WASI::FDE*& outFDE);
+
 	WAVM_VALIDATE_AS_PRINTF(2, 3)
 	void traceSyscallf(const char* syscallName, const char* argFormat, ...);
 
@@ -139,4 +154,5 @@ namespace WAVM { namespace WASI {
 	WAVM_DECLARE_INTRINSIC_MODULE(wasiArgsEnvs);
 	WAVM_DECLARE_INTRINSIC_MODULE(wasiClocks);
 	WAVM_DECLARE_INTRINSIC_MODULE(wasiFile);
+	WAVM_DECLARE_INTRINSIC_MODULE(wasiMapping);
 }}
@@ -9,6 +9,7 @@
 #include "WAVM/Inline/Timing.h"
 #include "WAVM/LLVMJIT/LLVMJIT.h"
 #include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Runtime.h"
 #include "WAVM/WASM/WASM.h"
 #include "WAVM/WASTParse/WASTParse.h"
 
@@ -136,8 +137,9 @@ int main(int argc, char** argv)
 	default: WAVM_UNREACHABLE();
 	};
 
-	// Extract the compiled object code and add it to the IR module as a user section.
-	irModule.userSections.push_back({"wavm.precompiled_object", objectCode});
+	// Add the compiled object code to the IR module as a user section.
+	Runtime::addPrecompiledObjectSection(
+		irModule, objectCode, Runtime::MemoryBoundsCheckMode::guardRegion);
 
 	// Serialize the WASM module.
 	std::vector<U8> wasmBytes;
@@ -21,6 +21,9 @@
 #include "WAVM/Platform/Memory.h"
 #include "WAVM/Runtime/Linker.h"
 #include "WAVM/Runtime/Runtime.h"
+#include "WAVM/VFS/MemoryFS.h"
+#include "WAVM/VFS/MountFS.h"
+#include "WAVM/VFS/OverlayFS.h"
 #include "WAVM/VFS/SandboxFS.h"
 #include "WAVM/VFS/VFS.h"
 #include "WAVM/WASI/WASI.h"
@@ -60,10 +63,17 @@ static bool loadModule(const char* filename, IR::Module& outModule)
 	}
 }
 
+// The default limit on the size of each in-memory filesystem, so a program can't use unbounded
+// host memory by writing to one.
+static constexpr U64 defaultMaxTmpfsMiB = 256;
+
 struct CommandLineOptions
 {
 	const char* filename = nullptr;
 	const char* rootMountPath = nullptr;
+	bool overlayRoot = false;
+	std::vector<const char*> tmpfsMountPaths;
+	U64 maxTmpfsBytes = defaultMaxTmpfsMiB * 1024 * 1024;
 	std::vector<std::string> args;
 	bool onlyCheck = false;
 	bool precompiled = false;
@@ -82,30 +92,13 @@ static int run(const CommandLineOptions& options)
 	if(!options.precompiled) { module = Runtime::compileModule(irModule); }
 	else
 	{
-		const UserSection* precompiledObjectSection = nullptr;
-		for(const UserSection& userSection : irModule.userSections)
-		{
-			if(userSection.name == "wavm.precompiled_object")
-			{
-				precompiledObjectSection = &userSection;
-				break;
-			}
-		}
-
-		if(!precompiledObjectSection)
-		{
-			Log::printf(Log::error,
-						"Input file did not contain 'wavm.precompiled_object' section.\n");
-			return EXIT_FAILURE;
-		}
-		else
-		{
-			module = Runtime::loadPrecompiledModule(irModule, precompiledObjectSection->data);
-		}
+		module = Runtime::loadPrecompiledModule(irModule);
+		if(!module) { return EXIT_FAILURE; }
 	}
 
 	// If a directory to mount as the root filesystem was passed on the command-line, create a
-	// SandboxFS for it.
+	// sandbox filesystem for it. Prefer the host's sandbox filesystem, which resolves paths
+	// relative to a handle for the directory, and fall back to the portable SandboxFS.
 	VFS::FileSystem* sandboxFS = nullptr;
 	if(options.rootMountPath)
 	{
@@ -117,7 +110,50 @@ static int run(const CommandLineOptions& options)
 		{
 			rootPath = Platform::getCurrentWorkingDirectory() + '/' + options.rootMountPath;
 		}
-		sandboxFS = VFS::makeSandboxFS(&Platform::getHostFS(), rootPath);
+		sandboxFS = Platform::openHostSandboxFS(rootPath);
+		if(!sandboxFS) { sandboxFS = VFS::makeSandboxFS(&Platform::getHostFS(), rootPath); }
+	}
+
+	std::vector<VFS::FileSystem*> fileSystems;
+	if(sandboxFS) { fileSystems.push_back(sandboxFS); }
+
+	// If the root directory should be an overlay, keep the writes to it in memory.
+	if(sandboxFS && options.overlayRoot)
+	{
+		VFS::FileSystem* upperFS = VFS::makeMemoryFS(options.maxTmpfsBytes);
+		sandboxFS = VFS::makeOverlayFS(sandboxFS, upperFS);
+		fileSystems.push_back(upperFS);
+		fileSystems.push_back(sandboxFS);
+	}
+
+	// Mount an in-memory filesystem at each tmpfs mount path. If there's no root directory, use
+	// an in-memory root filesystem that only contains the mount points.
+	if(options.tmpfsMountPaths.size())
+	{
+		if(!sandboxFS)
+		{
+			sandboxFS = VFS::makeMemoryFS(0);
+			fileSystems.push_back(sandboxFS);
+			for(const char* mountPath : options.tmpfsMountPaths)
+			{
+				// Create each directory on the mount path, ignoring those that already exist.
+				const std::string mountPathString = mountPath;
+				Uptr separatorIndex = 0;
+				do
+				{
+					separatorIndex = mountPathString.find('/', separatorIndex + 1);
+					sandboxFS->createDir(mountPathString.substr(0, separatorIndex));
+				} while(separatorIndex != std::string::npos);
+			}
+		}
+
+		for(const char* mountPath : options.tmpfsMountPaths)
+		{
+			VFS::FileSystem* tmpFS = VFS::makeMemoryFS(options.maxTmpfsBytes);
+			sandboxFS = VFS::makeMountFS(sandboxFS, mountPath, tmpFS);
+			fileSystems.push_back(tmpFS);
+			fileSystems.push_back(sandboxFS);
+		}
 	}
 
 	std::vector<std::string> args = options.args;
@@ -134,7 +170,7 @@ static int run(const CommandLineOptions& options)
 									   Platform::getStdFD(Platform::StdDevice::err),
 									   exitCode);
 	executionTimer.stop();
-	if(sandboxFS) { delete sandboxFS; }
+	for(VFS::FileSystem* fileSystem : fileSystems) { delete fileSystem; }
 
 	switch(result)
 	{
@@ -171,8 +207,14 @@ static void showHelp()
 		"  --trace-syscalls            Trace WASI syscalls to stdout\n"
 		"  --trace-syscall-callstacks  Trace WASI syscalls w/ callstacks to stdout\n"
 		"  --mount-root <directory>    Mounts directory as the WASI root directory\n"
+		"  --overlay-root <directory>  Mounts directory as the WASI root directory, but keeps\n"
+		"                              writes to it in memory\n"
+		"  --mount-tmpfs <directory>   Mounts an in-memory filesystem at directory\n"
+		"  --tmpfs-size <MiB>          Limits the size of each in-memory filesystem\n"
+		"                              (default: %" PRIu64 ")\n"
 		"  <program file>              The WebAssembly module (.wast/.wasm) to run\n"
-		"  [program arguments]         The arguments to pass to the WebAssembly function\n");
+		"  [program arguments]         The arguments to pass to the WebAssembly function\n",
+		defaultMaxTmpfsMiB);
 }
 
 int main(int argc, char** argv)
@@ -210,8 +252,9 @@ int main(int argc, char** argv)
 		{
 			WASI::setSyscallTraceLevel(WASI::SyscallTraceLevel::syscallsWithCallstacks);
 		}
-		else if(!strcmp(*nextArg, "--mount-root"))
+		else if(!strcmp(*nextArg, "--mount-root") || !strcmp(*nextArg, "--overlay-root"))
 		{
+			options.overlayRoot = !strcmp(*nextArg, "--overlay-root");
 			if(!*++nextArg)
 			{
 				showHelp();
@@ -219,6 +262,28 @@ int main(int argc, char** argv)
 			}
 			options.rootMountPath = *nextArg;
 		}
+		else if(!strcmp(*nextArg, "--mount-tmpfs"))
+		{
+			if(!*++nextArg || (*nextArg)[0] != '/')
+			{
+				showHelp();
+				return EXIT_FAILURE;
+			}
+			options.tmpfsMountPaths.push_back(*nextArg);
+		}
+		else if(!strcmp(*nextArg, "--tmpfs-size"))
+		{
+			// Reject sizes that are zero, or that overflow a Uptr when converted to bytes.
+			char* end = nullptr;
+			U64 numMiB = 0;
+			if(!*++nextArg || !(numMiB = strtoull(*nextArg, &end, 10)) || *end
+			   || numMiB > UINTPTR_MAX / (1024 * 1024))
+			{
+				showHelp();
+				return EXIT_FAILURE;
+			}
+			options.maxTmpfsBytes = numMiB * 1024 * 1024;
+		}
 		else
 		{
 			options.filename = *nextArg;
@@ -104,6 +104,7 @@ struct CommandLineOptions
 	bool enableEmscripten = true;
 	bool enableThreadTest = false;
 	bool precompiled = false;
+	Runtime::CodegenMode codegenMode = Runtime::CodegenMode::optimized;
 };
 
 static int run(const CommandLineOptions& options)
@@ -116,29 +117,15 @@ static int run(const CommandLineOptions& options)
 
 	// Compile the module.
 	Runtime::ModuleRef module = nullptr;
-	if(!options.precompiled) { module = Runtime::compileModule(irModule); }
+	if(!options.precompiled)
+	{
+		module = Runtime::compileModule(
+			irModule, Runtime::MemoryBoundsCheckMode::guardRegion, options.codegenMode);
+	}
 	else
 	{
-		const UserSection* precompiledObjectSection = nullptr;
-		for(const UserSection& userSection : irModule.userSections)
-		{
-			if(userSection.name == "wavm.precompiled_object")
-			{
-				precompiledObjectSection = &userSection;
-				break;
-			}
-		}
-
-		if(!precompiledObjectSection)
-		{
-			Log::printf(Log::error,
-						"Input file did not contain 'wavm.precompiled_object' section.\n");
-			return EXIT_FAILURE;
-		}
-		else
-		{
-			module = Runtime::loadPrecompiledModule(irModule, precompiledObjectSection->data);
-		}
+		module = Runtime::loadPrecompiledModule(irModule);
+		if(!module) { return EXIT_FAILURE; }
 	}
 
 	// Link the module with the intrinsic modules.
@@ -314,6 +301,9 @@ static void showHelp()
 				"  --disable-emscripten  Disable Emscripten intrinsics\n"
 				"  --enable-thread-test  Enable ThreadTest intrinsics\n"
 				"  --precompiled         Use precompiled object code in programfile\n"
+				"  --huge-pages          Back memories and code with transparent huge pages\n"
+				"  --fast-codegen        Use fast/unoptimized codegen: compile faster, but\n"
+				"                        generate slower code. Can't be used with --precompiled\n"
 				"  --metrics             Write benchmarking information to stdout\n"
 				"  <program file>        The WebAssembly module (.wast/.wasm) to run\n"
 				"  [program arguments]   The arguments to pass to the WebAssembly function\n");
@@ -363,6 +353,14 @@ int main(int argc, char** argv)
 		{
 			options.precompiled = true;
 		}
+		else if(!strcmp(*options.args, "--huge-pages"))
+		{
+			Runtime::setHugePagesEnabled(true);
+		}
+		else if(!strcmp(*options.args, "--fast-codegen"))
+		{
+			options.codegenMode = Runtime::CodegenMode::fastUnoptimized;
+		}
 		else
 		{
 			options.filename = *options.args;
@@ -377,6 +375,13 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
+	// Precompiled object code was already generated, so it can't be generated with fast codegen.
+	if(options.precompiled && options.codegenMode != Runtime::CodegenMode::optimized)
+	{
+		Log::printf(Log::error, "--fast-codegen can't be used with --precompiled.\n");
+		return EXIT_FAILURE;
+	}
+
 	int result = EXIT_FAILURE;
 	Runtime::catchRuntimeExceptions([&result, options]() { result = run(options); },
 									[](Runtime::Exception* exception) {
@@ -0,0 +1,99 @@
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numFunctions = 1000,
+	numLoopIterations = 100000000
+};
+
+// Generates a module with many functions that each run a small loop, and call the next function.
+static std::string generateModuleWAST()
+{
+	std::string wast = "(module\n";
+	for(Uptr functionIndex = 0; functionIndex < numFunctions; ++functionIndex)
+	{
+		wast += "  (func $f" + std::to_string(functionIndex);
+		if(functionIndex == 0) { wast += " (export \"f0\")"; }
+		wast += " (param $n i32) (result i32)\n"
+				"    (local $sum i32)\n"
+				"    (block $done (loop $loop\n"
+				"      (br_if $done (i32.eqz (local.get $n)))\n"
+				"      (local.set $sum (i32.add (local.get $sum)\n"
+				"        (i32.mul (local.get $n) (i32.const "
+				+ std::to_string(functionIndex + 1)
+				+ "))))\n"
+				  "      (local.set $n (i32.sub (local.get $n) (i32.const 1)))\n"
+				  "      (br $loop)))\n";
+		if(functionIndex + 1 < numFunctions)
+		{
+			wast += "    (drop (call $f" + std::to_string(functionIndex + 1)
+					+ " (i32.const 0)))\n";
+		}
+		wast += "    (local.get $sum))\n";
+	}
+	wast += ")";
+	return wast;
+}
+
+static void runBenchmark(const IR::Module& irModule, CodegenMode codegenMode)
+{
+	const char* codegenModeName
+		= codegenMode == CodegenMode::optimized ? "optimized" : "fast/unoptimized";
+
+	// Measure the time from compiling the module to the first call returning.
+	GCPointer<Compartment> compartment = createCompartment();
+	Timing::Timer startupTimer;
+	ModuleRef module = compileModule(irModule, MemoryBoundsCheckMode::guardRegion, codegenMode);
+	ModuleInstance* moduleInstance = instantiateModule(compartment, module, {}, "compileBench");
+	Context* context = createContext(compartment);
+	Function* function = asFunction(getInstanceExport(moduleInstance, "f0"));
+	invokeFunctionChecked(context, function, {Value{I32(0)}});
+	startupTimer.stop();
+
+	// Measure the speed of the compiled code.
+	Timing::Timer runTimer;
+	invokeFunctionChecked(context, function, {Value{I32(numLoopIterations)}});
+	runTimer.stop();
+
+	Log::printf(Log::output,
+				"%s: ms to first call: %.1f, ns/loop iteration: %.2f\n",
+				codegenModeName,
+				startupTimer.getMilliseconds(),
+				runTimer.getNanoseconds() / F64(numLoopIterations));
+
+	moduleInstance = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+int main(int argc, char** argv)
+{
+	const std::string wast = generateModuleWAST();
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(wast.c_str(), wast.size() + 1, irModule, parseErrors))
+	{
+		WAST::reportParseErrors("compile-bench", parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+
+	runBenchmark(irModule, CodegenMode::optimized);
+	runBenchmark(irModule, CodegenMode::fastUnoptimized);
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+#include <inttypes.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Serialization.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Inline/Unicode.h"
+#include "WAVM/Logging/Logging.h"
+
+using namespace WAVM;
+using namespace WAVM::Serialization;
+
+enum
+{
+	numRepeats = 100
+};
+
+// A simple deterministic PRNG, so the benchmark input is the same on every run.
+static U32 nextRandom(U32& state)
+{
+	state = state * 1664525 + 1013904223;
+	return state >> 8;
+}
+
+static void logThroughput(const char* description, F64 numBytes, Timing::Timer& timer)
+{
+	const F64 megabytesPerSecond = numBytes / 1000000.0 / timer.getSeconds();
+	Log::printf(Log::output, "%s: %.1f MB/s\n", description, megabytesPerSecond);
+}
+
+// The one code point at a time UTF-8 validation loop, without any ASCII fast path.
+static const U8* validateUTF8StringScalar(const U8* nextChar, const U8* endChar)
+{
+	U32 codePoint;
+	while(nextChar != endChar && Unicode::decodeUTF8CodePoint(nextChar, endChar, codePoint)) {};
+	return nextChar;
+}
+
+static void benchmarkUTF8(const char* description, const std::string& string)
+{
+	const U8* begin = (const U8*)string.data();
+	const U8* end = begin + string.size();
+
+	Timing::Timer scalarTimer;
+	for(Uptr repeatIndex = 0; repeatIndex < numRepeats; ++repeatIndex)
+	{ errorUnless(validateUTF8StringScalar(begin, end) == end); }
+	scalarTimer.stop();
+
+	Timing::Timer fastTimer;
+	for(Uptr repeatIndex = 0; repeatIndex < numRepeats; ++repeatIndex)
+	{ errorUnless(Unicode::validateUTF8String(begin, end) == end); }
+	fastTimer.stop();
+
+	const F64 numBytes = F64(string.size()) * numRepeats;
+	logThroughput((std::string("UTF-8 validate ") + description + " (scalar)").c_str(),
+				  numBytes,
+				  scalarTimer);
+	logThroughput(
+		(std::string("UTF-8 validate ") + description).c_str(), numBytes, fastTimer);
+}
+
+// Wraps one of the LEB128 helpers so it can be instantiated for both input and output streams.
+#define DEFINE_LEB128_SERIALIZER(name, helper)                                                     \
+	struct name                                                                                    \
+	{                                                                                              \
+		template<typename Stream, typename Value> static void serialize(Stream& s, Value& v)       \
+		{                                                                                          \
+			helper(s, v);                                                                          \
+		}                                                                                          \
+	};
+
+DEFINE_LEB128_SERIALIZER(VarUInt32Serializer, serializeVarUInt32)
+DEFINE_LEB128_SERIALIZER(VarInt32Serializer, serializeVarInt32)
+DEFINE_LEB128_SERIALIZER(VarInt64Serializer, serializeVarInt64)
+
+template<typename Serializer, typename Value>
+static void benchmarkLEB128(const char* description, std::vector<Value>& values)
+{
+	ArrayOutputStream outputStream;
+	for(Value& value : values) { Serializer::serialize(outputStream, value); }
+	std::vector<U8> bytes = outputStream.getBytes();
+
+	Timing::Timer timer;
+	for(Uptr repeatIndex = 0; repeatIndex < numRepeats; ++repeatIndex)
+	{
+		MemoryInputStream inputStream(bytes.data(), bytes.size());
+		for(Uptr valueIndex = 0; valueIndex < values.size(); ++valueIndex)
+		{
+			Value value;
+			Serializer::serialize(inputStream, value);
+			errorUnless(value == values[valueIndex]);
+		}
+	}
+	timer.stop();
+
+	logThroughput((std::string("LEB128 decode ") + description).c_str(),
+				  F64(bytes.size()) * numRepeats,
+				  timer);
+}
+
+int main(int argc, char** argv)
+{
+	// Generate an ASCII string, and a string that mixes mostly-ASCII text with multi-byte code
+	// points, like the names in a C++ module's name section.
+	U32 randomState = 0;
+	std::string asciiString;
+	std::string mixedString;
+	while(asciiString.size() < 1024 * 1024)
+	{
+		asciiString += char('a' + nextRandom(randomState) % 26);
+
+		const U32 random = nextRandom(randomState);
+		if(random % 64 == 0) { Unicode::encodeUTF8CodePoint(0x3b1 + random % 16, mixedString); }
+		else if(random % 64 == 1)
+		{
+			Unicode::encodeUTF8CodePoint(0x4e00 + random % 256, mixedString);
+		}
+		else
+		{
+			mixedString += char('a' + random % 26);
+		}
+	};
+
+	benchmarkUTF8("ASCII", asciiString);
+	benchmarkUTF8("mixed", mixedString);
+
+	// Generate LEB128 values with a distribution of lengths similar to a code section: mostly
+	// small local/function indices and constants, with occasional large values.
+	std::vector<U32> u32Values;
+	std::vector<I32> i32Values;
+	std::vector<I64> i64Values;
+	for(Uptr valueIndex = 0; valueIndex < 1024 * 1024; ++valueIndex)
+	{
+		const U32 random = nextRandom(randomState);
+		const U32 numBits = (random % 8 == 0) ? 24 : (random % 2 == 0) ? 7 : 14;
+		u32Values.push_back(nextRandom(randomState) & ((1u << numBits) - 1));
+		i32Values.push_back(I32(nextRandom(randomState) << 8) >> (32 - numBits));
+		i64Values.push_back(I64(U64(nextRandom(randomState)) << 40) >> (64 - numBits));
+	}
+
+	benchmarkLEB128<VarUInt32Serializer>("varuint32", u32Values);
+	benchmarkLEB128<VarInt32Serializer>("varint32", i32Values);
+	benchmarkLEB128<VarInt64Serializer>("varint64", i64Values);
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include <inttypes.h>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numThrows = 100000
+};
+
+// Functions that throw and catch an exception in a loop: "localThrow" throws within the function
+// that catches it, and "callThrow" calls a function that throws it.
+static const char exceptionWAST[]
+	= "(module\n"
+	  "  (exception_type $e i32)\n"
+	  "  (func $throw (param i32) (throw $e (local.get 0)))\n"
+	  "  (func (export \"localThrow\") (param $n i32) (result i32)\n"
+	  "    (local $sum i32)\n"
+	  "    loop $l\n"
+	  "      try (result i32)\n"
+	  "        local.get $n\n"
+	  "        throw $e\n"
+	  "      catch $e\n"
+	  "      end\n"
+	  "      local.get $sum\n"
+	  "      i32.add\n"
+	  "      local.set $sum\n"
+	  "      local.get $n\n"
+	  "      i32.const 1\n"
+	  "      i32.sub\n"
+	  "      local.tee $n\n"
+	  "      br_if $l\n"
+	  "    end\n"
+	  "    local.get $sum)\n"
+	  "  (func (export \"callThrow\") (param $n i32) (result i32)\n"
+	  "    (local $sum i32)\n"
+	  "    loop $l\n"
+	  "      try (result i32)\n"
+	  "        local.get $n\n"
+	  "        call $throw\n"
+	  "        i32.const 0\n"
+	  "      catch $e\n"
+	  "      end\n"
+	  "      local.get $sum\n"
+	  "      i32.add\n"
+	  "      local.set $sum\n"
+	  "      local.get $n\n"
+	  "      i32.const 1\n"
+	  "      i32.sub\n"
+	  "      local.tee $n\n"
+	  "      br_if $l\n"
+	  "    end\n"
+	  "    local.get $sum))\n";
+
+static void runBenchmark(Context* context, ModuleInstance* moduleInstance, const char* exportName)
+{
+	Function* function = asFunction(getInstanceExport(moduleInstance, exportName));
+
+	Timing::Timer timer;
+	ValueTuple results = invokeFunctionChecked(context, function, {Value{I32(numThrows)}});
+	timer.stop();
+
+	// The sum of 1..numThrows, modulo 2^32.
+	errorUnless(results.size() == 1
+				&& results[0].u32 == U32(U64(numThrows) * (numThrows + 1) / 2));
+
+	Log::printf(Log::output,
+				"ns/throw+catch (%s): %.1f\n",
+				exportName,
+				timer.getNanoseconds() / F64(numThrows));
+}
+
+int main(int argc, char** argv)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(exceptionWAST, sizeof(exceptionWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("exception-bench", parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleRef module = compileModule(irModule);
+	ModuleInstance* moduleInstance = instantiateModule(compartment, module, {}, "exceptionBench");
+	Context* context = createContext(compartment);
+
+	// Measure the latency of throwing and catching an exception within a function, and across a
+	// call.
+	runBenchmark(context, moduleInstance, "localThrow");
+	runBenchmark(context, moduleInstance, "callThrow");
+
+	moduleInstance = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+
+	return 0;
+}
@@ -170,6 +170,24 @@ int main(int argc, char** argv)
 			return 0;
 		});
 
+	// Benchmark entering and leaving catchRuntimeExceptions, which guards host-to-wasm calls.
+	runBenchmarkSingleAndMultiThreaded(
+		compartment, nopFunction, "catchRuntimeExceptions", [](void* argument) -> I64 {
+			ThreadArgs* threadArgs = (ThreadArgs*)argument;
+
+			Timing::Timer timer;
+			for(Uptr repeatIndex = 0; repeatIndex < numInvokesPerThread; ++repeatIndex)
+			{
+				catchRuntimeExceptions([] {},
+									   [](Exception* exception) { destroyException(exception); });
+			}
+			timer.stop();
+
+			threadArgs->elapsedNanoseconds = timer.getNanoseconds();
+
+			return 0;
+		});
+
 	// Free the compartment.
 	errorUnless(tryCollectCompartment(std::move(compartment)));
 
@@ -0,0 +1,238 @@
+#include <inttypes.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Operators.h"
+#include "WAVM/IR/Types.h"
+#include "WAVM/IR/Validate.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/CLI.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Serialization.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/WASM/WASM.h"
+#include "WAVM/WASTParse/TestScript.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+
+enum
+{
+	numFunctions = 1024,
+	numBlocksPerFunction = 64,
+	numDecodeRepeats = 20
+};
+
+// Generates a module with functions that use a typical mix of operators: local variable accesses,
+// constants, arithmetic, loads and stores, branches, and calls.
+static void generateModule(IR::Module& irModule, Uptr& outNumOps)
+{
+	irModule.types.push_back(FunctionType());
+	irModule.memories.defs.push_back({MemoryType(false, SizeConstraints{1, 1})});
+
+	outNumOps = 0;
+	for(Uptr functionIndex = 0; functionIndex < numFunctions; ++functionIndex)
+	{
+		Serialization::ArrayOutputStream codeStream;
+		OperatorEncoderStream encoder(codeStream);
+		for(Uptr blockIndex = 0; blockIndex < numBlocksPerFunction; ++blockIndex)
+		{
+			encoder.local_get({0});
+			encoder.i32_const({I32(blockIndex * 37)});
+			encoder.i32_add();
+			encoder.local_set({1});
+			encoder.local_get({1});
+			encoder.i32_load({2, U32(blockIndex * 4)});
+			encoder.local_set({0});
+			encoder.local_get({0});
+			encoder.local_get({1});
+			encoder.i32_store({2, 8});
+			encoder.block({{IndexedBlockType::noParametersOrResult, {}}});
+			encoder.local_get({1});
+			encoder.br_if({0});
+			encoder.end();
+			encoder.f64_const({1.5});
+			encoder.drop();
+			encoder.call({(functionIndex + blockIndex) % numFunctions});
+			outNumOps += 17;
+		}
+		encoder.end();
+		++outNumOps;
+
+		irModule.functions.defs.push_back(
+			{{0}, {ValueType::i32, ValueType::i32}, codeStream.getBytes(), {}});
+	}
+	IR::validatePreCodeSections(irModule);
+	IR::validatePostCodeSections(irModule);
+}
+
+// Passes decoded operators to a CodeValidationStream.
+struct ValidatingVisitor
+{
+	typedef void Result;
+
+	CodeValidationStream& validationStream;
+
+#define VISIT_OPCODE(_, name, nameString, Imm, ...)                                                \
+	void name(Imm imm) { validationStream.name(imm); }
+	WAVM_ENUM_OPERATORS(VISIT_OPCODE)
+#undef VISIT_OPCODE
+};
+
+// Counts decoded operators.
+struct CountingVisitor
+{
+	typedef void Result;
+
+	Uptr numOps = 0;
+
+#define VISIT_OPCODE(_, name, nameString, Imm, ...)                                                \
+	void name(Imm imm) { ++numOps; }
+	WAVM_ENUM_OPERATORS(VISIT_OPCODE)
+#undef VISIT_OPCODE
+};
+
+struct Footprint
+{
+	Uptr numModules = 0;
+	Uptr numOps = 0;
+	Uptr numIRCodeBytes = 0;
+	Uptr numWASMBytes = 0;
+};
+
+// Adds the IR code footprint of a module to a Footprint. The module is serialized to WASM and
+// loaded back, so its IR code is encoded by the WASM decoder.
+static void addModuleFootprint(const IR::Module& module, Footprint& footprint)
+{
+	Serialization::ArrayOutputStream moduleStream;
+	WASM::serialize(moduleStream, module);
+	const std::vector<U8> moduleBytes = moduleStream.getBytes();
+
+	IR::Module irModule;
+	errorUnless(WASM::loadBinaryModule(moduleBytes.data(), moduleBytes.size(), irModule));
+
+	++footprint.numModules;
+	footprint.numWASMBytes += moduleBytes.size();
+	for(const FunctionDef& functionDef : irModule.functions.defs)
+	{
+		footprint.numIRCodeBytes += functionDef.code.size();
+
+		CountingVisitor visitor;
+		OperatorDecoderStream decoder(functionDef.code);
+		while(decoder) { decoder.decodeOp(visitor); };
+		footprint.numOps += visitor.numOps;
+	}
+}
+
+// Adds the IR code footprint of the modules in a WASM binary module, or a WAST module or test
+// script (e.g. from the spec test corpus) to a Footprint.
+static bool addFileFootprint(const char* filename, Footprint& footprint)
+{
+	std::vector<U8> fileBytes;
+	if(!loadFile(filename, fileBytes)) { return false; }
+
+	static const U8 wasmMagicNumber[4] = {0x00, 0x61, 0x73, 0x6d};
+	if(fileBytes.size() >= 4 && !memcmp(fileBytes.data(), wasmMagicNumber, 4))
+	{
+		IR::Module irModule;
+		if(!WASM::loadBinaryModule(fileBytes.data(), fileBytes.size(), irModule)) { return false; }
+		addModuleFootprint(irModule, footprint);
+		return true;
+	}
+
+	// Parse the file as a test script, which may also be a single text module.
+	fileBytes.push_back(0);
+	IR::FeatureSpec featureSpec;
+	featureSpec.requireSharedFlagForAtomicOperators = true;
+	std::vector<std::unique_ptr<WAST::Command>> testCommands;
+	std::vector<WAST::Error> parseErrors;
+	WAST::parseTestCommands(
+		(const char*)fileBytes.data(), fileBytes.size(), featureSpec, testCommands, parseErrors);
+	if(parseErrors.size())
+	{
+		WAST::reportParseErrors(filename, parseErrors);
+		return false;
+	}
+
+	for(const std::unique_ptr<WAST::Command>& command : testCommands)
+	{
+		if(command->type != WAST::Command::action) { continue; }
+		const WAST::Action* action = ((WAST::ActionCommand*)command.get())->action.get();
+		if(action && action->type == WAST::ActionType::_module)
+		{ addModuleFootprint(*((WAST::ModuleAction*)action)->module, footprint); }
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	// If files are passed on the command-line, report the IR code footprint of the modules they
+	// contain instead of running the benchmark.
+	if(argc > 1)
+	{
+		Footprint footprint;
+		for(int argIndex = 1; argIndex < argc; ++argIndex)
+		{
+			if(!addFileFootprint(argv[argIndex], footprint)) { return EXIT_FAILURE; }
+		}
+
+		Log::printf(Log::output,
+					"Modules: %" PRIuPTR ", operators: %" PRIuPTR "\n",
+					footprint.numModules,
+					footprint.numOps);
+		Log::printf(Log::output,
+					"IR code size: %" PRIuPTR " bytes (%.2f bytes/op)\n",
+					footprint.numIRCodeBytes,
+					F64(footprint.numIRCodeBytes) / F64(footprint.numOps));
+		Log::printf(Log::output, "WASM module size: %" PRIuPTR " bytes\n", footprint.numWASMBytes);
+		return EXIT_SUCCESS;
+	}
+
+	IR::Module generatedModule;
+	Uptr numOps = 0;
+	generateModule(generatedModule, numOps);
+
+	Serialization::ArrayOutputStream moduleStream;
+	WASM::serialize(moduleStream, generatedModule);
+	const std::vector<U8> moduleBytes = moduleStream.getBytes();
+
+	// Load the module from WASM, so the IR code is encoded by the WASM decoder.
+	IR::Module irModule;
+	errorUnless(WASM::loadBinaryModule(moduleBytes.data(), moduleBytes.size(), irModule));
+
+	Uptr numCodeBytes = 0;
+	for(const FunctionDef& functionDef : irModule.functions.defs)
+	{ numCodeBytes += functionDef.code.size(); }
+
+	Log::printf(Log::output,
+				"IR code size: %" PRIuPTR " bytes (%.2f bytes/op)\n",
+				numCodeBytes,
+				F64(numCodeBytes) / F64(numOps));
+	Log::printf(Log::output, "WASM module size: %" PRIuPTR " bytes\n", moduleBytes.size());
+
+	// Measure how long it takes to decode the IR code, using the validator as a typical consumer of
+	// the decoded operators.
+	Timing::Timer timer;
+	for(Uptr repeatIndex = 0; repeatIndex < numDecodeRepeats; ++repeatIndex)
+	{
+		for(const FunctionDef& functionDef : irModule.functions.defs)
+		{
+			CodeValidationStream validationStream(irModule, functionDef);
+			ValidatingVisitor visitor{validationStream};
+			OperatorDecoderStream decoder(functionDef.code);
+			while(decoder) { decoder.decodeOp(visitor); };
+			validationStream.finish();
+		}
+	}
+	timer.stop();
+
+	Log::printf(Log::output,
+				"ns/IR operator decode+validate: %.2f\n",
+				timer.getNanoseconds() / F64(numOps * numDecodeRepeats));
+
+	return 0;
+}
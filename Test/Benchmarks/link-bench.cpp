@@ -0,0 +1,110 @@
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Linker.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numImports = 100,
+	numLinks = 100000
+};
+
+// Resolves imports from a single host module by name, like the resolvers used to link a guest
+// module against per-process host modules.
+struct HostResolver : Resolver
+{
+	ModuleInstance* hostModuleInstance;
+
+	HostResolver(ModuleInstance* inHostModuleInstance) : hostModuleInstance(inHostModuleInstance) {}
+
+	bool resolve(const std::string& moduleName,
+				 const std::string& exportName,
+				 IR::ExternType type,
+				 Object*& outObject) override
+	{
+		if(moduleName != "host") { return false; }
+		outObject = getInstanceExport(hostModuleInstance, exportName);
+		return outObject && isA(outObject, type);
+	}
+};
+
+static void parseModule(const std::string& wast, IR::Module& outModule)
+{
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(wast.c_str(), wast.size() + 1, outModule, parseErrors))
+	{
+		WAST::reportParseErrors("link-bench", parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Generate a host module that exports numImports functions, and a module that imports them.
+	std::string hostWAST = "(module\n";
+	std::string guestWAST = "(module\n";
+	for(Uptr importIndex = 0; importIndex < numImports; ++importIndex)
+	{
+		const std::string name = "\"f" + std::to_string(importIndex) + "\"";
+		hostWAST += "  (func (export " + name + ") (param i32) (result i32) (local.get 0))\n";
+		guestWAST += "  (import \"host\" " + name + " (func (param i32) (result i32)))\n";
+	}
+	hostWAST += ")";
+	guestWAST += ")";
+
+	IR::Module hostIRModule;
+	IR::Module guestIRModule;
+	parseModule(hostWAST, hostIRModule);
+	parseModule(guestWAST, guestIRModule);
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleInstance* hostModuleInstance
+		= instantiateModule(compartment, compileModule(hostIRModule), {}, "host");
+	HostResolver resolver(hostModuleInstance);
+
+	// Measure linking the guest module by resolving its imports.
+	Timing::Timer resolveTimer;
+	for(Uptr linkIndex = 0; linkIndex < numLinks; ++linkIndex)
+	{
+		LinkResult linkResult = linkModule(guestIRModule, resolver);
+		errorUnless(linkResult.success && linkResult.resolvedImports.size() == numImports);
+	}
+	resolveTimer.stop();
+
+	// Measure linking the guest module with a link plan.
+	const std::vector<ModuleInstance*> hostModuleInstances = {hostModuleInstance};
+	LinkPlan linkPlan = createLinkPlan(guestIRModule, resolver, hostModuleInstances);
+	errorUnless(linkPlan.success);
+
+	Timing::Timer planTimer;
+	for(Uptr linkIndex = 0; linkIndex < numLinks; ++linkIndex)
+	{
+		LinkResult linkResult = linkModule(linkPlan, hostModuleInstances);
+		errorUnless(linkResult.success && linkResult.resolvedImports.size() == numImports);
+	}
+	planTimer.stop();
+
+	Log::printf(Log::output,
+				"ns/link with resolver: %.0f\n",
+				resolveTimer.getNanoseconds() / F64(numLinks));
+	Log::printf(Log::output,
+				"ns/link with link plan: %.0f\n",
+				planTimer.getNanoseconds() / F64(numLinks));
+
+	hostModuleInstance = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+
+	return 0;
+}
@@ -0,0 +1,219 @@
+#include <inttypes.h>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/Runtime/RuntimeData.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numSequentialLoopIterations = 100000000,
+	numRandomLoopIterations = 20000000
+};
+
+// A loop that sums three loads per iteration. The loads are from the same local with decreasing
+// offsets, so with explicit bounds checks only the first load of each iteration is checked.
+static const char sequentialLoadsWAST[]
+	= "(module\n"
+	  "  (memory (export \"memory\") 1 16)\n"
+	  "  (func (export \"loads\") (param $n i32) (result i32)\n"
+	  "    (local $i i32) (local $address i32) (local $sum i32)\n"
+	  "    (loop $loop\n"
+	  "      (local.set $address (i32.and (i32.shl (local.get $i) (i32.const 4))\n"
+	  "                                   (i32.const 0xfff0)))\n"
+	  "      (local.set $sum (i32.add (local.get $sum)\n"
+	  "                               (i32.load offset=8 (local.get $address))))\n"
+	  "      (local.set $sum (i32.add (local.get $sum)\n"
+	  "                               (i32.load offset=4 (local.get $address))))\n"
+	  "      (local.set $sum (i32.add (local.get $sum) (i32.load (local.get $address))))\n"
+	  "      (local.set $i (i32.add (local.get $i) (i32.const 1)))\n"
+	  "      (br_if $loop (i32.lt_u (local.get $i) (local.get $n))))\n"
+	  "    (local.get $sum)))\n";
+
+// A loop that loads from pseudo-random addresses in a 1GB memory, so most loads miss the TLB.
+static const char randomLoadsWAST[]
+	= "(module\n"
+	  "  (memory (export \"memory\") 16384 16384)\n"
+	  "  (func (export \"loads\") (param $n i32) (result i32)\n"
+	  "    (local $i i32) (local $random i32) (local $sum i32)\n"
+	  "    (loop $loop\n"
+	  "      (local.set $random (i32.add (i32.mul (local.get $random) (i32.const 1664525))\n"
+	  "                                  (i32.const 1013904223)))\n"
+	  "      (local.set $sum (i32.add (local.get $sum)\n"
+	  "                               (i32.load (i32.and (local.get $random)\n"
+	  "                                                  (i32.const 0x3ffffffc)))))\n"
+	  "      (local.set $i (i32.add (local.get $i) (i32.const 1)))\n"
+	  "      (br_if $loop (i32.lt_u (local.get $i) (local.get $n))))\n"
+	  "    (local.get $sum)))\n";
+
+// Counts the data TLB misses of the calling thread, if the OS exposes a counter for them.
+struct TLBMissCounter
+{
+	TLBMissCounter()
+	{
+#ifdef __linux__
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+					  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~TLBMissCounter()
+	{
+#ifdef __linux__
+		if(fd >= 0) { close(fd); }
+#endif
+	}
+
+	void start()
+	{
+#ifdef __linux__
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// Stops counting, and returns false if the counter isn't available.
+	bool stop(U64& outNumMisses)
+	{
+#ifdef __linux__
+		if(fd < 0) { return false; }
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		return read(fd, &outNumMisses, sizeof(outNumMisses)) == sizeof(outNumMisses);
+#else
+		return false;
+#endif
+	}
+
+private:
+	int fd = -1;
+};
+
+static void runBenchmark(const char* wast,
+						 Uptr wastNumChars,
+						 Uptr numIterations,
+						 Uptr numLoadsPerIteration,
+						 MemoryBoundsCheckMode boundsCheckMode,
+						 bool enableHugePages,
+						 const char* description)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(wast, wastNumChars, irModule, parseErrors))
+	{
+		WAST::reportParseErrors(description, parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+
+	setHugePagesEnabled(enableHugePages);
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleRef module = compileModule(irModule, boundsCheckMode);
+	ModuleInstance* moduleInstance = instantiateModule(compartment, module, {}, "memoryBench");
+	Function* loadsFunction = asFunction(getInstanceExport(moduleInstance, "loads"));
+	Memory* memory = asMemory(getInstanceExport(moduleInstance, "memory"));
+	Context* context = createContext(compartment);
+
+	// Report the address space reserved for each memory, and how many such memories fit in a
+	// 47-bit user address space.
+	const Uptr numReservedBytes = getMemoryNumReservedBytes(memory);
+	Log::printf(Log::output,
+				"%s memory slot size: %" PRIuPTR " KiB (%" PRIu64 " memories per 128 TiB)\n",
+				description,
+				numReservedBytes / 1024,
+				(U64(1) << 47) / U64(numReservedBytes));
+
+	// Run the loop once to fault in the memory's pages, then time it and report the cost per load.
+	invokeFunctionChecked(context, loadsFunction, {Value{I32(numIterations)}});
+
+	TLBMissCounter tlbMissCounter;
+	Timing::Timer timer;
+	tlbMissCounter.start();
+	invokeFunctionChecked(context, loadsFunction, {Value{I32(numIterations)}});
+	U64 numTLBMisses = 0;
+	const bool hasTLBMisses = tlbMissCounter.stop(numTLBMisses);
+	timer.stop();
+
+	const F64 numLoads = F64(numIterations * numLoadsPerIteration);
+	Log::printf(
+		Log::output, "%s ns/load: %.3f\n", description, timer.getNanoseconds() / numLoads);
+	if(hasTLBMisses)
+	{
+		Log::printf(Log::output,
+					"%s dTLB misses/load: %.3f\n",
+					description,
+					F64(numTLBMisses) / numLoads);
+	}
+	else
+	{
+		Log::printf(Log::output, "%s dTLB misses/load: unavailable\n", description);
+	}
+
+	moduleInstance = nullptr;
+	loadsFunction = nullptr;
+	memory = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+int main(int argc, char** argv)
+{
+	// Measure the cost of explicit bounds checks.
+	runBenchmark(sequentialLoadsWAST,
+				 sizeof(sequentialLoadsWAST),
+				 numSequentialLoopIterations,
+				 3,
+				 MemoryBoundsCheckMode::guardRegion,
+				 false,
+				 "guard region");
+	runBenchmark(sequentialLoadsWAST,
+				 sizeof(sequentialLoadsWAST),
+				 numSequentialLoopIterations,
+				 3,
+				 MemoryBoundsCheckMode::explicitChecks,
+				 false,
+				 "explicit checks");
+
+	// Measure the effect of huge pages on random accesses to a large memory.
+	runBenchmark(randomLoadsWAST,
+				 sizeof(randomLoadsWAST),
+				 numRandomLoopIterations,
+				 1,
+				 MemoryBoundsCheckMode::guardRegion,
+				 false,
+				 "random loads, small pages");
+	runBenchmark(randomLoadsWAST,
+				 sizeof(randomLoadsWAST),
+				 numRandomLoopIterations,
+				 1,
+				 MemoryBoundsCheckMode::guardRegion,
+				 true,
+				 "random loads, huge pages");
+
+	return 0;
+}
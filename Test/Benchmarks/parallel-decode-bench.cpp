@@ -0,0 +1,194 @@
+#include <inttypes.h>
+#include <string.h>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Operators.h"
+#include "WAVM/IR/Types.h"
+#include "WAVM/IR/Validate.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Serialization.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/Thread.h"
+#include "WAVM/WASM/WASM.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+
+enum
+{
+	numTypes = 2048,
+	numDistinctTypes = 256,
+	numFunctions = 2048,
+	numCallsPerFunction = 8,
+	numDecodesPerThread = 20,
+	numInternsPerThread = 1000000
+};
+
+static const ValueType valueTypes[4]
+	= {ValueType::i32, ValueType::i64, ValueType::f32, ValueType::f64};
+
+static FunctionType makeFunctionType(Uptr typeIndex)
+{
+	// Derive a signature from the bits of the type index, so the module's type section contains
+	// each of numDistinctTypes signatures several times, as a module linked from many objects
+	// would.
+	const Uptr distinctTypeIndex = typeIndex % numDistinctTypes;
+	std::vector<ValueType> params;
+	for(Uptr paramIndex = 0; paramIndex < 1 + distinctTypeIndex % 4; ++paramIndex)
+	{ params.push_back(valueTypes[(distinctTypeIndex >> (paramIndex * 2)) & 3]); }
+	std::vector<ValueType> results;
+	if(distinctTypeIndex & 128) { results.push_back(valueTypes[distinctTypeIndex & 3]); }
+	return FunctionType(TypeTuple(results), TypeTuple(params));
+}
+
+static void encodeZero(OperatorEncoderStream& encoder, ValueType type)
+{
+	switch(type)
+	{
+	case ValueType::i32: encoder.i32_const({0}); break;
+	case ValueType::i64: encoder.i64_const({0}); break;
+	case ValueType::f32: encoder.f32_const({0.0f}); break;
+	case ValueType::f64: encoder.f64_const({0.0}); break;
+
+	// makeFunctionType only uses the number types.
+	case ValueType::none:
+	case ValueType::any:
+	case ValueType::v128:
+	case ValueType::anyref:
+	case ValueType::funcref:
+	case ValueType::nullref:
+	default: WAVM_UNREACHABLE();
+	};
+}
+
+// Generates a module with many function types, and functions that call each other.
+static std::vector<U8> generateModule()
+{
+	IR::Module irModule;
+	for(Uptr typeIndex = 0; typeIndex < numTypes; ++typeIndex)
+	{ irModule.types.push_back(makeFunctionType(typeIndex)); }
+
+	for(Uptr functionIndex = 0; functionIndex < numFunctions; ++functionIndex)
+	{
+		const Uptr typeIndex = functionIndex % numTypes;
+		Serialization::ArrayOutputStream codeStream;
+		OperatorEncoderStream encoder(codeStream);
+		for(Uptr callIndex = 0; callIndex < numCallsPerFunction; ++callIndex)
+		{
+			const Uptr calleeIndex = (functionIndex * 7 + callIndex * 13) % numFunctions;
+			const FunctionType calleeType = irModule.types[calleeIndex % numTypes];
+			for(ValueType param : calleeType.params()) { encodeZero(encoder, param); }
+			encoder.call({calleeIndex});
+			for(Uptr resultIndex = 0; resultIndex < calleeType.results().size(); ++resultIndex)
+			{ encoder.drop(); }
+		}
+		for(ValueType result : irModule.types[typeIndex].results()) { encodeZero(encoder, result); }
+		encoder.end();
+
+		irModule.functions.defs.push_back({{typeIndex}, {}, codeStream.getBytes(), {}});
+	}
+	IR::validatePreCodeSections(irModule);
+	IR::validatePostCodeSections(irModule);
+
+	Serialization::ArrayOutputStream moduleStream;
+	WASM::serialize(moduleStream, irModule);
+	return moduleStream.getBytes();
+}
+
+struct ThreadArgs
+{
+	const std::vector<U8>* moduleBytes = nullptr;
+	F64 elapsedNanoseconds = 0;
+	Platform::Thread* thread = nullptr;
+};
+
+static void runBenchmark(const std::vector<U8>& moduleBytes,
+						 Uptr numThreads,
+						 const char* description,
+						 Uptr numOpsPerThread,
+						 I64 (*threadFunc)(void*))
+{
+	std::vector<ThreadArgs*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		ThreadArgs* threadArgs = new ThreadArgs;
+		threadArgs->moduleBytes = &moduleBytes;
+		threadArgs->thread = Platform::createThread(512 * 1024, threadFunc, threadArgs);
+		threads.push_back(threadArgs);
+	}
+
+	// Wait for the threads to exit, and sum the time taken by each thread.
+	F64 totalElapsedNanoseconds = 0;
+	for(ThreadArgs* threadArgs : threads)
+	{
+		Platform::joinThread(threadArgs->thread);
+		totalElapsedNanoseconds += threadArgs->elapsedNanoseconds;
+		delete threadArgs;
+	}
+
+	const F64 nanosecondsPerOp = totalElapsedNanoseconds / F64(numOpsPerThread * numThreads);
+	Log::printf(Log::output,
+				"ns/%s in %" PRIuPTR " threads: %.2f\n",
+				description,
+				numThreads,
+				nanosecondsPerOp);
+}
+
+static void runBenchmarkSingleAndMultiThreaded(const std::vector<U8>& moduleBytes,
+											   const char* description,
+											   Uptr numOpsPerThread,
+											   I64 (*threadFunc)(void*))
+{
+	const Uptr numHardwareThreads = Platform::getNumberOfHardwareThreads();
+	runBenchmark(moduleBytes, 1, description, numOpsPerThread, threadFunc);
+	runBenchmark(moduleBytes, numHardwareThreads, description, numOpsPerThread, threadFunc);
+}
+
+int main(int argc, char** argv)
+{
+	const std::vector<U8> moduleBytes = generateModule();
+
+	// Benchmark decoding and validating the module.
+	runBenchmarkSingleAndMultiThreaded(
+		moduleBytes, "module decode", numDecodesPerThread, [](void* argument) -> I64 {
+			ThreadArgs* threadArgs = (ThreadArgs*)argument;
+
+			Timing::Timer timer;
+			for(Uptr repeatIndex = 0; repeatIndex < numDecodesPerThread; ++repeatIndex)
+			{
+				IR::Module irModule;
+				errorUnless(WASM::loadBinaryModule(
+					threadArgs->moduleBytes->data(), threadArgs->moduleBytes->size(), irModule));
+			}
+			timer.stop();
+
+			threadArgs->elapsedNanoseconds = timer.getNanoseconds();
+			return 0;
+		});
+
+	// Benchmark interning function types that already exist, like the FunctionType temporaries
+	// created while compiling a module.
+	runBenchmarkSingleAndMultiThreaded(
+		moduleBytes, "FunctionType intern", numInternsPerThread, [](void* argument) -> I64 {
+			ThreadArgs* threadArgs = (ThreadArgs*)argument;
+
+			Timing::Timer timer;
+			for(Uptr repeatIndex = 0; repeatIndex < numInternsPerThread; ++repeatIndex)
+			{
+				const ValueType resultType = valueTypes[repeatIndex & 3];
+				const ValueType paramType = valueTypes[(repeatIndex >> 2) & 3];
+				FunctionType functionType{TypeTuple{resultType},
+										  TypeTuple{ValueType::i32, paramType}};
+				errorUnless(functionType.params().size() == 2);
+			}
+			timer.stop();
+
+			threadArgs->elapsedNanoseconds = timer.getNanoseconds();
+			return 0;
+		});
+
+	return 0;
+}
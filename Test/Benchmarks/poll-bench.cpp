@@ -0,0 +1,216 @@
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/Clock.h"
+#include "WAVM/Platform/File.h"
+#include "WAVM/Platform/Thread.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::Platform;
+using namespace WAVM::VFS;
+
+enum
+{
+	numPingPongs = 100000,
+	numTimedWaits = 1000,
+	numIdleWaits = 10,
+	timedWaitNanoseconds = 1000000,
+	idleWaitNanoseconds = 100000000,
+};
+
+// A VFD for one end of a host pipe, which stands in for a socket connected to another process.
+struct PipeVFD : VFD
+{
+	PipeVFD(I32 inFD) : fd(inFD) {}
+
+	virtual Result close() override
+	{
+		::close(fd);
+		delete this;
+		return Result::success;
+	}
+
+	virtual Result seek(I64, SeekOrigin, U64*) override { return Result::notSeekable; }
+	virtual Result readv(const IOReadBuffer* buffers,
+						 Uptr numBuffers,
+						 Uptr* outNumBytesRead,
+						 const U64* offset) override
+	{
+		errorUnless(numBuffers == 1 && !offset);
+		const ssize_t result = ::read(fd, buffers[0].data, buffers[0].numBytes);
+		errorUnless(result >= 0);
+		if(outNumBytesRead) { *outNumBytesRead = Uptr(result); }
+		return Result::success;
+	}
+	virtual Result writev(const IOWriteBuffer* buffers,
+						  Uptr numBuffers,
+						  Uptr* outNumBytesWritten,
+						  const U64* offset) override
+	{
+		errorUnless(numBuffers == 1 && !offset);
+		const ssize_t result = ::write(fd, buffers[0].data, buffers[0].numBytes);
+		errorUnless(result >= 0);
+		if(outNumBytesWritten) { *outNumBytesWritten = Uptr(result); }
+		return Result::success;
+	}
+
+	virtual Result sync(SyncType) override { return Result::notSynchronizable; }
+	virtual Result getVFDInfo(VFDInfo&) override { return Result::notPermitted; }
+	virtual Result getFileInfo(FileInfo&) override { return Result::notPermitted; }
+	virtual Result setVFDFlags(const VFDFlags&) override { return Result::notPermitted; }
+	virtual Result setFileSize(U64) override { return Result::notPermitted; }
+	virtual Result setFileTimes(bool, I128, bool, I128) override { return Result::notPermitted; }
+	virtual Result openDir(DirEntStream*&) override { return Result::isNotDirectory; }
+
+	virtual I32 getPollableHostFD() override { return fd; }
+
+private:
+	const I32 fd;
+};
+
+static void createPipe(VFD*& outReadVFD, VFD*& outWriteVFD)
+{
+	int fds[2];
+	errorUnless(!pipe(fds));
+	outReadVFD = new PipeVFD(fds[0]);
+	outWriteVFD = new PipeVFD(fds[1]);
+}
+
+// Waits for a byte to be readable from the VFD, then reads it.
+static void waitAndRead(Poller* poller, VFD* vfd)
+{
+	PollSubscription subscription{vfd, PollEventType::read};
+	PollEvent event;
+	errorUnless(poller->wait(&subscription, 1, I128::nan(), &event) == Result::success);
+	errorUnless(event.isReady && event.numBytes == 1);
+
+	U8 byte;
+	Uptr numBytesRead = 0;
+	errorUnless(vfd->read(&byte, 1, &numBytesRead) == Result::success && numBytesRead == 1);
+}
+
+struct EchoThreadArgs
+{
+	VFD* pingReadVFD;
+	VFD* pongWriteVFD;
+};
+
+// Echoes each byte written to the ping pipe back through the pong pipe.
+static I64 echoThreadFunc(void* argument)
+{
+	EchoThreadArgs* args = (EchoThreadArgs*)argument;
+	Poller* poller = createPoller();
+	for(Uptr pingPongIndex = 0; pingPongIndex < numPingPongs; ++pingPongIndex)
+	{
+		waitAndRead(poller, args->pingReadVFD);
+		const U8 byte = 0;
+		errorUnless(args->pongWriteVFD->write(&byte, 1) == Result::success);
+	}
+	delete poller;
+	return 0;
+}
+
+// Measures the time for a thread blocked in Poller::wait to wake up after its pipe is written.
+static void benchmarkWakeupLatency()
+{
+	EchoThreadArgs args;
+	VFD* pingWriteVFD;
+	VFD* pongReadVFD;
+	createPipe(args.pingReadVFD, pingWriteVFD);
+	createPipe(pongReadVFD, args.pongWriteVFD);
+
+	Thread* echoThread = createThread(512 * 1024, echoThreadFunc, &args);
+
+	Poller* poller = createPoller();
+	Timing::Timer timer;
+	for(Uptr pingPongIndex = 0; pingPongIndex < numPingPongs; ++pingPongIndex)
+	{
+		const U8 byte = 0;
+		errorUnless(pingWriteVFD->write(&byte, 1) == Result::success);
+		waitAndRead(poller, pongReadVFD);
+	}
+	timer.stop();
+	delete poller;
+
+	joinThread(echoThread);
+	errorUnless(pingWriteVFD->close() == Result::success);
+	errorUnless(pongReadVFD->close() == Result::success);
+	errorUnless(args.pingReadVFD->close() == Result::success);
+	errorUnless(args.pongWriteVFD->close() == Result::success);
+
+	// Each round trip includes two wakeups.
+	Log::printf(Log::output,
+				"pipe wakeup latency: %.2f us\n",
+				timer.getMicroseconds() / F64(numPingPongs * 2));
+}
+
+// Measures how late a wait with a deadline and no ready VFDs returns.
+static void benchmarkTimerLatency()
+{
+	VFD* readVFD;
+	VFD* writeVFD;
+	createPipe(readVFD, writeVFD);
+
+	Poller* poller = createPoller();
+	I128 totalLateness = 0;
+	for(Uptr waitIndex = 0; waitIndex < numTimedWaits; ++waitIndex)
+	{
+		const I128 deadline = getMonotonicClock() + timedWaitNanoseconds;
+		PollSubscription subscription{readVFD, PollEventType::read};
+		PollEvent event;
+		errorUnless(poller->wait(&subscription, 1, deadline, &event) == Result::success);
+		errorUnless(!event.isReady);
+		totalLateness += getMonotonicClock() - deadline;
+	}
+	delete poller;
+
+	errorUnless(readVFD->close() == Result::success);
+	errorUnless(writeVFD->close() == Result::success);
+
+	Log::printf(Log::output,
+				"timer wakeup lateness: %.2f us\n",
+				F64(totalLateness) / 1000.0 / F64(numTimedWaits));
+}
+
+// Measures the CPU time used by a wait on a VFD that never becomes ready.
+static void benchmarkIdleCPU()
+{
+	VFD* readVFD;
+	VFD* writeVFD;
+	createPipe(readVFD, writeVFD);
+
+	Poller* poller = createPoller();
+	const I128 startProcessTime = getProcessClock();
+	Timing::Timer timer;
+	for(Uptr waitIndex = 0; waitIndex < numIdleWaits; ++waitIndex)
+	{
+		PollSubscription subscription{readVFD, PollEventType::read};
+		PollEvent event;
+		const I128 deadline = getMonotonicClock() + idleWaitNanoseconds;
+		errorUnless(poller->wait(&subscription, 1, deadline, &event) == Result::success);
+	}
+	timer.stop();
+	const I128 processTime = getProcessClock() - startProcessTime;
+	delete poller;
+
+	errorUnless(readVFD->close() == Result::success);
+	errorUnless(writeVFD->close() == Result::success);
+
+	Log::printf(Log::output,
+				"idle CPU use: %.4f%%\n",
+				100.0 * F64(processTime) / timer.getNanoseconds());
+}
+
+int main(int argc, char** argv)
+{
+	benchmarkWakeupLatency();
+	benchmarkTimerLatency();
+	benchmarkIdleCPU();
+	return 0;
+}
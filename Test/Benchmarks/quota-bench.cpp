@@ -0,0 +1,96 @@
+#include <inttypes.h>
+#include <vector>
+
+#include "WAVM/IR/Types.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/Thread.h"
+#include "WAVM/Runtime/Runtime.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numGrowsPerThread = 1000000
+};
+
+struct ThreadArgs
+{
+	Table* table = nullptr;
+	F64 elapsedNanoseconds = 0;
+	Platform::Thread* thread = nullptr;
+};
+
+// Grows a table by one element at a time. Tables commit a page of elements at a time, so most
+// grows only allocate from the table's resource quota and initialize the new element.
+static I64 growThreadFunc(void* argument)
+{
+	ThreadArgs* threadArgs = (ThreadArgs*)argument;
+
+	Timing::Timer timer;
+	for(Uptr growIndex = 0; growIndex < numGrowsPerThread; ++growIndex)
+	{ errorUnless(growTable(threadArgs->table, 1)); }
+	timer.stop();
+
+	threadArgs->elapsedNanoseconds = timer.getNanoseconds();
+	return 0;
+}
+
+// Runs threads that each grow their own table, with all the tables sharing a resource quota.
+static void runBenchmark(Uptr numThreads)
+{
+	GCPointer<Compartment> compartment = createCompartment();
+	ResourceQuotaRef resourceQuota = createResourceQuota();
+	setResourceQuotaMaxTableElems(resourceQuota, numGrowsPerThread * numThreads);
+
+	std::vector<ThreadArgs*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		ThreadArgs* threadArgs = new ThreadArgs;
+		threadArgs->table
+			= createTable(compartment,
+						  TableType(ReferenceType::funcref, false, {0, numGrowsPerThread}),
+						  nullptr,
+						  "quotaBench",
+						  resourceQuota);
+		errorUnless(threadArgs->table);
+		threads.push_back(threadArgs);
+	}
+	for(ThreadArgs* threadArgs : threads)
+	{ threadArgs->thread = Platform::createThread(512 * 1024, growThreadFunc, threadArgs); }
+
+	// Wait for the threads to exit, and sum the results from each thread.
+	F64 totalElapsedNanoseconds = 0;
+	for(ThreadArgs* threadArgs : threads)
+	{
+		Platform::joinThread(threadArgs->thread);
+		totalElapsedNanoseconds += threadArgs->elapsedNanoseconds;
+		delete threadArgs;
+	}
+
+	// The quota is exactly exhausted, so one more allocation must fail.
+	errorUnless(getResourceQuotaCurrentTableElems(resourceQuota)
+				== numGrowsPerThread * numThreads);
+	Table* table = createTable(
+		compartment, TableType(ReferenceType::funcref, false, {1, 1}), nullptr, "", resourceQuota);
+	errorUnless(!table);
+
+	Log::printf(Log::output,
+				"ns/table.grow in %" PRIuPTR " threads: %.2f\n",
+				numThreads,
+				totalElapsedNanoseconds / F64(U64(numGrowsPerThread) * numThreads));
+
+	threads.clear();
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+int main(int argc, char** argv)
+{
+	runBenchmark(1);
+	runBenchmark(Platform::getNumberOfHardwareThreads());
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/Random.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+using namespace WAVM;
+
+enum
+{
+	numBytesPerSize = 64 * 1024 * 1024,
+	maxCallsPerSize = 1000000,
+};
+
+// Reads random bytes with a getrandom syscall for each call, like WASI random_get did before
+// Platform::getCryptographicRNG used a generator for each thread.
+static void getRandomSyscall(U8* outRandomBytes, Uptr numBytes)
+{
+#ifdef SYS_getrandom
+	while(numBytes)
+	{
+		const long result = syscall(SYS_getrandom, outRandomBytes, numBytes, 0);
+		errorUnless(result >= 0 || errno == EINTR);
+		if(result > 0)
+		{
+			outRandomBytes += result;
+			numBytes -= result;
+		}
+	};
+#else
+	static const int randomFD = open("/dev/urandom", O_RDONLY);
+	errorUnless(randomFD >= 0 && read(randomFD, outRandomBytes, numBytes) == ssize_t(numBytes));
+#endif
+}
+
+static void benchmark(const char* description,
+					  void (*getRandomBytes)(U8*, Uptr),
+					  Uptr numBytesPerCall)
+{
+	const Uptr numCalls = std::min(Uptr(maxCallsPerSize), numBytesPerSize / numBytesPerCall);
+	std::vector<U8> buffer(numBytesPerCall);
+
+	Timing::Timer timer;
+	for(Uptr callIndex = 0; callIndex < numCalls; ++callIndex)
+	{ getRandomBytes(buffer.data(), numBytesPerCall); }
+	timer.stop();
+
+	Log::printf(Log::output,
+				"%s, %" PRIuPTR " bytes/call: %.1f ns/call, %.1f MB/s\n",
+				description,
+				numBytesPerCall,
+				timer.getNanoseconds() / F64(numCalls),
+				F64(numCalls * numBytesPerCall) / 1000000.0 / timer.getSeconds());
+}
+
+int main(int argc, char** argv)
+{
+	for(Uptr numBytesPerCall : {8, 32, 256, 4096, 65536})
+	{
+		benchmark("getrandom", getRandomSyscall, numBytesPerCall);
+		benchmark("getCryptographicRNG", Platform::getCryptographicRNG, numBytesPerCall);
+	}
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include <inttypes.h>
+#include <atomic>
+#include <vector>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/Thread.h"
+
+using namespace WAVM;
+
+enum
+{
+	numStackBytes = 1024 * 1024,
+	numSerialThreads = 10000,
+	numConcurrentThreads = 1000,
+	numConcurrentRepeats = 10
+};
+
+static std::atomic<Uptr> numThreadsRun{0};
+
+static I64 threadFunc(void* argument)
+{
+	++numThreadsRun;
+	return I64(reinterpret_cast<Uptr>(argument));
+}
+
+int main(int argc, char** argv)
+{
+	// Measure the latency of creating a thread and joining it, like a guest that creates a
+	// short-lived thread for each task.
+	Timing::Timer serialTimer;
+	for(Uptr threadIndex = 0; threadIndex < numSerialThreads; ++threadIndex)
+	{
+		void* argument = reinterpret_cast<void*>(threadIndex);
+		Platform::Thread* thread = Platform::createThread(numStackBytes, threadFunc, argument);
+		errorUnless(Platform::joinThread(thread) == I64(threadIndex));
+	}
+	serialTimer.stop();
+	Log::printf(Log::output,
+				"ns/thread create+join: %.0f\n",
+				serialTimer.getNanoseconds() / F64(numSerialThreads));
+
+	// Measure creating many threads before joining any of them.
+	Timing::Timer concurrentTimer;
+	for(Uptr repeatIndex = 0; repeatIndex < numConcurrentRepeats; ++repeatIndex)
+	{
+		std::vector<Platform::Thread*> threads;
+		for(Uptr threadIndex = 0; threadIndex < numConcurrentThreads; ++threadIndex)
+		{
+			threads.push_back(Platform::createThread(
+				numStackBytes, threadFunc, reinterpret_cast<void*>(threadIndex)));
+		}
+		for(Uptr threadIndex = 0; threadIndex < numConcurrentThreads; ++threadIndex)
+		{ errorUnless(Platform::joinThread(threads[threadIndex]) == I64(threadIndex)); }
+	}
+	concurrentTimer.stop();
+	const Uptr numConcurrentJoins = numConcurrentThreads * numConcurrentRepeats;
+	Log::printf(Log::output,
+				"ns/thread create+join with %u concurrent threads: %.0f\n",
+				U32(numConcurrentThreads),
+				concurrentTimer.getNanoseconds() / F64(numConcurrentJoins));
+
+	errorUnless(numThreadsRun == numSerialThreads + numConcurrentThreads * numConcurrentRepeats);
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include <inttypes.h>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numTraps = 100000
+};
+
+// A function that recurses to the given depth, and then loads from an out-of-bounds address, so
+// the trap is raised by the signal handler with that many wasm frames on the stack.
+static const char trapWAST[]
+	= "(module\n"
+	  "  (memory 1 1)\n"
+	  "  (func $trap (export \"trap\") (param $depth i32) (result i32)\n"
+	  "    (if (result i32) (local.get $depth)\n"
+	  "      (then (i32.add (i32.const 1)\n"
+	  "                     (call $trap (i32.sub (local.get $depth) (i32.const 1)))))\n"
+	  "      (else (i32.load (i32.const 0x10000))))))\n";
+
+static void runBenchmark(Context* context, Function* trapFunction, U32 depth)
+{
+	Uptr numCaughtTraps = 0;
+	Timing::Timer timer;
+	for(Uptr trapIndex = 0; trapIndex < numTraps; ++trapIndex)
+	{
+		catchRuntimeExceptions(
+			[&] { invokeFunctionChecked(context, trapFunction, {Value{I32(depth)}}); },
+			[&](Exception* exception) {
+				++numCaughtTraps;
+				destroyException(exception);
+			});
+	}
+	timer.stop();
+	errorUnless(numCaughtTraps == numTraps);
+
+	Log::printf(Log::output,
+				"ns/trap at depth %u: %.1f\n",
+				depth,
+				timer.getNanoseconds() / F64(numTraps));
+}
+
+int main(int argc, char** argv)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(trapWAST, sizeof(trapWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("trap-bench", parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleRef module = compileModule(irModule);
+	ModuleInstance* moduleInstance = instantiateModule(compartment, module, {}, "trapBench");
+	Function* trapFunction = asFunction(getInstanceExport(moduleInstance, "trap"));
+	Context* context = createContext(compartment);
+
+	// Measure the latency from a trap in wasm code to the runtime exception being caught.
+	runBenchmark(context, trapFunction, 0);
+	runBenchmark(context, trapFunction, 100);
+
+	moduleInstance = nullptr;
+	trapFunction = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+
+	return 0;
+}
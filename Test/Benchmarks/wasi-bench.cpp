@@ -0,0 +1,75 @@
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Logging/Logging.h"
+#include "WAVM/Platform/File.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/VFS/VFS.h"
+#include "WAVM/WASI/WASI.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numWrites = 1000000
+};
+
+// A WASI program that writes 16 bytes to stdout at a time, like a program that logs many short
+// lines. The IOV at address 0 points to the 16 bytes at address 16, and the loop runs numWrites
+// times.
+static const char writeWAST[]
+	= "(module\n"
+	  "  (import \"wasi_unstable\" \"fd_write\"\n"
+	  "    (func $fd_write (param i32 i32 i32 i32) (result i32)))\n"
+	  "  (memory (export \"memory\") 1)\n"
+	  "  (data (i32.const 0) \"\\10\\00\\00\\00\\10\\00\\00\\00\")\n"
+	  "  (data (i32.const 16) \"0123456789abcdef\")\n"
+	  "  (func (export \"_start\")\n"
+	  "    (local $i i32)\n"
+	  "    (loop $loop\n"
+	  "      (drop (call $fd_write (i32.const 1) (i32.const 0) (i32.const 1) (i32.const 32)))\n"
+	  "      (local.set $i (i32.add (local.get $i) (i32.const 1)))\n"
+	  "      (br_if $loop (i32.lt_u (local.get $i) (i32.const 1000000))))))\n";
+
+int main(int argc, char** argv)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(writeWAST, sizeof(writeWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("wasi-bench", parseErrors);
+		Errors::fatal("Failed to parse benchmark module");
+	}
+	ModuleRef module = compileModule(irModule);
+
+	// Send the program's stdout to /dev/null, so the benchmark measures the cost of the WASI
+	// syscall rather than the cost of the output.
+	VFS::VFD* nullFD = nullptr;
+	errorUnless(Platform::getHostFS().open("/dev/null",
+										   VFS::FileAccessMode::writeOnly,
+										   VFS::FileCreateMode::openExisting,
+										   nullFD)
+				== VFS::Result::success);
+
+	I32 exitCode = 0;
+	Timing::Timer timer;
+	errorUnless(WASI::run(module,
+						  {"wasi-bench"},
+						  {},
+						  nullptr,
+						  Platform::getStdFD(Platform::StdDevice::in),
+						  nullFD,
+						  Platform::getStdFD(Platform::StdDevice::err),
+						  exitCode)
+				== WASI::RunResult::success);
+	timer.stop();
+
+	Log::printf(Log::output, "ns/fd_write: %.1f\n", timer.getNanoseconds() / F64(numWrites));
+	return 0;
+}
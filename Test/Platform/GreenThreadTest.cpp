@@ -0,0 +1,354 @@
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "WAVM/Inline/Assert.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Platform/Clock.h"
+#include "WAVM/Platform/Diagnostics.h"
+#include "WAVM/Platform/Event.h"
+#include "WAVM/Platform/Memory.h"
+#include "WAVM/Platform/Signal.h"
+#include "WAVM/Platform/Thread.h"
+
+using namespace WAVM;
+using namespace WAVM::Platform;
+
+static constexpr Uptr greenThreadStackBytes = 256 * 1024;
+
+template<typename Body> static Thread* createGreenThreadWithBody(Body&& body)
+{
+	return createGreenThread(
+		greenThreadStackBytes,
+		[](void* bodyVoid) {
+			std::unique_ptr<Body> body((Body*)bodyVoid);
+			return (*body)();
+		},
+		new Body(std::move(body)));
+}
+
+// Checks that many more green threads than worker threads can run to completion.
+static void testManyGreenThreads()
+{
+	static constexpr Uptr numThreads = 1000;
+
+	std::vector<Thread*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		threads.push_back(createGreenThreadWithBody([threadIndex] { return I64(threadIndex); }));
+	}
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{ errorUnless(joinThread(threads[threadIndex]) == I64(threadIndex)); }
+}
+
+// Checks that two green threads can hand control back and forth through events.
+static void testEventPingPong()
+{
+	static constexpr Uptr numRounds = 10000;
+
+	Event pingEvent;
+	Event pongEvent;
+	std::atomic<Uptr> numPongs{0};
+
+	Thread* ponger = createGreenThreadWithBody([&] {
+		for(Uptr round = 0; round < numRounds; ++round)
+		{
+			errorUnless(pingEvent.wait(I128::nan()));
+			++numPongs;
+			pongEvent.signal();
+		}
+		return I64(0);
+	});
+	Thread* pinger = createGreenThreadWithBody([&] {
+		for(Uptr round = 0; round < numRounds; ++round)
+		{
+			pingEvent.signal();
+			errorUnless(pongEvent.wait(I128::nan()));
+			errorUnless(numPongs.load() == round + 1);
+		}
+		return I64(0);
+	});
+
+	errorUnless(joinThread(pinger) == 0);
+	errorUnless(joinThread(ponger) == 0);
+}
+
+// Checks timed waits on green threads, and signaling a green thread from a host thread.
+static void testTimedWait()
+{
+	Event event;
+	Event readyEvent;
+	Thread* thread = createGreenThreadWithBody([&] {
+		// Nothing signals the event, so the wait should time out.
+		const I128 startTime = getMonotonicClock();
+		errorUnless(!event.wait(1000000));
+		errorUnless(getMonotonicClock() - startTime >= 1000000);
+
+		// A signal that happens before the wait isn't lost.
+		event.signal();
+		errorUnless(event.wait(0));
+
+		// The host thread signals the event after the green thread is ready to wait for it.
+		readyEvent.signal();
+		return I64(event.wait(I128(10) * 1000000000));
+	});
+
+	errorUnless(readyEvent.wait(I128::nan()));
+	event.signal();
+	errorUnless(joinThread(thread) == 1);
+}
+
+// Checks that green threads that yield in a loop all make progress.
+static void testYield()
+{
+	static constexpr Uptr numThreads = 64;
+	static constexpr Uptr numYields = 100;
+
+	std::atomic<Uptr> numIterations{0};
+	std::vector<Thread*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		threads.push_back(createGreenThreadWithBody([&] {
+			for(Uptr yieldIndex = 0; yieldIndex < numYields; ++yieldIndex)
+			{
+				++numIterations;
+				yieldToAnotherThread();
+			}
+			return I64(0);
+		}));
+	}
+	for(Thread* thread : threads) { errorUnless(joinThread(thread) == 0); }
+	errorUnless(numIterations.load() == numThreads * numYields);
+}
+
+// Checks that forking a green thread creates a green thread that continues from the fork.
+static I64 forkEntry(void*)
+{
+	volatile Uptr stackValue = 1;
+	Thread* childThread = forkCurrentThread();
+	if(!childThread)
+	{
+		// The child has its own copy of the stack.
+		stackValue = 2;
+		yieldToAnotherThread();
+		return I64(stackValue);
+	}
+
+	yieldToAnotherThread();
+	errorUnless(stackValue == 1);
+	errorUnless(joinThread(childThread) == 2);
+	return 1;
+}
+
+static void testFork()
+{
+	Thread* thread = createGreenThread(greenThreadStackBytes, forkEntry, nullptr);
+	errorUnless(joinThread(thread) == 1);
+}
+
+// Checks that signals raised by green threads are caught by the green thread's own catchSignals,
+// even if other green threads ran on its worker thread since it called catchSignals.
+struct SignalTestArgs
+{
+	U8* inaccessibleAddress;
+	Signal::Type caughtSignalType = Signal::Type::invalid;
+};
+
+WAVM_FORCENOINLINE static Uptr recurseUntilStackOverflow(volatile U8* lastFrameByte)
+{
+	volatile U8 frameBytes[256];
+	frameBytes[0] = lastFrameByte ? *lastFrameByte : 0;
+	if(frameBytes[0] == 0xff) { return 0; }
+	return recurseUntilStackOverflow(frameBytes) + frameBytes[0];
+}
+
+static I64 signalEntry(void* argsVoid)
+{
+	SignalTestArgs& args = *(SignalTestArgs*)argsVoid;
+	const bool testStackOverflow = !args.inaccessibleAddress;
+	const bool caughtSignal = catchSignals(
+		[](void* argsVoid) {
+			SignalTestArgs& args = *(SignalTestArgs*)argsVoid;
+			for(Uptr yieldIndex = 0; yieldIndex < 10; ++yieldIndex) { yieldToAnotherThread(); }
+			if(args.inaccessibleAddress) { *(volatile U8*)args.inaccessibleAddress = 1; }
+			else
+			{
+				recurseUntilStackOverflow(nullptr);
+			}
+		},
+		[](void* argsVoid, Signal signal, CallStack&&) {
+			SignalTestArgs& args = *(SignalTestArgs*)argsVoid;
+			args.caughtSignalType = signal.type;
+			return true;
+		},
+		&args);
+	errorUnless(caughtSignal);
+	errorUnless(args.caughtSignalType
+				== (testStackOverflow ? Signal::Type::stackOverflow
+									  : Signal::Type::accessViolation));
+	return 0;
+}
+
+static void testSignals()
+{
+	static constexpr Uptr numThreads = 16;
+
+	U8* inaccessibleAddress = allocateVirtualPages(1);
+	errorUnless(inaccessibleAddress);
+
+	std::vector<SignalTestArgs> args(numThreads);
+	std::vector<Thread*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		args[threadIndex].inaccessibleAddress = threadIndex & 1 ? inaccessibleAddress : nullptr;
+		threads.push_back(
+			createGreenThread(greenThreadStackBytes, signalEntry, &args[threadIndex]));
+	}
+	for(Thread* thread : threads) { errorUnless(joinThread(thread) == 0); }
+
+	freeVirtualPages(inaccessibleAddress, 1);
+}
+
+// Checks that a green thread that is woken on a different worker thread while it's inside
+// catchSignals still catches a signal that it raises after the wake: catchSignals must use the
+// thread-local signal state of the worker thread that it returns on, rather than the worker thread it
+// was called on.
+static std::atomic<Uptr> nextWorkerThreadId{1};
+static thread_local Uptr workerThreadId = 0;
+WAVM_FORCENOINLINE static Uptr getWorkerThreadId()
+{
+	if(!workerThreadId) { workerThreadId = nextWorkerThreadId++; }
+	return workerThreadId;
+}
+
+struct CrossWorkerSignalTestArgs
+{
+	U8* inaccessibleAddress;
+	Event wakeEvent;
+	std::atomic<bool> isWaiting{false};
+	std::atomic<bool> isDoneWaiting{false};
+	std::atomic<Uptr> numWakes{0};
+	bool migrated = false;
+	Signal caughtSignal;
+};
+
+static I64 crossWorkerSignalEntry(void* argsVoid)
+{
+	CrossWorkerSignalTestArgs& args = *(CrossWorkerSignalTestArgs*)argsVoid;
+	const bool caughtSignal = catchSignals(
+		[](void* argsVoid) {
+			CrossWorkerSignalTestArgs& args = *(CrossWorkerSignalTestArgs*)argsVoid;
+
+			// Wait until the green thread is resumed on a different worker thread.
+			static constexpr Uptr maxWaits = 100;
+			for(Uptr waitIndex = 0; waitIndex < maxWaits && !args.migrated; ++waitIndex)
+			{
+				const Uptr waitingWorkerThreadId = getWorkerThreadId();
+				args.isWaiting.store(true);
+				errorUnless(args.wakeEvent.wait(I128::nan()));
+				args.migrated = getWorkerThreadId() != waitingWorkerThreadId;
+				++args.numWakes;
+			}
+			args.isDoneWaiting.store(true);
+
+			*(volatile U8*)args.inaccessibleAddress = 1;
+		},
+		[](void* argsVoid, Signal signal, CallStack&&) {
+			CrossWorkerSignalTestArgs& args = *(CrossWorkerSignalTestArgs*)argsVoid;
+			args.caughtSignal = signal;
+			return true;
+		},
+		&args);
+	errorUnless(caughtSignal);
+	errorUnless(args.caughtSignal.type == Signal::Type::accessViolation);
+	errorUnless(args.caughtSignal.accessViolation.address == Uptr(args.inaccessibleAddress));
+	return 0;
+}
+
+static void testCrossWorkerSignal()
+{
+	CrossWorkerSignalTestArgs args;
+	args.inaccessibleAddress = allocateVirtualPages(1);
+	errorUnless(args.inaccessibleAddress);
+
+	Thread* waitingThread = createGreenThread(greenThreadStackBytes, crossWorkerSignalEntry, &args);
+	while(!args.isDoneWaiting.load())
+	{
+		bool isWaiting = true;
+		if(!args.isWaiting.compare_exchange_strong(isWaiting, false))
+		{
+			yieldToAnotherThread();
+			continue;
+		}
+
+		// Wake the waiting green thread from a green thread that then blocks its worker thread
+		// until the woken green thread runs. The woken green thread is added to the blocked worker
+		// thread's ready queue, so it must be resumed by a different worker thread.
+		Thread* wakingThread = createGreenThreadWithBody([&args] {
+			BlockingCallScope blockingCall;
+			const Uptr numWakes = args.numWakes.load();
+			args.wakeEvent.signal();
+			while(args.numWakes.load() == numWakes) {};
+			return I64(0);
+		});
+		errorUnless(joinThread(wakingThread) == 0);
+	}
+	errorUnless(joinThread(waitingThread) == 0);
+	errorUnless(args.migrated);
+
+	freeVirtualPages(args.inaccessibleAddress, 1);
+}
+
+// Checks that green threads still run while every worker thread is blocked: each of the blocked
+// green threads joins a host thread that waits for an event that is only signaled by a green thread
+// created after them.
+static void testBlockingCalls()
+{
+	const Uptr numBlockedThreads = getNumberOfHardwareThreads() + 1;
+
+	std::vector<std::unique_ptr<Event>> releaseEvents;
+	std::vector<Thread*> blockedThreads;
+	for(Uptr threadIndex = 0; threadIndex < numBlockedThreads; ++threadIndex)
+	{
+		releaseEvents.emplace_back(new Event);
+		Event* releaseEvent = releaseEvents.back().get();
+		blockedThreads.push_back(createGreenThreadWithBody([releaseEvent] {
+			Thread* hostThread = createThread(
+				greenThreadStackBytes,
+				[](void* releaseEventVoid) {
+					errorUnless(((Event*)releaseEventVoid)->wait(I128::nan()));
+					return I64(0);
+				},
+				releaseEvent);
+			return joinThread(hostThread);
+		}));
+	}
+
+	Thread* releasingThread = createGreenThreadWithBody([&] {
+		for(auto& releaseEvent : releaseEvents) { releaseEvent->signal(); }
+		return I64(0);
+	});
+
+	errorUnless(joinThread(releasingThread) == 0);
+	for(Thread* thread : blockedThreads) { errorUnless(joinThread(thread) == 0); }
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	testManyGreenThreads();
+	testEventPingPong();
+	testTimedWait();
+	testYield();
+	testFork();
+	testSignals();
+	testCrossWorkerSignal();
+	testBlockingCalls();
+
+	Timing::logTimer("GreenThreadTest", timer);
+	return 0;
+}
@@ -43,6 +43,7 @@ struct Config
 	bool strictAssertInvalid{false};
 	bool strictAssertMalformed{false};
 	bool testCloning{false};
+	MemoryBoundsCheckMode boundsCheckMode{MemoryBoundsCheckMode::guardRegion};
 };
 
 struct TestScriptState
@@ -278,7 +279,8 @@ static bool processAction(TestScriptState& state, Action* action, IR::ValueTuple
 		{
 			state.hasInstantiatedModule = true;
 			state.lastModuleInstance = instantiateModule(state.compartment,
-														 compileModule(*moduleAction->module),
+														 compileModule(*moduleAction->module,
+																   state.config.boundsCheckMode),
 														 std::move(linkResult.resolvedImports),
 														 "test module");
 
@@ -621,7 +623,8 @@ static void processCommand(TestScriptState& state, const Command* command)
 				{
 					auto moduleInstance
 						= instantiateModule(state.compartment,
-											compileModule(*assertCommand->moduleAction->module),
+											compileModule(*assertCommand->moduleAction->module,
+													  state.config.boundsCheckMode),
 											std::move(linkResult.resolvedImports),
 											"test module");
 
@@ -882,7 +885,8 @@ static void showHelp()
 		"  --strict-assert-malformed  Strictly evaluate assert_malformed, failing if the\n"
 		"                             module was invalid\n"
 		"  --test-cloning             Run each test command in the original compartment\n"
-		"                             and a clone of it, and compare the resulting state\n");
+		"                             and a clone of it, and compare the resulting state\n"
+		"  --explicit-bounds-checks   Compile modules with explicit memory bounds checks\n");
 }
 
 int main(int argc, char** argv)
@@ -935,6 +939,10 @@ int main(int argc, char** argv)
 		{
 			config.testCloning = true;
 		}
+		else if(!strcmp(argv[argIndex], "--explicit-bounds-checks"))
+		{
+			config.boundsCheckMode = MemoryBoundsCheckMode::explicitChecks;
+		}
 		else
 		{
 			filenames.push_back(argv[argIndex]);
@@ -0,0 +1,100 @@
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+static const char importMemoryWAST[] = R"(
+(module
+  (import "env" "memory" (memory 1 1))
+  (func (export "load") (param $address i32) (result i32)
+    (i32.load (local.get $address)))
+)
+)";
+
+// Instantiates the module with an imported memory, and returns whether instantiation succeeded.
+// Instantiation fails with an invalidArgument exception if the memory's bounds check mode isn't
+// compatible with the module's.
+static bool tryInstantiate(ModuleConstRefParam module, MemoryBoundsCheckMode memoryBoundsCheckMode)
+{
+	GCPointer<Compartment> compartment = createCompartment();
+	Memory* memory = createMemory(
+		compartment, MemoryType(false, SizeConstraints{1, 1}), "memory", {}, memoryBoundsCheckMode);
+	errorUnless(memory);
+
+	bool instantiated = false;
+	catchRuntimeExceptions(
+		[&] {
+			ModuleInstance* moduleInstance
+				= instantiateModule(compartment, module, {asObject(memory)}, "boundsCheckModeTest");
+			instantiated = moduleInstance != nullptr;
+		},
+		[&](Exception* exception) {
+			errorUnless(getExceptionType(exception) == ExceptionTypes::invalidArgument);
+			destroyException(exception);
+		});
+
+	memory = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+	return instantiated;
+}
+
+static void testImportedMemoryBoundsCheckMode(const IR::Module& irModule)
+{
+	ModuleRef guardRegionModule = compileModule(irModule, MemoryBoundsCheckMode::guardRegion);
+	errorUnless(tryInstantiate(guardRegionModule, MemoryBoundsCheckMode::guardRegion));
+	errorUnless(!tryInstantiate(guardRegionModule, MemoryBoundsCheckMode::explicitChecks));
+
+	ModuleRef explicitChecksModule = compileModule(irModule, MemoryBoundsCheckMode::explicitChecks);
+	errorUnless(tryInstantiate(explicitChecksModule, MemoryBoundsCheckMode::guardRegion));
+	errorUnless(tryInstantiate(explicitChecksModule, MemoryBoundsCheckMode::explicitChecks));
+}
+
+static void testPrecompiledObjectSection(const IR::Module& irModule)
+{
+	ModuleRef module = compileModule(irModule, MemoryBoundsCheckMode::explicitChecks);
+
+	// A module loaded from a precompiled object section must use the mode it was compiled with.
+	IR::Module precompiledIRModule = irModule;
+	addPrecompiledObjectSection(
+		precompiledIRModule, getObjectCode(module), MemoryBoundsCheckMode::explicitChecks);
+	ModuleRef precompiledModule
+		= loadPrecompiledModule(precompiledIRModule, MemoryBoundsCheckMode::explicitChecks);
+	errorUnless(precompiledModule);
+	errorUnless(getObjectCode(precompiledModule) == getObjectCode(module));
+	errorUnless(tryInstantiate(precompiledModule, MemoryBoundsCheckMode::explicitChecks));
+	errorUnless(!loadPrecompiledModule(precompiledIRModule, MemoryBoundsCheckMode::guardRegion));
+
+	// A module without a precompiled object section, or with a section that doesn't record the
+	// bounds check mode, can't be loaded.
+	errorUnless(!loadPrecompiledModule(irModule));
+	IR::Module unversionedIRModule = irModule;
+	unversionedIRModule.userSections.push_back({"wavm.precompiled_object", getObjectCode(module)});
+	errorUnless(!loadPrecompiledModule(unversionedIRModule));
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(importMemoryWAST, sizeof(importMemoryWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("BoundsCheckModeTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+
+	testImportedMemoryBoundsCheckMode(irModule);
+	testPrecompiledObjectSection(irModule);
+
+	Timing::logTimer("BoundsCheckModeTest", timer);
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+// memory.copy and memory.fill with dynamic sizes, which call the runtime intrinsics, and with
+// constant sizes, which may be emitted inline.
+static const char bulkMemoryWAST[] = R"(
+(module
+  (memory 3 3)
+  (data (i32.const 0) "\01\02\03\04\05\06\07\08\09\0a\0b\0c\0d\0e\0f\10")
+
+  (func (export "copy") (param $destAddress i32) (param $sourceAddress i32) (param $numBytes i32)
+    (memory.copy (local.get $destAddress) (local.get $sourceAddress) (local.get $numBytes)))
+  (func (export "copy-16") (param $destAddress i32) (param $sourceAddress i32)
+    (memory.copy (local.get $destAddress) (local.get $sourceAddress) (i32.const 16)))
+  (func (export "fill") (param $destAddress i32) (param $numBytes i32)
+    (memory.fill (local.get $destAddress) (i32.const 0xff) (local.get $numBytes)))
+  (func (export "fill-16") (param $destAddress i32)
+    (memory.fill (local.get $destAddress) (i32.const 0xff) (i32.const 16)))
+  (func (export "load") (param $address i32) (result i32)
+    (i32.load8_u (local.get $address)))
+)
+)";
+
+struct BulkMemoryInstance
+{
+	Context* context;
+	ModuleInstance* moduleInstance;
+
+	void invoke(const char* exportName, std::vector<Value>&& args)
+	{
+		invokeFunctionChecked(
+			context, asFunction(getInstanceExport(moduleInstance, exportName)), args);
+	}
+
+	U32 load(U32 address)
+	{
+		ValueTuple results = invokeFunctionChecked(
+			context, asFunction(getInstanceExport(moduleInstance, "load")), {Value{address}});
+		errorUnless(results.size() == 1 && results[0].type == ValueType::i32);
+		return results[0].u32;
+	}
+
+	// Checks that calling the export raises an out-of-bounds memory access exception.
+	void expectOutOfBounds(const char* exportName, std::vector<Value>&& args)
+	{
+		bool trapped = false;
+		catchRuntimeExceptions([&] { invoke(exportName, std::move(args)); },
+							   [&](Exception* exception) {
+								   errorUnless(getExceptionType(exception)
+											   == ExceptionTypes::outOfBoundsMemoryAccess);
+								   destroyException(exception);
+								   trapped = true;
+							   });
+		errorUnless(trapped);
+	}
+};
+
+// Checks that copies and fills that access a page of the memory that was decommitted with
+// unmapMemoryPages trap, instead of crashing the host.
+static void testDecommittedPage(BulkMemoryInstance& instance)
+{
+	unmapMemoryPages(getDefaultMemory(instance.moduleInstance), 1, 1);
+
+	instance.expectOutOfBounds("copy", {U32(65536), U32(0), U32(16)});
+	instance.expectOutOfBounds("copy", {U32(0), U32(65536), U32(16)});
+	instance.expectOutOfBounds("copy", {U32(131072), U32(65530), U32(1000)});
+	instance.expectOutOfBounds("copy", {U32(65000), U32(0), U32(1000)});
+	instance.expectOutOfBounds("copy-16", {U32(65536), U32(0)});
+	instance.expectOutOfBounds("copy-16", {U32(0), U32(65536 + 100)});
+	instance.expectOutOfBounds("fill", {U32(65536), U32(1)});
+	instance.expectOutOfBounds("fill", {U32(65000), U32(1000)});
+	instance.expectOutOfBounds("fill-16", {U32(65536)});
+	instance.expectOutOfBounds("fill-16", {U32(131056)});
+
+	// A copy from the decommitted page doesn't write to the destination before trapping.
+	errorUnless(instance.load(0) == 1);
+
+	// The pages on either side of the decommitted page can still be accessed.
+	instance.invoke("copy", {U32(131072), U32(0), U32(16)});
+	errorUnless(instance.load(131072 + 15) == 16);
+	instance.invoke("copy-16", {U32(65520), U32(131072)});
+	errorUnless(instance.load(65535) == 16);
+	instance.invoke("fill-16", {U32(131088)});
+	errorUnless(instance.load(131103) == 0xff);
+	instance.invoke("fill", {U32(65000), U32(536)});
+	errorUnless(instance.load(65535) == 0xff);
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(bulkMemoryWAST, sizeof(bulkMemoryWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("BulkMemoryTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleRef module = compileModule(irModule);
+	BulkMemoryInstance instance;
+	instance.moduleInstance = instantiateModule(compartment, module, {}, "bulkMemoryTest");
+	instance.context = createContext(compartment);
+
+	testDecommittedPage(instance);
+
+	instance.moduleInstance = nullptr;
+	instance.context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+
+	Timing::logTimer("BulkMemoryTest", timer);
+	return 0;
+}
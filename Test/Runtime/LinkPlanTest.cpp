@@ -0,0 +1,180 @@
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Runtime/Linker.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+static const char hostWAST[] = R"(
+(module
+  (global (export "g") i32 (i32.const 1))
+  (func (export "f") (param i32) (result i32) (local.get 0))
+)
+)";
+
+// A module that exports the same names as hostWAST, but with different types.
+static const char mismatchedHostWAST[] = R"(
+(module
+  (global (export "g") f64 (f64.const 1))
+  (func (export "f") (param i64) (result i64) (local.get 0))
+)
+)";
+
+static const char guestWAST[] = R"(
+(module
+  (import "host" "g" (global i32))
+  (import "host" "f" (func (param i32) (result i32)))
+)
+)";
+
+// A guest module with an import that the host module doesn't export.
+static const char missingImportGuestWAST[] = R"(
+(module
+  (import "host" "g" (global i32))
+  (import "host" "missing" (global i32))
+)
+)";
+
+// Resolves imports from a single host module by name.
+struct HostResolver : Resolver
+{
+	ModuleInstance* hostModuleInstance;
+
+	HostResolver(ModuleInstance* inHostModuleInstance) : hostModuleInstance(inHostModuleInstance) {}
+
+	bool resolve(const std::string& moduleName,
+				 const std::string& exportName,
+				 IR::ExternType type,
+				 Object*& outObject) override
+	{
+		if(moduleName != "host") { return false; }
+		outObject = getInstanceExport(hostModuleInstance, exportName);
+		return outObject && isA(outObject, type);
+	}
+};
+
+static void parseModule(const char* wast, Uptr numChars, IR::Module& outModule)
+{
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(wast, numChars, outModule, parseErrors))
+	{
+		WAST::reportParseErrors("LinkPlanTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+}
+
+static ModuleInstance* instantiateWAST(Compartment* compartment,
+									   const char* wast,
+									   Uptr numChars,
+									   const char* debugName)
+{
+	IR::Module irModule;
+	parseModule(wast, numChars, irModule);
+	return instantiateModule(compartment, compileModule(irModule), {}, debugName);
+}
+
+static bool hasMissingImport(const std::vector<LinkResult::MissingImport>& missingImports,
+							 const char* exportName)
+{
+	for(const LinkResult::MissingImport& missingImport : missingImports)
+	{
+		if(missingImport.moduleName == "host" && missingImport.exportName == exportName)
+		{ return true; }
+	}
+	return false;
+}
+
+// Checks that linking with a plan resolves the same objects as linking with the resolver.
+static void testLinkPlan(Compartment* compartment, ModuleInstance* hostModuleInstance)
+{
+	IR::Module guestIRModule;
+	parseModule(guestWAST, sizeof(guestWAST), guestIRModule);
+
+	HostResolver resolver(hostModuleInstance);
+	LinkPlan linkPlan = createLinkPlan(guestIRModule, resolver, {hostModuleInstance});
+	errorUnless(linkPlan.success);
+
+	LinkResult linkResult = linkModule(linkPlan, {hostModuleInstance});
+	errorUnless(linkResult.success);
+	errorUnless(linkResult.resolvedImports.size() == 2);
+	errorUnless(linkResult.resolvedImports[0] == getInstanceExport(hostModuleInstance, "g"));
+	errorUnless(linkResult.resolvedImports[1] == getInstanceExport(hostModuleInstance, "f"));
+
+	// Linking with the plan against instances with different export types fails, and reports each
+	// mismatched import as missing.
+	ModuleInstance* mismatchedHostModuleInstance = instantiateWAST(
+		compartment, mismatchedHostWAST, sizeof(mismatchedHostWAST), "mismatchedHost");
+	linkResult = linkModule(linkPlan, {mismatchedHostModuleInstance});
+	errorUnless(!linkResult.success);
+	errorUnless(linkResult.missingImports.size() == 2);
+	errorUnless(hasMissingImport(linkResult.missingImports, "g"));
+	errorUnless(hasMissingImport(linkResult.missingImports, "f"));
+	errorUnless(linkResult.resolvedImports.size() == 2);
+	errorUnless(!linkResult.resolvedImports[0] && !linkResult.resolvedImports[1]);
+
+	// Linking with the plan against too few instances fails.
+	linkResult = linkModule(linkPlan, {});
+	errorUnless(!linkResult.success);
+	errorUnless(linkResult.missingImports.size() == 2);
+}
+
+// Checks that imports the resolver can't resolve, or resolves to stubs that aren't exported by the
+// plan's module instances, are reported as missing by both the plan and linking with it.
+static void testMissingImports(Compartment* compartment, ModuleInstance* hostModuleInstance)
+{
+	IR::Module guestIRModule;
+	parseModule(missingImportGuestWAST, sizeof(missingImportGuestWAST), guestIRModule);
+
+	HostResolver resolver(hostModuleInstance);
+	LinkPlan linkPlan = createLinkPlan(guestIRModule, resolver, {hostModuleInstance});
+	errorUnless(!linkPlan.success);
+	errorUnless(linkPlan.missingImports.size() == 1);
+	errorUnless(hasMissingImport(linkPlan.missingImports, "missing"));
+
+	LinkResult linkResult = linkModule(linkPlan, {hostModuleInstance});
+	errorUnless(!linkResult.success);
+	errorUnless(linkResult.missingImports.size() == 1);
+	errorUnless(hasMissingImport(linkResult.missingImports, "missing"));
+	errorUnless(linkResult.resolvedImports.size() == 2);
+	errorUnless(linkResult.resolvedImports[0] == getInstanceExport(hostModuleInstance, "g"));
+	errorUnless(!linkResult.resolvedImports[1]);
+
+	// A stub resolver resolves every import, but its stubs aren't exported by the host instance.
+	StubResolver stubResolver(compartment, StubResolver::FunctionBehavior::trap, false);
+	linkPlan = createLinkPlan(guestIRModule, stubResolver, {hostModuleInstance});
+	errorUnless(!linkPlan.success);
+	errorUnless(linkPlan.missingImports.size() == 2);
+	errorUnless(hasMissingImport(linkPlan.missingImports, "g"));
+	errorUnless(hasMissingImport(linkPlan.missingImports, "missing"));
+
+	linkResult = linkModule(linkPlan, {hostModuleInstance});
+	errorUnless(!linkResult.success);
+	errorUnless(linkResult.missingImports.size() == 2);
+	errorUnless(!linkResult.resolvedImports[0] && !linkResult.resolvedImports[1]);
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleInstance* hostModuleInstance
+		= instantiateWAST(compartment, hostWAST, sizeof(hostWAST), "host");
+
+	testLinkPlan(compartment, hostModuleInstance);
+	testMissingImports(compartment, hostModuleInstance);
+
+	hostModuleInstance = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+
+	Timing::logTimer("LinkPlanTest", timer);
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include <atomic>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Platform/Thread.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+// A module with a branch table, so releasing and reloading its code must restore the function's
+// branch tables as well as its code.
+static const char releaseModuleCodeWAST[] = R"(
+(module
+  (func (export "add") (param $a i32) (param $b i32) (result i32)
+    (i32.add (local.get $a) (local.get $b)))
+  (func (export "select") (param $index i32) (result i32)
+    (block $default (block $two (block $one (block $zero
+      (br_table $zero $one $two $default (local.get $index)))
+      (return (i32.const 100)))
+      (return (i32.const 101)))
+      (return (i32.const 102)))
+    (i32.const -1))
+)
+)";
+
+static I32 invokeI32(Context* context,
+					 ModuleInstance* moduleInstance,
+					 const char* exportName,
+					 std::vector<Value>&& args)
+{
+	ValueTuple results = invokeFunctionChecked(
+		context, asFunction(getInstanceExport(moduleInstance, exportName)), args);
+	errorUnless(results.size() == 1 && results[0].type == ValueType::i32);
+	return results[0].i32;
+}
+
+// Instantiates the module in a new compartment, and checks that its functions work.
+static void instantiateAndCheck(ModuleConstRefParam module)
+{
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleInstance* moduleInstance
+		= instantiateModule(compartment, module, {}, "releaseModuleCodeTest");
+	Context* context = createContext(compartment);
+
+	errorUnless(invokeI32(context, moduleInstance, "add", {I32(2), I32(3)}) == 5);
+	errorUnless(invokeI32(context, moduleInstance, "select", {I32(0)}) == 100);
+	errorUnless(invokeI32(context, moduleInstance, "select", {I32(2)}) == 102);
+	errorUnless(invokeI32(context, moduleInstance, "select", {I32(7)}) == -1);
+
+	moduleInstance = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+static void checkFunctionDefsHaveCode(const IR::Module& irModule, const IR::Module& expectedModule)
+{
+	errorUnless(irModule.functions.defs.size() == expectedModule.functions.defs.size());
+	for(Uptr defIndex = 0; defIndex < irModule.functions.defs.size(); ++defIndex)
+	{
+		const FunctionDef& functionDef = irModule.functions.defs[defIndex];
+		const FunctionDef& expectedFunctionDef = expectedModule.functions.defs[defIndex];
+		errorUnless(functionDef.code.size());
+		errorUnless(functionDef.code == expectedFunctionDef.code);
+		errorUnless(functionDef.branchTables == expectedFunctionDef.branchTables);
+	}
+}
+
+// Checks that a module can be instantiated after its code is released, and that
+// getModuleIRWithCode and getObjectCode load the released code.
+static void testReleaseThenInstantiate(const IR::Module& irModule)
+{
+	ModuleRef module = compileModule(irModule);
+	const std::vector<U8> objectCode = getObjectCode(module);
+	errorUnless(objectCode.size());
+
+	// An instance created before the module's code is released keeps working after it's released.
+	GCPointer<Compartment> compartment = createCompartment();
+	ModuleInstance* moduleInstance
+		= instantiateModule(compartment, module, {}, "releaseModuleCodeTest");
+	Context* context = createContext(compartment);
+
+	Uptr numCodeLoads = 0;
+	releaseModuleCode(module, [&](IR::Module& outIRModule, std::vector<U8>& outObjectCode) {
+		++numCodeLoads;
+		outIRModule = irModule;
+		outObjectCode = objectCode;
+	});
+	errorUnless(invokeI32(context, moduleInstance, "add", {I32(1), I32(1)}) == 2);
+
+	// getModuleIR doesn't load the released function bodies.
+	for(const FunctionDef& functionDef : getModuleIR(module).functions.defs)
+	{ errorUnless(!functionDef.code.size() && !functionDef.branchTables.size()); }
+	errorUnless(getModuleIR(module).exports.size() == irModule.exports.size());
+	errorUnless(numCodeLoads == 0);
+
+	// getModuleIRWithCode and getObjectCode load the released code.
+	checkFunctionDefsHaveCode(getModuleIRWithCode(module), irModule);
+	errorUnless(numCodeLoads == 1);
+	errorUnless(getObjectCode(module) == objectCode);
+	errorUnless(numCodeLoads == 2);
+
+	// Each instantiation loads the released code again.
+	instantiateAndCheck(module);
+	instantiateAndCheck(module);
+	errorUnless(numCodeLoads == 4);
+
+	// The module's code stays released.
+	for(const FunctionDef& functionDef : getModuleIR(module).functions.defs)
+	{ errorUnless(!functionDef.code.size()); }
+
+	moduleInstance = nullptr;
+	context = nullptr;
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+// Checks that getModuleIRWithCode returns the module's code if it wasn't released.
+static void testGetModuleIRWithCode(const IR::Module& irModule)
+{
+	ModuleRef module = compileModule(irModule);
+	checkFunctionDefsHaveCode(getModuleIRWithCode(module), irModule);
+	checkFunctionDefsHaveCode(getModuleIR(module), irModule);
+}
+
+// Checks that a module's code can be released while other threads instantiate it.
+struct ConcurrentReleaseArgs
+{
+	ModuleRef module;
+	std::atomic<Uptr> numInstantiations{0};
+};
+
+static void testConcurrentRelease(const IR::Module& irModule)
+{
+	static constexpr Uptr numThreads = 4;
+	static constexpr Uptr numInstantiationsPerThread = 8;
+
+	ConcurrentReleaseArgs args;
+	args.module = compileModule(irModule);
+	const std::vector<U8> objectCode = getObjectCode(args.module);
+
+	std::vector<Platform::Thread*> threads;
+	for(Uptr threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		threads.push_back(Platform::createThread(
+			1024 * 1024,
+			[](void* argsVoid) {
+				ConcurrentReleaseArgs& args = *(ConcurrentReleaseArgs*)argsVoid;
+				for(Uptr index = 0; index < numInstantiationsPerThread; ++index)
+				{
+					instantiateAndCheck(args.module);
+					++args.numInstantiations;
+				}
+				return I64(0);
+			},
+			&args));
+	}
+
+	// Release the module's code once some of the threads have instantiated it.
+	while(!args.numInstantiations.load()) { Platform::yieldToAnotherThread(); }
+	releaseModuleCode(args.module,
+					  [&irModule, &objectCode](IR::Module& outIRModule,
+											   std::vector<U8>& outObjectCode) {
+						  outIRModule = irModule;
+						  outObjectCode = objectCode;
+					  });
+
+	for(Platform::Thread* thread : threads) { errorUnless(Platform::joinThread(thread) == 0); }
+	errorUnless(args.numInstantiations.load() == numThreads * numInstantiationsPerThread);
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(
+		   releaseModuleCodeWAST, sizeof(releaseModuleCodeWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("ReleaseModuleCodeTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+
+	testReleaseThenInstantiate(irModule);
+	testGetModuleIRWithCode(irModule);
+	testConcurrentRelease(irModule);
+
+	Timing::logTimer("ReleaseModuleCodeTest", timer);
+	return 0;
+}
@@ -0,0 +1,206 @@
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/VFS/MemoryFS.h"
+#include "WAVM/VFS/MountFS.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+static VFD* openFile(FileSystem* fs,
+					 const std::string& path,
+					 FileCreateMode createMode = FileCreateMode::openAlways)
+{
+	VFD* vfd = nullptr;
+	errorUnless(fs->open(path, FileAccessMode::readWrite, createMode, vfd) == Result::success);
+	return vfd;
+}
+
+static void testReadWrite()
+{
+	FileSystem* fs = makeMemoryFS();
+	VFD* vfd = openFile(fs, "/a", FileCreateMode::createNew);
+
+	// Write a pattern that spans several extents, with a single writev.
+	std::vector<U8> bytes(3 * 1024 * 1024 + 17);
+	for(Uptr index = 0; index < bytes.size(); ++index) { bytes[index] = U8(index * 7); }
+	IOWriteBuffer writeBuffers[2] = {{bytes.data(), 100}, {bytes.data() + 100, bytes.size() - 100}};
+	Uptr numBytesWritten = 0;
+	errorUnless(vfd->writev(writeBuffers, 2, &numBytesWritten) == Result::success);
+	errorUnless(numBytesWritten == bytes.size());
+
+	// Read it back, with a single readv.
+	std::vector<U8> readBytes(bytes.size() + 10);
+	IOReadBuffer readBuffers[2]
+		= {{readBytes.data(), 5000}, {readBytes.data() + 5000, readBytes.size() - 5000}};
+	U64 offset = 0;
+	errorUnless(vfd->seek(0, SeekOrigin::begin, &offset) == Result::success && offset == 0);
+	Uptr numBytesRead = 0;
+	errorUnless(vfd->readv(readBuffers, 2, &numBytesRead) == Result::success);
+	errorUnless(numBytesRead == bytes.size());
+	errorUnless(!memcmp(readBytes.data(), bytes.data(), bytes.size()));
+
+	// Writing beyond the end of the file leaves a hole that reads as zeroes.
+	const U64 holeOffset = bytes.size() + 10000;
+	errorUnless(vfd->write("x", 1, nullptr, (U64*)&holeOffset) == Result::success);
+	U8 holeBytes[4] = {1, 1, 1, 1};
+	U64 readOffset = holeOffset - 3;
+	errorUnless(vfd->read(holeBytes, 4, &numBytesRead, &readOffset) == Result::success);
+	errorUnless(numBytesRead == 4 && !holeBytes[0] && !holeBytes[2] && holeBytes[3] == 'x');
+
+	// Truncating and extending the file zeroes the truncated bytes.
+	errorUnless(vfd->setFileSize(10) == Result::success);
+	errorUnless(vfd->setFileSize(20) == Result::success);
+	U8 truncatedBytes[20];
+	readOffset = 0;
+	errorUnless(vfd->read(truncatedBytes, 20, &numBytesRead, &readOffset) == Result::success);
+	errorUnless(numBytesRead == 20 && !memcmp(truncatedBytes, bytes.data(), 10));
+	for(Uptr index = 10; index < 20; ++index) { errorUnless(!truncatedBytes[index]); }
+
+	FileInfo fileInfo;
+	errorUnless(vfd->getFileInfo(fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::file && fileInfo.numBytes == 20);
+
+	// Files may outlive their filesystem.
+	delete fs;
+	errorUnless(vfd->close() == Result::success);
+}
+
+static void testDirectories()
+{
+	FileSystem* fs = makeMemoryFS();
+	errorUnless(fs->createDir("/d") == Result::success);
+	errorUnless(fs->createDir("/d") == Result::alreadyExists);
+	errorUnless(fs->createDir("/d/e") == Result::success);
+	errorUnless(fs->createDir("/x/y") == Result::doesNotExist);
+	openFile(fs, "/d/e/f")->close();
+
+	VFD* vfd = nullptr;
+	errorUnless(fs->open("/d/e/f", FileAccessMode::readOnly, FileCreateMode::createNew, vfd)
+				== Result::alreadyExists);
+	errorUnless(fs->open("/d/g", FileAccessMode::readOnly, FileCreateMode::openExisting, vfd)
+				== Result::doesNotExist);
+	errorUnless(fs->open("/d/e/f/g", FileAccessMode::readOnly, FileCreateMode::openAlways, vfd)
+				== Result::isNotDirectory);
+
+	FileInfo fileInfo;
+	errorUnless(fs->getFileInfo("/d/e/../e/./f", fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::file);
+	errorUnless(fs->getFileInfo("/d/e/..", fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::directory);
+
+	DirEntStream* dirEntStream = nullptr;
+	errorUnless(fs->openDir("/d/e", dirEntStream) == Result::success);
+	std::vector<std::string> names;
+	DirEnt dirEnt;
+	while(dirEntStream->getNext(dirEnt)) { names.push_back(dirEnt.name); };
+	dirEntStream->close();
+	errorUnless(names == std::vector<std::string>({".", "..", "f"}));
+
+	errorUnless(fs->removeDir("/d/e") == Result::isNotEmpty);
+	errorUnless(fs->unlinkFile("/d/e") == Result::isDirectory);
+	errorUnless(fs->removeDir("/d/e/f") == Result::isNotDirectory);
+	errorUnless(fs->unlinkFile("/d/e/f") == Result::success);
+	errorUnless(fs->unlinkFile("/d/e/f") == Result::doesNotExist);
+	errorUnless(fs->removeDir("/d/e") == Result::success);
+	errorUnless(fs->removeDir("/") == Result::busy);
+
+	delete fs;
+}
+
+static void testQuota()
+{
+	FileSystem* fs = makeMemoryFS(64 * 1024);
+	VFD* vfd = openFile(fs, "/a");
+
+	// A write that exceeds the quota writes the buffers that fit.
+	std::vector<U8> bytes(128 * 1024, 1);
+	Uptr numBytesWritten = 0;
+	errorUnless(vfd->write(bytes.data(), bytes.size(), &numBytesWritten) == Result::outOfQuota);
+	IOWriteBuffer buffers[2] = {{bytes.data(), 60 * 1024}, {bytes.data(), 8 * 1024}};
+	errorUnless(vfd->writev(buffers, 2, &numBytesWritten) == Result::success);
+	errorUnless(numBytesWritten == 60 * 1024);
+	errorUnless(vfd->write(bytes.data(), 8 * 1024, &numBytesWritten) == Result::outOfQuota);
+
+	// Truncating the file frees its extents.
+	errorUnless(vfd->setFileSize(0) == Result::success);
+	U64 offset = 0;
+	errorUnless(vfd->write(bytes.data(), 64 * 1024, &numBytesWritten, &offset) == Result::success);
+	errorUnless(numBytesWritten == 64 * 1024);
+
+	// A write that fails after allocating some of the extents it needs frees them. Write 4KB at 0
+	// and 32KB, then write 64KB at 4KB: the hole before 32KB fits in the quota, but the hole after
+	// it doesn't.
+	errorUnless(vfd->setFileSize(0) == Result::success);
+	offset = 0;
+	errorUnless(vfd->write(bytes.data(), 4 * 1024, &numBytesWritten, &offset) == Result::success);
+	offset = 32 * 1024;
+	errorUnless(vfd->write(bytes.data(), 4 * 1024, &numBytesWritten, &offset) == Result::success);
+	offset = 4 * 1024;
+	errorUnless(vfd->write(bytes.data(), 64 * 1024, &numBytesWritten, &offset)
+				== Result::outOfQuota);
+	errorUnless(numBytesWritten == 0);
+
+	// The rest of the quota can still be used.
+	offset = 1024 * 1024;
+	errorUnless(vfd->write(bytes.data(), 56 * 1024, &numBytesWritten, &offset) == Result::success);
+	errorUnless(numBytesWritten == 56 * 1024);
+
+	errorUnless(vfd->close() == Result::success);
+	delete fs;
+}
+
+static void testMount()
+{
+	FileSystem* rootFS = makeMemoryFS();
+	FileSystem* tmpFS = makeMemoryFS();
+	FileSystem* fs = makeMountFS(rootFS, "/tmp/", tmpFS);
+	errorUnless(rootFS->createDir("/tmp") == Result::success);
+
+	openFile(fs, "/tmp/a")->close();
+	openFile(fs, "/tmpfile")->close();
+
+	FileInfo fileInfo;
+	errorUnless(tmpFS->getFileInfo("/a", fileInfo) == Result::success);
+	errorUnless(rootFS->getFileInfo("/tmpfile", fileInfo) == Result::success);
+	errorUnless(rootFS->getFileInfo("/tmp/a", fileInfo) == Result::doesNotExist);
+	errorUnless(fs->removeDir("/tmp") == Result::busy);
+
+	delete fs;
+	delete tmpFS;
+	delete rootFS;
+
+	// A filesystem mounted at the root is used for every path.
+	rootFS = makeMemoryFS();
+	tmpFS = makeMemoryFS();
+	fs = makeMountFS(rootFS, "/", tmpFS);
+
+	openFile(fs, "/a")->close();
+	errorUnless(fs->createDir("/d") == Result::success);
+	openFile(fs, "/d/b")->close();
+	errorUnless(tmpFS->getFileInfo("/a", fileInfo) == Result::success);
+	errorUnless(tmpFS->getFileInfo("/d/b", fileInfo) == Result::success);
+	errorUnless(rootFS->getFileInfo("/a", fileInfo) == Result::doesNotExist);
+	errorUnless(rootFS->getFileInfo("/d", fileInfo) == Result::doesNotExist);
+	errorUnless(fs->removeDir("/") == Result::busy);
+
+	delete fs;
+	delete tmpFS;
+	delete rootFS;
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+	testReadWrite();
+	testDirectories();
+	testQuota();
+	testMount();
+	Timing::logTimer("MemoryFSTest", timer);
+	return 0;
+}
@@ -0,0 +1,211 @@
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/VFS/MemoryFS.h"
+#include "WAVM/VFS/OverlayFS.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+static void writeFile(FileSystem* fs, const std::string& path, const std::string& contents)
+{
+	VFD* vfd = nullptr;
+	errorUnless(fs->open(path, FileAccessMode::writeOnly, FileCreateMode::createAlways, vfd)
+				== Result::success);
+	errorUnless(vfd->write(contents.data(), contents.size()) == Result::success);
+	errorUnless(vfd->close() == Result::success);
+}
+
+static std::string readFile(FileSystem* fs, const std::string& path)
+{
+	VFD* vfd = nullptr;
+	errorUnless(fs->open(path, FileAccessMode::readOnly, FileCreateMode::openExisting, vfd)
+				== Result::success);
+	char buffer[256];
+	Uptr numBytesRead = 0;
+	errorUnless(vfd->read(buffer, sizeof(buffer), &numBytesRead) == Result::success);
+	errorUnless(vfd->close() == Result::success);
+	return std::string(buffer, numBytesRead);
+}
+
+static std::vector<std::string> listDir(FileSystem* fs, const std::string& path)
+{
+	VFD* vfd = nullptr;
+	errorUnless(fs->open(path, FileAccessMode::readOnly, FileCreateMode::openExisting, vfd)
+				== Result::success);
+	DirEntStream* dirEntStream = nullptr;
+	errorUnless(vfd->openDir(dirEntStream) == Result::success);
+	std::vector<std::string> names;
+	DirEnt dirEnt;
+	while(dirEntStream->getNext(dirEnt))
+	{
+		if(dirEnt.name != "." && dirEnt.name != "..") { names.push_back(dirEnt.name); }
+	};
+	dirEntStream->close();
+	errorUnless(vfd->close() == Result::success);
+	return names;
+}
+
+static void testOverlay()
+{
+	// Create a lower layer that is shared by two overlays.
+	FileSystem* lowerFS = makeMemoryFS();
+	errorUnless(lowerFS->createDir("/d") == Result::success);
+	errorUnless(lowerFS->createDir("/d/e") == Result::success);
+	writeFile(lowerFS, "/d/a", "lower a");
+	writeFile(lowerFS, "/d/e/b", "lower b");
+
+	FileSystem* upperFS = makeMemoryFS();
+	FileSystem* fs = makeOverlayFS(lowerFS, upperFS);
+	FileSystem* otherUpperFS = makeMemoryFS();
+	FileSystem* otherFS = makeOverlayFS(lowerFS, otherUpperFS);
+
+	// Reading a file doesn't copy it up.
+	errorUnless(readFile(fs, "/d/a") == "lower a");
+	FileInfo fileInfo;
+	errorUnless(upperFS->getFileInfo("/d/a", fileInfo) == Result::doesNotExist);
+
+	// Writing a file copies it and its parent directories up.
+	VFD* vfd = nullptr;
+	errorUnless(fs->open("/d/e/b", FileAccessMode::readWrite, FileCreateMode::openExisting, vfd)
+				== Result::success);
+	U64 offset = 6;
+	errorUnless(vfd->write("B", 1, nullptr, &offset) == Result::success);
+	errorUnless(vfd->close() == Result::success);
+	errorUnless(readFile(fs, "/d/e/b") == "lower B");
+	errorUnless(readFile(upperFS, "/d/e/b") == "lower B");
+	errorUnless(readFile(lowerFS, "/d/e/b") == "lower b");
+	errorUnless(readFile(otherFS, "/d/e/b") == "lower b");
+
+	// New files are created in the upper layer, and listed with the lower layer's files.
+	writeFile(fs, "/d/c", "upper c");
+	errorUnless(listDir(fs, "/d") == std::vector<std::string>({"c", "e", "a"}));
+	errorUnless(listDir(otherFS, "/d") == std::vector<std::string>({"a", "e"}));
+
+	// Removing a file or directory that is in the lower layer hides it.
+	errorUnless(fs->unlinkFile("/d/a") == Result::success);
+	errorUnless(fs->getFileInfo("/d/a", fileInfo) == Result::doesNotExist);
+	errorUnless(fs->removeDir("/d/e") == Result::isNotEmpty);
+	errorUnless(fs->unlinkFile("/d/e/b") == Result::success);
+	errorUnless(fs->removeDir("/d/e") == Result::success);
+	errorUnless(listDir(fs, "/d") == std::vector<std::string>({"c"}));
+	errorUnless(readFile(otherFS, "/d/a") == "lower a");
+
+	// A hidden directory that is created again is empty.
+	errorUnless(fs->createDir("/d/e") == Result::success);
+	errorUnless(listDir(fs, "/d/e").empty());
+	errorUnless(fs->getFileInfo("/d/e/b", fileInfo) == Result::doesNotExist);
+	writeFile(fs, "/d/a", "upper a");
+	errorUnless(readFile(fs, "/d/a") == "upper a");
+	errorUnless(listDir(fs, "/d") == std::vector<std::string>({"a", "c", "e"}));
+
+	// Removing a file that was created again hides the lower layer's file again.
+	errorUnless(fs->unlinkFile("/d/a") == Result::success);
+	errorUnless(fs->getFileInfo("/d/a", fileInfo) == Result::doesNotExist);
+	errorUnless(listDir(fs, "/d") == std::vector<std::string>({"c", "e"}));
+
+	delete otherFS;
+	delete otherUpperFS;
+	delete fs;
+	delete upperFS;
+	delete lowerFS;
+}
+
+// Checks that metadata writes through VFDs for lower layer files and directories copy them up
+// instead of modifying the lower layer.
+static void testLowerVFDMetadataWrites()
+{
+	FileSystem* lowerFS = makeMemoryFS();
+	errorUnless(lowerFS->createDir("/d") == Result::success);
+	writeFile(lowerFS, "/d/a", "lower a");
+	errorUnless(lowerFS->createDir("/e") == Result::success);
+	FileInfo lowerFileInfo;
+	FileInfo lowerDirInfo;
+	errorUnless(lowerFS->getFileInfo("/d/a", lowerFileInfo) == Result::success);
+	errorUnless(lowerFS->getFileInfo("/e", lowerDirInfo) == Result::success);
+
+	FileSystem* upperFS = makeMemoryFS();
+	FileSystem* fs = makeOverlayFS(lowerFS, upperFS);
+	const I128 newTime = lowerFileInfo.lastWriteTime + 1000000000;
+
+	// A file opened to be read can't be written or resized, and setting its times copies it up.
+	VFD* vfd = nullptr;
+	errorUnless(fs->open("/d/a", FileAccessMode::readOnly, FileCreateMode::openExisting, vfd)
+				== Result::success);
+	errorUnless(vfd->write("A", 1) == Result::notPermitted);
+	errorUnless(vfd->setFileSize(0) == Result::notPermitted);
+	errorUnless(vfd->setFileTimes(false, 0, true, newTime) == Result::success);
+	FileInfo fileInfo;
+	errorUnless(vfd->getFileInfo(fileInfo) == Result::success);
+	errorUnless(fileInfo.lastWriteTime == newTime && fileInfo.numBytes == 7);
+	errorUnless(vfd->close() == Result::success);
+	errorUnless(upperFS->getFileInfo("/d/a", fileInfo) == Result::success);
+	errorUnless(fileInfo.lastWriteTime == newTime);
+	errorUnless(lowerFS->getFileInfo("/d/a", fileInfo) == Result::success);
+	errorUnless(fileInfo.lastWriteTime == lowerFileInfo.lastWriteTime && fileInfo.numBytes == 7);
+	errorUnless(readFile(fs, "/d/a") == "lower a");
+
+	// Setting the times of a lower layer directory copies it up.
+	errorUnless(fs->open("/e", FileAccessMode::readOnly, FileCreateMode::openExisting, vfd)
+				== Result::success);
+	errorUnless(vfd->setFileSize(0) == Result::isDirectory);
+	errorUnless(vfd->setFileTimes(false, 0, true, newTime) == Result::success);
+	errorUnless(vfd->getFileInfo(fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::directory && fileInfo.lastWriteTime == newTime);
+	errorUnless(vfd->close() == Result::success);
+	errorUnless(upperFS->getFileInfo("/e", fileInfo) == Result::success);
+	errorUnless(lowerFS->getFileInfo("/e", fileInfo) == Result::success);
+	errorUnless(fileInfo.lastWriteTime == lowerDirInfo.lastWriteTime);
+
+	delete fs;
+	delete upperFS;
+	delete lowerFS;
+}
+
+static void testLowerLookupCache()
+{
+	FileSystem* lowerFS = makeMemoryFS();
+	FileSystem* upperFS = makeMemoryFS();
+	FileSystem* fs = makeOverlayFS(lowerFS, upperFS);
+
+	// Paths that aren't in the lower layer aren't cached, so they are found if they're added to
+	// the lower layer later.
+	FileInfo fileInfo;
+	errorUnless(fs->getFileInfo("/new", fileInfo) == Result::doesNotExist);
+	writeFile(lowerFS, "/new", "new");
+	errorUnless(fs->getFileInfo("/new", fileInfo) == Result::success);
+	errorUnless(readFile(fs, "/new") == "new");
+
+	// Looking up more paths than are cached evicts the least recently used paths, but they are
+	// still found.
+	errorUnless(lowerFS->createDir("/d") == Result::success);
+	for(Uptr fileIndex = 0; fileIndex < 5000; ++fileIndex)
+	{
+		const std::string path = "/d/" + std::to_string(fileIndex);
+		writeFile(lowerFS, path, path);
+		errorUnless(fs->getFileInfo(path, fileInfo) == Result::success);
+		errorUnless(fs->getFileInfo(path + "x", fileInfo) == Result::doesNotExist);
+	}
+	errorUnless(readFile(fs, "/new") == "new");
+	errorUnless(readFile(fs, "/d/0") == "/d/0");
+	errorUnless(readFile(fs, "/d/4999") == "/d/4999");
+
+	delete fs;
+	delete upperFS;
+	delete lowerFS;
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+	testOverlay();
+	testLowerVFDMetadataWrites();
+	testLowerLookupCache();
+	Timing::logTimer("OverlayFSTest", timer);
+	return 0;
+}
@@ -0,0 +1,207 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string>
+
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#endif
+
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Platform/File.h"
+#include "WAVM/VFS/VFS.h"
+
+using namespace WAVM;
+using namespace WAVM::VFS;
+
+// The host directories and files that the tests use. The sandbox's root is root, and outside is a
+// sibling of it that the sandbox must not be able to access.
+//   root/a                 contains "a"
+//   root/d/f               contains "f"
+//   root/d/up          ->  ../a
+//   root/absolute      ->  <outside>/secret
+//   root/escape        ->  ../outside/secret
+//   root/escapeDir     ->  ..
+//   outside/secret         contains "secret"
+struct TestDirs
+{
+	std::string base;
+	std::string root;
+	std::string outside;
+
+	TestDirs()
+	{
+		char baseTemplate[] = "/tmp/SandboxFSTest.XXXXXX";
+		errorUnless(mkdtemp(baseTemplate));
+		base = baseTemplate;
+		root = base + "/root";
+		outside = base + "/outside";
+
+		errorUnless(!mkdir(root.c_str(), 0700));
+		errorUnless(!mkdir(outside.c_str(), 0700));
+		errorUnless(!mkdir((root + "/d").c_str(), 0700));
+		writeHostFile(root + "/a", "a");
+		writeHostFile(root + "/d/f", "f");
+		writeHostFile(outside + "/secret", "secret");
+		errorUnless(!symlink("../a", (root + "/d/up").c_str()));
+		errorUnless(!symlink((outside + "/secret").c_str(), (root + "/absolute").c_str()));
+		errorUnless(!symlink("../outside/secret", (root + "/escape").c_str()));
+		errorUnless(!symlink("..", (root + "/escapeDir").c_str()));
+	}
+
+	~TestDirs()
+	{
+		for(const char* link : {"/d/up", "/absolute", "/escape", "/escapeDir", "/a", "/d/f"})
+		{ errorUnless(!unlink((root + link).c_str())); }
+		errorUnless(!rmdir((root + "/d").c_str()));
+		errorUnless(!rmdir(root.c_str()));
+		errorUnless(!unlink((outside + "/secret").c_str()));
+		errorUnless(!rmdir(outside.c_str()));
+		errorUnless(!rmdir(base.c_str()));
+	}
+
+private:
+	static void writeHostFile(const std::string& path, const char* contents)
+	{
+		const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+		errorUnless(fd >= 0);
+		errorUnless(::write(fd, contents, strlen(contents)) == ssize_t(strlen(contents)));
+		errorUnless(!::close(fd));
+	}
+};
+
+static bool isOpenat2Supported()
+{
+#if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+	open_how how{};
+	how.flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+	how.resolve = RESOLVE_BENEATH;
+	const long fd = syscall(SYS_openat2, AT_FDCWD, ".", &how, sizeof(how));
+	if(fd < 0) { return false; }
+	close(int(fd));
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Opens a file in the sandbox for reading, and returns its contents, or returns the error.
+static Result readFile(FileSystem* fs, const std::string& path, std::string& outContents)
+{
+	VFD* vfd = nullptr;
+	const Result result
+		= fs->open(path, FileAccessMode::readOnly, FileCreateMode::openExisting, vfd);
+	if(result != Result::success) { return result; }
+
+	char buffer[64];
+	Uptr numBytesRead = 0;
+	errorUnless(vfd->read(buffer, sizeof(buffer), &numBytesRead) == Result::success);
+	outContents.assign(buffer, numBytesRead);
+	errorUnless(vfd->close() == Result::success);
+	return Result::success;
+}
+
+static bool hostFileExists(const std::string& path)
+{
+	struct stat fileStatus;
+	return !lstat(path.c_str(), &fileStatus);
+}
+
+// Checks that no path can reach a file outside the root, whether or not symbolic links are
+// followed.
+static void testEscapes(const TestDirs& dirs, FileSystem* fs)
+{
+	std::string contents;
+	errorUnless(readFile(fs, "/a", contents) == Result::success && contents == "a");
+	errorUnless(readFile(fs, "d/f", contents) == Result::success && contents == "f");
+
+	// .. can't leave the root.
+	errorUnless(readFile(fs, "/../outside/secret", contents) != Result::success);
+	errorUnless(readFile(fs, "/d/../../outside/secret", contents) != Result::success);
+	errorUnless(readFile(fs, "..", contents) != Result::success);
+	errorUnless(readFile(fs, "/d/..", contents) != Result::success);
+	FileInfo fileInfo;
+	errorUnless(fs->getFileInfo("/..", fileInfo) != Result::success);
+	errorUnless(fs->createDir("/../created") != Result::success);
+	errorUnless(!hostFileExists(dirs.base + "/created"));
+
+	// Absolute symbolic links are never followed, since they're resolved from the host's root.
+	errorUnless(readFile(fs, "/absolute", contents) != Result::success);
+	errorUnless(fs->getFileInfo("/absolute", fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::symbolicLink);
+
+	// Relative symbolic links that lead outside the root aren't followed.
+	errorUnless(readFile(fs, "/escape", contents) != Result::success);
+	errorUnless(fs->getFileInfo("/escape", fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::symbolicLink);
+	errorUnless(readFile(fs, "/escapeDir/outside/secret", contents) != Result::success);
+	errorUnless(fs->getFileInfo("/escapeDir/outside/secret", fileInfo) != Result::success);
+
+	// Files outside the root can't be created or removed through a symbolic link.
+	errorUnless(fs->createDir("/escapeDir/outside/created") != Result::success);
+	errorUnless(!hostFileExists(dirs.outside + "/created"));
+	errorUnless(fs->unlinkFile("/escapeDir/outside/secret") != Result::success);
+	errorUnless(hostFileExists(dirs.outside + "/secret"));
+	errorUnless(fs->setFileTimes("/escape", true, I128(0), true, I128(0)) == Result::success);
+	struct stat secretStatus;
+	errorUnless(!stat((dirs.outside + "/secret").c_str(), &secretStatus));
+	errorUnless(secretStatus.st_mtime != 0);
+}
+
+static void testFollowSymbolicLinks(const TestDirs& dirs)
+{
+	FileSystem* fs = Platform::openHostSandboxFS(dirs.root);
+	errorUnless(fs);
+	testEscapes(dirs, fs);
+
+	// If the host supports openat2, symbolic links and .. that stay beneath the root are followed.
+	// Otherwise, they're treated as if symbolic links weren't being followed.
+	std::string contents;
+	if(isOpenat2Supported())
+	{
+		errorUnless(readFile(fs, "/d/up", contents) == Result::success && contents == "a");
+		errorUnless(readFile(fs, "/d/../a", contents) == Result::success && contents == "a");
+	}
+	else
+	{
+		errorUnless(readFile(fs, "/d/up", contents) != Result::success);
+		errorUnless(readFile(fs, "/d/../a", contents) == Result::notAccessible);
+	}
+
+	delete fs;
+}
+
+static void testNoFollowSymbolicLinks(const TestDirs& dirs)
+{
+	// Not following symbolic links uses the same path resolution as hosts without openat2.
+	FileSystem* fs = Platform::openHostSandboxFS(dirs.root, false);
+	errorUnless(fs);
+	testEscapes(dirs, fs);
+
+	// Symbolic links aren't followed even if they stay beneath the root, and .. isn't allowed.
+	std::string contents;
+	errorUnless(readFile(fs, "/d/up", contents) != Result::success);
+	FileInfo fileInfo;
+	errorUnless(fs->getFileInfo("/d/up", fileInfo) == Result::success);
+	errorUnless(fileInfo.type == FileType::symbolicLink);
+	errorUnless(readFile(fs, "/d/../a", contents) == Result::notAccessible);
+
+	delete fs;
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+	{
+		TestDirs dirs;
+		testFollowSymbolicLinks(dirs);
+		testNoFollowSymbolicLinks(dirs);
+	}
+	Timing::logTimer("SandboxFSTest", timer);
+	return 0;
+}
@@ -449,6 +449,104 @@
 
 (assert_trap   (invoke "memory.fill" (i32.const 0xffffffff) (i32.const 0) (i32.const 1)) "out of bounds memory access")
 
+;; memory.copy and memory.fill with constant sizes, which may be emitted inline, and with
+;; dynamic sizes, next to pages that are reserved for the memory but not yet committed.
+
+(module
+	(memory $m 1 2)
+
+	(data (i32.const 0) "\10\11\12\13\14\15\16\17\18\19\1a\1b\1c\1d\1e\1f")
+
+	(func (export "memory.copy")
+		(param $destAddress i32)
+		(param $sourceAddress i32)
+		(param $numBytes i32)
+		(memory.copy (local.get $destAddress) (local.get $sourceAddress) (local.get $numBytes))
+	)
+	(func (export "memory.copy 16") (param $destAddress i32) (param $sourceAddress i32)
+		(memory.copy (local.get $destAddress) (local.get $sourceAddress) (i32.const 16))
+	)
+	(func (export "memory.copy 64") (param $destAddress i32) (param $sourceAddress i32)
+		(memory.copy (local.get $destAddress) (local.get $sourceAddress) (i32.const 64))
+	)
+
+	(func (export "memory.fill")
+		(param $destAddress i32)
+		(param $value i32)
+		(param $numBytes i32)
+		(memory.fill (local.get $destAddress) (local.get $value) (local.get $numBytes))
+	)
+	(func (export "memory.fill 16") (param $destAddress i32) (param $value i32)
+		(memory.fill (local.get $destAddress) (local.get $value) (i32.const 16))
+	)
+	(func (export "memory.fill 64") (param $destAddress i32) (param $value i32)
+		(memory.fill (local.get $destAddress) (local.get $value) (i32.const 64))
+	)
+
+	(func (export "memory.grow") (param $numPages i32) (result i32)
+		(memory.grow (local.get $numPages))
+	)
+
+	(func (export "i32.load8_u") (param $address i32) (result i32)
+		(i32.load8_u (local.get $address))
+	)
+)
+
+(assert_return (invoke "memory.copy 16" (i32.const 100) (i32.const 0)))
+(assert_return (invoke "i32.load8_u" (i32.const 100)) (i32.const 0x10))
+(assert_return (invoke "i32.load8_u" (i32.const 115)) (i32.const 0x1f))
+(assert_return (invoke "i32.load8_u" (i32.const 116)) (i32.const 0))
+
+(assert_return (invoke "memory.copy 16" (i32.const 4) (i32.const 0)))
+(assert_return (invoke "i32.load8_u" (i32.const 3)) (i32.const 0x13))
+(assert_return (invoke "i32.load8_u" (i32.const 4)) (i32.const 0x10))
+(assert_return (invoke "i32.load8_u" (i32.const 19)) (i32.const 0x1f))
+
+(assert_return (invoke "memory.copy 64" (i32.const 65472) (i32.const 0)))
+(assert_return (invoke "i32.load8_u" (i32.const 65472)) (i32.const 0x10))
+(assert_return (invoke "i32.load8_u" (i32.const 65491)) (i32.const 0x1f))
+(assert_return (invoke "i32.load8_u" (i32.const 65535)) (i32.const 0))
+
+(assert_trap   (invoke "memory.copy 16" (i32.const 65528) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.copy 16" (i32.const 65536) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.copy 64" (i32.const 131008) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.copy 16" (i32.const 0xfffffff0) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.copy 16" (i32.const 0) (i32.const 65536)) "out of bounds memory access")
+(assert_return (invoke "i32.load8_u" (i32.const 0)) (i32.const 0x10))
+(assert_trap   (invoke "memory.copy" (i32.const 65536) (i32.const 0) (i32.const 1)) "out of bounds memory access")
+(assert_trap   (invoke "memory.copy" (i32.const 0) (i32.const 65536) (i32.const 256)) "out of bounds memory access")
+(assert_return (invoke "i32.load8_u" (i32.const 0)) (i32.const 0x10))
+(assert_trap   (invoke "memory.copy" (i32.const 65000) (i32.const 0) (i32.const 1000)) "out of bounds memory access")
+
+(assert_return (invoke "memory.fill 16" (i32.const 65520) (i32.const 0xaa)))
+(assert_return (invoke "i32.load8_u" (i32.const 65519)) (i32.const 0))
+(assert_return (invoke "i32.load8_u" (i32.const 65520)) (i32.const 0xaa))
+(assert_return (invoke "i32.load8_u" (i32.const 65535)) (i32.const 0xaa))
+(assert_return (invoke "memory.fill 64" (i32.const 200) (i32.const 0x1bb)))
+(assert_return (invoke "i32.load8_u" (i32.const 200)) (i32.const 0xbb))
+(assert_return (invoke "i32.load8_u" (i32.const 263)) (i32.const 0xbb))
+(assert_return (invoke "i32.load8_u" (i32.const 264)) (i32.const 0))
+
+(assert_trap   (invoke "memory.fill 16" (i32.const 65530) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill 16" (i32.const 65536) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill 64" (i32.const 131008) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill 16" (i32.const 0xfffffff0) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill" (i32.const 65536) (i32.const 0) (i32.const 1)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill" (i32.const 65000) (i32.const 0) (i32.const 1000)) "out of bounds memory access")
+
+;; After growing the memory, its second page can be copied to and filled.
+(assert_return (invoke "memory.grow" (i32.const 1)) (i32.const 1))
+(assert_return (invoke "memory.copy 16" (i32.const 65536) (i32.const 0)))
+(assert_return (invoke "i32.load8_u" (i32.const 65536)) (i32.const 0x10))
+(assert_return (invoke "memory.copy" (i32.const 65530) (i32.const 0) (i32.const 16)))
+(assert_return (invoke "i32.load8_u" (i32.const 65545)) (i32.const 0x1b))
+(assert_return (invoke "memory.fill 64" (i32.const 131008) (i32.const 0x55)))
+(assert_return (invoke "i32.load8_u" (i32.const 131071)) (i32.const 0x55))
+(assert_return (invoke "memory.fill" (i32.const 65000) (i32.const 0x66) (i32.const 1000)))
+(assert_return (invoke "i32.load8_u" (i32.const 65999)) (i32.const 0x66))
+(assert_trap   (invoke "memory.copy 16" (i32.const 131072) (i32.const 0)) "out of bounds memory access")
+(assert_trap   (invoke "memory.fill 16" (i32.const 131072) (i32.const 0)) "out of bounds memory access")
+
 ;; passive elem segments
 
 (module (elem funcref (ref.func $f)) (func $f))
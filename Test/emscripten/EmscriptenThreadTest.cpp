@@ -0,0 +1,332 @@
+#include <string>
+#include <vector>
+
+#include "WAVM/Emscripten/Emscripten.h"
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Value.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/HashMap.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Runtime/Linker.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::IR;
+using namespace WAVM::Runtime;
+
+enum
+{
+	numThreads = 4,
+	numIncrementsPerThread = 1000,
+
+	// Addresses in the module's static data that are read by the test. The module's code uses the
+	// same addresses.
+	onceCountAddress = 1096,
+	threadStackPointersAddress = 1200,
+	threadResultsAddress = 1300,
+	trapOnceAddress = 1400,
+	trapOnceEnableAddress = 1404,
+	trapOnceCountAddress = 1408,
+	threadStacksAddress = 1600,
+	mainStackAddress = 1716,
+
+	numThreadStackBytes = 2 * 1024 * 1024,
+};
+
+// A module that uses the Emscripten pthread intrinsics the way Emscripten's libc does: "run"
+// creates numThreads threads that each increment a counter while holding a mutex, waits on a
+// condition variable until every thread has signaled it, and then joins the threads. Each thread
+// also calls pthread_once, and records its stack pointer to check that each thread has its own
+// stack, and the stack that pthread_getattr_np and pthread_attr_getstack report for it.
+// "getMainStack" records the stack reported for the calling thread. "trapOnce" calls pthread_once
+// with an init routine that traps until it is enabled. "trapThread" creates a thread that traps,
+// and joins it. "allocate" allocates memory from the Emscripten runtime's heap.
+static const char threadWAST[] = R"(
+(module
+  (import "env" "memory" (memory 256 512 shared))
+  (import "env" "table" (table 4 4 funcref))
+  (import "env" "_pthread_create" (func $pthread_create (param i32 i32 i32 i32) (result i32)))
+  (import "env" "_pthread_join" (func $pthread_join (param i32 i32) (result i32)))
+  (import "env" "_pthread_mutex_lock" (func $mutex_lock (param i32) (result i32)))
+  (import "env" "_pthread_mutex_unlock" (func $mutex_unlock (param i32) (result i32)))
+  (import "env" "_pthread_cond_wait" (func $cond_wait (param i32 i32) (result i32)))
+  (import "env" "_pthread_cond_broadcast" (func $cond_broadcast (param i32) (result i32)))
+  (import "env" "_pthread_once" (func $pthread_once (param i32 i32) (result i32)))
+  (import "env" "_pthread_self" (func $pthread_self (result i32)))
+  (import "env" "_pthread_attr_init" (func $attr_init (param i32) (result i32)))
+  (import "env" "_pthread_getattr_np" (func $getattr_np (param i32 i32) (result i32)))
+  (import "env" "_pthread_attr_getstack" (func $attr_getstack (param i32 i32 i32) (result i32)))
+  (import "env" "___cxa_allocate_exception" (func $allocate (param i32) (result i32)))
+
+  (global $stackTop (mut i32) (i32.const 0))
+  (global $stackMax (mut i32) (i32.const 0))
+
+  (elem (i32.const 0) $threadEntry $onceInit $trapOnceInit $trapThreadEntry)
+
+  (func (export "establishStackSpace") (param $top i32) (param $max i32)
+    (global.set $stackTop (local.get $top))
+    (global.set $stackMax (local.get $max)))
+
+  (func (export "getStackTop") (result i32) (global.get $stackTop))
+
+  (func $onceInit
+    (i32.store (i32.const 1096) (i32.add (i32.load (i32.const 1096)) (i32.const 1))))
+
+  (func $trapOnceInit
+    (if (i32.eqz (i32.load (i32.const 1404))) (then unreachable))
+    (i32.store (i32.const 1408) (i32.add (i32.load (i32.const 1408)) (i32.const 1))))
+
+  ;; Stores the base and size of the calling thread's stack at $address, using an attr at
+  ;; $attrAddress.
+  (func $getStack (param $attrAddress i32) (param $address i32)
+    (drop (call $attr_init (local.get $attrAddress)))
+    (drop (call $getattr_np (call $pthread_self) (local.get $attrAddress)))
+    (drop (call $attr_getstack (local.get $attrAddress)
+                               (local.get $address)
+                               (i32.add (local.get $address) (i32.const 4)))))
+
+  (func $threadEntry (param $index i32) (result i32)
+    (local $i i32)
+    (drop (call $pthread_once (i32.const 1092) (i32.const 1)))
+    (i32.store (i32.add (i32.const 1200) (i32.shl (local.get $index) (i32.const 2)))
+               (global.get $stackTop))
+    (call $getStack (i32.add (i32.const 1500) (i32.shl (local.get $index) (i32.const 4)))
+                    (i32.add (i32.const 1600) (i32.shl (local.get $index) (i32.const 3))))
+    (loop $increment
+      (drop (call $mutex_lock (i32.const 1024)))
+      (i32.store (i32.const 1088) (i32.add (i32.load (i32.const 1088)) (i32.const 1)))
+      (drop (call $mutex_unlock (i32.const 1024)))
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $increment (i32.lt_u (local.get $i) (i32.const 1000))))
+    (drop (call $mutex_lock (i32.const 1024)))
+    (i32.store (i32.const 1140) (i32.add (i32.load (i32.const 1140)) (i32.const 1)))
+    (drop (call $cond_broadcast (i32.const 1056)))
+    (drop (call $mutex_unlock (i32.const 1024)))
+    (i32.add (local.get $index) (i32.const 100)))
+
+  (func (export "run") (result i32)
+    (local $i i32)
+    (loop $create
+      (if (call $pthread_create (i32.add (i32.const 1100) (i32.shl (local.get $i) (i32.const 2)))
+                                (i32.const 0) (i32.const 0) (local.get $i))
+        (then (return (i32.const -1))))
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $create (i32.lt_u (local.get $i) (i32.const 4))))
+
+    (drop (call $mutex_lock (i32.const 1024)))
+    (block $ready
+      (loop $wait
+        (br_if $ready (i32.ge_u (i32.load (i32.const 1140)) (i32.const 4)))
+        (drop (call $cond_wait (i32.const 1056) (i32.const 1024)))
+        (br $wait)))
+    (drop (call $mutex_unlock (i32.const 1024)))
+
+    (local.set $i (i32.const 0))
+    (loop $join
+      (if (call $pthread_join
+            (i32.load (i32.add (i32.const 1100) (i32.shl (local.get $i) (i32.const 2))))
+            (i32.add (i32.const 1300) (i32.shl (local.get $i) (i32.const 2))))
+        (then (return (i32.const -2))))
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $join (i32.lt_u (local.get $i) (i32.const 4))))
+
+    (i32.load (i32.const 1088)))
+
+  (func $trapThreadEntry (param i32) (result i32) unreachable)
+
+  (func (export "trapThread") (result i32)
+    (if (call $pthread_create (i32.const 1800) (i32.const 0) (i32.const 3) (i32.const 0))
+      (then (return (i32.const -1))))
+    (call $pthread_join (i32.load (i32.const 1800)) (i32.const 0)))
+
+  (func (export "getMainStack")
+    (call $getStack (i32.const 1700) (i32.const 1716)))
+
+  (func (export "trapOnce")
+    (drop (call $pthread_once (i32.const 1400) (i32.const 2))))
+
+  (func (export "allocate") (param $numBytes i32) (result i32)
+    (call $allocate (local.get $numBytes)))
+)
+)";
+
+// Resolves imports from the Emscripten intrinsic modules.
+struct EmscriptenResolver : Resolver
+{
+	HashMap<std::string, ModuleInstance*> moduleNameToInstanceMap;
+
+	bool resolve(const std::string& moduleName,
+				 const std::string& exportName,
+				 IR::ExternType type,
+				 Object*& outObject) override
+	{
+		ModuleInstance* const* moduleInstance = moduleNameToInstanceMap.get(moduleName);
+		if(!moduleInstance) { return false; }
+		outObject = getInstanceExport(*moduleInstance, exportName);
+		return outObject && isA(outObject, type);
+	}
+};
+
+static ModuleInstance* instantiateTestModule(Compartment* compartment,
+											 Context* context,
+											 Emscripten::Instance*& outEmscriptenInstance)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(threadWAST, sizeof(threadWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("EmscriptenThreadTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+
+	outEmscriptenInstance = Emscripten::instantiate(compartment, irModule);
+	errorUnless(outEmscriptenInstance);
+
+	EmscriptenResolver resolver;
+	resolver.moduleNameToInstanceMap.set("env", outEmscriptenInstance->env);
+	resolver.moduleNameToInstanceMap.set("asm2wasm", outEmscriptenInstance->asm2wasm);
+	resolver.moduleNameToInstanceMap.set("global", outEmscriptenInstance->global);
+	LinkResult linkResult = linkModule(irModule, resolver);
+	errorUnless(linkResult.success);
+
+	ModuleInstance* moduleInstance = instantiateModule(compartment,
+													   compileModule(irModule),
+													   std::move(linkResult.resolvedImports),
+													   "EmscriptenThreadTest");
+	Emscripten::initializeGlobals(outEmscriptenInstance, context, irModule, moduleInstance);
+	return moduleInstance;
+}
+
+static void testThreads(Context* context,
+						Emscripten::Instance* emscriptenInstance,
+						ModuleInstance* moduleInstance)
+{
+	Memory* memory = emscriptenInstance->memory;
+
+	// Run the threads, and check that the mutex serialized the counter increments.
+	Function* runFunction = asFunction(getInstanceExport(moduleInstance, "run"));
+	ValueTuple results = invokeFunctionChecked(context, runFunction, {});
+	errorUnless(results.size() == 1 && results[0].i32 == numThreads * numIncrementsPerThread);
+
+	// The once routine ran exactly once, and each thread returned its result through join.
+	errorUnless(memoryRef<U32>(memory, onceCountAddress) == 1);
+	for(U32 threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		errorUnless(memoryRef<I32>(memory, threadResultsAddress + threadIndex * 4)
+					== I32(threadIndex + 100));
+	}
+
+	// Each thread ran on its own stack, which isn't the main thread's stack.
+	Function* getStackTopFunction = asFunction(getInstanceExport(moduleInstance, "getStackTop"));
+	const U32 mainStackTop = invokeFunctionChecked(context, getStackTopFunction, {})[0].u32;
+	for(U32 threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		const U32 stackTop = memoryRef<U32>(memory, threadStackPointersAddress + threadIndex * 4);
+		errorUnless(stackTop && stackTop != mainStackTop);
+		for(U32 otherThreadIndex = 0; otherThreadIndex < threadIndex; ++otherThreadIndex)
+		{
+			errorUnless(stackTop
+						!= memoryRef<U32>(memory,
+										  threadStackPointersAddress + otherThreadIndex * 4));
+		}
+
+		// pthread_attr_getstack reported the thread's own stack.
+		const U32 threadStackAddress = threadStacksAddress + threadIndex * 8;
+		errorUnless(memoryRef<U32>(memory, threadStackAddress) == stackTop);
+		errorUnless(memoryRef<U32>(memory, threadStackAddress + 4) == numThreadStackBytes);
+	}
+
+	// pthread_attr_getstack reports the main thread's stack on the main thread.
+	Function* getMainStackFunction = asFunction(getInstanceExport(moduleInstance, "getMainStack"));
+	invokeFunctionChecked(context, getMainStackFunction, {});
+	errorUnless(memoryRef<U32>(memory, mainStackAddress) == mainStackTop);
+	errorUnless(memoryRef<U32>(memory, mainStackAddress + 4));
+}
+
+static void testThreadTrap(Context* context, ModuleInstance* moduleInstance)
+{
+	// A trap in a pthread is passed on to the thread that joins it.
+	Function* trapThreadFunction = asFunction(getInstanceExport(moduleInstance, "trapThread"));
+	bool trapped = false;
+	catchRuntimeExceptions([&] { invokeFunctionChecked(context, trapThreadFunction, {}); },
+						   [&](Exception* exception) {
+							   errorUnless(getExceptionType(exception)
+										   == ExceptionTypes::reachedUnreachable);
+							   trapped = true;
+							   destroyException(exception);
+						   });
+	errorUnless(trapped);
+}
+
+static void testOnceTrap(Context* context,
+						 Emscripten::Instance* emscriptenInstance,
+						 ModuleInstance* moduleInstance)
+{
+	Memory* memory = emscriptenInstance->memory;
+	Function* trapOnceFunction = asFunction(getInstanceExport(moduleInstance, "trapOnce"));
+
+	// If the init routine traps, pthread_once passes on the trap, and doesn't leave the once
+	// variable in the running state.
+	bool trapped = false;
+	catchRuntimeExceptions([&] { invokeFunctionChecked(context, trapOnceFunction, {}); },
+						   [&](Exception* exception) {
+							   trapped = true;
+							   destroyException(exception);
+						   });
+	errorUnless(trapped);
+	errorUnless(memoryRef<U32>(memory, trapOnceAddress) == 0);
+
+	// A later call runs the init routine again.
+	memoryRef<U32>(memory, trapOnceEnableAddress) = 1;
+	invokeFunctionChecked(context, trapOnceFunction, {});
+	invokeFunctionChecked(context, trapOnceFunction, {});
+	errorUnless(memoryRef<U32>(memory, trapOnceCountAddress) == 1);
+}
+
+static void testFailedAllocation(Context* context, ModuleInstance* moduleInstance)
+{
+	Function* allocateFunction = asFunction(getInstanceExport(moduleInstance, "allocate"));
+	auto allocate = [&](U32 numBytes) {
+		return invokeFunctionChecked(context, allocateFunction, {Value{numBytes}})[0].u32;
+	};
+	auto expectOutOfMemory = [&](U32 numBytes) {
+		bool trapped = false;
+		catchRuntimeExceptions([&] { allocate(numBytes); },
+							   [&](Exception* exception) {
+								   errorUnless(getExceptionType(exception)
+											   == ExceptionTypes::outOfMemory);
+								   trapped = true;
+								   destroyException(exception);
+							   });
+		errorUnless(trapped);
+	};
+
+	// Allocations that can't fit in the memory's maximum size, or in the 32-bit address space,
+	// fail without using any of the heap, so later allocations are placed after the last
+	// allocation that succeeded.
+	const U32 firstAddress = allocate(16);
+	expectOutOfMemory(512 * IR::numBytesPerPage);
+	expectOutOfMemory(UINT32_MAX);
+	errorUnless(allocate(16) == firstAddress + 16);
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	GCPointer<Compartment> compartment = createCompartment();
+	Context* context = createContext(compartment);
+	Emscripten::Instance* emscriptenInstance = nullptr;
+	ModuleInstance* moduleInstance
+		= instantiateTestModule(compartment, context, emscriptenInstance);
+
+	testThreads(context, emscriptenInstance, moduleInstance);
+	testThreadTrap(context, moduleInstance);
+	testOnceTrap(context, emscriptenInstance, moduleInstance);
+	testFailedAllocation(context, moduleInstance);
+
+	Timing::logTimer("EmscriptenThreadTest", timer);
+	return 0;
+}
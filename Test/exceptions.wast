@@ -124,6 +124,153 @@
       throw $b
     end
     )
+
+  ;; Throws that are caught by a try in the same function, including tries nested in it.
+  (func (export "nested_try_inner_catch") (result i32)
+    try (result i32)
+      try (result i32)
+        i32.const 30
+        throw $a
+      catch $a
+        i32.const 1
+        i32.add
+      end
+    catch $a
+      i32.const 100
+      i32.add
+    end
+    )
+
+  (func (export "nested_try_outer_catch") (result i32)
+    try (result i32)
+      try (result i32)
+        i32.const 31
+        throw $a
+      catch $b
+        i32.const 1
+        i32.add
+      end
+    catch $a
+      i32.const 100
+      i32.add
+    end
+    )
+
+  (func (export "nested_try_throw_from_inner_catch") (result i32)
+    try (result i32)
+      try (result i32)
+        i32.const 32
+        throw $a
+      catch $a
+        i32.const 1
+        i32.add
+        throw $b
+      end
+    catch $a
+      i32.const 100
+      i32.add
+    catch $b
+      i32.const 200
+      i32.add
+    end
+    )
+
+  (func (export "nested_try_rethrow_to_outer") (result i32)
+    try (result i32)
+      try (result i32)
+        i32.const 33
+        throw $a
+      catch_all
+        rethrow 0
+      end
+    catch $a
+      i32.const 100
+      i32.add
+    end
+    )
+
+  (func (export "nested_try_three_levels") (param $type i32) (result i32)
+    try (result i32)
+      try (result i32)
+        try (result i32)
+          local.get $type
+          if (result i32)
+            i32.const 34
+            throw $b
+          else
+            i32.const 34
+            f64.const 2.5
+            throw $c
+          end
+        catch $a
+          i32.const 1
+          i32.add
+        end
+      catch $b
+        i32.const 100
+        i32.add
+      end
+    catch $c
+      drop
+      i32.const 200
+      i32.add
+    end
+    )
+
+  (func (export "nested_try_uncaught") (result i32)
+    try (result i32)
+      try (result i32)
+        i32.const 35
+        throw $d
+      catch $a
+        i32.const 1
+        i32.add
+      end
+    catch $b
+      i32.const 100
+      i32.add
+    end
+    )
+
+  ;; A throw in the try and a call that throws both reach the same catch clauses.
+  (func (export "local_or_call_throw") (param $call i32) (result i32)
+    try (result i32)
+      local.get $call
+      if
+        i32.const 36
+        call $throw_a
+      end
+      i32.const 37
+      throw $b
+    catch $a
+      i32.const 100
+      i32.add
+    catch $b
+      i32.const 200
+      i32.add
+    end
+    )
+
+  ;; Throws and catches an exception in each iteration of a loop.
+  (func (export "throw_catch_in_loop") (param $count i32) (result i32)
+    (local $sum i32)
+    loop $loop
+      try
+        local.get $count
+        throw $a
+      catch $a
+        local.get $sum
+        i32.add
+        local.set $sum
+      end
+      local.get $count
+      i32.const 1
+      i32.sub
+      local.tee $count
+      br_if $loop
+    end
+    local.get $sum
+    )
 )
 
 (assert_throws (invoke "throw_a" (i32.const 1)) $A "a" (i32.const 1))
@@ -148,10 +295,20 @@
 
 (assert_throws (invoke "throw_from_catch") $A "b" (i32.const 27))
 
+(assert_return (invoke "nested_try_inner_catch") (i32.const 31))
+(assert_return (invoke "nested_try_outer_catch") (i32.const 131))
+(assert_return (invoke "nested_try_throw_from_inner_catch") (i32.const 233))
+(assert_return (invoke "nested_try_rethrow_to_outer") (i32.const 133))
+(assert_return (invoke "nested_try_three_levels" (i32.const 1)) (i32.const 134))
+(assert_return (invoke "nested_try_three_levels" (i32.const 0)) (i32.const 234))
+(assert_throws (invoke "nested_try_uncaught") $A "d")
+(assert_return (invoke "local_or_call_throw" (i32.const 1)) (i32.const 136))
+(assert_return (invoke "local_or_call_throw" (i32.const 0)) (i32.const 237))
+(assert_return (invoke "throw_catch_in_loop" (i32.const 100)) (i32.const 5050))
+
 ;; todo:
 ;; throw inside of function vs directly in try
 ;; throw in catch
-;; throw in catch in try (same function)
 ;; exception type imported into other module
 ;; named/indexed rethrows
 ;; rethrow outside of catch
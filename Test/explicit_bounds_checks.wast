@@ -0,0 +1,81 @@
+;; Memory accesses in code compiled with explicit bounds checks.
+;; This script is run by RunTestScript with --explicit-bounds-checks.
+
+(module
+	(memory 1 2)
+	(data (i32.const 0) "\01\02\03\04")
+	(data (i32.const 65532) "\05\06\07\08")
+
+	(func (export "load") (param $address i32) (result i32)
+		(i32.load8_u (local.get $address)))
+	(func (export "load-offset") (param $address i32) (result i32)
+		(i32.load8_u offset=65536 (local.get $address)))
+	(func (export "store") (param $address i32)
+		(i32.store8 (local.get $address) (i32.const 0)))
+	(func (export "grow") (param $delta i32) (result i32)
+		(memory.grow (local.get $delta)))
+	(func (export "copy-16") (param $destAddress i32) (param $sourceAddress i32)
+		(memory.copy (local.get $destAddress) (local.get $sourceAddress) (i32.const 16)))
+	(func (export "fill-16") (param $destAddress i32)
+		(memory.fill (local.get $destAddress) (i32.const 0xff) (i32.const 16)))
+
+	;; The same local accessed with increasing offsets must be checked for each larger offset.
+	(func (export "load-increasing-offsets") (param $address i32) (result i32)
+		(i32.add
+			(i32.load8_u (local.get $address))
+			(i32.load8_u offset=131072 (local.get $address))))
+
+	;; A value read from a local before the local is overwritten must still be checked after the
+	;; new value of the local was checked.
+	(func (export "set-after-get") (param $address i32) (result i32)
+		(local.get $address)
+		(local.set $address (i32.const 0))
+		(drop (i32.load8_u (local.get $address)))
+		(i32.load8_u))
+	(func (export "tee-after-get") (param $address i32) (result i32)
+		(local.get $address)
+		(drop (i32.load8_u (local.tee $address (i32.const 0))))
+		(i32.load8_u))
+
+	;; A checked value remains checked after the local it was read from is overwritten.
+	(func (export "get-after-set") (param $address i32) (result i32)
+		(local.get $address)
+		(drop (i32.load8_u (local.get $address)))
+		(local.set $address (i32.const 0x40000000))
+		(i32.load8_u))
+)
+
+(assert_return (invoke "load" (i32.const 0)) (i32.const 1))
+(assert_return (invoke "load" (i32.const 65535)) (i32.const 8))
+(assert_trap (invoke "load" (i32.const 0x40000000)) "out of bounds memory access")
+(assert_trap (invoke "load" (i32.const -1)) "out of bounds memory access")
+(assert_trap (invoke "load-offset" (i32.const 0)) "out of bounds memory access")
+(assert_trap (invoke "load-offset" (i32.const -1)) "out of bounds memory access")
+(assert_trap (invoke "store" (i32.const 0x40000000)) "out of bounds memory access")
+(assert_trap (invoke "load-increasing-offsets" (i32.const 0)) "out of bounds memory access")
+
+(assert_return (invoke "set-after-get" (i32.const 3)) (i32.const 4))
+(assert_trap (invoke "set-after-get" (i32.const 0x40000000)) "out of bounds memory access")
+(assert_trap (invoke "set-after-get" (i32.const -1)) "out of bounds memory access")
+(assert_return (invoke "tee-after-get" (i32.const 3)) (i32.const 4))
+(assert_trap (invoke "tee-after-get" (i32.const 0x40000000)) "out of bounds memory access")
+(assert_return (invoke "get-after-set" (i32.const 2)) (i32.const 3))
+
+;; Addresses between the memory's current size and its maximum size are within the reservation,
+;; and trap until the memory is grown.
+(assert_trap (invoke "load" (i32.const 65536)) "out of bounds memory access")
+(assert_trap (invoke "copy-16" (i32.const 65536) (i32.const 0)) "out of bounds memory access")
+(assert_trap (invoke "copy-16" (i32.const 0) (i32.const 65536)) "out of bounds memory access")
+(assert_trap (invoke "copy-16" (i32.const 0x40000000) (i32.const 0)) "out of bounds memory access")
+(assert_trap (invoke "fill-16" (i32.const 65536)) "out of bounds memory access")
+(assert_trap (invoke "fill-16" (i32.const -16)) "out of bounds memory access")
+(assert_return (invoke "grow" (i32.const 1)) (i32.const 1))
+(assert_return (invoke "load" (i32.const 65536)) (i32.const 0))
+(assert_return (invoke "load" (i32.const 131071)) (i32.const 0))
+(assert_trap (invoke "load" (i32.const 131072)) "out of bounds memory access")
+(assert_return (invoke "copy-16" (i32.const 65536) (i32.const 0)))
+(assert_return (invoke "load" (i32.const 65539)) (i32.const 4))
+(assert_return (invoke "fill-16" (i32.const 131056)))
+(assert_return (invoke "load" (i32.const 131071)) (i32.const 0xff))
+(assert_trap (invoke "copy-16" (i32.const 131072) (i32.const 0)) "out of bounds memory access")
+(assert_return (invoke "grow" (i32.const 1)) (i32.const -1))
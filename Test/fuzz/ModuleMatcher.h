@@ -226,13 +226,8 @@ namespace WAVM {
 
 			while(aNextByte < aEnd && bNextByte < bEnd)
 			{
-				wavmAssert(aNextByte + sizeof(Opcode) <= aEnd);
-				wavmAssert(bNextByte + sizeof(Opcode) <= bEnd);
-
-				Opcode aOpcode;
-				Opcode bOpcode;
-				memcpy(&aOpcode, aNextByte, sizeof(Opcode));
-				memcpy(&bOpcode, bNextByte, sizeof(Opcode));
+				const Opcode aOpcode = OperatorEncoding::decodeOpcode(aNextByte);
+				const Opcode bOpcode = OperatorEncoding::decodeOpcode(bNextByte);
 				if(aOpcode != bOpcode) { failVerification(); }
 
 				switch(aOpcode)
@@ -240,15 +235,13 @@ namespace WAVM {
 #define VISIT_OPCODE(opcode, name, nameString, Imm, ...)                                           \
 	case Opcode::name:                                                                             \
 	{                                                                                              \
-		wavmAssert(aNextByte + sizeof(OpcodeAndImm<Imm>) <= aEnd);                                 \
-		wavmAssert(bNextByte + sizeof(OpcodeAndImm<Imm>) <= bEnd);                                 \
-		OpcodeAndImm<Imm> aEncodedOperator;                                                        \
-		OpcodeAndImm<Imm> bEncodedOperator;                                                        \
-		memcpy(&aEncodedOperator, aNextByte, sizeof(OpcodeAndImm<Imm>));                           \
-		memcpy(&bEncodedOperator, bNextByte, sizeof(OpcodeAndImm<Imm>));                           \
-		aNextByte += sizeof(OpcodeAndImm<Imm>);                                                    \
-		bNextByte += sizeof(OpcodeAndImm<Imm>);                                                    \
-		verifyMatches(aEncodedOperator.imm, bEncodedOperator.imm);                                 \
+		Imm aImm;                                                                                  \
+		Imm bImm;                                                                                  \
+		OperatorEncoding::decodeImm(aNextByte, aImm);                                              \
+		OperatorEncoding::decodeImm(bNextByte, bImm);                                              \
+		wavmAssert(aNextByte <= aEnd);                                                             \
+		wavmAssert(bNextByte <= bEnd);                                                             \
+		verifyMatches(aImm, bImm);                                                                 \
 		break;                                                                                     \
 	}
 					WAVM_ENUM_OPERATORS(VISIT_OPCODE)
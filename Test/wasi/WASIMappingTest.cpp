@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/IR.h"
+#include "WAVM/IR/Module.h"
+#include "WAVM/IR/Types.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Platform/File.h"
+#include "WAVM/Platform/Memory.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/VFS/MemoryFS.h"
+#include "WAVM/VFS/VFS.h"
+#include "WAVM/WASI/WASI.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::Runtime;
+using namespace WAVM::VFS;
+
+enum
+{
+	// The test file is two WebAssembly pages and a partial page long.
+	numFileBytes = 2 * IR::numBytesPerPage + 100
+};
+
+static U8 getFileByte(Uptr offset) { return U8(offset % 251 + 1); }
+
+// A WASI program that maps stdin, which must be the test file, into its memory with fd_map, and
+// checks the memory's contents before and after unmapping it.
+// The program exits with 0 if all the checks passed, or the number of the check that failed.
+static const char mappingWAST[] = R"(
+(module
+  (import "wavm_wasi_unstable" "fd_map" (func $fd_map (param i32 i64 i32 i32) (result i32)))
+  (import "wavm_wasi_unstable" "unmap" (func $unmap (param i32 i32) (result i32)))
+  (import "wasi_unstable" "proc_exit" (func $proc_exit (param i32)))
+  (memory (export "memory") 4 4)
+
+  (func $fail (param $check i32)
+    (call $proc_exit (local.get $check))
+    unreachable)
+
+  (func $expect (param $result i32) (param $expected i32) (param $check i32)
+    (if (i32.ne (local.get $result) (local.get $expected))
+      (then (call $fail (local.get $check)))))
+
+  (func (export "_start")
+    ;; Map the whole file into pages 1-3, after the memory's first page.
+    (call $expect (call $fd_map (i32.const 0) (i64.const 0) (i32.const 65536) (i32.const 196608))
+                  (i32.const 0) (i32.const 1))
+    (call $expect (i32.load8_u (i32.const 65536)) (i32.const 1) (i32.const 2))
+    (call $expect (i32.load8_u (i32.const 65537)) (i32.const 2) (i32.const 3))
+    (call $expect (i32.load8_u (i32.const 196707)) (i32.const 150) (i32.const 4))
+
+    ;; The memory beyond the end of the file is zeroed.
+    (call $expect (i32.load8_u (i32.const 196708)) (i32.const 0) (i32.const 5))
+    (call $expect (i32.load8_u (i32.const 262143)) (i32.const 0) (i32.const 6))
+
+    ;; The mapped pages can be written.
+    (i32.store8 (i32.const 65536) (i32.const 100))
+    (call $expect (i32.load8_u (i32.const 65536)) (i32.const 100) (i32.const 7))
+
+    ;; Mapping at a later offset in the file maps the file's data from that offset.
+    (call $expect (call $fd_map (i32.const 0) (i64.const 65536) (i32.const 65536) (i32.const 65536))
+                  (i32.const 0) (i32.const 8))
+    (call $expect (i32.load8_u (i32.const 65536)) (i32.const 26) (i32.const 9))
+
+    ;; Unaligned offsets and ranges, and ranges beyond the memory's size, are rejected.
+    (call $expect (call $fd_map (i32.const 0) (i64.const 1) (i32.const 65536) (i32.const 65536))
+                  (i32.const 28) (i32.const 10))
+    (call $expect (call $fd_map (i32.const 0) (i64.const 0) (i32.const 1) (i32.const 65536))
+                  (i32.const 28) (i32.const 11))
+    (call $expect (call $fd_map (i32.const 0) (i64.const 0) (i32.const 65536) (i32.const 1))
+                  (i32.const 28) (i32.const 12))
+    (call $expect (call $fd_map (i32.const 0) (i64.const 0) (i32.const 196608) (i32.const 131072))
+                  (i32.const 21) (i32.const 13))
+    (call $expect (call $unmap (i32.const 196608) (i32.const 131072)) (i32.const 21) (i32.const 14))
+
+    ;; Mapping a bad FD fails.
+    (call $expect (call $fd_map (i32.const 100) (i64.const 0) (i32.const 65536) (i32.const 65536))
+                  (i32.const 8) (i32.const 15))
+
+    ;; Unmapping the pages zeroes them.
+    (call $expect (call $unmap (i32.const 65536) (i32.const 196608)) (i32.const 0) (i32.const 16))
+    (call $expect (i32.load8_u (i32.const 65536)) (i32.const 0) (i32.const 17))
+    (call $expect (i32.load8_u (i32.const 131072)) (i32.const 0) (i32.const 18)))
+)
+)";
+
+// Creates a temporary host file that contains numFileBytes bytes, and returns its path.
+static std::string createTestFile()
+{
+	char pathTemplate[] = "/tmp/WASIMappingTest.XXXXXX";
+	const int fd = mkstemp(pathTemplate);
+	errorUnless(fd >= 0);
+
+	std::vector<U8> bytes(numFileBytes);
+	for(Uptr offset = 0; offset < numFileBytes; ++offset) { bytes[offset] = getFileByte(offset); }
+	errorUnless(write(fd, bytes.data(), bytes.size()) == ssize_t(bytes.size()));
+	errorUnless(!close(fd));
+	return pathTemplate;
+}
+
+// Checks that numBytes bytes of memory contain the file's bytes starting at fileOffset, followed by
+// zeroes after the end of the file.
+static bool containsFile(const U8* bytes, Uptr numBytes, Uptr fileOffset)
+{
+	for(Uptr index = 0; index < numBytes; ++index)
+	{
+		const Uptr offset = fileOffset + index;
+		if(bytes[index] != (offset < numFileBytes ? getFileByte(offset) : 0)) { return false; }
+	}
+	return true;
+}
+
+static bool isZeroed(const U8* bytes, Uptr numBytes)
+{
+	for(Uptr index = 0; index < numBytes; ++index)
+	{
+		if(bytes[index]) { return false; }
+	}
+	return true;
+}
+
+// Maps a VFD's file into a memory with mapFileIntoMemory, and checks the memory's contents.
+static void testMapFileIntoMemory(VFD* vfd)
+{
+	GCPointer<Compartment> compartment = createCompartment();
+	Memory* memory = createMemory(compartment, IR::MemoryType(false, {4, 4}), "test");
+	errorUnless(memory);
+	U8* pages = getMemoryBaseAddress(memory) + IR::numBytesPerPage;
+	const Uptr numPageBytes = 3 * IR::numBytesPerPage;
+
+	// Unaligned file offsets and ranges beyond the memory's size are rejected.
+	errorUnless(mapFileIntoMemory(memory, 1, 1, vfd, 1) == Result::invalidOffset);
+	errorUnless(mapFileIntoMemory(memory, 3, 2, vfd, 0) == Result::inaccessibleBuffer);
+	errorUnless(mapFileIntoMemory(memory, 5, 0, vfd, 0) == Result::inaccessibleBuffer);
+
+	// Map the whole file, and the zeroed pages after its end.
+	pages[numPageBytes - 1] = 1;
+	errorUnless(mapFileIntoMemory(memory, 1, 3, vfd, 0) == Result::success);
+	errorUnless(containsFile(pages, numPageBytes, 0));
+
+	// Writing to the mapped pages doesn't write to the file.
+	pages[0] = 0;
+	U8 firstFileByte = 0;
+	U64 fileOffset = 0;
+	errorUnless(vfd->read(&firstFileByte, 1, nullptr, &fileOffset) == Result::success);
+	errorUnless(firstFileByte == getFileByte(0));
+
+	// Map the file from an offset.
+	errorUnless(mapFileIntoMemory(memory, 1, 2, vfd, IR::numBytesPerPage) == Result::success);
+	errorUnless(containsFile(pages, 2 * IR::numBytesPerPage, IR::numBytesPerPage));
+
+	// Unmapping the file zeroes the pages.
+	unmapFileFromMemory(memory, 1, 3);
+	errorUnless(isZeroed(pages, numPageBytes));
+
+	// Pages that are still mapped from the file are zeroed if they are unmapped from the memory,
+	// and then committed again.
+	errorUnless(mapFileIntoMemory(memory, 1, 3, vfd, 0) == Result::success);
+	unmapMemoryPages(memory, 1, 3);
+	errorUnless(Platform::commitVirtualPages(pages, numPageBytes >> Platform::getPageSizeLog2()));
+	errorUnless(isZeroed(pages, numPageBytes));
+
+	errorUnless(tryCollectCompartment(std::move(compartment)));
+}
+
+static void testWASIMapping(VFD* vfd)
+{
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(mappingWAST, sizeof(mappingWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("WASIMappingTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+	ModuleRef module = compileModule(irModule);
+
+	I32 exitCode = -1;
+	errorUnless(WASI::run(module,
+						  {"WASIMappingTest"},
+						  {},
+						  nullptr,
+						  vfd,
+						  Platform::getStdFD(Platform::StdDevice::out),
+						  Platform::getStdFD(Platform::StdDevice::err),
+						  exitCode)
+				== WASI::RunResult::success);
+	if(exitCode != 0) { Errors::fatalf("WASIMappingTest check %d failed", exitCode); }
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	const std::string path = createTestFile();
+	VFD* hostVFD = nullptr;
+	errorUnless(Platform::getHostFS().open(path,
+										   FileAccessMode::readOnly,
+										   FileCreateMode::openExisting,
+										   hostVFD)
+				== Result::success);
+
+	// A file that isn't on the host can't be mapped, so mapFileIntoMemory reads it instead.
+	FileSystem* memoryFS = makeMemoryFS();
+	VFD* memoryVFD = nullptr;
+	errorUnless(memoryFS->open("/file",
+							   FileAccessMode::readWrite,
+							   FileCreateMode::createNew,
+							   memoryVFD)
+				== Result::success);
+	std::vector<U8> bytes(numFileBytes);
+	for(Uptr offset = 0; offset < numFileBytes; ++offset) { bytes[offset] = getFileByte(offset); }
+	errorUnless(memoryVFD->write(bytes.data(), bytes.size()) == Result::success);
+
+	testMapFileIntoMemory(hostVFD);
+	testMapFileIntoMemory(memoryVFD);
+	testWASIMapping(hostVFD);
+	testWASIMapping(memoryVFD);
+
+	errorUnless(memoryVFD->close() == Result::success);
+	delete memoryFS;
+	errorUnless(hostVFD->close() == Result::success);
+	errorUnless(!unlink(path.c_str()));
+
+	Timing::logTimer("WASIMappingTest", timer);
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "WAVM/IR/Module.h"
+#include "WAVM/Inline/BasicTypes.h"
+#include "WAVM/Inline/Errors.h"
+#include "WAVM/Inline/I128.h"
+#include "WAVM/Inline/Timing.h"
+#include "WAVM/Runtime/Runtime.h"
+#include "WAVM/VFS/VFS.h"
+#include "WAVM/WASI/WASI.h"
+#include "WAVM/WASTParse/WASTParse.h"
+
+using namespace WAVM;
+using namespace WAVM::Runtime;
+using namespace WAVM::VFS;
+
+enum
+{
+	numStdInBytes = 5
+};
+
+// A WASI program that calls poll_oneoff with clock and FD subscriptions, and checks the events it
+// returns. stdin must be a pipe with numStdInBytes bytes to read, and stderr must be the read end of
+// an empty pipe.
+// The program exits with 0 if all the checks passed, or the number of the check that failed.
+static const char pollWAST[] = R"(
+(module
+  (import "wasi_unstable" "poll_oneoff" (func $poll_oneoff (param i32 i32 i32 i32) (result i32)))
+  (import "wasi_unstable" "clock_time_get" (func $clock_time_get (param i32 i64 i32) (result i32)))
+  (import "wasi_unstable" "proc_exit" (func $proc_exit (param i32)))
+  (memory (export "memory") 1)
+
+  ;; Subscriptions are written at 0, events are written at 1024, the number of events is written
+  ;; at 2048, and clock_time_get writes the time at 2056.
+
+  (func $fail (param $check i32)
+    (call $proc_exit (local.get $check))
+    unreachable)
+
+  (func $now (result i64)
+    (if (call $clock_time_get (i32.const 1) (i64.const 1) (i32.const 2056))
+      (then (call $fail (i32.const 100))))
+    (i64.load (i32.const 2056)))
+
+  ;; Writes a subscription to a relative timeout on the monotonic clock.
+  (func $subscribeClock (param $index i32) (param $userdata i64) (param $timeout i64)
+    (local $address i32)
+    (local.set $address (i32.mul (local.get $index) (i32.const 56)))
+    (i64.store (local.get $address) (local.get $userdata))
+    (i32.store8 offset=8 (local.get $address) (i32.const 0))
+    (i64.store offset=16 (local.get $address) (i64.const 0))
+    (i32.store offset=24 (local.get $address) (i32.const 1))
+    (i64.store offset=32 (local.get $address) (local.get $timeout))
+    (i64.store offset=40 (local.get $address) (i64.const 0))
+    (i32.store16 offset=48 (local.get $address) (i32.const 0)))
+
+  ;; Writes a subscription to an FD becoming readable.
+  (func $subscribeRead (param $index i32) (param $userdata i64) (param $fd i32)
+    (local $address i32)
+    (local.set $address (i32.mul (local.get $index) (i32.const 56)))
+    (i64.store (local.get $address) (local.get $userdata))
+    (i32.store8 offset=8 (local.get $address) (i32.const 1))
+    (i32.store offset=16 (local.get $address) (local.get $fd)))
+
+  ;; Polls the first numSubscriptions subscriptions, and fails the check if the number of events
+  ;; isn't numEvents.
+  (func $poll (param $numSubscriptions i32) (param $numEvents i32) (param $check i32)
+    (if (call $poll_oneoff (i32.const 0) (i32.const 1024) (local.get $numSubscriptions)
+                           (i32.const 2048))
+      (then (call $fail (local.get $check))))
+    (if (i32.ne (i32.load (i32.const 2048)) (local.get $numEvents))
+      (then (call $fail (local.get $check)))))
+
+  ;; Fails the check if an event doesn't have the expected userdata, error, and type.
+  (func $checkEvent (param $index i32) (param $userdata i64) (param $error i32) (param $type i32)
+                    (param $check i32)
+    (local $address i32)
+    (local.set $address (i32.add (i32.const 1024) (i32.mul (local.get $index) (i32.const 32))))
+    (if (i64.ne (i64.load (local.get $address)) (local.get $userdata))
+      (then (call $fail (local.get $check))))
+    (if (i32.ne (i32.load16_u offset=8 (local.get $address)) (local.get $error))
+      (then (call $fail (local.get $check))))
+    (if (i32.ne (i32.load8_u offset=10 (local.get $address)) (local.get $type))
+      (then (call $fail (local.get $check)))))
+
+  (func (export "_start")
+    (local $startTime i64)
+
+    ;; A 1ms timeout produces a clock event after at least 1ms.
+    (local.set $startTime (call $now))
+    (call $subscribeClock (i32.const 0) (i64.const 1) (i64.const 1000000))
+    (call $poll (i32.const 1) (i32.const 1) (i32.const 1))
+    (call $checkEvent (i32.const 0) (i64.const 1) (i32.const 0) (i32.const 0) (i32.const 2))
+    (if (i64.lt_u (i64.sub (call $now) (local.get $startTime)) (i64.const 1000000))
+      (then (call $fail (i32.const 3))))
+
+    ;; stdin is readable, and the event reports the number of bytes that can be read.
+    (call $subscribeRead (i32.const 0) (i64.const 2) (i32.const 0))
+    (call $poll (i32.const 1) (i32.const 1) (i32.const 4))
+    (call $checkEvent (i32.const 0) (i64.const 2) (i32.const 0) (i32.const 1) (i32.const 5))
+    (if (i64.ne (i64.load (i32.const 1040)) (i64.const 5))
+      (then (call $fail (i32.const 6))))
+
+    ;; With a readable FD and a 10s timeout, only the FD is ready, and the call doesn't wait.
+    (local.set $startTime (call $now))
+    (call $subscribeClock (i32.const 0) (i64.const 3) (i64.const 10000000000))
+    (call $subscribeRead (i32.const 1) (i64.const 4) (i32.const 0))
+    (call $poll (i32.const 2) (i32.const 1) (i32.const 7))
+    (call $checkEvent (i32.const 0) (i64.const 4) (i32.const 0) (i32.const 1) (i32.const 8))
+    (if (i64.ge_u (i64.sub (call $now) (local.get $startTime)) (i64.const 5000000000))
+      (then (call $fail (i32.const 9))))
+
+    ;; With an FD that isn't readable and a 1ms timeout, only the timeout is ready.
+    (call $subscribeRead (i32.const 0) (i64.const 5) (i32.const 2))
+    (call $subscribeClock (i32.const 1) (i64.const 6) (i64.const 1000000))
+    (call $poll (i32.const 2) (i32.const 1) (i32.const 10))
+    (call $checkEvent (i32.const 0) (i64.const 6) (i32.const 0) (i32.const 0) (i32.const 11))
+
+    ;; A subscription to a bad FD produces an EBADF event without waiting for the timeout.
+    (call $subscribeRead (i32.const 0) (i64.const 7) (i32.const 100))
+    (call $subscribeClock (i32.const 1) (i64.const 8) (i64.const 10000000000))
+    (call $poll (i32.const 2) (i32.const 1) (i32.const 12))
+    (call $checkEvent (i32.const 0) (i64.const 7) (i32.const 8) (i32.const 1) (i32.const 13)))
+)
+)";
+
+// A VFD for one end of a host pipe.
+struct PipeVFD : VFD
+{
+	PipeVFD(I32 inFD) : fd(inFD) {}
+
+	virtual Result close() override
+	{
+		::close(fd);
+		delete this;
+		return Result::success;
+	}
+
+	virtual Result seek(I64, SeekOrigin, U64*) override { return Result::notSeekable; }
+	virtual Result readv(const IOReadBuffer* buffers,
+						 Uptr numBuffers,
+						 Uptr* outNumBytesRead,
+						 const U64* offset) override
+	{
+		errorUnless(numBuffers == 1 && !offset);
+		const ssize_t result = ::read(fd, buffers[0].data, buffers[0].numBytes);
+		errorUnless(result >= 0);
+		if(outNumBytesRead) { *outNumBytesRead = Uptr(result); }
+		return Result::success;
+	}
+	virtual Result writev(const IOWriteBuffer* buffers,
+						  Uptr numBuffers,
+						  Uptr* outNumBytesWritten,
+						  const U64* offset) override
+	{
+		errorUnless(numBuffers == 1 && !offset);
+		const ssize_t result = ::write(fd, buffers[0].data, buffers[0].numBytes);
+		errorUnless(result >= 0);
+		if(outNumBytesWritten) { *outNumBytesWritten = Uptr(result); }
+		return Result::success;
+	}
+
+	virtual Result sync(SyncType) override { return Result::notSynchronizable; }
+	virtual Result getVFDInfo(VFDInfo&) override { return Result::notPermitted; }
+	virtual Result getFileInfo(FileInfo&) override { return Result::notPermitted; }
+	virtual Result setVFDFlags(const VFDFlags&) override { return Result::notPermitted; }
+	virtual Result setFileSize(U64) override { return Result::notPermitted; }
+	virtual Result setFileTimes(bool, I128, bool, I128) override { return Result::notPermitted; }
+	virtual Result openDir(DirEntStream*&) override { return Result::isNotDirectory; }
+
+	virtual I32 getPollableHostFD() override { return fd; }
+
+private:
+	const I32 fd;
+};
+
+static void createPipe(VFD*& outReadVFD, VFD*& outWriteVFD)
+{
+	int fds[2];
+	errorUnless(!pipe(fds));
+	outReadVFD = new PipeVFD(fds[0]);
+	outWriteVFD = new PipeVFD(fds[1]);
+}
+
+I32 main()
+{
+	Timing::Timer timer;
+
+	IR::Module irModule;
+	std::vector<WAST::Error> parseErrors;
+	if(!WAST::parseModule(pollWAST, sizeof(pollWAST), irModule, parseErrors))
+	{
+		WAST::reportParseErrors("WASIPollTest", parseErrors);
+		Errors::fatal("Failed to parse test module");
+	}
+	ModuleRef module = compileModule(irModule);
+
+	// stdin has numStdInBytes bytes to read. stderr is the read end of a pipe that nothing is
+	// written to, and stdout is its write end.
+	VFD* stdInReadVFD = nullptr;
+	VFD* stdInWriteVFD = nullptr;
+	createPipe(stdInReadVFD, stdInWriteVFD);
+	const U8 stdInBytes[numStdInBytes] = {1, 2, 3, 4, 5};
+	errorUnless(stdInWriteVFD->write(stdInBytes, numStdInBytes) == Result::success);
+
+	VFD* emptyReadVFD = nullptr;
+	VFD* emptyWriteVFD = nullptr;
+	createPipe(emptyReadVFD, emptyWriteVFD);
+
+	I32 exitCode = -1;
+	errorUnless(WASI::run(module,
+						  {"WASIPollTest"},
+						  {},
+						  nullptr,
+						  stdInReadVFD,
+						  emptyWriteVFD,
+						  emptyReadVFD,
+						  exitCode)
+				== WASI::RunResult::success);
+	if(exitCode != 0) { Errors::fatalf("WASIPollTest check %d failed", exitCode); }
+
+	// WASI::run closed the VFDs it was passed when the process exited, so only close the write end
+	// of the stdin pipe.
+	errorUnless(stdInWriteVFD->close() == Result::success);
+
+	Timing::logTimer("WASIPollTest", timer);
+	return 0;
+}
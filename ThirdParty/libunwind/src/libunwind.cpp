@@ -349,6 +349,39 @@ void _unw_remove_dynamic_fde(unw_word_t fde) {
   // fde is own mh_group
   DwarfFDECache<LocalAddressSpace>::removeAllIn((LocalAddressSpace::pint_t)fde);
 }
+
+/// IPI: decodes the range of code covered by an FDE. Returns zero if the FDE
+/// is malformed.
+int _unw_get_fde_pc_range(unw_word_t fde, unw_word_t *pcStart,
+                          unw_word_t *pcEnd) {
+  CFI_Parser<LocalAddressSpace>::FDE_Info fdeInfo;
+  CFI_Parser<LocalAddressSpace>::CIE_Info cieInfo;
+  const char *message = CFI_Parser<LocalAddressSpace>::decodeFDE(
+                           LocalAddressSpace::sThisAddressSpace,
+                          (LocalAddressSpace::pint_t) fde, &fdeInfo, &cieInfo);
+  if (message != NULL)
+    return 0;
+  *pcStart = fdeInfo.pcStart;
+  *pcEnd = fdeInfo.pcEnd;
+  return 1;
+}
+
+static unw_word_t (*findDynamicFDEFunc)(unw_word_t pc) = NULL;
+
+/// IPI: sets a function that is called to find the FDE for a pc that isn't
+/// covered by any loaded image, before searching the FDEs registered with
+/// __register_frame(). This lets dynamic code generators that register many
+/// FDEs look them up with their own index instead of the linear FDE cache.
+void _unw_set_find_dynamic_fde(unw_word_t (*func)(unw_word_t pc)) {
+  __atomic_store_n(&findDynamicFDEFunc, func, __ATOMIC_RELEASE);
+}
+
+/// IPI: calls the function set by _unw_set_find_dynamic_fde(), if any.
+unw_word_t _unw_find_dynamic_fde(unw_word_t pc) {
+  unw_word_t (*func)(unw_word_t pc) =
+      __atomic_load_n(&findDynamicFDEFunc, __ATOMIC_ACQUIRE);
+  return func ? func(pc) : 0;
+}
 #endif // defined(_LIBUNWIND_SUPPORT_DWARF_UNWIND)
 #endif // !defined(__USING_SJLJ_EXCEPTIONS__)
 
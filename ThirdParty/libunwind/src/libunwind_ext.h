@@ -33,6 +33,12 @@ extern void unw_iterate_dwarf_unwind_cache(void (*func)(unw_word_t ip_start,
 extern void _unw_add_dynamic_fde(unw_word_t fde);
 extern void _unw_remove_dynamic_fde(unw_word_t fde);
 
+// IPI: for dynamic code generators that index their own FDEs
+extern int _unw_get_fde_pc_range(unw_word_t fde, unw_word_t *pcStart,
+                                 unw_word_t *pcEnd);
+extern void _unw_set_find_dynamic_fde(unw_word_t (*func)(unw_word_t pc));
+extern unw_word_t _unw_find_dynamic_fde(unw_word_t pc);
+
 #if defined(_LIBUNWIND_ARM_EHABI)
 extern const uint32_t* decode_eht_entry(const uint32_t*, size_t*, size_t*);
 extern _Unwind_Reason_Code _Unwind_VRS_Interpret(_Unwind_Context *context,